@@ -0,0 +1,271 @@
+/*
+ * src/bin/pgcopydb/bench/queue_bench.c
+ *   Micro-benchmark for the pgcopydb inter-process queues
+ *
+ * Producer processes send messages on a queue, and consumer processes
+ * receive them until they get a STOP message, as the pgcopydb supervisors
+ * and workers do. The same run is timed with a shared memory ring queue and
+ * with a System V message queue.
+ *
+ * Build with `make queue-bench` in src/bin/pgcopydb, then run:
+ *
+ *   ./bench/queue_bench [ messages [ producers [ consumers ] ] ]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "postgres_fe.h"
+
+#include "copydb.h"
+#include "defaults.h"
+#include "lock_utils.h"
+#include "log.h"
+#include "queue_utils.h"
+
+
+/* the pgcopydb objects we link with expect the globals from main.c */
+char pgcopydb_argv0[MAXPGPATH];
+char pgcopydb_program[MAXPGPATH];
+char *pgcopydb_cmdline = NULL;
+
+char *ps_buffer;
+size_t ps_buffer_size;
+size_t last_status_len;
+
+FILE *logfp = NULL;
+Semaphore log_semaphore = { 0 };
+
+SysVResArray system_res_array = { 0 };
+
+
+static bool queue_bench_run(QueueKind kind,
+							int messages, int producers, int consumers,
+							double *elapsed);
+static bool queue_bench_wait(int count);
+static double queue_bench_now(void);
+
+
+int
+main(int argc, char **argv)
+{
+	int messages = argc > 1 ? atoi(argv[1]) : 1000000;
+	int producers = argc > 2 ? atoi(argv[2]) : 1;
+	int consumers = argc > 3 ? atoi(argv[3]) : 4;
+
+	if (messages < 1 || producers < 1 || consumers < 1)
+	{
+		fformat(stderr,
+				"Usage: %s [ messages [ producers [ consumers ] ] ]\n",
+				argv[0]);
+		exit(EXIT_CODE_BAD_ARGS);
+	}
+
+	log_set_level(LOG_INFO);
+
+	fformat(stdout, "%d messages, %d producers, %d consumers\n\n",
+			messages, producers, consumers);
+
+	fformat(stdout, "%10s | %12s | %14s\n", "Queue", "Elapsed", "Messages/s");
+	fformat(stdout, "%10s-+-%12s-+-%14s\n",
+			"----------", "------------", "--------------");
+
+	QueueKind kinds[] = { QUEUE_KIND_RING, QUEUE_KIND_SYSV };
+	char *names[] = { "ring", "sysv" };
+
+	for (int i = 0; i < 2; i++)
+	{
+		double elapsed = 0;
+
+		/* do not have the sub-processes flush our output buffer again */
+		fflush(stdout);
+
+		if (!queue_bench_run(kinds[i], messages, producers, consumers,
+							 &elapsed))
+		{
+			exit(EXIT_CODE_INTERNAL_ERROR);
+		}
+
+		fformat(stdout, "%10s | %10.3f s | %14.0f\n",
+				names[i],
+				elapsed,
+				elapsed > 0 ? messages / elapsed : 0);
+	}
+
+	exit(EXIT_CODE_QUIT);
+}
+
+
+/*
+ * queue_bench_run times sending the given number of messages through a new
+ * queue of the given kind.
+ */
+static bool
+queue_bench_run(QueueKind kind,
+				int messages, int producers, int consumers,
+				double *elapsed)
+{
+	Queue queue = { 0 };
+
+	if (!queue_create_kind(&queue, "bench", kind))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* consumers count the messages they receive in shared memory */
+	uint64_t *received = mmap(NULL, sizeof(uint64_t),
+							  PROT_READ | PROT_WRITE,
+							  MAP_SHARED | MAP_ANONYMOUS,
+							  -1, 0);
+
+	if (received == MAP_FAILED)
+	{
+		log_error("Failed to create shared memory counter: %m");
+		return false;
+	}
+
+	*received = 0;
+
+	double start = queue_bench_now();
+
+	for (int i = 0; i < consumers; i++)
+	{
+		pid_t pid = fork();
+
+		if (pid == -1)
+		{
+			log_error("Failed to fork a consumer process: %m");
+			return false;
+		}
+
+		if (pid == 0)
+		{
+			for (;;)
+			{
+				QMessage mesg = { 0 };
+
+				if (!queue_receive(&queue, &mesg))
+				{
+					exit(EXIT_CODE_INTERNAL_ERROR);
+				}
+
+				if (mesg.type == QMSG_TYPE_STOP)
+				{
+					exit(EXIT_CODE_QUIT);
+				}
+
+				(void) __atomic_add_fetch(received, 1, __ATOMIC_RELAXED);
+			}
+		}
+	}
+
+	for (int i = 0; i < producers; i++)
+	{
+		pid_t pid = fork();
+
+		if (pid == -1)
+		{
+			log_error("Failed to fork a producer process: %m");
+			return false;
+		}
+
+		if (pid == 0)
+		{
+			int count = messages / producers;
+
+			if (i == 0)
+			{
+				count += messages % producers;
+			}
+
+			for (int m = 0; m < count; m++)
+			{
+				QMessage mesg = {
+					.type = QMSG_TYPE_TABLEPOID,
+					.data.tp = { .oid = m, .part = i }
+				};
+
+				if (!queue_send(&queue, &mesg))
+				{
+					exit(EXIT_CODE_INTERNAL_ERROR);
+				}
+			}
+
+			exit(EXIT_CODE_QUIT);
+		}
+	}
+
+	bool success = queue_bench_wait(producers);
+
+	for (int i = 0; i < consumers; i++)
+	{
+		QMessage stop = { .type = QMSG_TYPE_STOP };
+
+		success = queue_send(&queue, &stop) && success;
+	}
+
+	success = queue_bench_wait(consumers) && success;
+
+	*elapsed = queue_bench_now() - start;
+
+	if (*received != (uint64_t) messages)
+	{
+		log_error("Consumers received %lld messages, expected %d",
+				  (long long) *received,
+				  messages);
+		success = false;
+	}
+
+	(void) munmap(received, sizeof(uint64_t));
+	(void) queue_unlink(&queue);
+
+	return success;
+}
+
+
+/*
+ * queue_bench_wait waits until count sub-processes have exited, and returns
+ * true when all of them were successful.
+ */
+static bool
+queue_bench_wait(int count)
+{
+	bool success = true;
+
+	for (int i = 0; i < count; i++)
+	{
+		int status = 0;
+
+		if (wait(&status) == -1)
+		{
+			log_error("Failed to wait for sub-processes: %m");
+			return false;
+		}
+
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_CODE_QUIT)
+		{
+			success = false;
+		}
+	}
+
+	return success;
+}
+
+
+/*
+ * queue_bench_now returns the current time in seconds.
+ */
+static double
+queue_bench_now(void)
+{
+	struct timespec ts = { 0 };
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
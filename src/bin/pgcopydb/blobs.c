@@ -9,6 +9,7 @@
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include "concurrency.h"
 #include "copydb.h"
 #include "log.h"
 #include "schema.h"
@@ -80,6 +81,14 @@ copydb_start_blob_process(CopyDataSpec *specs)
 			return false;
 		}
 
+		/* with --spool, let the snapshot owner know we're done with it */
+		if (specs->useSpool &&
+			!copydb_spool_mark_done(specs->cfPaths.spool.blobsDoneFile))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+
 		return true;
 	}
 
@@ -117,6 +126,13 @@ copydb_start_blob_process(CopyDataSpec *specs)
 				exit(EXIT_CODE_INTERNAL_ERROR);
 			}
 
+			if (specs->useSpool &&
+				!copydb_spool_mark_done(specs->cfPaths.spool.blobsDoneFile))
+			{
+				/* errors have already been logged */
+				exit(EXIT_CODE_INTERNAL_ERROR);
+			}
+
 			exit(EXIT_CODE_QUIT);
 		}
 
@@ -379,6 +395,10 @@ copydb_blob_worker(CopyDataSpec *specs)
 		return false;
 	}
 
+	/* the source and target connections are used for all the objects */
+	ConnectionReuse reuse = { 0 };
+	uint64_t blobCount = 0;
+
 	int errors = 0;
 	bool stop = false;
 
@@ -399,6 +419,13 @@ copydb_blob_worker(CopyDataSpec *specs)
 			return false;
 		}
 
+		/* with --total-jobs, wait until the jobs budget allows for it */
+		if (!concurrency_budget_acquire(CONCURRENCY_POOL_BLOB))
+		{
+			log_error("Large Objects worker has been interrupted");
+			return false;
+		}
+
 		switch (mesg.type)
 		{
 			case QMSG_TYPE_STOP:
@@ -409,6 +436,7 @@ copydb_blob_worker(CopyDataSpec *specs)
 				if (!pgsql_commit(&dst))
 				{
 					/* errors have already been logged */
+					concurrency_budget_release(CONCURRENCY_POOL_BLOB);
 					return false;
 				}
 
@@ -430,6 +458,7 @@ copydb_blob_worker(CopyDataSpec *specs)
 					log_error("Failed to copy Large Object with oid %u, "
 							  "see above for details",
 							  mesg.data.oid);
+					concurrency_budget_release(CONCURRENCY_POOL_BLOB);
 					return false;
 				}
 
@@ -440,6 +469,14 @@ copydb_blob_worker(CopyDataSpec *specs)
 
 				uint64_t durationMs = INSTR_TIME_GET_MILLISEC(duration);
 
+				/* only the first object paid for the connections set-up */
+				if (blobCount++ > 0)
+				{
+					++(reuse.reused);
+					copydb_connection_reused(&reuse, src);
+					copydb_connection_reused(&reuse, &dst);
+				}
+
 				if (!summary_increment_timing(sourceDB,
 											  TIMING_SECTION_LARGE_OBJECTS,
 											  1, /* count */
@@ -447,6 +484,7 @@ copydb_blob_worker(CopyDataSpec *specs)
 											  durationMs))
 				{
 					/* errors have already been logged */
+					concurrency_budget_release(CONCURRENCY_POOL_BLOB);
 					return false;
 				}
 
@@ -463,12 +501,20 @@ copydb_blob_worker(CopyDataSpec *specs)
 				break;
 			}
 		}
+
+		concurrency_budget_release(CONCURRENCY_POOL_BLOB);
 	}
 
 	/* terminate our connection to the source and target database now */
 	(void) copydb_close_snapshot(specs);
 	(void) pgsql_finish(&dst);
 
+	if (!copydb_report_connection_reuse(sourceDB, &reuse))
+	{
+		log_warn("Failed to register connection re-use timings, "
+				 "see above for details");
+	}
+
 	if (!catalog_close(sourceDB))
 	{
 		log_error("Failed to close source catalogs, see above for details");
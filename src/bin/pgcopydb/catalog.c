@@ -131,10 +131,16 @@ static char *sourceDBcreateTableDDLs[] = {
 	"  primary key(oid, attnum) "
 	")",
 
+	"create table s_table_copy_format("
+	"  oid integer primary key references s_table(oid), "
+	"  format text, reason text "
+	")",
+
 	"create table s_table_part("
 	"  oid integer references s_table(oid), "
 	"  partnum integer, partcount integer, "
-	"  min integer, max integer, count integer, "
+	"  min integer, max integer, count integer, est_rows integer, "
+	"  min_key text, max_key text, "
 	"  primary key(oid, partnum) "
 	")",
 
@@ -147,7 +153,8 @@ static char *sourceDBcreateTableDDLs[] = {
 	"  oid integer primary key, "
 	"  qname text, nspname text, relname text, restore_list_name text, "
 	"  tableoid references s_table(oid), "
-	"  isprimary bool, isunique bool, columns text, sql text "
+	"  isprimary bool, isunique bool, columns text, sql text, "
+	"  bytes integer "
 	")",
 
 	"create table s_constraint("
@@ -156,6 +163,17 @@ static char *sourceDBcreateTableDDLs[] = {
 	"  condeferrable bool, condeferred bool, sql text "
 	")",
 
+	"create table s_fkey("
+	"  oid integer primary key, "
+	"  conrelid integer references s_table(oid), confrelid integer, "
+	"  qname text, conname text, convalidated bool, bytes integer, sql text, "
+	"  restore bool default false "
+	")",
+
+	"create table s_table_pg_stats("
+	"  oid integer primary key references s_table(oid), sql text "
+	")",
+
 	"create table s_seq("
 	"  oid integer, "
 	"  ownedby integer, attrelid integer, attroid integer, "
@@ -191,6 +209,14 @@ static char *sourceDBcreateTableDDLs[] = {
 	"  extoid integer, "
 	"  start_time_epoch integer, done_time_epoch integer, duration integer, "
 	"  bytes integer, "
+	"  ring_depth integer, ring_samples integer, ring_occupancy integer, "
+	"  ring_full integer, ring_empty integer, "
+	"  wal_skipped bool, frozen bool, "
+	"  retries integer, retry_duration integer, "
+	"  copy_rows integer, copy_messages integer, "
+	"  src_wait integer, dst_wait integer, "
+	"  throttle_wait integer, client_time integer, "
+	"  mem_grant integer, parallel_workers integer, "
 	"  command text, "
 	"  unique(tableoid, partnum)"
 	")",
@@ -199,13 +225,72 @@ static char *sourceDBcreateTableDDLs[] = {
 	"  pid integer, "
 	"  tableoid integer references s_table(oid), "
 	"  start_time_epoch integer, done_time_epoch integer, duration integer, "
+	"  frozen bool, stats_imported bool, parallel_workers integer, "
+	"  command text, "
+	"  unique(tableoid)"
+	")",
+
+	"create table fkey_summary("
+	"  pid integer, "
+	"  conoid integer references s_fkey(oid), "
+	"  start_time_epoch integer, done_time_epoch integer, duration integer, "
+	"  command text, "
+	"  unique(conoid)"
+	")",
+
+	"create table summary_target("
+	"  tableoid integer references s_table(oid), "
+	"  partnum integer, "
+	"  target integer, "
+	"  pid integer, "
+	"  done_time_epoch integer, bytes integer, stalls integer, "
+	"  unique(tableoid, partnum, target)"
+	")",
+
+	"create table unlogged_summary("
+	"  pid integer, "
+	"  tableoid integer references s_table(oid), "
+	"  unlogged_time_epoch integer, "
+	"  start_time_epoch integer, done_time_epoch integer, duration integer, "
 	"  unique(tableoid)"
 	")",
 
+	"create table spool("
+	"  tableoid integer references s_table(oid), "
+	"  partnum integer, "
+	"  pid integer, "
+	"  segments integer, bytes integer, spool_time_epoch integer, "
+	"  drained integer, drain_time_epoch integer, pending_xid integer, "
+	"  unique(tableoid, partnum)"
+	")",
+
+	"create table chunk("
+	"  tableoid integer references s_table(oid), "
+	"  partnum integer, "
+	"  pid integer, "
+	"  position integer, chunks integer, bytes integer, "
+	"  done_time_epoch integer, "
+	"  hi integer, width integer, unbounded integer, "
+	"  pending_xid integer, pending_position integer, pending_last integer, "
+	"  unique(tableoid, partnum)"
+	")",
+
+	"create table concurrency_log("
+	"  id integer primary key, "
+	"  time_epoch integer, section text, action text, "
+	"  active integer, min_jobs integer, max_jobs integer, "
+	"  throughput integer, wait_ratio integer, reason text"
+	")",
+
 	"create table s_table_parts_done("
 	" tableoid integer primary key references s_table(oid), pid integer"
 	")",
 
+	"create table s_table_truncate("
+	" tableoid integer primary key references s_table(oid), pid integer, "
+	" state text"
+	")",
+
 	"create table s_table_indexes_done("
 	" tableoid integer primary key references s_table(oid), pid integer "
 	")",
@@ -391,10 +476,16 @@ static char *filterDBcreateTableDDLs[] = {
 	"  primary key(oid, attnum) "
 	")",
 
+	"create table s_table_copy_format("
+	"  oid integer primary key references s_table(oid), "
+	"  format text, reason text "
+	")",
+
 	"create table s_table_part("
 	"  oid integer references s_table(oid), "
 	"  partnum integer, partcount integer, "
-	"  min integer, max integer, count integer, "
+	"  min integer, max integer, count integer, est_rows integer, "
+	"  min_key text, max_key text, "
 	"  primary key(oid, partnum) "
 	")",
 
@@ -407,7 +498,8 @@ static char *filterDBcreateTableDDLs[] = {
 	"  oid integer primary key, "
 	"  qname text, nspname text, relname text, restore_list_name text, "
 	"  tableoid references s_table(oid), "
-	"  isprimary bool, isunique bool, columns text, sql text "
+	"  isprimary bool, isunique bool, columns text, sql text, "
+	"  bytes integer "
 	")",
 
 	"create table s_constraint("
@@ -492,6 +584,14 @@ static char *filterDBcreateTableDDLs[] = {
 	"  extoid integer, "
 	"  start_time_epoch integer, done_time_epoch integer, duration integer, "
 	"  bytes integer, "
+	"  ring_depth integer, ring_samples integer, ring_occupancy integer, "
+	"  ring_full integer, ring_empty integer, "
+	"  wal_skipped bool, frozen bool, "
+	"  retries integer, retry_duration integer, "
+	"  copy_rows integer, copy_messages integer, "
+	"  src_wait integer, dst_wait integer, "
+	"  throttle_wait integer, client_time integer, "
+	"  mem_grant integer, parallel_workers integer, "
 	"  command text, "
 	"  unique(tableoid, partnum)"
 	")",
@@ -563,7 +663,8 @@ static char *targetDBcreateTableDDLs[] = {
 	"  oid integer primary key, "
 	"  qname text, nspname text, relname text, restore_list_name text, "
 	"  tableoid integer references s_table(oid), "
-	"  isprimary bool, isunique bool, columns text, sql text "
+	"  isprimary bool, isunique bool, columns text, sql text, "
+	"  bytes integer "
 	")",
 
 	"create table s_constraint("
@@ -664,11 +765,14 @@ static char *sourceDBdropDDLs[] = {
 	"drop table if exists s_table",
 	"drop table if exists s_matview",
 	"drop table if exists s_attr",
+	"drop table if exists s_table_copy_format",
 	"drop table if exists s_table_part",
 	"drop table if exists s_table_chksum",
 	"drop table if exists s_table_size",
 	"drop table if exists s_index",
 	"drop table if exists s_constraint",
+	"drop table if exists s_fkey",
+	"drop table if exists s_table_pg_stats",
 	"drop table if exists s_seq",
 	"drop table if exists s_depend",
 
@@ -679,7 +783,14 @@ static char *sourceDBdropDDLs[] = {
 
 	"drop table if exists process",
 	"drop table if exists summary",
+	"drop table if exists fkey_summary",
+	"drop table if exists summary_target",
+	"drop table if exists spool",
+	"drop table if exists chunk",
+	"drop table if exists concurrency_log",
+	"drop table if exists unlogged_summary",
 	"drop table if exists s_table_parts_done",
+	"drop table if exists s_table_truncate",
 	"drop table if exists s_table_indexes_done",
 
 	"drop table if exists sentinel",
@@ -702,6 +813,7 @@ static char *filterDBdropDDLs[] = {
 	"drop table if exists s_table",
 	"drop table if exists s_matview",
 	"drop table if exists s_attr",
+	"drop table if exists s_table_copy_format",
 	"drop table if exists s_table_part",
 	"drop table if exists s_table_chksum",
 	"drop table if exists s_table_size",
@@ -1075,6 +1187,23 @@ catalog_register_setup_from_specs(CopyDataSpec *copySpecs)
 				return false;
 			}
 
+			/*
+			 * With --split-tables-larger-than auto, re-use the size threshold
+			 * that has been computed when the table-data cache was populated.
+			 */
+			if (tablePartsDataSection->fetched &&
+				copySpecs->splitTablesLargerThan.automatic &&
+				copySpecs->splitTablesLargerThan.bytes == 0)
+			{
+				SplitTableLargerThan *split = &(copySpecs->splitTablesLargerThan);
+
+				split->bytes = setup->splitTablesLargerThanBytes;
+
+				pretty_print_bytes(split->bytesPretty,
+								   sizeof(split->bytesPretty),
+								   split->bytes);
+			}
+
 			/*
 			 * Difference in --split-at is only meaningful if table-data cache
 			 * has already been populated.
@@ -3876,8 +4005,9 @@ catalog_add_s_table_part(DatabaseCatalog *catalog, SourceTable *table)
 	}
 
 	char *sql =
-		"insert into s_table_part(oid, partnum, partcount, min, max, count)"
-		"values($1, $2, $3, $4, $5, $6)";
+		"insert into s_table_part"
+		"(oid, partnum, partcount, min, max, count, est_rows, min_key, max_key)"
+		"values($1, $2, $3, $4, $5, $6, $7, $8, $9)";
 
 	SQLiteQuery query = { 0 };
 
@@ -3896,6 +4026,9 @@ catalog_add_s_table_part(DatabaseCatalog *catalog, SourceTable *table)
 		{ BIND_PARAMETER_TYPE_INT64, "min", part->min, NULL },
 		{ BIND_PARAMETER_TYPE_INT64, "max", part->max, NULL },
 		{ BIND_PARAMETER_TYPE_INT64, "count", part->count, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "est_rows", part->estRows, NULL },
+		{ BIND_PARAMETER_TYPE_TEXT, "min_key", 0, part->minKey },
+		{ BIND_PARAMETER_TYPE_TEXT, "max_key", 0, part->maxKey },
 	};
 
 	int count = sizeof(params) / sizeof(params[0]);
@@ -4418,6 +4551,36 @@ catalog_lookup_s_table(DatabaseCatalog *catalog,
 		return false;
 	}
 
+	/* tables split on a non-integer key also have typed key boundaries */
+	if (partNumber > 0)
+	{
+		SQLiteQuery keysQuery = {
+			.context = &(table->partition),
+			.fetchFunction = &catalog_s_table_part_keys_fetch
+		};
+
+		char *sql =
+			"select min_key, max_key "
+			"  from s_table_part "
+			" where oid = $1 and partnum = $2";
+
+		BindParam params[] = {
+			{ BIND_PARAMETER_TYPE_INT64, "oid", oid, NULL },
+			{ BIND_PARAMETER_TYPE_INT64, "partnum", partNumber, NULL }
+		};
+
+		int count = sizeof(params) / sizeof(params[0]);
+
+		if (!catalog_sql_prepare(db, sql, &keysQuery) ||
+			!catalog_sql_bind(&keysQuery, params, count) ||
+			!catalog_sql_execute_once(&keysQuery))
+		{
+			/* errors have already been logged */
+			(void) semaphore_unlock(&(catalog->sema));
+			return false;
+		}
+	}
+
 	(void) semaphore_unlock(&(catalog->sema));
 
 	return true;
@@ -4692,7 +4855,14 @@ catalog_iter_s_table_init(SourceTableIterator *iter)
 		"         coalesce(p.partnum, 0) as partnum, "
 		"         coalesce(p.min, 0) as min, coalesce(p.max, 0) as max, "
 		"         c.srcrowcount, c.srcsum, c.dstrowcount, c.dstsum, "
-		"         sum(s.duration), sum(s.bytes) "
+		"         sum(s.duration), sum(s.bytes), "
+		"         max(s.ring_depth), sum(s.ring_samples), "
+		"         sum(s.ring_occupancy), sum(s.ring_full), sum(s.ring_empty), "
+		"         sum(s.wal_skipped), "
+		"         sum(s.retries), sum(s.retry_duration), "
+		"         sum(s.copy_rows), sum(s.copy_messages), "
+		"         sum(s.src_wait), sum(s.dst_wait), "
+		"         sum(s.throttle_wait), sum(s.client_time) "
 		"    from s_table t "
 		"         left join s_table_part p on p.oid = t.oid "
 		"         left join s_table_chksum c on c.oid = t.oid "
@@ -4911,12 +5081,46 @@ catalog_s_table_fetch(SQLiteQuery *query)
 	}
 
 	/* summary information from s_table_parts_done */
-	if (cols == 23)
+	if (cols >= 23)
 	{
 		table->durationMs = sqlite3_column_int64(query->ppStmt, 21);
 		table->bytesTransmitted = sqlite3_column_int64(query->ppStmt, 22);
 	}
 
+	/* --use-copy-threads ring statistics, from the summary */
+	if (cols >= 28)
+	{
+		table->ringDepth = sqlite3_column_int(query->ppStmt, 23);
+		table->ringSamples = sqlite3_column_int64(query->ppStmt, 24);
+		table->ringOccupancy = sqlite3_column_int64(query->ppStmt, 25);
+		table->ringFull = sqlite3_column_int64(query->ppStmt, 26);
+		table->ringEmpty = sqlite3_column_int64(query->ppStmt, 27);
+	}
+
+	/* count of parts copied without writing WAL, from the summary */
+	if (cols >= 29)
+	{
+		table->walSkippedParts = sqlite3_column_int64(query->ppStmt, 28);
+	}
+
+	/* COPY retries and time lost to them, from the summary */
+	if (cols >= 31)
+	{
+		table->retries = sqlite3_column_int64(query->ppStmt, 29);
+		table->retryMs = sqlite3_column_int64(query->ppStmt, 30);
+	}
+
+	/* COPY wait-time attribution, from the summary */
+	if (cols == 37)
+	{
+		table->copyRows = sqlite3_column_int64(query->ppStmt, 31);
+		table->copyMessages = sqlite3_column_int64(query->ppStmt, 32);
+		table->srcWaitMs = sqlite3_column_int64(query->ppStmt, 33);
+		table->dstWaitMs = sqlite3_column_int64(query->ppStmt, 34);
+		table->throttleMs = sqlite3_column_int64(query->ppStmt, 35);
+		table->clientMs = sqlite3_column_int64(query->ppStmt, 36);
+	}
+
 	return true;
 }
 
@@ -5021,7 +5225,8 @@ catalog_iter_s_table_part_init(SourceTablePartsIterator *iter)
 	}
 
 	char *sql =
-		"  select partnum, partcount, min, max, count "
+		"  select partnum, partcount, min, max, count, est_rows, "
+		"         min_key, max_key "
 		"    from s_table_part "
 		"   where oid = $1 "
 		"order by partnum";
@@ -5096,11 +5301,55 @@ catalog_s_table_part_fetch(SQLiteQuery *query)
 	part->min = sqlite3_column_int64(query->ppStmt, 2);
 	part->max = sqlite3_column_int64(query->ppStmt, 3);
 	part->count = sqlite3_column_int64(query->ppStmt, 4);
+	part->estRows = sqlite3_column_int64(query->ppStmt, 5);
+
+	(void) catalog_s_table_part_keys_parse(query, 6, part);
+
+	return true;
+}
+
+
+/*
+ * catalog_s_table_part_keys_parse parses the typed key boundaries of a
+ * SourceTableParts entry from the given columns of a SQLite ppStmt result set.
+ */
+bool
+catalog_s_table_part_keys_parse(SQLiteQuery *query, int col,
+								SourceTableParts *part)
+{
+	if (sqlite3_column_type(query->ppStmt, col) != SQLITE_NULL)
+	{
+		part->typed = true;
+		strlcpy(part->minKey,
+				(char *) sqlite3_column_text(query->ppStmt, col),
+				sizeof(part->minKey));
+	}
+
+	if (sqlite3_column_type(query->ppStmt, col + 1) != SQLITE_NULL)
+	{
+		part->typed = true;
+		strlcpy(part->maxKey,
+				(char *) sqlite3_column_text(query->ppStmt, col + 1),
+				sizeof(part->maxKey));
+	}
 
 	return true;
 }
 
 
+/*
+ * catalog_s_table_part_keys_fetch is a SQLiteQuery fetch function for the
+ * typed key boundaries of a single table part.
+ */
+bool
+catalog_s_table_part_keys_fetch(SQLiteQuery *query)
+{
+	SourceTableParts *part = (SourceTableParts *) query->context;
+
+	return catalog_s_table_part_keys_parse(query, 0, part);
+}
+
+
 /*
  * catalog_iter_s_table_part_finish cleans-up the internal memory used for the
  * iteration.
@@ -5273,6 +5522,153 @@ catalog_s_table_all_binary_compatible(DatabaseCatalog *catalog,
 }
 
 
+/*
+ * Built-in types for which COPY BINARY is known to be much cheaper than COPY
+ * text: bytea avoids the hex encoding, numeric and the date/time types avoid
+ * parsing, and arrays of those avoid the array literal syntax.
+ */
+#define COPY_BINARY_FASTER_TYPES \
+	"17, 700, 701, 1082, 1083, 1114, 1184, 1186, 1266, 1700, 2950, " \
+	"1001, 1021, 1022, 1115, 1182, 1185, 1187, 1231, 2951"
+
+/*
+ * catalog_prepare_s_table_copy_format computes the COPY format to use for
+ * each table with --copy-format auto, using the type information in s_attr.
+ *
+ * COPY BINARY is only chosen when all the column types are built-in types
+ * with a safe binary format, and at least one of them is faster to process in
+ * binary. User-defined types, including extension types, are copied in text
+ * because their binary format may differ between source and target.
+ */
+bool
+catalog_prepare_s_table_copy_format(DatabaseCatalog *catalog)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: catalog_prepare_s_table_copy_format: db is NULL");
+		return false;
+	}
+
+	char *sql =
+		"insert or replace into s_table_copy_format(oid, format, reason) "
+		"     select oid, "
+		"            case when sum(not attisbinarycompatible) > 0 then 'text' "
+		"                 when sum(attypid >= 16384) > 0 then 'text' "
+		"                 when sum(attypid in (" COPY_BINARY_FASTER_TYPES ")) > 0 "
+		"                 then 'binary' "
+		"                 else 'text' "
+		"             end, "
+		"            case when sum(not attisbinarycompatible) > 0 "
+		"                 then 'unsafe binary format' "
+		"                 when sum(attypid >= 16384) > 0 "
+		"                 then 'user-defined type' "
+		"                 when sum(attypid in (" COPY_BINARY_FASTER_TYPES ")) > 0 "
+		"                 then 'faster in binary' "
+		"                 else 'no binary gain' "
+		"             end "
+		"       from s_attr "
+		"   group by oid";
+
+	if (!catalog_execute(catalog, sql))
+	{
+		log_error("Failed to compute the COPY format of tables, "
+				  "see above for details");
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * catalog_lookup_s_table_copy_format fetches the COPY format computed for the
+ * given table. The format is an empty string when it has not been computed.
+ */
+bool
+catalog_lookup_s_table_copy_format(DatabaseCatalog *catalog,
+								   uint32_t oid,
+								   SourceTableCopyFormat *copyFormat)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: catalog_lookup_s_table_copy_format: db is NULL");
+		return false;
+	}
+
+	char *sql =
+		"select oid, format, reason from s_table_copy_format where oid = $1";
+
+	SQLiteQuery query = {
+		.context = copyFormat,
+		.fetchFunction = &catalog_s_table_copy_format_fetch
+	};
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "oid", oid, NULL }
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* now execute the query, which return exactly one row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * catalog_s_table_copy_format_fetch fetches a SourceTableCopyFormat entry
+ * from a SQLite ppStmt result set.
+ */
+bool
+catalog_s_table_copy_format_fetch(SQLiteQuery *query)
+{
+	SourceTableCopyFormat *copyFormat = (SourceTableCopyFormat *) query->context;
+
+	/* cleanup the memory area before re-use */
+	bzero(copyFormat, sizeof(SourceTableCopyFormat));
+
+	copyFormat->oid = sqlite3_column_int64(query->ppStmt, 0);
+
+	if (sqlite3_column_type(query->ppStmt, 1) != SQLITE_NULL)
+	{
+		strlcpy(copyFormat->format,
+				(char *) sqlite3_column_text(query->ppStmt, 1),
+				sizeof(copyFormat->format));
+	}
+
+	if (sqlite3_column_type(query->ppStmt, 2) != SQLITE_NULL)
+	{
+		strlcpy(copyFormat->reason,
+				(char *) sqlite3_column_text(query->ppStmt, 2),
+				sizeof(copyFormat->reason));
+	}
+
+	return true;
+}
+
+
 /*
  * catalog_s_table_fetch_attrs fetches the table SourceTableAttribute array
  * from our s_attr catalog.
@@ -5512,8 +5908,8 @@ catalog_add_s_index(DatabaseCatalog *catalog, SourceIndex *index)
 	char *sql =
 		"insert into s_index("
 		"  oid, qname, nspname, relname, restore_list_name, tableoid, "
-		"  isprimary, isunique, columns, sql) "
-		"values($1, $2, $3, $4, $5, $6, $7, $8, $9, $10)";
+		"  isprimary, isunique, columns, sql, bytes) "
+		"values($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11)";
 
 	SQLiteQuery query = { 0 };
 
@@ -5541,7 +5937,8 @@ catalog_add_s_index(DatabaseCatalog *catalog, SourceIndex *index)
 		{ BIND_PARAMETER_TYPE_INT, "isunique", index->isUnique ? 1 : 0, NULL },
 
 		{ BIND_PARAMETER_TYPE_TEXT, "columns", 0, index->indexColumns },
-		{ BIND_PARAMETER_TYPE_TEXT, "sql", 0, index->indexDef }
+		{ BIND_PARAMETER_TYPE_TEXT, "sql", 0, index->indexDef },
+		{ BIND_PARAMETER_TYPE_INT64, "bytes", index->bytes, NULL }
 	};
 
 	int count = sizeof(params) / sizeof(params[0]);
@@ -5905,19 +6302,20 @@ catalog_add_s_index_batch(DatabaseCatalog *catalog,
 		appendPQExpBufferStr(&buf,
 							 "insert into s_index("
 							 "oid, qname, nspname, relname, restore_list_name, "
-							 "tableoid, isprimary, isunique, columns, sql) values");
+							 "tableoid, isprimary, isunique, columns, sql, "
+							 "bytes) values");
 
 		int paramIdx = 1;
 
 		for (int r = 0; r < rows; r++)
 		{
 			appendPQExpBuffer(&buf,
-							  "%s(?%d,?%d,?%d,?%d,?%d,?%d,?%d,?%d,?%d,?%d)",
+							  "%s(?%d,?%d,?%d,?%d,?%d,?%d,?%d,?%d,?%d,?%d,?%d)",
 							  r == 0 ? "" : ",",
 							  paramIdx, paramIdx + 1, paramIdx + 2,
 							  paramIdx + 3, paramIdx + 4, paramIdx + 5,
 							  paramIdx + 6, paramIdx + 7, paramIdx + 8,
-							  paramIdx + 9);
+							  paramIdx + 9, paramIdx + 10);
 			paramIdx += CATALOG_INSERT_NCOLS_S_INDEX;
 		}
 
@@ -5956,6 +6354,7 @@ catalog_add_s_index_batch(DatabaseCatalog *catalog,
 			sqlite3_bind_int(stmt, base + 7, idx->isUnique ? 1 : 0);
 			sqlite3_bind_text(stmt, base + 8, idx->indexColumns, -1, SQLITE_STATIC);
 			sqlite3_bind_text(stmt, base + 9, idx->indexDef, -1, SQLITE_STATIC);
+			sqlite3_bind_int64(stmt, base + 10, idx->bytes);
 		}
 
 		rc = sqlite3_step(stmt);
@@ -6142,7 +6541,7 @@ catalog_lookup_s_index(DatabaseCatalog *catalog, uint32_t oid, SourceIndex *inde
 		"         i.tableoid, t.qname, t.nspname, t.relname, "
 		"         isprimary, isunique, columns, i.sql, "
 		"         c.oid as constraintoid, conname, "
-		"         condeferrable, condeferred, c.sql as condef"
+		"         condeferrable, condeferred, c.sql as condef, i.bytes"
 		"    from s_index i "
 		"         join s_table t on t.oid = i.tableoid "
 		"         left join s_constraint c on c.indexoid = i.oid"
@@ -6214,7 +6613,7 @@ catalog_lookup_s_index_by_name(DatabaseCatalog *catalog,
 		"         i.tableoid, t.qname, t.nspname, t.relname, "
 		"         isprimary, isunique, columns, i.sql, "
 		"         c.oid as constraintoid, conname, "
-		"         condeferrable, condeferred, c.sql as condef"
+		"         condeferrable, condeferred, c.sql as condef, i.bytes"
 		"    from s_index i "
 		"         join s_table t on t.oid = i.tableoid "
 		"         left join s_constraint c on c.indexoid = i.oid"
@@ -6382,6 +6781,8 @@ catalog_s_index_fetch(SQLiteQuery *query)
 		}
 	}
 
+	index->bytes = sqlite3_column_int64(query->ppStmt, 18);
+
 	return true;
 }
 
@@ -6543,7 +6944,7 @@ catalog_iter_s_index_init(SourceIndexIterator *iter)
 		"         i.tableoid, t.qname, t.nspname, t.relname, "
 		"         isprimary, isunique, columns, i.sql, "
 		"         c.oid as constraintoid, conname, "
-		"         condeferrable, condeferred, c.sql as condef"
+		"         condeferrable, condeferred, c.sql as condef, i.bytes"
 		"    from s_index i "
 		"         join s_table t on t.oid = i.tableoid "
 		"		  left join s_table_size ts on ts.oid = i.tableoid"
@@ -6593,7 +6994,7 @@ catalog_iter_s_index_table_init(SourceIndexIterator *iter)
 		"         i.tableoid, t.qname, t.nspname, t.relname, "
 		"         isprimary, isunique, columns, i.sql, "
 		"         c.oid as constraintoid, conname, "
-		"         condeferrable, condeferred, c.sql as condef"
+		"         condeferrable, condeferred, c.sql as condef, i.bytes"
 		"    from s_index i "
 		"         join s_table t on t.oid = i.tableoid "
 		"         left join s_constraint c on c.indexoid = i.oid "
@@ -6760,62 +7161,683 @@ catalog_s_table_count_indexes_fetch(SQLiteQuery *query)
 
 
 /*
- * catalog_delete_s_index_all DELETE all the indexes registered in the given
- * database catalog.
+ * catalog_s_table_loaded_frozen sets frozen to true when all the parts of the
+ * given table have been loaded with COPY FREEZE, as registered in the summary
+ * table.
  */
 bool
-catalog_delete_s_index_all(DatabaseCatalog *catalog)
+catalog_s_table_loaded_frozen(DatabaseCatalog *catalog,
+							  SourceTable *table,
+							  bool *frozen)
 {
-	sqlite3 *db = catalog->db;
+	if (catalog->db == NULL)
+	{
+		log_error("BUG: catalog_s_table_loaded_frozen: db is NULL");
+		return false;
+	}
 
-	if (db == NULL)
+	char *sql =
+		"select count(*) > 0 and count(*) = sum(frozen) "
+		"  from summary "
+		" where tableoid = $1 and done_time_epoch is not null";
+
+	if (!semaphore_lock(&(catalog->sema)))
 	{
-		log_error("BUG: catalog_delete_s_index_all: db is NULL");
+		/* errors have already been logged */
 		return false;
 	}
 
-	char *sql = "delete from s_index";
+	SQLiteQuery query = {
+		.context = frozen,
+		.fetchFunction = &catalog_s_table_loaded_frozen_fetch
+	};
 
-	SQLiteQuery query = { 0 };
+	if (!catalog_sql_prepare(catalog->db, sql, &query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
 
-	if (!catalog_sql_prepare(db, sql, &query))
+	/* bind our parameters now */
+	BindParam params[1] = {
+		{ BIND_PARAMETER_TYPE_INT64, "oid", table->oid, NULL }
+	};
+
+	if (!catalog_sql_bind(&query, params, 1))
 	{
 		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
 		return false;
 	}
 
-	/* now execute the query, which does not return any row */
+	/* now execute the query, which return exactly one row */
 	if (!catalog_sql_execute_once(&query))
 	{
 		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
 		return false;
 	}
 
+	(void) semaphore_unlock(&(catalog->sema));
+
 	return true;
 }
 
 
 /*
- * catalog_add_s_seq INSERTs a SourceSequence to our internal catalogs database.
+ * catalog_s_table_loaded_frozen_fetch is a SQLiteQuery callback.
  */
 bool
-catalog_add_s_seq(DatabaseCatalog *catalog, SourceSequence *seq)
+catalog_s_table_loaded_frozen_fetch(SQLiteQuery *query)
 {
-	sqlite3 *db = catalog->db;
+	bool *frozen = (bool *) query->context;
 
-	if (db == NULL)
-	{
-		log_error("BUG: catalog_add_s_seq: db is NULL");
-		return false;
-	}
+	*frozen = sqlite3_column_int(query->ppStmt, 0) == 1;
 
-	char *sql =
-		"insert into s_seq("
-		"  oid, ownedby, attrelid, attroid, "
-		"  datname, qname, nspname, relname, restore_list_name)"
+	return true;
+}
+
+
+/*
+ * catalog_delete_s_index_all DELETE all the indexes registered in the given
+ * database catalog.
+ */
+bool
+catalog_delete_s_index_all(DatabaseCatalog *catalog)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: catalog_delete_s_index_all: db is NULL");
+		return false;
+	}
+
+	char *sql = "delete from s_index";
+
+	SQLiteQuery query = { 0 };
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* now execute the query, which does not return any row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * catalog_add_s_seq INSERTs a SourceSequence to our internal catalogs database.
+ */
+bool
+catalog_add_s_seq(DatabaseCatalog *catalog, SourceSequence *seq)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: catalog_add_s_seq: db is NULL");
+		return false;
+	}
+
+	char *sql =
+		"insert into s_seq("
+		"  oid, ownedby, attrelid, attroid, "
+		"  datname, qname, nspname, relname, restore_list_name)"
 		"values($1, $2, $3, $4, $5, $6, $7, $8, $9)";
 
-	SQLiteQuery query = { 0 };
+	SQLiteQuery query = { 0 };
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "oid", seq->oid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "ownedby", seq->ownedby, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "attrelid", seq->attrelid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "attroid", seq->attroid, NULL },
+
+		{ BIND_PARAMETER_TYPE_TEXT, "datname", 0, seq->datname },
+		{ BIND_PARAMETER_TYPE_TEXT, "qname", 0, seq->qname },
+		{ BIND_PARAMETER_TYPE_TEXT, "nspname", 0, seq->nspname },
+		{ BIND_PARAMETER_TYPE_TEXT, "relname", 0, seq->relname },
+
+		{
+			BIND_PARAMETER_TYPE_TEXT, "restore_list_name", 0,
+			seq->restoreListName
+		}
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* now execute the query, which does not return any row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * catalog_update_sequence_values UPDATEs a SourceSequence lastValue and
+ * isCalled parameters in our catalogs.
+ */
+bool
+catalog_update_sequence_values(DatabaseCatalog *catalog, SourceSequence *seq)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: catalog_update_sequence_values: db is NULL");
+		return false;
+	}
+
+	char *sql =
+		"update s_seq "
+		"   set last_value = $1, isCalled = $2 "
+		" where nspname = $3 and relname = $4";
+
+	SQLiteQuery query = { 0 };
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "last_alue", seq->lastValue, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "isCalled", seq->isCalled ? 1 : 0, NULL },
+		{ BIND_PARAMETER_TYPE_TEXT, "nspname", 0, seq->nspname },
+		{ BIND_PARAMETER_TYPE_TEXT, "relname", 0, seq->relname }
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* now execute the query, which does not return any row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * Updates the 'relpages' field of the 's_table' table in the database catalog with the given values.
+ */
+bool
+catalog_update_s_table_relpages(DatabaseCatalog *catalog, SourceTable *sourceTable)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: catalog_update_s_table_relpages: db is NULL");
+		return false;
+	}
+
+	char *sql =
+		"update s_table "
+		"   set relpages = $1 "
+		" where oid = $2";
+
+	SQLiteQuery query = { 0 };
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "relpages", sourceTable->relpages, NULL },
+		{ BIND_PARAMETER_TYPE_TEXT, "oid", sourceTable->oid, NULL },
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* now execute the query, which does not return any row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * catalog_update_s_table_part_key updates the partition key of the given
+ * table in our catalogs, used when the table is split on a unique key that
+ * the table listing query does not consider.
+ */
+bool
+catalog_update_s_table_part_key(DatabaseCatalog *catalog, SourceTable *sourceTable)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: catalog_update_s_table_part_key: db is NULL");
+		return false;
+	}
+
+	char *sql =
+		"update s_table "
+		"   set part_key = $1 "
+		" where oid = $2";
+
+	SQLiteQuery query = { 0 };
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_TEXT, "part_key", 0, sourceTable->partKey },
+		{ BIND_PARAMETER_TYPE_INT64, "oid", sourceTable->oid, NULL },
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* now execute the query, which does not return any row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * catalog_lookup_s_seq_by_name fetches a SourceSeq from our catalogs.
+ */
+bool
+catalog_lookup_s_seq_by_name(DatabaseCatalog *catalog,
+							 const char *nspname,
+							 const char *relname,
+							 SourceSequence *seq)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: catalog_s_seq_stats: db is NULL");
+		return false;
+	}
+
+	char *sql =
+		"  select oid, ownedby, attrelid, attroid, "
+		"         datname, qname, nspname, relname, restore_list_name, "
+		"         last_value, isCalled "
+		"    from s_seq "
+		"   where nspname = $1 and relname = $2 ";
+
+	SQLiteQuery query = {
+		.context = seq,
+		.fetchFunction = &catalog_s_seq_fetch
+	};
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_TEXT, "nspname", 0, (char *) nspname },
+		{ BIND_PARAMETER_TYPE_TEXT, "relname", 0, (char *) relname },
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* now execute the query, which return exactly one row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * catalog_iter_s_seq iterates over the list of sequences in our catalogs.
+ */
+bool
+catalog_iter_s_seq(DatabaseCatalog *catalog,
+				   void *context,
+				   SourceSequenceIterFun *callback)
+{
+	SourceSeqIterator *iter =
+		(SourceSeqIterator *) calloc(1, sizeof(SourceSeqIterator));
+
+	iter->catalog = catalog;
+
+	if (!catalog_iter_s_seq_init(iter))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	for (;;)
+	{
+		if (!catalog_iter_s_seq_next(iter))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+
+		SourceSequence *seq = iter->seq;
+
+		if (seq == NULL)
+		{
+			if (!catalog_iter_s_seq_finish(iter))
+			{
+				/* errors have already been logged */
+				return false;
+			}
+
+			break;
+		}
+
+		/* now call the provided callback */
+		if (!(*callback)(context, seq))
+		{
+			log_error("Failed to iterate over list of seqs, "
+					  "see above for details");
+			return false;
+		}
+	}
+
+
+	return true;
+}
+
+
+/*
+ * catalog_iter_s_seq_init initializes an Interator over our catalog of
+ * SourceSequence entries.
+ */
+bool
+catalog_iter_s_seq_init(SourceSeqIterator *iter)
+{
+	sqlite3 *db = iter->catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: Failed to initialize s_seq iterator: db is NULL");
+		return false;
+	}
+
+	iter->seq = (SourceSequence *) calloc(1, sizeof(SourceSequence));
+
+	if (iter->seq == NULL)
+	{
+		log_error(ALLOCATION_FAILED_ERROR);
+		return false;
+	}
+
+	char *sql =
+		"  select oid, ownedby, attrelid, attroid, "
+		"         datname, qname, nspname, relname, restore_list_name, "
+		"         last_value, isCalled "
+		"    from s_seq "
+		"order by nspname, relname";
+
+	SQLiteQuery *query = &(iter->query);
+
+	query->context = iter->seq;
+	query->fetchFunction = &catalog_s_seq_fetch;
+
+	if (!catalog_sql_prepare(db, sql, query))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * catalog_iter_s_seq_next fetches the next SourceSequence entry in our catalogs.
+ */
+bool
+catalog_iter_s_seq_next(SourceSeqIterator *iter)
+{
+	SQLiteQuery *query = &(iter->query);
+
+	int rc = catalog_sql_step(query);
+
+	if (rc == SQLITE_DONE)
+	{
+		iter->seq = NULL;
+
+		return true;
+	}
+
+	if (rc != SQLITE_ROW)
+	{
+		log_error("Failed to step through statement: %s", query->sql);
+		log_error("[SQLite] %s", sqlite3_errmsg(query->db));
+		return false;
+	}
+
+	return catalog_s_seq_fetch(query);
+}
+
+
+/*
+ * catalog_s_seq_fetch fetches a SourceSequence entry from a SQLite ppStmt
+ * result set.
+ */
+bool
+catalog_s_seq_fetch(SQLiteQuery *query)
+{
+	SourceSequence *seq = (SourceSequence *) query->context;
+
+	/* cleanup the memory area before re-use */
+	bzero(seq, sizeof(SourceSequence));
+
+	seq->oid = sqlite3_column_int64(query->ppStmt, 0);
+	seq->ownedby = sqlite3_column_int64(query->ppStmt, 1);
+	seq->attrelid = sqlite3_column_int64(query->ppStmt, 2);
+	seq->attroid = sqlite3_column_int64(query->ppStmt, 3);
+
+	if (sqlite3_column_type(query->ppStmt, 4) != SQLITE_NULL)
+	{
+		strlcpy(seq->datname,
+				(char *) sqlite3_column_text(query->ppStmt, 4),
+				sizeof(seq->datname));
+	}
+
+	strlcpy(seq->qname,
+			(char *) sqlite3_column_text(query->ppStmt, 5),
+			sizeof(seq->qname));
+
+	strlcpy(seq->nspname,
+			(char *) sqlite3_column_text(query->ppStmt, 6),
+			sizeof(seq->nspname));
+
+	strlcpy(seq->relname,
+			(char *) sqlite3_column_text(query->ppStmt, 7),
+			sizeof(seq->relname));
+
+	strlcpy(seq->restoreListName,
+			(char *) sqlite3_column_text(query->ppStmt, 8),
+			sizeof(seq->restoreListName));
+
+	seq->lastValue = sqlite3_column_int64(query->ppStmt, 9);
+	seq->isCalled = sqlite3_column_int(query->ppStmt, 10);
+
+	return true;
+}
+
+
+/*
+ * catalog_iter_s_seq_finish cleans-up the internal memory used for the
+ * iteration.
+ */
+bool
+catalog_iter_s_seq_finish(SourceSeqIterator *iter)
+{
+	SQLiteQuery *query = &(iter->query);
+
+	/* in case we finish before reaching the DONE step */
+	if (iter->seq != NULL)
+	{
+		iter->seq = NULL;
+	}
+
+	if (!catalog_sql_finalize(query))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * catalog_add_s_table_pg_stats INSERTs a SourceTablePgStats to our internal
+ * catalogs database.
+ */
+bool
+catalog_add_s_table_pg_stats(DatabaseCatalog *catalog, SourceTablePgStats *stats)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: catalog_add_s_table_pg_stats: db is NULL");
+		return false;
+	}
+
+	char *sql =
+		"insert or replace into s_table_pg_stats(oid, sql) values($1, $2)";
+
+	SQLiteQuery query = { 0 };
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "oid", stats->oid, NULL },
+		{ BIND_PARAMETER_TYPE_TEXT, "sql", 0, stats->sql }
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* now execute the query, which does not return any row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * catalog_lookup_s_table_pg_stats fetches the planner statistics of the given
+ * table from our catalogs. When the table has no statistics, stats->oid is
+ * zero and stats->sql is NULL.
+ */
+bool
+catalog_lookup_s_table_pg_stats(DatabaseCatalog *catalog,
+								uint32_t oid,
+								SourceTablePgStats *stats)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: catalog_lookup_s_table_pg_stats: db is NULL");
+		return false;
+	}
+
+	char *sql =
+		"  select oid, sql "
+		"    from s_table_pg_stats "
+		"   where oid = $1 ";
+
+	SQLiteQuery query = {
+		.context = stats,
+		.fetchFunction = &catalog_s_table_pg_stats_fetch
+	};
 
 	if (!catalog_sql_prepare(db, sql, &query))
 	{
@@ -6825,20 +7847,7 @@ catalog_add_s_seq(DatabaseCatalog *catalog, SourceSequence *seq)
 
 	/* bind our parameters now */
 	BindParam params[] = {
-		{ BIND_PARAMETER_TYPE_INT64, "oid", seq->oid, NULL },
-		{ BIND_PARAMETER_TYPE_INT64, "ownedby", seq->ownedby, NULL },
-		{ BIND_PARAMETER_TYPE_INT64, "attrelid", seq->attrelid, NULL },
-		{ BIND_PARAMETER_TYPE_INT64, "attroid", seq->attroid, NULL },
-
-		{ BIND_PARAMETER_TYPE_TEXT, "datname", 0, seq->datname },
-		{ BIND_PARAMETER_TYPE_TEXT, "qname", 0, seq->qname },
-		{ BIND_PARAMETER_TYPE_TEXT, "nspname", 0, seq->nspname },
-		{ BIND_PARAMETER_TYPE_TEXT, "relname", 0, seq->relname },
-
-		{
-			BIND_PARAMETER_TYPE_TEXT, "restore_list_name", 0,
-			seq->restoreListName
-		}
+		{ BIND_PARAMETER_TYPE_INT64, "oid", oid, NULL }
 	};
 
 	int count = sizeof(params) / sizeof(params[0]);
@@ -6849,7 +7858,7 @@ catalog_add_s_seq(DatabaseCatalog *catalog, SourceSequence *seq)
 		return false;
 	}
 
-	/* now execute the query, which does not return any row */
+	/* now execute the query, which return exactly one row */
 	if (!catalog_sql_execute_once(&query))
 	{
 		/* errors have already been logged */
@@ -6861,24 +7870,59 @@ catalog_add_s_seq(DatabaseCatalog *catalog, SourceSequence *seq)
 
 
 /*
- * catalog_update_sequence_values UPDATEs a SourceSequence lastValue and
- * isCalled parameters in our catalogs.
+ * catalog_s_table_pg_stats_fetch fetches a SourceTablePgStats entry from a
+ * SQLite ppStmt result set.
  */
 bool
-catalog_update_sequence_values(DatabaseCatalog *catalog, SourceSequence *seq)
+catalog_s_table_pg_stats_fetch(SQLiteQuery *query)
+{
+	SourceTablePgStats *stats = (SourceTablePgStats *) query->context;
+
+	/* cleanup the memory area before re-use */
+	free(stats->sql);
+	bzero(stats, sizeof(SourceTablePgStats));
+
+	stats->oid = sqlite3_column_int64(query->ppStmt, 0);
+
+	int len = sqlite3_column_bytes(query->ppStmt, 1);
+	int bytes = len + 1;
+
+	stats->sql = (char *) calloc(bytes, sizeof(char));
+
+	if (stats->sql == NULL)
+	{
+		log_fatal(ALLOCATION_FAILED_ERROR);
+		return false;
+	}
+
+	strlcpy(stats->sql,
+			(char *) sqlite3_column_text(query->ppStmt, 1),
+			bytes);
+
+	return true;
+}
+
+
+/*
+ * catalog_add_s_fkey INSERTs a SourceForeignKey to our internal catalogs
+ * database.
+ */
+bool
+catalog_add_s_fkey(DatabaseCatalog *catalog, SourceForeignKey *fkey)
 {
 	sqlite3 *db = catalog->db;
 
 	if (db == NULL)
 	{
-		log_error("BUG: catalog_update_sequence_values: db is NULL");
+		log_error("BUG: catalog_add_s_fkey: db is NULL");
 		return false;
 	}
 
 	char *sql =
-		"update s_seq "
-		"   set last_value = $1, isCalled = $2 "
-		" where nspname = $3 and relname = $4";
+		"insert or replace into s_fkey("
+		"  oid, conrelid, confrelid, qname, conname, convalidated, "
+		"  bytes, sql) "
+		"values($1, $2, $3, $4, $5, $6, $7, $8)";
 
 	SQLiteQuery query = { 0 };
 
@@ -6890,10 +7934,14 @@ catalog_update_sequence_values(DatabaseCatalog *catalog, SourceSequence *seq)
 
 	/* bind our parameters now */
 	BindParam params[] = {
-		{ BIND_PARAMETER_TYPE_INT64, "last_alue", seq->lastValue, NULL },
-		{ BIND_PARAMETER_TYPE_INT64, "isCalled", seq->isCalled ? 1 : 0, NULL },
-		{ BIND_PARAMETER_TYPE_TEXT, "nspname", 0, seq->nspname },
-		{ BIND_PARAMETER_TYPE_TEXT, "relname", 0, seq->relname }
+		{ BIND_PARAMETER_TYPE_INT64, "oid", fkey->oid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "conrelid", fkey->conrelid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "confrelid", fkey->confrelid, NULL },
+		{ BIND_PARAMETER_TYPE_TEXT, "qname", 0, fkey->qname },
+		{ BIND_PARAMETER_TYPE_TEXT, "conname", 0, fkey->conname },
+		{ BIND_PARAMETER_TYPE_INT, "convalidated", fkey->convalidated, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "bytes", fkey->bytes, NULL },
+		{ BIND_PARAMETER_TYPE_TEXT, "sql", 0, fkey->condef }
 	};
 
 	int count = sizeof(params) / sizeof(params[0]);
@@ -6916,25 +7964,32 @@ catalog_update_sequence_values(DatabaseCatalog *catalog, SourceSequence *seq)
 
 
 /*
- * Updates the 'relpages' field of the 's_table' table in the database catalog with the given values.
+ * catalog_lookup_s_fkey fetches a SourceForeignKey from our catalogs, given
+ * its oid. When the foreign key is not found, fkey->oid is zero.
  */
 bool
-catalog_update_s_table_relpages(DatabaseCatalog *catalog, SourceTable *sourceTable)
+catalog_lookup_s_fkey(DatabaseCatalog *catalog,
+					  uint32_t oid,
+					  SourceForeignKey *fkey)
 {
 	sqlite3 *db = catalog->db;
 
 	if (db == NULL)
 	{
-		log_error("BUG: catalog_update_s_table_relpages: db is NULL");
+		log_error("BUG: catalog_lookup_s_fkey: db is NULL");
 		return false;
 	}
 
 	char *sql =
-		"update s_table "
-		"   set relpages = $1 "
-		" where oid = $2";
+		"  select oid, conrelid, confrelid, qname, conname, convalidated, "
+		"         bytes, sql "
+		"    from s_fkey "
+		"   where oid = $1 ";
 
-	SQLiteQuery query = { 0 };
+	SQLiteQuery query = {
+		.context = fkey,
+		.fetchFunction = &catalog_s_fkey_fetch
+	};
 
 	if (!catalog_sql_prepare(db, sql, &query))
 	{
@@ -6944,8 +7999,7 @@ catalog_update_s_table_relpages(DatabaseCatalog *catalog, SourceTable *sourceTab
 
 	/* bind our parameters now */
 	BindParam params[] = {
-		{ BIND_PARAMETER_TYPE_INT64, "relpages", sourceTable->relpages, NULL },
-		{ BIND_PARAMETER_TYPE_TEXT, "oid", sourceTable->oid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "oid", oid, NULL }
 	};
 
 	int count = sizeof(params) / sizeof(params[0]);
@@ -6956,7 +8010,7 @@ catalog_update_s_table_relpages(DatabaseCatalog *catalog, SourceTable *sourceTab
 		return false;
 	}
 
-	/* now execute the query, which does not return any row */
+	/* now execute the query, which return exactly one row */
 	if (!catalog_sql_execute_once(&query))
 	{
 		/* errors have already been logged */
@@ -6968,33 +8022,23 @@ catalog_update_s_table_relpages(DatabaseCatalog *catalog, SourceTable *sourceTab
 
 
 /*
- * catalog_lookup_s_seq_by_name fetches a SourceSeq from our catalogs.
+ * catalog_s_fkey_set_restore registers that the given foreign key is to be
+ * created by pgcopydb rather than by pg_restore.
  */
 bool
-catalog_lookup_s_seq_by_name(DatabaseCatalog *catalog,
-							 const char *nspname,
-							 const char *relname,
-							 SourceSequence *seq)
+catalog_s_fkey_set_restore(DatabaseCatalog *catalog, uint32_t oid)
 {
 	sqlite3 *db = catalog->db;
 
 	if (db == NULL)
 	{
-		log_error("BUG: catalog_s_seq_stats: db is NULL");
+		log_error("BUG: catalog_s_fkey_set_restore: db is NULL");
 		return false;
 	}
 
-	char *sql =
-		"  select oid, ownedby, attrelid, attroid, "
-		"         datname, qname, nspname, relname, restore_list_name, "
-		"         last_value, isCalled "
-		"    from s_seq "
-		"   where nspname = $1 and relname = $2 ";
+	char *sql = "update s_fkey set restore = true where oid = $1";
 
-	SQLiteQuery query = {
-		.context = seq,
-		.fetchFunction = &catalog_s_seq_fetch
-	};
+	SQLiteQuery query = { 0 };
 
 	if (!catalog_sql_prepare(db, sql, &query))
 	{
@@ -7004,8 +8048,7 @@ catalog_lookup_s_seq_by_name(DatabaseCatalog *catalog,
 
 	/* bind our parameters now */
 	BindParam params[] = {
-		{ BIND_PARAMETER_TYPE_TEXT, "nspname", 0, (char *) nspname },
-		{ BIND_PARAMETER_TYPE_TEXT, "relname", 0, (char *) relname },
+		{ BIND_PARAMETER_TYPE_INT64, "oid", oid, NULL }
 	};
 
 	int count = sizeof(params) / sizeof(params[0]);
@@ -7016,7 +8059,7 @@ catalog_lookup_s_seq_by_name(DatabaseCatalog *catalog,
 		return false;
 	}
 
-	/* now execute the query, which return exactly one row */
+	/* now execute the query, which does not return any row */
 	if (!catalog_sql_execute_once(&query))
 	{
 		/* errors have already been logged */
@@ -7028,19 +8071,29 @@ catalog_lookup_s_seq_by_name(DatabaseCatalog *catalog,
 
 
 /*
- * catalog_iter_s_seq iterates over the list of sequences in our catalogs.
+ * catalog_iter_s_fkey iterates over the foreign keys that pgcopydb creates,
+ * largest referencing table first, and grouped by referencing table. When
+ * conrelid is not zero, only the foreign keys of that table are considered.
  */
 bool
-catalog_iter_s_seq(DatabaseCatalog *catalog,
-				   void *context,
-				   SourceSequenceIterFun *callback)
+catalog_iter_s_fkey(DatabaseCatalog *catalog,
+					uint32_t conrelid,
+					void *context,
+					SourceFKeyIterFun *callback)
 {
-	SourceSeqIterator *iter =
-		(SourceSeqIterator *) calloc(1, sizeof(SourceSeqIterator));
+	SourceFKeyIterator *iter =
+		(SourceFKeyIterator *) calloc(1, sizeof(SourceFKeyIterator));
+
+	if (iter == NULL)
+	{
+		log_error(ALLOCATION_FAILED_ERROR);
+		return false;
+	}
 
 	iter->catalog = catalog;
+	iter->conrelid = conrelid;
 
-	if (!catalog_iter_s_seq_init(iter))
+	if (!catalog_iter_s_fkey_init(iter))
 	{
 		/* errors have already been logged */
 		return false;
@@ -7048,17 +8101,17 @@ catalog_iter_s_seq(DatabaseCatalog *catalog,
 
 	for (;;)
 	{
-		if (!catalog_iter_s_seq_next(iter))
+		if (!catalog_iter_s_fkey_next(iter))
 		{
 			/* errors have already been logged */
 			return false;
 		}
 
-		SourceSequence *seq = iter->seq;
+		SourceForeignKey *fkey = iter->fkey;
 
-		if (seq == NULL)
+		if (fkey == NULL)
 		{
-			if (!catalog_iter_s_seq_finish(iter))
+			if (!catalog_iter_s_fkey_finish(iter))
 			{
 				/* errors have already been logged */
 				return false;
@@ -7068,53 +8121,55 @@ catalog_iter_s_seq(DatabaseCatalog *catalog,
 		}
 
 		/* now call the provided callback */
-		if (!(*callback)(context, seq))
+		if (!(*callback)(context, fkey))
 		{
-			log_error("Failed to iterate over list of seqs, "
+			log_error("Failed to iterate over list of foreign keys, "
 					  "see above for details");
 			return false;
 		}
 	}
 
+	free(iter);
 
 	return true;
 }
 
 
 /*
- * catalog_iter_s_seq_init initializes an Interator over our catalog of
- * SourceSequence entries.
+ * catalog_iter_s_fkey_init initializes an Interator over our catalog of
+ * SourceForeignKey entries.
  */
 bool
-catalog_iter_s_seq_init(SourceSeqIterator *iter)
+catalog_iter_s_fkey_init(SourceFKeyIterator *iter)
 {
 	sqlite3 *db = iter->catalog->db;
 
 	if (db == NULL)
 	{
-		log_error("BUG: Failed to initialize s_seq iterator: db is NULL");
+		log_error("BUG: Failed to initialize s_fkey iterator: db is NULL");
 		return false;
 	}
 
-	iter->seq = (SourceSequence *) calloc(1, sizeof(SourceSequence));
+	iter->fkey = (SourceForeignKey *) calloc(1, sizeof(SourceForeignKey));
 
-	if (iter->seq == NULL)
+	if (iter->fkey == NULL)
 	{
 		log_error(ALLOCATION_FAILED_ERROR);
 		return false;
 	}
 
 	char *sql =
-		"  select oid, ownedby, attrelid, attroid, "
-		"         datname, qname, nspname, relname, restore_list_name, "
-		"         last_value, isCalled "
-		"    from s_seq "
-		"order by nspname, relname";
+		"  select oid, conrelid, confrelid, qname, conname, convalidated, "
+		"         bytes, sql "
+		"    from s_fkey "
+		"   where restore "
+		"     and ($1 = 0 or conrelid = $1) "
+		"order by bytes desc, conrelid, oid";
 
 	SQLiteQuery *query = &(iter->query);
 
-	query->context = iter->seq;
-	query->fetchFunction = &catalog_s_seq_fetch;
+	query->context = iter->fkey;
+	query->fetchFunction = &catalog_s_fkey_fetch;
 
 	if (!catalog_sql_prepare(db, sql, query))
 	{
@@ -7122,15 +8177,28 @@ catalog_iter_s_seq_init(SourceSeqIterator *iter)
 		return false;
 	}
 
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "conrelid", iter->conrelid, NULL }
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(query, params, count))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
 	return true;
 }
 
 
 /*
- * catalog_iter_s_seq_next fetches the next SourceSequence entry in our catalogs.
+ * catalog_iter_s_fkey_next fetches the next SourceForeignKey entry in our
+ * catalogs.
  */
 bool
-catalog_iter_s_seq_next(SourceSeqIterator *iter)
+catalog_iter_s_fkey_next(SourceFKeyIterator *iter)
 {
 	SQLiteQuery *query = &(iter->query);
 
@@ -7138,7 +8206,9 @@ catalog_iter_s_seq_next(SourceSeqIterator *iter)
 
 	if (rc == SQLITE_DONE)
 	{
-		iter->seq = NULL;
+		free(iter->fkey->condef);
+		free(iter->fkey);
+		iter->fkey = NULL;
 
 		return true;
 	}
@@ -7150,70 +8220,72 @@ catalog_iter_s_seq_next(SourceSeqIterator *iter)
 		return false;
 	}
 
-	return catalog_s_seq_fetch(query);
+	return catalog_s_fkey_fetch(query);
 }
 
 
 /*
- * catalog_s_seq_fetch fetches a SourceSequence entry from a SQLite ppStmt
+ * catalog_s_fkey_fetch fetches a SourceForeignKey entry from a SQLite ppStmt
  * result set.
  */
 bool
-catalog_s_seq_fetch(SQLiteQuery *query)
+catalog_s_fkey_fetch(SQLiteQuery *query)
 {
-	SourceSequence *seq = (SourceSequence *) query->context;
+	SourceForeignKey *fkey = (SourceForeignKey *) query->context;
 
 	/* cleanup the memory area before re-use */
-	bzero(seq, sizeof(SourceSequence));
+	free(fkey->condef);
+	bzero(fkey, sizeof(SourceForeignKey));
 
-	seq->oid = sqlite3_column_int64(query->ppStmt, 0);
-	seq->ownedby = sqlite3_column_int64(query->ppStmt, 1);
-	seq->attrelid = sqlite3_column_int64(query->ppStmt, 2);
-	seq->attroid = sqlite3_column_int64(query->ppStmt, 3);
+	fkey->oid = sqlite3_column_int64(query->ppStmt, 0);
+	fkey->conrelid = sqlite3_column_int64(query->ppStmt, 1);
+	fkey->confrelid = sqlite3_column_int64(query->ppStmt, 2);
 
-	if (sqlite3_column_type(query->ppStmt, 4) != SQLITE_NULL)
-	{
-		strlcpy(seq->datname,
-				(char *) sqlite3_column_text(query->ppStmt, 4),
-				sizeof(seq->datname));
-	}
+	strlcpy(fkey->qname,
+			(char *) sqlite3_column_text(query->ppStmt, 3),
+			sizeof(fkey->qname));
 
-	strlcpy(seq->qname,
-			(char *) sqlite3_column_text(query->ppStmt, 5),
-			sizeof(seq->qname));
+	strlcpy(fkey->conname,
+			(char *) sqlite3_column_text(query->ppStmt, 4),
+			sizeof(fkey->conname));
 
-	strlcpy(seq->nspname,
-			(char *) sqlite3_column_text(query->ppStmt, 6),
-			sizeof(seq->nspname));
+	fkey->convalidated = sqlite3_column_int(query->ppStmt, 5) == 1;
+	fkey->bytes = sqlite3_column_int64(query->ppStmt, 6);
 
-	strlcpy(seq->relname,
-			(char *) sqlite3_column_text(query->ppStmt, 7),
-			sizeof(seq->relname));
+	int len = sqlite3_column_bytes(query->ppStmt, 7);
+	int bytes = len + 1;
 
-	strlcpy(seq->restoreListName,
-			(char *) sqlite3_column_text(query->ppStmt, 8),
-			sizeof(seq->restoreListName));
+	fkey->condef = (char *) calloc(bytes, sizeof(char));
 
-	seq->lastValue = sqlite3_column_int64(query->ppStmt, 9);
-	seq->isCalled = sqlite3_column_int(query->ppStmt, 10);
+	if (fkey->condef == NULL)
+	{
+		log_fatal(ALLOCATION_FAILED_ERROR);
+		return false;
+	}
+
+	strlcpy(fkey->condef,
+			(char *) sqlite3_column_text(query->ppStmt, 7),
+			bytes);
 
 	return true;
 }
 
 
 /*
- * catalog_iter_s_seq_finish cleans-up the internal memory used for the
+ * catalog_iter_s_fkey_finish cleans-up the internal memory used for the
  * iteration.
  */
 bool
-catalog_iter_s_seq_finish(SourceSeqIterator *iter)
+catalog_iter_s_fkey_finish(SourceFKeyIterator *iter)
 {
 	SQLiteQuery *query = &(iter->query);
 
 	/* in case we finish before reaching the DONE step */
-	if (iter->seq != NULL)
+	if (iter->fkey != NULL)
 	{
-		iter->seq = NULL;
+		free(iter->fkey->condef);
+		free(iter->fkey);
+		iter->fkey = NULL;
 	}
 
 	if (!catalog_sql_finalize(query))
@@ -10170,14 +11242,23 @@ catalog_delete_source_schema_data(DatabaseCatalog *catalog)
 	static char *sqls[] = {
 		/* delete in FK-safe order: dependents first, then referenced tables */
 		"delete from summary",
+		"delete from summary_target",
+		"delete from spool",
+		"delete from chunk",
+		"delete from unlogged_summary",
 		"delete from s_table_parts_done",
+		"delete from s_table_truncate",
 		"delete from s_table_indexes_done",
 		"delete from vacuum_summary",
+		"delete from fkey_summary",
 		"delete from s_table_chksum",
 		"delete from s_table_size",
+		"delete from s_table_copy_format",
 		"delete from s_table_part",
 		"delete from s_attr",
 		"delete from s_constraint",
+		"delete from s_fkey",
+		"delete from s_table_pg_stats",
 		"delete from s_index",
 		"delete from s_depend",
 		"delete from s_seq",
@@ -10392,7 +11473,16 @@ catalog_iter_s_table_in_copy_init(SourceTableIterator *iter)
 		"  select t.oid, t.datname, qname, nspname, relname, amname, restore_list_name, "
 		"         relpages, reltuples, ts.bytes, ts.bytes_pretty, "
 		"         exclude_data, part_key, "
-		"         part.partcount, s.partnum, part.min, part.max "
+		"         part.partcount, s.partnum, part.min, part.max, "
+		"         c.srcrowcount, c.srcsum, c.dstrowcount, c.dstsum, "
+		"         s.duration, s.bytes, "
+		"         s.ring_depth, s.ring_samples, "
+		"         s.ring_occupancy, s.ring_full, s.ring_empty, "
+		"         s.wal_skipped, "
+		"         s.retries, s.retry_duration, "
+		"         s.copy_rows, s.copy_messages, "
+		"         s.src_wait, s.dst_wait, "
+		"         s.throttle_wait, s.client_time "
 
 		"    from process p "
 		"         join s_table t on p.tableoid = t.oid "
@@ -10506,7 +11596,7 @@ catalog_iter_s_index_in_progress_init(SourceIndexIterator *iter)
 		"         i.tableoid, t.qname, t.nspname, t.relname, "
 		"         isprimary, isunique, columns, i.sql, "
 		"         c.oid as constraintoid, conname, "
-		"         condeferrable, condeferred, c.sql as condef"
+		"         condeferrable, condeferred, c.sql as condef, i.bytes"
 		"    from process p "
 		"         join s_index i on p.indexoid = i.oid "
 		"         join s_table t on t.oid = i.tableoid "
@@ -10634,7 +11724,12 @@ catalog_count_bytes(DatabaseCatalog *catalog, CatalogBytesCounts *count)
 		"    as done, "
 		"  coalesce((select sum(bytes) from summary"
 		"             where tableoid is not null and done_time_epoch is null), 0)"
-		"    as in_progress";
+		"    as in_progress, "
+		"  coalesce((select sum(t.bytes) from summary s"
+		"             join s_index i on i.oid = s.indexoid"
+		"             join s_table t on t.oid = i.tableoid"
+		"             where s.done_time_epoch is not null), 0)"
+		"    as indexed";
 
 	SQLiteQuery query = {
 		.context = count,
@@ -10671,6 +11766,79 @@ catalog_count_bytes_fetch(SQLiteQuery *query)
 	count->total = sqlite3_column_int64(query->ppStmt, 0);
 	count->done = sqlite3_column_int64(query->ppStmt, 1);
 	count->inProgress = sqlite3_column_int64(query->ppStmt, 2);
+	count->indexed = sqlite3_column_int64(query->ppStmt, 3);
+
+	return true;
+}
+
+
+/*
+ * catalog_add_concurrency_decision records a decision of the --adaptive-jobs
+ * controller in the concurrency_log table.
+ */
+bool
+catalog_add_concurrency_decision(DatabaseCatalog *catalog,
+								 CatalogConcurrencyDecision *decision)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: catalog_add_concurrency_decision: db is NULL");
+		return false;
+	}
+
+	char *sql =
+		"insert into concurrency_log(time_epoch, section, action, "
+		"  active, min_jobs, max_jobs, throughput, wait_ratio, reason) "
+		"values($1, $2, $3, $4, $5, $6, $7, $8, $9)";
+
+	if (!semaphore_lock(&(catalog->sema)))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	SQLiteQuery query = { 0 };
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "time_epoch", decision->timestamp, NULL },
+		{ BIND_PARAMETER_TYPE_TEXT, "section", 0, decision->section },
+		{ BIND_PARAMETER_TYPE_TEXT, "action", 0, decision->action },
+		{ BIND_PARAMETER_TYPE_INT, "active", decision->active, NULL },
+		{ BIND_PARAMETER_TYPE_INT, "min_jobs", decision->minJobs, NULL },
+		{ BIND_PARAMETER_TYPE_INT, "max_jobs", decision->maxJobs, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "throughput", decision->throughput, NULL },
+		{ BIND_PARAMETER_TYPE_INT, "wait_ratio", decision->waitRatio, NULL },
+		{ BIND_PARAMETER_TYPE_TEXT, "reason", 0, decision->reason }
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* now execute the query, which does not return any row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	(void) semaphore_unlock(&(catalog->sema));
 
 	return true;
 }
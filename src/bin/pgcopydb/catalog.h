@@ -18,7 +18,7 @@
  */
 #define CATALOG_INSERT_NCOLS_S_TABLE 11
 #define CATALOG_INSERT_NCOLS_S_ATTR 10
-#define CATALOG_INSERT_NCOLS_S_INDEX 10
+#define CATALOG_INSERT_NCOLS_S_INDEX 11
 #define CATALOG_INSERT_NCOLS_S_CONSTRAINT 6
 #define CATALOG_INSERT_NCOLS_S_SEQ 9
 
@@ -99,11 +99,17 @@ typedef enum
 	TIMING_SECTION_PREPARE_SCHEMA,
 	TIMING_SECTION_TOTAL_DATA,
 	TIMING_SECTION_COPY_DATA,
+	TIMING_SECTION_COPY_RETRY,
+	TIMING_SECTION_COPY_SRC_WAIT,
+	TIMING_SECTION_COPY_DST_WAIT,
+	TIMING_SECTION_COPY_CLIENT,
 	TIMING_SECTION_CREATE_INDEX,
 	TIMING_SECTION_ALTER_TABLE,
 	TIMING_SECTION_VACUUM,
+	TIMING_SECTION_SET_LOGGED,
 	TIMING_SECTION_SET_SEQUENCES,
 	TIMING_SECTION_LARGE_OBJECTS,
+	TIMING_SECTION_CONN_REUSE,
 	TIMING_SECTION_FINALIZE_SCHEMA,
 	TIMING_SECTION_TOTAL
 } TimingSection;
@@ -305,7 +311,15 @@ bool catalog_s_table_attrlist(DatabaseCatalog *catalog, SourceTable *table);
 bool catalog_s_table_all_binary_compatible(DatabaseCatalog *catalog,
 										   SourceTable *table,
 										   bool *allCompatible);
+bool catalog_prepare_s_table_copy_format(DatabaseCatalog *catalog);
+bool catalog_lookup_s_table_copy_format(DatabaseCatalog *catalog,
+										uint32_t oid,
+										SourceTableCopyFormat *copyFormat);
+bool catalog_s_table_copy_format_fetch(SQLiteQuery *query);
 bool catalog_s_table_part_fetch(SQLiteQuery *query);
+bool catalog_s_table_part_keys_parse(SQLiteQuery *query, int col,
+									 SourceTableParts *part);
+bool catalog_s_table_part_keys_fetch(SQLiteQuery *query);
 
 bool catalog_s_table_fetch_attrlist(SQLiteQuery *query);
 
@@ -402,6 +416,12 @@ bool catalog_s_table_count_indexes(DatabaseCatalog *catalog,
 
 bool catalog_s_table_count_indexes_fetch(SQLiteQuery *query);
 
+bool catalog_s_table_loaded_frozen(DatabaseCatalog *catalog,
+								   SourceTable *table,
+								   bool *frozen);
+
+bool catalog_s_table_loaded_frozen_fetch(SQLiteQuery *query);
+
 typedef struct SourceIndexIterator
 {
 	DatabaseCatalog *catalog;
@@ -426,6 +446,7 @@ bool catalog_s_index_fetch(SQLiteQuery *query);
 bool catalog_add_s_seq(DatabaseCatalog *catalog, SourceSequence *index);
 bool catalog_update_sequence_values(DatabaseCatalog *catalog, SourceSequence *seq);
 bool catalog_update_s_table_relpages(DatabaseCatalog *catalog, SourceTable *sourceTable);
+bool catalog_update_s_table_part_key(DatabaseCatalog *catalog, SourceTable *sourceTable);
 
 typedef bool (SourceSequenceIterFun)(void *context, SourceSequence *seq);
 
@@ -451,6 +472,46 @@ bool catalog_iter_s_seq_finish(SourceSeqIterator *iter);
 
 bool catalog_s_seq_fetch(SQLiteQuery *query);
 
+/*
+ * Planner statistics
+ */
+bool catalog_add_s_table_pg_stats(DatabaseCatalog *catalog,
+								  SourceTablePgStats *stats);
+bool catalog_lookup_s_table_pg_stats(DatabaseCatalog *catalog,
+									 uint32_t oid,
+									 SourceTablePgStats *stats);
+bool catalog_s_table_pg_stats_fetch(SQLiteQuery *query);
+
+/*
+ * Foreign keys
+ */
+bool catalog_add_s_fkey(DatabaseCatalog *catalog, SourceForeignKey *fkey);
+bool catalog_lookup_s_fkey(DatabaseCatalog *catalog,
+						   uint32_t oid,
+						   SourceForeignKey *fkey);
+bool catalog_s_fkey_set_restore(DatabaseCatalog *catalog, uint32_t oid);
+
+typedef bool (SourceFKeyIterFun)(void *context, SourceForeignKey *fkey);
+
+bool catalog_iter_s_fkey(DatabaseCatalog *catalog,
+						 uint32_t conrelid,
+						 void *context,
+						 SourceFKeyIterFun *callback);
+
+typedef struct SourceFKeyIterator
+{
+	DatabaseCatalog *catalog;
+	SourceForeignKey *fkey;
+	SQLiteQuery query;
+	uint32_t conrelid;
+} SourceFKeyIterator;
+
+bool catalog_iter_s_fkey_init(SourceFKeyIterator *iter);
+bool catalog_iter_s_fkey_next(SourceFKeyIterator *iter);
+bool catalog_iter_s_fkey_finish(SourceFKeyIterator *iter);
+
+bool catalog_s_fkey_fetch(SQLiteQuery *query);
+
 /*
  * Filtering is done through a single table keyed by (catoid, oid) — the same
  * object identity scheme PostgreSQL uses in pg_depend (classid + objid).
@@ -710,12 +771,31 @@ typedef struct CatalogBytesCounts
 	uint64_t total;       /* sum of s_table.bytes (source catalog sizes) */
 	uint64_t done;        /* sum of summary.bytes for completed tables */
 	uint64_t inProgress;  /* sum of summary.bytes for in-progress tables (last flush) */
+	uint64_t indexed;     /* sum of s_table.bytes for each index built */
 } CatalogBytesCounts;
 
 bool catalog_count_bytes(DatabaseCatalog *catalog, CatalogBytesCounts *count);
 bool catalog_count_bytes_fetch(SQLiteQuery *query);
 
 
+/* a decision of the --adaptive-jobs controller, see concurrency.c */
+typedef struct CatalogConcurrencyDecision
+{
+	uint64_t timestamp;
+	char *section;
+	char *action;
+	int active;
+	int minJobs;
+	int maxJobs;
+	uint64_t throughput;  /* bytes per second */
+	int waitRatio;        /* percentage of target backends waiting */
+	char *reason;
+} CatalogConcurrencyDecision;
+
+bool catalog_add_concurrency_decision(DatabaseCatalog *catalog,
+									  CatalogConcurrencyDecision *decision);
+
+
 /*
  * Logical decoding
  */
@@ -0,0 +1,1294 @@
+/*
+ * src/bin/pgcopydb/chunks.c
+ *	 Implementation of the --copy-chunk-size option: the COPY of a table (or
+ *	 table part) is split in a series of chunks, each committed on the target
+ *	 database in its own transaction, so that a retry or a --resume restarts
+ *	 from the last committed chunk rather than from the start of the table.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "catalog.h"
+#include "copydb.h"
+#include "log.h"
+#include "signals.h"
+#include "string_utils.h"
+#include "summary.h"
+
+
+/*
+ * Idle workers only split parts that have at least that many chunks left to
+ * copy, counting the chunk in flight, see chunk_steal.
+ */
+#define CHUNK_STEAL_MIN_CHUNKS 3
+
+
+/*
+ * A chunk plan covers the range of positions [lo, hi) of a table part, either
+ * as block numbers (ctid ranges) or as values of the integer part key. When
+ * the plan is unbounded, the last chunk has no upper bound, so that rows
+ * found past our estimate of hi are still copied.
+ */
+typedef struct ChunkPlan
+{
+	bool byCtid;
+	char partKey[PG_NAMEDATALEN];
+
+	int64_t lo;
+	int64_t hi;
+	bool unbounded;
+
+	int64_t width;              /* chunk width, in blocks or key values */
+} ChunkPlan;
+
+
+/*
+ * Progress reporting uses the bytes sent in all the chunks so far, where
+ * each pg_copy_fanout call only knows about the current chunk.
+ */
+typedef struct ChunkStatsContext
+{
+	void *context;
+	CopyStatsCallback *callback;
+	uint64_t bytesOffset;
+	CopyStats *tableStats;      /* previous chunks statistics */
+} ChunkStatsContext;
+
+
+static bool copydb_chunk_plan(CopyDataSpec *specs, PGSQL *src,
+							  CopyTableDataSpec *tableSpecs,
+							  ChunkPlan *plan);
+
+static void copydb_chunk_where_clause(ChunkPlan *plan,
+									  int64_t pos, int64_t next, bool last,
+									  char *where, size_t size);
+
+static bool copydb_chunk_stats_hook(void *ctx, CopyStats *stats);
+
+static bool copydb_chunk_resume(PGSQL *dst, DatabaseCatalog *catalog,
+								CopyChunk *chunk);
+static bool copydb_chunk_begin(void *context, uint64_t xid);
+
+/*
+ * The begin context registers the target transaction id of each chunk before
+ * sending its data, see copydb_copy_table_chunks.
+ */
+typedef struct ChunkBeginContext
+{
+	DatabaseCatalog *catalog;
+	CopyChunk *chunk;
+} ChunkBeginContext;
+
+/*
+ * The table part with the most chunks left to copy, as found by chunk_steal.
+ */
+typedef struct ChunkStealContext
+{
+	CopyChunk chunk;
+	int partCount;
+	int64_t min;
+	int64_t estRows;
+	char qname[PG_NAMEDATALEN_FQ];
+} ChunkStealContext;
+
+
+static bool chunk_fetch(SQLiteQuery *query);
+static bool chunk_steal_fetch(SQLiteQuery *query);
+static bool chunk_progress_fetch(SQLiteQuery *query);
+
+
+/*
+ * copydb_copy_table_use_chunks returns true when the COPY of the given table
+ * (or table part) is split in chunks.
+ */
+bool
+copydb_copy_table_use_chunks(CopyDataSpec *specs, CopyTableDataSpec *tableSpecs)
+{
+	SourceTable *table = tableSpecs->sourceTable;
+	CopyTableDataPartSpec *part = &(tableSpecs->part);
+
+	if (specs->copyChunkSize == 0)
+	{
+		return false;
+	}
+
+	/* chunks are committed and tracked on a single target database */
+	if (specs->useSpool || specs->connStrings.fanoutCount > 0)
+	{
+		return false;
+	}
+
+	/* ctid ranges are only meaningful for heap tables */
+	if (!streq(table->amname, "heap"))
+	{
+		return false;
+	}
+
+	/* chunk positions are block numbers or integer key values */
+	if (part->typed)
+	{
+		return false;
+	}
+
+	/* the NULL values part of a key split can not be chunked */
+	if (part->partCount > 1 &&
+		!streq(part->partKey, "ctid") &&
+		part->min == -1 &&
+		part->max == -1)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * copydb_copy_table_chunks copies the given table (or table part) one chunk
+ * at a time. Each chunk is a COPY in its own transaction on the target, and
+ * once it has been committed we register the next position to copy from in
+ * our catalogs. When called again, either on retry or with --resume, the COPY
+ * restarts from that position.
+ */
+bool
+copydb_copy_table_chunks(CopyDataSpec *specs, PGSQL *src, PGSQL *dst,
+						 CopyTableDataSpec *tableSpecs,
+						 CopyStats *stats,
+						 void *context,
+						 CopyStatsCallback *callback)
+{
+	DatabaseCatalog *sourceDB = &(specs->catalogs.source);
+	SourceTable *table = tableSpecs->sourceTable;
+
+	CopyChunk chunk = {
+		.oid = table->oid,
+		.partNumber = tableSpecs->part.partNumber
+	};
+
+	if (!chunk_lookup_table(sourceDB, &chunk) ||
+		!copydb_chunk_resume(dst, sourceDB, &chunk))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	stats->startTime = time(NULL);
+	stats->bytesTransmitted = chunk.bytes;
+
+	if (chunk.doneTime > 0)
+	{
+		log_info("Table %s COPY is already done, %d chunks have been "
+				 "committed already",
+				 table->qname,
+				 chunk.chunks);
+		return true;
+	}
+
+	ChunkPlan plan = { 0 };
+
+	if (!copydb_chunk_plan(specs, src, tableSpecs, &plan))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	int64_t pos = plan.lo;
+
+	if (chunk.chunks > 0)
+	{
+		pos = chunk.position;
+
+		log_info("Resuming COPY of table %s at %s %lld, "
+				 "after %d chunks already committed",
+				 table->qname,
+				 plan.byCtid ? "block" : plan.partKey,
+				 (long long) pos,
+				 chunk.chunks);
+	}
+
+	/* publish our plan, so that idle workers may split it */
+	chunk.pid = getpid();
+	chunk.position = pos;
+	chunk.hi = plan.hi;
+	chunk.width = plan.width;
+	chunk.unbounded = plan.unbounded;
+
+	if (!chunk_register_plan(sourceDB, &chunk))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	ChunkStatsContext chunkContext = {
+		.context = context,
+		.callback = callback,
+		.bytesOffset = chunk.bytes,
+		.tableStats = stats
+	};
+
+	ChunkBeginContext beginContext = {
+		.catalog = sourceDB,
+		.chunk = &chunk
+	};
+
+	for (;;)
+	{
+		int64_t next = pos + plan.width;
+		bool last = next >= plan.hi;
+
+		/* a bounded plan might be done already */
+		if (!plan.unbounded && pos >= plan.hi)
+		{
+			break;
+		}
+
+		char where[BUFSIZE] = { 0 };
+		char command[BUFSIZE] = { 0 };
+
+		(void) copydb_chunk_where_clause(&plan, pos, next, last,
+										 where, sizeof(where));
+
+		sformat(command, sizeof(command), "COPY %s %s", table->qname, where);
+
+		/*
+		 * Only the first chunk may TRUNCATE the target table, the next
+		 * chunks add to the data that's already been committed.
+		 */
+		CopyArgs args = tableSpecs->copyArgs;
+
+		args.srcWhereClause = where;
+		args.logCommand = command;
+
+		if (chunk.chunks > 0)
+		{
+			args.truncate = false;
+			args.freeze = false;
+		}
+
+		pos = last ? (plan.hi > next ? plan.hi : next) : next;
+
+		chunk.pendingPosition = pos;
+		chunk.pendingLast = last;
+
+		args.beginCallback = &copydb_chunk_begin;
+		args.beginContext = &beginContext;
+
+		CopyStats chunkStats = { 0 };
+
+		if (!pg_copy_fanout(src, &dst, 1, &args, &chunkStats,
+							&chunkContext, &copydb_chunk_stats_hook))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+
+		chunk.pid = getpid();
+		chunk.position = pos;
+		chunk.chunks += 1;
+		chunk.bytes += chunkStats.bytesTransmitted;
+		chunk.doneTime = last ? time(NULL) : 0;
+		chunk.pendingXid = 0;
+
+		if (!chunk_update_table(sourceDB, &chunk))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+
+		chunkContext.bytesOffset = chunk.bytes;
+
+		/* publish the whole table statistics */
+		stats->bytesTransmitted = chunk.bytes;
+		stats->targetCount = chunkStats.targetCount;
+		stats->targets[0] = chunkStats.targets[0];
+		stats->targets[0].bytesTransmitted = chunk.bytes;
+
+		stats->ringDepth = chunkStats.ringDepth;
+		stats->ringSamples += chunkStats.ringSamples;
+		stats->ringOccupancy += chunkStats.ringOccupancy;
+		stats->ringFull += chunkStats.ringFull;
+		stats->ringEmpty += chunkStats.ringEmpty;
+
+		stats->rows += chunkStats.rows;
+		stats->messages += chunkStats.messages;
+		stats->srcWaitUs += chunkStats.srcWaitUs;
+		stats->dstWaitUs += chunkStats.dstWaitUs;
+		stats->throttleUs += chunkStats.throttleUs;
+		stats->clientUs += chunkStats.clientUs;
+
+		if (last)
+		{
+			break;
+		}
+
+		/*
+		 * An idle worker might have split off the end of our range in the
+		 * meantime, in which case we stop where the new part begins.
+		 */
+		CopyChunk current = {
+			.oid = chunk.oid,
+			.partNumber = chunk.partNumber
+		};
+
+		if (!chunk_lookup_table(sourceDB, &current))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+
+		if (current.hi > 0 && current.hi < plan.hi)
+		{
+			log_info("Table %s COPY now stops at %s %lld, "
+					 "the rest has been split off to another worker",
+					 table->qname,
+					 plan.byCtid ? "block" : plan.partKey,
+					 (long long) current.hi);
+
+			plan.hi = current.hi;
+			plan.unbounded = false;
+		}
+	}
+
+	log_info("Table %s COPY done in %d chunks",
+			 table->qname,
+			 chunk.chunks);
+
+	return true;
+}
+
+
+/*
+ * copydb_chunk_resume checks the target transaction of the chunk that was
+ * being sent when we were interrupted, if any. When that transaction has been
+ * committed the chunk is registered as done, otherwise it is sent again.
+ */
+static bool
+copydb_chunk_resume(PGSQL *dst, DatabaseCatalog *catalog, CopyChunk *chunk)
+{
+	if (chunk->pendingXid == 0)
+	{
+		return true;
+	}
+
+	bool committed = false;
+
+	if (!pgsql_txid_committed(dst, chunk->pendingXid, &committed))
+	{
+		log_error("Failed to resume COPY of table with oid %u part %d",
+				  chunk->oid,
+				  chunk->partNumber);
+		return false;
+	}
+
+	if (committed)
+	{
+		log_info("Chunk %d of table with oid %u part %d has already been "
+				 "committed in transaction %lld",
+				 chunk->chunks + 1,
+				 chunk->oid,
+				 chunk->partNumber,
+				 (long long) chunk->pendingXid);
+
+		chunk->position = chunk->pendingPosition;
+		chunk->chunks += 1;
+		chunk->doneTime = chunk->pendingLast ? time(NULL) : 0;
+	}
+
+	chunk->pendingXid = 0;
+
+	return chunk_update_table(catalog, chunk);
+}
+
+
+/*
+ * copydb_chunk_begin is a CopyBeginCallback that registers the target
+ * transaction id of the chunk being sent, and the position to restart from
+ * once it is committed, before sending its data.
+ */
+static bool
+copydb_chunk_begin(void *context, uint64_t xid)
+{
+	ChunkBeginContext *beginContext = (ChunkBeginContext *) context;
+
+	beginContext->chunk->pendingXid = xid;
+
+	return chunk_update_table(beginContext->catalog, beginContext->chunk);
+}
+
+
+/*
+ * copydb_copy_steal_table_parts is called by a COPY worker once the queue of
+ * tables to copy is empty. Rather than exiting while other workers still have
+ * a long way to go on large table parts, the worker splits off the end of the
+ * part with the most chunks left, and copies it, until no such part is left.
+ */
+bool
+copydb_copy_steal_table_parts(CopyDataSpec *specs, PGSQL *src, PGSQL *dst,
+							  uint64_t *errors)
+{
+	DatabaseCatalog *sourceDB = &(specs->catalogs.source);
+
+	/* parts are split at chunk boundaries */
+	if (specs->copyChunkSize == 0 ||
+		specs->useSpool ||
+		specs->connStrings.fanoutCount > 0)
+	{
+		return true;
+	}
+
+	while (!(asked_to_stop || asked_to_stop_fast || asked_to_quit))
+	{
+		CopyChunk stolen = { 0 };
+		bool found = false;
+
+		if (!chunk_steal(sourceDB, &stolen, &found))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+
+		if (!found)
+		{
+			break;
+		}
+
+		if (!copydb_copy_data_by_oid(specs, src, dst,
+									 stolen.oid,
+									 stolen.partNumber))
+		{
+			log_error("Failed to copy data for table with oid %u "
+					  "and part number %d, see above for details",
+					  stolen.oid,
+					  stolen.partNumber);
+
+			++(*errors);
+
+			if (specs->failFast)
+			{
+				return false;
+			}
+
+			/* clean-up our target connection state for next table */
+			(void) copydb_close_snapshot(specs);
+
+			if (!copydb_set_snapshot(specs))
+			{
+				/* errors have already been logged */
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+/*
+ * copydb_chunk_plan computes the range of positions to copy for the given
+ * table part, and the width of each chunk in that range.
+ *
+ * Tables that are not split, and parts of a split by ctid, are chunked by
+ * ctid ranges of --copy-chunk-size worth of blocks. Parts of a split by an
+ * integer key are chunked by key ranges, so that each chunk still benefits
+ * from an index on the part key, and the number of chunks is estimated from
+ * the part size on-disk.
+ */
+static bool
+copydb_chunk_plan(CopyDataSpec *specs, PGSQL *src,
+				  CopyTableDataSpec *tableSpecs,
+				  ChunkPlan *plan)
+{
+	SourceTable *table = tableSpecs->sourceTable;
+	CopyTableDataPartSpec *part = &(tableSpecs->part);
+
+	/* get the block size from the source once and then memoize it */
+	static int blockSize = 0;
+
+	if (blockSize == 0 && !pgsql_get_block_size(src, &blockSize))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	int64_t relpages = 0;
+
+	if (!pgsql_get_relation_pages(src, table->qname, &relpages))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	int64_t chunkPages = ceil((double) specs->copyChunkSize / blockSize);
+
+	if (chunkPages < 1)
+	{
+		chunkPages = 1;
+	}
+
+	bool splitByKey = part->partCount > 1 && !streq(part->partKey, "ctid");
+
+	if (!splitByKey)
+	{
+		plan->byCtid = true;
+		plan->width = chunkPages;
+
+		if (part->partCount > 1)
+		{
+			/* the last part of a ctid split covers "extra" relpages */
+			plan->lo = part->min;
+			plan->hi = part->max == -1 ? relpages : part->max + 1;
+			plan->unbounded = part->max == -1;
+		}
+		else
+		{
+			plan->lo = 0;
+			plan->hi = relpages;
+			plan->unbounded = true;
+		}
+	}
+	else
+	{
+		plan->byCtid = false;
+		plan->lo = part->min;
+
+		strlcpy(plan->partKey, part->partKey, sizeof(plan->partKey));
+
+		if (part->max == -1)
+		{
+			/* the last part of a key split has no upper bound */
+			int64_t max = 0;
+			bool isNull = false;
+
+			if (!pgsql_get_column_max(src, table->qname, part->partKey,
+									  &max, &isNull))
+			{
+				/* errors have already been logged */
+				return false;
+			}
+
+			plan->hi = isNull ? plan->lo : max + 1;
+			plan->unbounded = true;
+		}
+		else
+		{
+			plan->hi = part->max + 1;
+			plan->unbounded = false;
+		}
+
+		int64_t partPages = relpages / part->partCount;
+		int64_t chunkCount = ceil((double) partPages / chunkPages);
+
+		if (chunkCount < 1)
+		{
+			chunkCount = 1;
+		}
+
+		plan->width = ceil((double) (plan->hi - plan->lo) / chunkCount);
+	}
+
+	if (plan->hi < plan->lo)
+	{
+		plan->hi = plan->lo;
+	}
+
+	if (plan->width < 1)
+	{
+		plan->width = 1;
+	}
+
+	log_debug("copydb_chunk_plan: %s %s [%lld, %lld%s by %lld",
+			  table->qname,
+			  plan->byCtid ? "ctid" : plan->partKey,
+			  (long long) plan->lo,
+			  (long long) plan->hi,
+			  plan->unbounded ? "+)" : ")",
+			  (long long) plan->width);
+
+	return true;
+}
+
+
+/*
+ * copydb_chunk_where_clause prepares the COPY WHERE clause for the chunk that
+ * starts at position pos.
+ */
+static void
+copydb_chunk_where_clause(ChunkPlan *plan,
+						  int64_t pos, int64_t next, bool last,
+						  char *where, size_t size)
+{
+	int64_t upper = next < plan->hi ? next : plan->hi;
+
+	if (plan->byCtid)
+	{
+		if (last && plan->unbounded)
+		{
+			sformat(where, size, "WHERE ctid >= '(%lld,0)'::tid",
+					(long long) pos);
+		}
+		else
+		{
+			sformat(where, size,
+					"WHERE ctid >= '(%lld,0)'::tid"
+					" and ctid < '(%lld,0)'::tid",
+					(long long) pos,
+					(long long) upper);
+		}
+	}
+	else
+	{
+		if (last && plan->unbounded)
+		{
+			sformat(where, size, "WHERE %s >= %lld",
+					plan->partKey,
+					(long long) pos);
+		}
+		else
+		{
+			sformat(where, size, "WHERE %s >= %lld AND %s < %lld",
+					plan->partKey,
+					(long long) pos,
+					plan->partKey,
+					(long long) upper);
+		}
+	}
+}
+
+
+/*
+ * copydb_chunk_stats_hook is a CopyStatsCallback that adds the bytes sent and
+ * the time spent in the previous chunks before calling the table COPY
+ * statistics callback.
+ */
+static bool
+copydb_chunk_stats_hook(void *ctx, CopyStats *stats)
+{
+	ChunkStatsContext *context = (ChunkStatsContext *) ctx;
+
+	if (context->callback == NULL)
+	{
+		return true;
+	}
+
+	CopyStats tableStats = *stats;
+
+	tableStats.bytesTransmitted += context->bytesOffset;
+
+	tableStats.rows += context->tableStats->rows;
+	tableStats.messages += context->tableStats->messages;
+	tableStats.srcWaitUs += context->tableStats->srcWaitUs;
+	tableStats.dstWaitUs += context->tableStats->dstWaitUs;
+	tableStats.throttleUs += context->tableStats->throttleUs;
+	tableStats.clientUs += context->tableStats->clientUs;
+
+	return (*context->callback)(context->context, &tableStats);
+}
+
+
+/*
+ * chunk_lookup_table fetches the chunk progress of the given table (part).
+ */
+bool
+chunk_lookup_table(DatabaseCatalog *catalog, CopyChunk *chunk)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: chunk_lookup_table: db is NULL");
+		return false;
+	}
+
+	char *sql =
+		"  select pid, position, chunks, bytes, done_time_epoch, "
+		"         hi, width, unbounded, "
+		"         pending_xid, pending_position, pending_last "
+		"    from chunk "
+		"   where tableoid = $1 and partnum = $2";
+
+	if (!semaphore_lock(&(catalog->sema)))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	SQLiteQuery query = {
+		.context = chunk,
+		.fetchFunction = &chunk_fetch
+	};
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", chunk->oid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "partnum", chunk->partNumber, NULL }
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* now execute the query, which return exactly one row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	(void) semaphore_unlock(&(catalog->sema));
+
+	return true;
+}
+
+
+/*
+ * chunk_fetch fetches a CopyChunk entry from a SQLite ppStmt result set.
+ */
+static bool
+chunk_fetch(SQLiteQuery *query)
+{
+	CopyChunk *chunk = (CopyChunk *) query->context;
+
+	chunk->pid = sqlite3_column_int64(query->ppStmt, 0);
+	chunk->position = sqlite3_column_int64(query->ppStmt, 1);
+	chunk->chunks = sqlite3_column_int(query->ppStmt, 2);
+	chunk->bytes = sqlite3_column_int64(query->ppStmt, 3);
+	chunk->doneTime = sqlite3_column_int64(query->ppStmt, 4);
+	chunk->hi = sqlite3_column_int64(query->ppStmt, 5);
+	chunk->width = sqlite3_column_int64(query->ppStmt, 6);
+	chunk->unbounded = sqlite3_column_int(query->ppStmt, 7) == 1;
+	chunk->pendingXid = sqlite3_column_int64(query->ppStmt, 8);
+	chunk->pendingPosition = sqlite3_column_int64(query->ppStmt, 9);
+	chunk->pendingLast = sqlite3_column_int(query->ppStmt, 10) == 1;
+
+	return true;
+}
+
+
+/*
+ * chunk_update_table registers the progress of the given table (part), and
+ * the chunk being sent to the target database, if any. The registered plan is
+ * left untouched, it belongs to chunk_register_plan and chunk_steal.
+ */
+bool
+chunk_update_table(DatabaseCatalog *catalog, CopyChunk *chunk)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: chunk_update_table: db is NULL");
+		return false;
+	}
+
+	char *sql =
+		"insert into chunk"
+		"(tableoid, partnum, pid, position, chunks, bytes, done_time_epoch, "
+		" pending_xid, pending_position, pending_last) "
+		"values($1, $2, $3, $4, $5, $6, $7, $8, $9, $10) "
+		"on conflict(tableoid, partnum) do update "
+		"set pid = excluded.pid, position = excluded.position, "
+		"    chunks = excluded.chunks, bytes = excluded.bytes, "
+		"    done_time_epoch = excluded.done_time_epoch, "
+		"    pending_xid = excluded.pending_xid, "
+		"    pending_position = excluded.pending_position, "
+		"    pending_last = excluded.pending_last";
+
+	if (!semaphore_lock(&(catalog->sema)))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	SQLiteQuery query = { 0 };
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", chunk->oid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "partnum", chunk->partNumber, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "pid", chunk->pid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "position", chunk->position, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "chunks", chunk->chunks, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "bytes", chunk->bytes, NULL },
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "done_time_epoch",
+			chunk->doneTime, NULL
+		},
+
+		{ BIND_PARAMETER_TYPE_INT64, "pending_xid", chunk->pendingXid, NULL },
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "pending_position",
+			chunk->pendingPosition, NULL
+		},
+
+		{ BIND_PARAMETER_TYPE_INT64, "pending_last", chunk->pendingLast, NULL }
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* now execute the query, which does not return any row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	(void) semaphore_unlock(&(catalog->sema));
+
+	return true;
+}
+
+
+/*
+ * chunk_register_plan registers the range of positions that the given table
+ * (part) COPY is going to process, and the width of its chunks.
+ */
+bool
+chunk_register_plan(DatabaseCatalog *catalog, CopyChunk *chunk)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: chunk_register_plan: db is NULL");
+		return false;
+	}
+
+	char *sql =
+		"insert into chunk"
+		"(tableoid, partnum, pid, position, chunks, bytes, done_time_epoch, "
+		" hi, width, unbounded) "
+		"values($1, $2, $3, $4, 0, 0, 0, $5, $6, $7) "
+		"on conflict(tableoid, partnum) do update "
+		"set pid = excluded.pid, position = excluded.position, "
+		"    hi = excluded.hi, width = excluded.width, "
+		"    unbounded = excluded.unbounded";
+
+	if (!semaphore_lock(&(catalog->sema)))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	SQLiteQuery query = { 0 };
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", chunk->oid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "partnum", chunk->partNumber, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "pid", chunk->pid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "position", chunk->position, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "hi", chunk->hi, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "width", chunk->width, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "unbounded", chunk->unbounded, NULL }
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* now execute the query, which does not return any row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	(void) semaphore_unlock(&(catalog->sema));
+
+	return true;
+}
+
+
+/*
+ * chunk_steal finds the table part that is being copied by another worker
+ * with the most chunks left to copy, and splits off the second half of what
+ * is left of it into a new table part, which the caller then copies.
+ *
+ * Only the range that the other worker has not started to copy yet is
+ * considered: it is copying the chunk that starts at its registered position,
+ * and the split happens at least one chunk after that. The other worker then
+ * reads its new upper bound after each chunk, see copydb_copy_table_chunks.
+ *
+ * The whole split happens in a single catalog transaction, while holding the
+ * catalog semaphore, so that two idle workers can not split the same range.
+ */
+bool
+chunk_steal(DatabaseCatalog *catalog, CopyChunk *stolen, bool *found)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: chunk_steal: db is NULL");
+		return false;
+	}
+
+	*found = false;
+
+	char *sql =
+		"  select c.tableoid, c.partnum, c.position, "
+		"         c.hi, c.width, c.unbounded, "
+		"         p.partcount, p.min, p.est_rows, t.qname "
+		"    from chunk c "
+		"         join process ps "
+		"           on ps.pid = c.pid "
+		"          and ps.tableoid = c.tableoid "
+		"          and ps.partnum = c.partnum "
+		"         join s_table_part p "
+		"           on p.oid = c.tableoid and p.partnum = c.partnum "
+		"         join s_table t on t.oid = c.tableoid "
+		"   where coalesce(c.done_time_epoch, 0) = 0 "
+		"     and c.width > 0 "
+		"     and c.hi - c.position >= $1 * c.width "
+		"order by (c.hi - c.position) / c.width desc "
+		"   limit 1";
+
+	if (!semaphore_lock(&(catalog->sema)))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	if (!catalog_begin(catalog, false))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	ChunkStealContext context = { 0 };
+
+	SQLiteQuery query = {
+		.context = &context,
+		.fetchFunction = &chunk_steal_fetch
+	};
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		(void) catalog_execute(catalog, "ROLLBACK");
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "chunks", CHUNK_STEAL_MIN_CHUNKS, NULL }
+	};
+
+	if (!catalog_sql_bind(&query, params, 1))
+	{
+		/* errors have already been logged */
+		(void) catalog_execute(catalog, "ROLLBACK");
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* now execute the query, which return at most one row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		(void) catalog_execute(catalog, "ROLLBACK");
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	if (context.chunk.oid == 0)
+	{
+		(void) catalog_execute(catalog, "ROLLBACK");
+		(void) semaphore_unlock(&(catalog->sema));
+		return true;
+	}
+
+	/*
+	 * Split what is left after the chunk in flight in two halves. The rows
+	 * estimate is shared in proportion of the ranges, computed in long double
+	 * because sparse bigint keys span ranges close to 2^63.
+	 */
+	CopyChunk *victim = &(context.chunk);
+
+	int64_t inflight = victim->position + victim->width;
+	int64_t mid = inflight + (victim->hi - inflight) / 2;
+
+	long double range = (long double) victim->hi - (long double) context.min;
+	long double share =
+		range > 0
+		? ((long double) mid - (long double) context.min) / range
+		: 0;
+
+	/* keep the estimate within [0, estRows] */
+	if (share < 0)
+	{
+		share = 0;
+	}
+	else if (share > 1)
+	{
+		share = 1;
+	}
+
+	int64_t victimRows = (int64_t) (share * (long double) context.estRows);
+
+	int newPartNumber = context.partCount + 1;
+
+	char *sqls[] = {
+		"update chunk set hi = $3, unbounded = 0 "
+		" where tableoid = $1 and partnum = $2",
+
+		"update s_table_part set max = $3 - 1, count = $3 - min, est_rows = $4 "
+		" where oid = $1 and partnum = $2",
+
+		"insert into s_table_part"
+		"(oid, partnum, partcount, min, max, count, est_rows) "
+		"values($1, $2, $5, $3, $4, $6, $7)",
+
+		"update s_table_part set partcount = $2 where oid = $1"
+	};
+
+	BindParam chunkParams[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", victim->oid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "partnum", victim->partNumber, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "hi", mid, NULL }
+	};
+
+	BindParam victimParams[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "oid", victim->oid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "partnum", victim->partNumber, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "mid", mid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "est_rows", victimRows, NULL }
+	};
+
+	BindParam partParams[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "oid", victim->oid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "partnum", newPartNumber, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "min", mid, NULL },
+		{
+			BIND_PARAMETER_TYPE_INT64, "max",
+			victim->unbounded ? -1 : victim->hi - 1, NULL
+		},
+		{ BIND_PARAMETER_TYPE_INT64, "partcount", newPartNumber, NULL },
+		{
+			BIND_PARAMETER_TYPE_INT64, "count",
+			victim->unbounded ? -1 : victim->hi - mid, NULL
+		},
+		{
+			BIND_PARAMETER_TYPE_INT64, "est_rows",
+			context.estRows - victimRows, NULL
+		}
+	};
+
+	BindParam countParams[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "oid", victim->oid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "partcount", newPartNumber, NULL }
+	};
+
+	BindParam *allParams[] = {
+		chunkParams, victimParams, partParams, countParams
+	};
+
+	int allCounts[] = {
+		sizeof(chunkParams) / sizeof(chunkParams[0]),
+		sizeof(victimParams) / sizeof(victimParams[0]),
+		sizeof(partParams) / sizeof(partParams[0]),
+		sizeof(countParams) / sizeof(countParams[0])
+	};
+
+	int count = sizeof(sqls) / sizeof(sqls[0]);
+
+	for (int i = 0; i < count; i++)
+	{
+		SQLiteQuery update = { 0 };
+
+		if (!catalog_sql_prepare(db, sqls[i], &update) ||
+			!catalog_sql_bind(&update, allParams[i], allCounts[i]) ||
+			!catalog_sql_execute_once(&update))
+		{
+			/* errors have already been logged */
+			(void) catalog_execute(catalog, "ROLLBACK");
+			(void) semaphore_unlock(&(catalog->sema));
+			return false;
+		}
+	}
+
+	if (!catalog_commit(catalog))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	(void) semaphore_unlock(&(catalog->sema));
+
+	log_info("Splitting table %s part %d at position %lld "
+			 "(%lld chunks left), new part %d",
+			 context.qname,
+			 victim->partNumber,
+			 (long long) mid,
+			 (long long) ((victim->hi - victim->position) / victim->width),
+			 newPartNumber);
+
+	stolen->oid = victim->oid;
+	stolen->partNumber = newPartNumber;
+
+	*found = true;
+
+	return true;
+}
+
+
+/*
+ * chunk_steal_fetch fetches the table part found by chunk_steal.
+ */
+static bool
+chunk_steal_fetch(SQLiteQuery *query)
+{
+	ChunkStealContext *context = (ChunkStealContext *) query->context;
+
+	context->chunk.oid = sqlite3_column_int64(query->ppStmt, 0);
+	context->chunk.partNumber = sqlite3_column_int(query->ppStmt, 1);
+	context->chunk.position = sqlite3_column_int64(query->ppStmt, 2);
+	context->chunk.hi = sqlite3_column_int64(query->ppStmt, 3);
+	context->chunk.width = sqlite3_column_int64(query->ppStmt, 4);
+	context->chunk.unbounded = sqlite3_column_int(query->ppStmt, 5) == 1;
+
+	context->partCount = sqlite3_column_int(query->ppStmt, 6);
+	context->min = sqlite3_column_int64(query->ppStmt, 7);
+	context->estRows = sqlite3_column_int64(query->ppStmt, 8);
+
+	if (sqlite3_column_type(query->ppStmt, 9) != SQLITE_NULL)
+	{
+		strlcpy(context->qname,
+				(char *) sqlite3_column_text(query->ppStmt, 9),
+				sizeof(context->qname));
+	}
+
+	return true;
+}
+
+
+/*
+ * chunk_table_has_progress sets hasProgress to true when at least one chunk
+ * of the given table has been committed on the target database already, in
+ * which case the target table must not be truncated anymore.
+ */
+bool
+chunk_table_has_progress(DatabaseCatalog *catalog,
+						 uint32_t oid,
+						 bool *hasProgress)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: chunk_table_has_progress: db is NULL");
+		return false;
+	}
+
+	char *sql =
+		"select count(*) from chunk where tableoid = $1 and chunks > 0";
+
+	if (!semaphore_lock(&(catalog->sema)))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	*hasProgress = false;
+
+	SQLiteQuery query = {
+		.context = hasProgress,
+		.fetchFunction = &chunk_progress_fetch
+	};
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", oid, NULL }
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* now execute the query, which return exactly one row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	(void) semaphore_unlock(&(catalog->sema));
+
+	return true;
+}
+
+
+/*
+ * chunk_progress_fetch fetches the count of tables parts with progress.
+ */
+static bool
+chunk_progress_fetch(SQLiteQuery *query)
+{
+	bool *hasProgress = (bool *) query->context;
+
+	*hasProgress = sqlite3_column_int64(query->ppStmt, 0) > 0;
+
+	return true;
+}
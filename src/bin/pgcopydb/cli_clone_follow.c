@@ -34,7 +34,15 @@
 	"  --table-jobs                  Number of concurrent COPY jobs to run\n" \
 	"  --index-jobs                  Number of concurrent CREATE INDEX jobs to run\n" \
 	"  --restore-jobs                Number of concurrent jobs for pg_restore\n" \
+	"  --fkey-jobs                   Number of concurrent foreign key validation jobs\n" \
 	"  --large-objects-jobs          Number of concurrent Large Objects jobs to run\n" \
+	"  --total-jobs                  Number of concurrent jobs to run, all kinds\n" \
+	"  --adaptive-jobs               Tune the number of active jobs at runtime\n" \
+	"  --min-table-jobs              Minimum number of active COPY jobs\n" \
+	"  --min-index-jobs              Minimum number of active CREATE INDEX jobs\n" \
+	"  --index-memory                maintenance_work_mem budget for all CREATE INDEX jobs\n" \
+	"  --parallel-index-larger-than  Parallel CREATE INDEX size threshold\n" \
+	"  --parallel-vacuum-larger-than Parallel VACUUM size threshold\n" \
 	"  --split-tables-larger-than    Same-table concurrency size threshold\n" \
 	"  --split-max-parts             Maximum number of jobs for Same-table concurrency \n" \
 	"  --estimate-table-sizes        Allow using estimates for relation sizes\n" \
@@ -68,6 +76,13 @@
 	"  --origin                      Use this Postgres replication origin node name\n" \
 	"  --endpos                      Stop replaying changes when reaching this LSN\n" \
 	"  --use-copy-binary             Use the COPY BINARY format for COPY operations\n" \
+	"  --copy-format                 COPY format to use (text, binary, auto)\n" \
+	"  --copy-chunk-size             Commit table data in chunks of this size\n" \
+	"  --max-bandwidth               Maximum source bandwidth, per second\n" \
+	"  --max-worker-bandwidth        Maximum source bandwidth per worker, per second\n" \
+	"  --use-copy-threads            Use a separate reader thread for COPY operations\n" \
+	"  --spool                       Spool table data to disk to close the snapshot early\n" \
+	"  --unlogged-load               Load table data into UNLOGGED tables, SET LOGGED after indexes\n" \
 	"  --all-databases               Clone all databases found on the source instance\n" \
 
 CommandLine clone_command =
@@ -120,7 +135,9 @@ static bool start_follow_process(CopyDataSpec *copySpecs,
 								 StreamSpecs *streamSpecs,
 								 pid_t *pid);
 
-static bool cli_clone_follow_wait_subprocess(const char *name, pid_t pid);
+static bool cli_clone_follow_wait_subprocess(const char *name,
+											 pid_t pid,
+											 CopyDataSpec *copySpecs);
 
 
 /*
@@ -566,7 +583,8 @@ cli_clone(int argc, char **argv)
 	}
 
 	/* wait until the clone process is finished */
-	bool success = cli_clone_follow_wait_subprocess("clone", clonePID);
+	bool success =
+		cli_clone_follow_wait_subprocess("clone", clonePID, &copySpecs);
 
 	/* close our top-level copy db connection and snapshot */
 	if (exportSnapshot && !copydb_close_snapshot(&copySpecs))
@@ -719,7 +737,7 @@ clone_and_follow(CopyDataSpec *copySpecs)
 
 	/* wait until the clone process is finished */
 	bool success =
-		cli_clone_follow_wait_subprocess("clone", clonePID);
+		cli_clone_follow_wait_subprocess("clone", clonePID, copySpecs);
 
 	/* close our top-level copy db connection and snapshot */
 	if (!copydb_close_snapshot(copySpecs))
@@ -751,7 +769,7 @@ clone_and_follow(CopyDataSpec *copySpecs)
 	if (followPID != -1)
 	{
 		success = success &&
-				  cli_clone_follow_wait_subprocess("follow", followPID);
+				  cli_clone_follow_wait_subprocess("follow", followPID, NULL);
 	}
 
 	/*
@@ -1165,9 +1183,14 @@ start_follow_process(CopyDataSpec *copySpecs, StreamSpecs *streamSpecs,
 /*
  * cli_clone_follow_wait_subprocesses waits until both sub-processes are
  * finished.
+ *
+ * When copySpecs is not NULL, the source snapshot is closed as soon as all the
+ * data has been spooled (see --spool), while waiting for the sub-process.
  */
 static bool
-cli_clone_follow_wait_subprocess(const char *name, pid_t pid)
+cli_clone_follow_wait_subprocess(const char *name,
+								 pid_t pid,
+								 CopyDataSpec *copySpecs)
 {
 	bool exited = false;
 	int returnCode = -1;
@@ -1181,6 +1204,11 @@ cli_clone_follow_wait_subprocess(const char *name, pid_t pid)
 
 	while (!exited)
 	{
+		if (copySpecs != NULL && !copydb_spool_close_snapshot(copySpecs))
+		{
+			log_warn("Failed to close snapshot early, see above for details");
+		}
+
 		if (!follow_wait_pid(pid, &exited, &returnCode, &sig))
 		{
 			/* errors have already been logged */
@@ -181,11 +181,7 @@ cli_copydb_getenv_split(SplitTableLargerThan *splitTablesLargerThan)
 
 		if (get_env_copy(PGCOPYDB_SPLIT_TABLES_LARGER_THAN, bytes, sizeof(bytes)))
 		{
-			if (!cli_parse_bytes_pretty(
-					bytes,
-					&(splitTablesLargerThan->bytes),
-					(char *) &(splitTablesLargerThan->bytesPretty),
-					sizeof(splitTablesLargerThan->bytesPretty)))
+			if (!cli_parse_split_tables_larger_than(bytes, splitTablesLargerThan))
 			{
 				log_fatal("Failed to parse PGCOPYDB_SPLIT_TABLES_LARGER_THAN: "
 						  " \"%s\"",
@@ -218,6 +214,8 @@ cli_copydb_getenv(CopyDBOptions *options)
 	options->indexJobs = DEFAULT_INDEX_JOBS;
 	options->restoreOptions.jobs = DEFAULT_RESTORE_JOBS;
 	options->lObjectJobs = DEFAULT_LARGE_OBJECTS_JOBS;
+	options->minTableJobs = DEFAULT_MIN_TABLE_JOBS;
+	options->minIndexJobs = DEFAULT_MIN_INDEX_JOBS;
 	options->splitTablesLargerThan.bytes = DEFAULT_SPLIT_TABLES_LARGER_THAN;
 
 	EnvParser parsers[] = {
@@ -237,6 +235,26 @@ cli_copydb_getenv(CopyDBOptions *options)
 			PGCOPYDB_LARGE_OBJECTS_JOBS, ENV_TYPE_INT,
 			&(options->lObjectJobs), 0, true, 1, true, 128
 		},
+		{
+			PGCOPYDB_ADAPTIVE_JOBS, ENV_TYPE_BOOL,
+			&(options->adaptiveJobs)
+		},
+		{
+			PGCOPYDB_MIN_TABLE_JOBS, ENV_TYPE_INT,
+			&(options->minTableJobs), 0, true, 1, true, 128
+		},
+		{
+			PGCOPYDB_MIN_INDEX_JOBS, ENV_TYPE_INT,
+			&(options->minIndexJobs), 0, true, 1, true, 128
+		},
+		{
+			PGCOPYDB_TOTAL_JOBS, ENV_TYPE_INT,
+			&(options->totalJobs), 0, true, 1, true, 128
+		},
+		{
+			PGCOPYDB_FKEY_JOBS, ENV_TYPE_INT,
+			&(options->fkeyJobs), 0, true, 1, true, 128
+		},
 		{
 			PGCOPYDB_SPLIT_MAX_PARTS, ENV_TYPE_INT,
 			&(options->splitMaxParts), 0, true, 1
@@ -285,6 +303,18 @@ cli_copydb_getenv(CopyDBOptions *options)
 			PGCOPYDB_USE_COPY_BINARY, ENV_TYPE_BOOL,
 			&(options->useCopyBinary)
 		},
+		{
+			PGCOPYDB_USE_COPY_THREADS, ENV_TYPE_BOOL,
+			&(options->useCopyThreads)
+		},
+		{
+			PGCOPYDB_SPOOL, ENV_TYPE_BOOL,
+			&(options->useSpool)
+		},
+		{
+			PGCOPYDB_UNLOGGED_LOAD, ENV_TYPE_BOOL,
+			&(options->unloggedLoad)
+		},
 		{
 			PGCOPYDB_REPLAY_NO_OP_UPDATES, ENV_TYPE_BOOL,
 			&(options->replayNoOpUpdates)
@@ -323,6 +353,166 @@ cli_copydb_getenv(CopyDBOptions *options)
 		++errors;
 	}
 
+	/* check --copy-chunk-size environment variable */
+	if (env_exists(PGCOPYDB_COPY_CHUNK_SIZE))
+	{
+		char bytes[BUFSIZE] = { 0 };
+
+		if (!get_env_copy(PGCOPYDB_COPY_CHUNK_SIZE, bytes, sizeof(bytes)))
+		{
+			/* errors have already been logged */
+			++errors;
+		}
+		else if (!cli_parse_bytes_pretty(
+					 bytes,
+					 &(options->copyChunkSize),
+					 (char *) &(options->copyChunkSizePretty),
+					 sizeof(options->copyChunkSizePretty)))
+		{
+			log_fatal("Failed to parse PGCOPYDB_COPY_CHUNK_SIZE: \"%s\"",
+					  bytes);
+			++errors;
+		}
+	}
+
+	/* check --max-bandwidth environment variable */
+	if (env_exists(PGCOPYDB_MAX_BANDWIDTH))
+	{
+		char bytes[BUFSIZE] = { 0 };
+
+		if (!get_env_copy(PGCOPYDB_MAX_BANDWIDTH, bytes, sizeof(bytes)))
+		{
+			/* errors have already been logged */
+			++errors;
+		}
+		else if (!cli_parse_bytes_pretty(
+					 bytes,
+					 &(options->maxBandwidth),
+					 (char *) &(options->maxBandwidthPretty),
+					 sizeof(options->maxBandwidthPretty)))
+		{
+			log_fatal("Failed to parse PGCOPYDB_MAX_BANDWIDTH: \"%s\"",
+					  bytes);
+			++errors;
+		}
+	}
+
+	/* check --max-worker-bandwidth environment variable */
+	if (env_exists(PGCOPYDB_MAX_WORKER_BANDWIDTH))
+	{
+		char bytes[BUFSIZE] = { 0 };
+
+		if (!get_env_copy(PGCOPYDB_MAX_WORKER_BANDWIDTH, bytes, sizeof(bytes)))
+		{
+			/* errors have already been logged */
+			++errors;
+		}
+		else if (!cli_parse_bytes_pretty(
+					 bytes,
+					 &(options->maxWorkerBandwidth),
+					 (char *) &(options->maxWorkerBandwidthPretty),
+					 sizeof(options->maxWorkerBandwidthPretty)))
+		{
+			log_fatal("Failed to parse PGCOPYDB_MAX_WORKER_BANDWIDTH: \"%s\"",
+					  bytes);
+			++errors;
+		}
+	}
+
+	/* check --index-memory environment variable */
+	if (env_exists(PGCOPYDB_INDEX_MEMORY))
+	{
+		char bytes[BUFSIZE] = { 0 };
+
+		if (!get_env_copy(PGCOPYDB_INDEX_MEMORY, bytes, sizeof(bytes)))
+		{
+			/* errors have already been logged */
+			++errors;
+		}
+		else if (!cli_parse_bytes_pretty(
+					 bytes,
+					 &(options->indexMemory),
+					 (char *) &(options->indexMemoryPretty),
+					 sizeof(options->indexMemoryPretty)))
+		{
+			log_fatal("Failed to parse PGCOPYDB_INDEX_MEMORY: \"%s\"",
+					  bytes);
+			++errors;
+		}
+	}
+
+	/* check --parallel-index-larger-than environment variable */
+	if (env_exists(PGCOPYDB_PARALLEL_INDEX_LARGER_THAN))
+	{
+		char bytes[BUFSIZE] = { 0 };
+
+		if (!get_env_copy(PGCOPYDB_PARALLEL_INDEX_LARGER_THAN,
+						  bytes,
+						  sizeof(bytes)))
+		{
+			/* errors have already been logged */
+			++errors;
+		}
+		else if (!cli_parse_bytes_pretty(
+					 bytes,
+					 &(options->parallelIndexLargerThan),
+					 (char *) &(options->parallelIndexLargerThanPretty),
+					 sizeof(options->parallelIndexLargerThanPretty)))
+		{
+			log_fatal("Failed to parse PGCOPYDB_PARALLEL_INDEX_LARGER_THAN: "
+					  "\"%s\"",
+					  bytes);
+			++errors;
+		}
+	}
+
+	/* check --parallel-vacuum-larger-than environment variable */
+	if (env_exists(PGCOPYDB_PARALLEL_VACUUM_LARGER_THAN))
+	{
+		char bytes[BUFSIZE] = { 0 };
+
+		if (!get_env_copy(PGCOPYDB_PARALLEL_VACUUM_LARGER_THAN,
+						  bytes,
+						  sizeof(bytes)))
+		{
+			/* errors have already been logged */
+			++errors;
+		}
+		else if (!cli_parse_bytes_pretty(
+					 bytes,
+					 &(options->parallelVacuumLargerThan),
+					 (char *) &(options->parallelVacuumLargerThanPretty),
+					 sizeof(options->parallelVacuumLargerThanPretty)))
+		{
+			log_fatal("Failed to parse PGCOPYDB_PARALLEL_VACUUM_LARGER_THAN: "
+					  "\"%s\"",
+					  bytes);
+			++errors;
+		}
+	}
+
+	/* check --copy-format environment variable */
+	if (env_exists(PGCOPYDB_COPY_FORMAT))
+	{
+		char format[BUFSIZE] = { 0 };
+
+		if (!get_env_copy(PGCOPYDB_COPY_FORMAT, format, BUFSIZE))
+		{
+			/* errors have already been logged */
+			++errors;
+		}
+
+		options->copyFormat = CopyFormatFromString(format);
+
+		if (options->copyFormat == COPY_FORMAT_UNKNOWN)
+		{
+			log_fatal("Unknown COPY format \"%s\", please use either "
+					  "text, binary, or auto",
+					  format);
+			++errors;
+		}
+	}
+
 	/* check --plugin environment variable */
 	if (env_exists(PGCOPYDB_OUTPUT_PLUGIN))
 	{
@@ -704,6 +894,9 @@ cli_copy_db_getopts(int argc, char **argv)
 	CopyDBOptions options = { 0 };
 	int c, option_index = 0, errors = 0;
 	int verboseCount = 0;
+	bool tableJobsSet = false;
+	bool indexJobsSet = false;
+	bool lObjectJobsSet = false;
 
 	static struct option long_options[] = {
 		{ "source", required_argument, NULL, 'S' },
@@ -754,6 +947,22 @@ cli_copy_db_getopts(int argc, char **argv)
 		{ "publication", required_argument, NULL, 1003 },
 		{ "all-databases", no_argument, NULL, 1004 },
 		{ "replay-no-op-updates", no_argument, NULL, 1005 },
+		{ "use-copy-threads", no_argument, NULL, 1006 },
+		{ "fanout-target", required_argument, NULL, 1007 },
+		{ "spool", no_argument, NULL, 1008 },
+		{ "unlogged-load", no_argument, NULL, 1009 },
+		{ "copy-format", required_argument, NULL, 1010 },
+		{ "copy-chunk-size", required_argument, NULL, 1011 },
+		{ "max-bandwidth", required_argument, NULL, 1012 },
+		{ "max-worker-bandwidth", required_argument, NULL, 1013 },
+		{ "adaptive-jobs", no_argument, NULL, 1014 },
+		{ "min-table-jobs", required_argument, NULL, 1015 },
+		{ "min-index-jobs", required_argument, NULL, 1016 },
+		{ "total-jobs", required_argument, NULL, 1017 },
+		{ "index-memory", required_argument, NULL, 1018 },
+		{ "parallel-index-larger-than", required_argument, NULL, 1019 },
+		{ "fkey-jobs", required_argument, NULL, 1020 },
+		{ "parallel-vacuum-larger-than", required_argument, NULL, 1021 },
 		{ "host", required_argument, NULL, 1001 },
 		{ "port", required_argument, NULL, 1002 },
 		{ "version", no_argument, NULL, 'V' },
@@ -828,6 +1037,7 @@ cli_copy_db_getopts(int argc, char **argv)
 					log_fatal("Failed to parse --jobs count: \"%s\"", optarg);
 					++errors;
 				}
+				tableJobsSet = true;
 				log_trace("--table-jobs %d", options.tableJobs);
 				break;
 			}
@@ -841,6 +1051,7 @@ cli_copy_db_getopts(int argc, char **argv)
 					log_fatal("Failed to parse --index-jobs count: \"%s\"", optarg);
 					++errors;
 				}
+				indexJobsSet = true;
 				log_trace("--jobs %d", options.indexJobs);
 				break;
 			}
@@ -855,17 +1066,16 @@ cli_copy_db_getopts(int argc, char **argv)
 							  optarg);
 					++errors;
 				}
+				lObjectJobsSet = true;
 				log_trace("--large-objects-jobs %d", options.lObjectJobs);
 				break;
 			}
 
 			case 'L':
 			{
-				if (!cli_parse_bytes_pretty(
+				if (!cli_parse_split_tables_larger_than(
 						optarg,
-						&(options.splitTablesLargerThan.bytes),
-						(char *) &(options.splitTablesLargerThan.bytesPretty),
-						sizeof(options.splitTablesLargerThan.bytesPretty)))
+						&(options.splitTablesLargerThan)))
 				{
 					log_fatal("Failed to parse --split-tables-larger-than: \"%s\"",
 							  optarg);
@@ -1148,6 +1358,241 @@ cli_copy_db_getopts(int argc, char **argv)
 				break;
 			}
 
+			case 1006:      /* --use-copy-threads */
+			{
+				options.useCopyThreads = true;
+				log_trace("--use-copy-threads");
+				break;
+			}
+
+			case 1007:      /* --fanout-target */
+			{
+				ConnStrings *connStrings = &(options.connStrings);
+
+				if (connStrings->fanoutCount >= MAX_FANOUT_TARGETS)
+				{
+					log_fatal("Option --fanout-target can be used at most "
+							  "%d times",
+							  MAX_FANOUT_TARGETS);
+					exit(EXIT_CODE_BAD_ARGS);
+				}
+
+				int n = connStrings->fanoutCount++;
+
+				connStrings->fanout_pguri[n] = pg_strdup(optarg);
+				log_trace("--fanout-target %s", connStrings->fanout_pguri[n]);
+				break;
+			}
+
+			case 1008:      /* --spool */
+			{
+				options.useSpool = true;
+				log_trace("--spool");
+				break;
+			}
+
+			case 1009:      /* --unlogged-load */
+			{
+				options.unloggedLoad = true;
+				log_trace("--unlogged-load");
+				break;
+			}
+
+			case 1010:      /* --copy-format */
+			{
+				options.copyFormat = CopyFormatFromString(optarg);
+
+				if (options.copyFormat == COPY_FORMAT_UNKNOWN)
+				{
+					log_fatal("Unknown COPY format \"%s\", please use either "
+							  "text, binary, or auto",
+							  optarg);
+					++errors;
+				}
+
+				log_trace("--copy-format %s", optarg);
+				break;
+			}
+
+			case 1011:      /* --copy-chunk-size */
+			{
+				if (!cli_parse_bytes_pretty(
+						optarg,
+						&(options.copyChunkSize),
+						(char *) &(options.copyChunkSizePretty),
+						sizeof(options.copyChunkSizePretty)))
+				{
+					log_fatal("Failed to parse --copy-chunk-size: \"%s\"",
+							  optarg);
+					++errors;
+				}
+
+				log_trace("--copy-chunk-size %s (%lld)",
+						  options.copyChunkSizePretty,
+						  (long long) options.copyChunkSize);
+				break;
+			}
+
+			case 1012:      /* --max-bandwidth */
+			{
+				if (!cli_parse_bytes_pretty(
+						optarg,
+						&(options.maxBandwidth),
+						(char *) &(options.maxBandwidthPretty),
+						sizeof(options.maxBandwidthPretty)))
+				{
+					log_fatal("Failed to parse --max-bandwidth: \"%s\"",
+							  optarg);
+					++errors;
+				}
+
+				log_trace("--max-bandwidth %s (%lld)",
+						  options.maxBandwidthPretty,
+						  (long long) options.maxBandwidth);
+				break;
+			}
+
+			case 1013:      /* --max-worker-bandwidth */
+			{
+				if (!cli_parse_bytes_pretty(
+						optarg,
+						&(options.maxWorkerBandwidth),
+						(char *) &(options.maxWorkerBandwidthPretty),
+						sizeof(options.maxWorkerBandwidthPretty)))
+				{
+					log_fatal("Failed to parse --max-worker-bandwidth: \"%s\"",
+							  optarg);
+					++errors;
+				}
+
+				log_trace("--max-worker-bandwidth %s (%lld)",
+						  options.maxWorkerBandwidthPretty,
+						  (long long) options.maxWorkerBandwidth);
+				break;
+			}
+
+			case 1014:      /* --adaptive-jobs */
+			{
+				options.adaptiveJobs = true;
+				log_trace("--adaptive-jobs");
+				break;
+			}
+
+			case 1015:      /* --min-table-jobs */
+			{
+				if (!stringToInt(optarg, &options.minTableJobs) ||
+					options.minTableJobs < 1 ||
+					options.minTableJobs > 128)
+				{
+					log_fatal("Failed to parse --min-table-jobs count: \"%s\"",
+							  optarg);
+					++errors;
+				}
+				log_trace("--min-table-jobs %d", options.minTableJobs);
+				break;
+			}
+
+			case 1016:      /* --min-index-jobs */
+			{
+				if (!stringToInt(optarg, &options.minIndexJobs) ||
+					options.minIndexJobs < 1 ||
+					options.minIndexJobs > 128)
+				{
+					log_fatal("Failed to parse --min-index-jobs count: \"%s\"",
+							  optarg);
+					++errors;
+				}
+				log_trace("--min-index-jobs %d", options.minIndexJobs);
+				break;
+			}
+
+			case 1017:      /* --total-jobs */
+			{
+				if (!stringToInt(optarg, &options.totalJobs) ||
+					options.totalJobs < 1 ||
+					options.totalJobs > 128)
+				{
+					log_fatal("Failed to parse --total-jobs count: \"%s\"",
+							  optarg);
+					++errors;
+				}
+				log_trace("--total-jobs %d", options.totalJobs);
+				break;
+			}
+
+			case 1018:      /* --index-memory */
+			{
+				if (!cli_parse_bytes_pretty(
+						optarg,
+						&(options.indexMemory),
+						(char *) &(options.indexMemoryPretty),
+						sizeof(options.indexMemoryPretty)))
+				{
+					log_fatal("Failed to parse --index-memory: \"%s\"",
+							  optarg);
+					++errors;
+				}
+
+				log_trace("--index-memory %s (%lld)",
+						  options.indexMemoryPretty,
+						  (long long) options.indexMemory);
+				break;
+			}
+
+			case 1019:      /* --parallel-index-larger-than */
+			{
+				if (!cli_parse_bytes_pretty(
+						optarg,
+						&(options.parallelIndexLargerThan),
+						(char *) &(options.parallelIndexLargerThanPretty),
+						sizeof(options.parallelIndexLargerThanPretty)))
+				{
+					log_fatal("Failed to parse --parallel-index-larger-than: "
+							  "\"%s\"",
+							  optarg);
+					++errors;
+				}
+
+				log_trace("--parallel-index-larger-than %s (%lld)",
+						  options.parallelIndexLargerThanPretty,
+						  (long long) options.parallelIndexLargerThan);
+				break;
+			}
+
+			case 1020:      /* --fkey-jobs */
+			{
+				if (!stringToInt(optarg, &options.fkeyJobs) ||
+					options.fkeyJobs < 1 ||
+					options.fkeyJobs > 128)
+				{
+					log_fatal("Failed to parse --fkey-jobs count: \"%s\"",
+							  optarg);
+					++errors;
+				}
+				log_trace("--fkey-jobs %d", options.fkeyJobs);
+				break;
+			}
+
+			case 1021:      /* --parallel-vacuum-larger-than */
+			{
+				if (!cli_parse_bytes_pretty(
+						optarg,
+						&(options.parallelVacuumLargerThan),
+						(char *) &(options.parallelVacuumLargerThanPretty),
+						sizeof(options.parallelVacuumLargerThanPretty)))
+				{
+					log_fatal("Failed to parse --parallel-vacuum-larger-than: "
+							  "\"%s\"",
+							  optarg);
+					++errors;
+				}
+
+				log_trace("--parallel-vacuum-larger-than %s (%lld)",
+						  options.parallelVacuumLargerThanPretty,
+						  (long long) options.parallelVacuumLargerThan);
+				break;
+			}
+
 			case 1001:      /* --host: follow coordinator TCP listen host */
 			{
 				strlcpy(options.host, optarg, sizeof(options.host));
@@ -1271,6 +1716,36 @@ cli_copy_db_getopts(int argc, char **argv)
 		}
 	}
 
+	/*
+	 * With --total-jobs, the jobs that have not been set default to the
+	 * total, so that any kind of work may use the whole budget.
+	 */
+	if (options.totalJobs > 0)
+	{
+		if (!tableJobsSet && !env_exists(PGCOPYDB_TABLE_JOBS))
+		{
+			options.tableJobs = options.totalJobs;
+		}
+
+		if (!indexJobsSet && !env_exists(PGCOPYDB_INDEX_JOBS))
+		{
+			options.indexJobs = options.totalJobs;
+		}
+
+		if (!lObjectJobsSet && !env_exists(PGCOPYDB_LARGE_OBJECTS_JOBS))
+		{
+			options.lObjectJobs = options.totalJobs;
+		}
+	}
+
+	/* Postgres does not accept a maintenance_work_mem value below 1MB */
+	if (options.indexMemory > 0 && options.indexMemory < 1024 * 1024)
+	{
+		log_fatal("Option --index-memory must be at least 1MB, \"%s\" given",
+				  options.indexMemoryPretty);
+		++errors;
+	}
+
 	/* if we haven't set restore-jobs, set it to index-jobs */
 	if (options.restoreOptions.jobs == DEFAULT_RESTORE_JOBS)
 	{
@@ -1299,12 +1774,42 @@ cli_copy_db_getopts(int argc, char **argv)
 		exit(EXIT_CODE_INTERNAL_ERROR);
 	}
 
+	if (options.allDatabases && options.connStrings.fanoutCount > 0)
+	{
+		log_fatal("Option --fanout-target is not supported "
+				  "with option --all-databases");
+		exit(EXIT_CODE_BAD_ARGS);
+	}
+
+	if (options.useSpool && options.allDatabases)
+	{
+		log_fatal("Option --spool is not supported "
+				  "with option --all-databases");
+		exit(EXIT_CODE_BAD_ARGS);
+	}
+
+	if (options.useSpool && options.connStrings.fanoutCount > 0)
+	{
+		log_fatal("Option --spool is not supported "
+				  "with option --fanout-target");
+		exit(EXIT_CODE_BAD_ARGS);
+	}
+
 	if (!cli_copydb_is_consistent(&options))
 	{
 		log_fatal("Option --resume requires option --not-consistent");
 		exit(EXIT_CODE_BAD_ARGS);
 	}
 
+	if (options.adaptiveJobs &&
+		(options.minTableJobs > options.tableJobs ||
+		 options.minIndexJobs > options.indexJobs))
+	{
+		log_fatal("Options --min-table-jobs and --min-index-jobs must not be "
+				  "greater than --table-jobs and --index-jobs");
+		exit(EXIT_CODE_BAD_ARGS);
+	}
+
 	if (errors > 0)
 	{
 		commandline_help(stderr);
@@ -1345,6 +1850,34 @@ cli_parse_bytes_pretty(const char *byteString,
 }
 
 
+/*
+ * cli_parse_split_tables_larger_than parses the --split-tables-larger-than
+ * option value, which is either a pretty printed bytes value or "auto". In
+ * the automatic mode the size threshold is computed later from the size of
+ * the tables to copy, see copydb_prepare_split_auto.
+ */
+bool
+cli_parse_split_tables_larger_than(const char *value,
+								   SplitTableLargerThan *split)
+{
+	if (streq(value, "auto"))
+	{
+		split->automatic = true;
+		split->bytes = 0;
+		strlcpy(split->bytesPretty, "auto", sizeof(split->bytesPretty));
+
+		return true;
+	}
+
+	split->automatic = false;
+
+	return cli_parse_bytes_pretty(value,
+								  &(split->bytes),
+								  (char *) &(split->bytesPretty),
+								  sizeof(split->bytesPretty));
+}
+
+
 /*
  * copydb_prepare_pguris prepares version of Postgres connections strings to
  * source and target without security sensible information (password is
@@ -1375,6 +1908,19 @@ cli_prepare_pguris(ConnStrings *connStrings)
 		++errors;
 	}
 
+	for (int i = 0; i < connStrings->fanoutCount; i++)
+	{
+		char *fpguri = connStrings->fanout_pguri[i];
+		SafeURI *safeFanoutPGURI = &(connStrings->safeFanoutPGURI[i]);
+
+		if (!parse_and_scrub_connection_string(fpguri, safeFanoutPGURI))
+		{
+			log_error("Failed to parse fan-out target connection string: "
+					  "\"%s\"", fpguri);
+			++errors;
+		}
+	}
+
 	return errors == 0;
 }
 
@@ -1394,6 +1940,13 @@ cli_copy_prepare_specs(CopyDataSpec *copySpecs, CopyDataSection section)
 	log_info("[SOURCE] Copying database from \"%s\"", safeSourceURI);
 	log_info("[TARGET] Copying database into \"%s\"", safeTargetURI);
 
+	for (int i = 0; i < copyDBoptions.connStrings.fanoutCount; i++)
+	{
+		log_info("[TARGET %d] Copying table data into \"%s\"",
+				 i + 1,
+				 copyDBoptions.connStrings.safeFanoutPGURI[i].pguri);
+	}
+
 	(void) find_pg_commands(pgPaths);
 
 	log_debug("Using pg_dump for Postgres \"%s\" at \"%s\"",
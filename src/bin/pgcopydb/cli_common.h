@@ -25,6 +25,7 @@ typedef struct SplitTableLargerThan
 {
 	uint64_t bytes;
 	char bytesPretty[NAMEDATALEN];
+	bool automatic;             /* --split-tables-larger-than auto */
 } SplitTableLargerThan;
 
 
@@ -54,10 +55,31 @@ typedef struct CopyDBOptions
 	int indexJobs;
 	int lObjectJobs;
 
+	bool adaptiveJobs;
+	int minTableJobs;
+	int minIndexJobs;
+	int totalJobs;
+	int fkeyJobs;
+
+	uint64_t indexMemory;
+	char indexMemoryPretty[NAMEDATALEN];
+	uint64_t parallelIndexLargerThan;
+	char parallelIndexLargerThanPretty[NAMEDATALEN];
+	uint64_t parallelVacuumLargerThan;
+	char parallelVacuumLargerThanPretty[NAMEDATALEN];
+
 	SplitTableLargerThan splitTablesLargerThan;
 	int splitMaxParts;
 	bool estimateTableSizes;
 
+	uint64_t copyChunkSize;
+	char copyChunkSizePretty[NAMEDATALEN];
+
+	uint64_t maxBandwidth;
+	char maxBandwidthPretty[NAMEDATALEN];
+	uint64_t maxWorkerBandwidth;
+	char maxWorkerBandwidthPretty[NAMEDATALEN];
+
 	RestoreOptions restoreOptions;
 
 	bool roles;
@@ -73,6 +95,10 @@ typedef struct CopyDBOptions
 	bool replayNoOpUpdates;
 	bool failFast;
 	bool useCopyBinary;
+	CopyFormat copyFormat;
+	bool useCopyThreads;
+	bool useSpool;
+	bool unloggedLoad;
 
 	bool restart;
 	bool resume;
@@ -147,6 +173,9 @@ bool cli_parse_bytes_pretty(const char *byteString,
 							char *bytesPretty,
 							size_t bytesPrettySize);
 
+bool cli_parse_split_tables_larger_than(const char *value,
+										SplitTableLargerThan *split);
+
 bool cli_prepare_pguris(ConnStrings *connStrings);
 
 #endif  /* CLI_COMMON_H */
@@ -40,6 +40,14 @@ static CommandLine copy_db_command =
 		"  --table-jobs          Number of concurrent COPY jobs to run\n"
 		"  --index-jobs          Number of concurrent CREATE INDEX jobs to run\n"
 		"  --restore-jobs        Number of concurrent jobs for pg_restore\n"
+		"  --fkey-jobs           Number of concurrent foreign key validation jobs\n"
+		"  --total-jobs          Number of concurrent jobs to run, all kinds\n"
+		"  --adaptive-jobs       Tune the number of active jobs at runtime\n"
+		"  --min-table-jobs      Minimum number of active COPY jobs\n"
+		"  --min-index-jobs      Minimum number of active CREATE INDEX jobs\n"
+		"  --index-memory        maintenance_work_mem budget for CREATE INDEX jobs\n"
+		"  --parallel-index-larger-than  Parallel CREATE INDEX size threshold\n"
+		"  --parallel-vacuum-larger-than Parallel VACUUM size threshold\n"
 		"  --drop-if-exists      On the target database, clean-up from a previous run first\n"
 		"  --roles               Also copy roles found on source to target\n"
 		"  --no-owner            Do not set ownership of objects to match the original database\n"
@@ -53,7 +61,14 @@ static CommandLine copy_db_command =
 		"  --resume              Allow resuming operations after a failure\n"
 		"  --not-consistent      Allow taking a new snapshot on the source database\n"
 		"  --snapshot            Use snapshot obtained with pg_export_snapshot\n"
-		"  --use-copy-binary     Use the COPY BINARY format for COPY operations\n",
+		"  --use-copy-binary     Use the COPY BINARY format for COPY operations\n"
+		"  --copy-format         COPY format to use (text, binary, auto)\n"
+		"  --copy-chunk-size     Commit table data in chunks of this size\n"
+		"  --max-bandwidth       Maximum source bandwidth, per second\n"
+		"  --max-worker-bandwidth Maximum source bandwidth per worker, per second\n"
+		"  --use-copy-threads    Use a separate reader thread for COPY operations\n"
+		"  --spool               Spool table data to disk to close the snapshot early\n"
+		"  --unlogged-load       Load table data into UNLOGGED tables, SET LOGGED after indexes\n",
 		cli_copy_db_getopts,
 		cli_clone);
 
@@ -130,13 +145,21 @@ static CommandLine copy_table_data_command =
 		"  --target                      Postgres URI to the target database\n"
 		"  --dir                         Work directory to use\n"
 		"  --table-jobs                  Number of concurrent COPY jobs to run\n"
+		"  --adaptive-jobs               Tune the number of active COPY jobs at runtime\n"
+		"  --min-table-jobs              Minimum number of active COPY jobs\n"
 		"  --split-tables-larger-than    Same-table concurrency size threshold\n"
 		"  --split-max-parts             Maximum number of jobs for Same-table concurrency\n"
 		"  --filters <filename>          Use the filters defined in <filename>\n"
 		"  --restart                     Allow restarting when temp files exist already\n"
 		"  --resume                      Allow resuming operations after a failure\n"
 		"  --not-consistent              Allow taking a new snapshot on the source database\n"
-		"  --snapshot                    Use snapshot obtained with pg_export_snapshot\n",
+		"  --snapshot                    Use snapshot obtained with pg_export_snapshot\n"
+		"  --fanout-target               Also copy the table data to this target database\n"
+		"  --spool                       Spool table data to disk to close the snapshot early\n"
+		"  --copy-format                 COPY format to use (text, binary, auto)\n"
+		"  --copy-chunk-size             Commit table data in chunks of this size\n"
+		"  --max-bandwidth               Maximum source bandwidth, per second\n"
+		"  --max-worker-bandwidth        Maximum source bandwidth per worker, per second\n",
 		cli_copy_db_getopts,
 		cli_copy_table_data);
 
@@ -182,6 +205,10 @@ static CommandLine copy_indexes_command =
 		"  --target             Postgres URI to the target database\n"
 		"  --dir                Work directory to use\n"
 		"  --index-jobs         Number of concurrent CREATE INDEX jobs to run\n"
+		"  --adaptive-jobs      Tune the number of active CREATE INDEX jobs at runtime\n"
+		"  --min-index-jobs     Minimum number of active CREATE INDEX jobs\n"
+		"  --index-memory       maintenance_work_mem budget for CREATE INDEX jobs\n"
+		"  --parallel-index-larger-than  Parallel CREATE INDEX size threshold\n"
 		"  --restore-jobs       Number of concurrent jobs for pg_restore\n"
 		"  --filters <filename> Use the filters defined in <filename>\n"
 		"  --restart            Allow restarting when temp files exist already\n"
@@ -21,6 +21,7 @@
 #include "pgcmd.h"
 #include "pgsql.h"
 #include "progress.h"
+#include "schedule.h"
 #include "schema.h"
 #include "string_utils.h"
 
@@ -34,6 +35,7 @@ static void cli_list_extension_requirements(int argc, char **argv);
 static void cli_list_collations(int argc, char **argv);
 static void cli_list_tables(int argc, char **argv);
 static void cli_list_table_parts(int argc, char **argv);
+static void cli_list_schedule(int argc, char **argv);
 static void cli_list_sequences(int argc, char **argv);
 static void cli_list_indexes(int argc, char **argv);
 static void cli_list_depends(int argc, char **argv);
@@ -53,6 +55,7 @@ static bool cli_list_extension_print_hook(void *ctx, SourceExtension *ext);
 static bool cli_list_colls_hook(void *context, SourceCollation *coll);
 static bool cli_list_table_print_hook(void *context, SourceTable *table);
 static bool cli_list_table_part_print_hook(void *ctx, SourceTableParts *part);
+static bool cli_list_schedule_hook(void *ctx, SourceTable *table);
 static bool cli_list_seq_print_hook(void *context, SourceSequence *seq);
 static bool cli_list_index_print_hook(void *context, SourceIndex *index);
 static bool cli_list_depends_hook(void *ctx, SourceDepend *dep);
@@ -110,13 +113,30 @@ static CommandLine list_table_parts_command =
 		"  --force                     Force fetching catalogs again\n"
 		"  --schema-name               Name of the schema where to find the table\n"
 		"  --table-name                Name of the target table\n"
-		"  --split-tables-larger-than  Size threshold to consider partitioning\n"
+		"  --split-tables-larger-than  Size threshold to consider partitioning, or auto\n"
 		"  --split-max-parts           Maximum number of jobs for Same-table concurrency \n" \
+		"  --table-jobs                Number of concurrent COPY jobs, with auto\n"
 		"  --skip-split-by-ctid        Skip the ctid split\n"
 		"  --estimate-table-sizes      Allow using estimates for relation sizes\n",
 		cli_list_db_getopts,
 		cli_list_table_parts);
 
+static CommandLine list_schedule_command =
+	make_command(
+		"schedule",
+		"List the predicted timeline of the COPY and CREATE INDEX jobs",
+		" --source ... [ --table-jobs ] [ --index-jobs ]",
+		"  --source                    Postgres URI to the source database\n"
+		"  --force                     Force fetching catalogs again\n"
+		"  --filter <filename>         Use the filters defined in <filename>\n"
+		"  --table-jobs                Number of concurrent COPY jobs to run\n"
+		"  --index-jobs                Number of concurrent CREATE INDEX jobs to run\n"
+		"  --split-tables-larger-than  Same-table concurrency size threshold\n"
+		"  --split-max-parts           Maximum number of jobs for Same-table concurrency \n"
+		"  --estimate-table-sizes      Allow using estimates for relation sizes\n",
+		cli_list_db_getopts,
+		cli_list_schedule);
+
 static CommandLine list_sequences_command =
 	make_command(
 		"sequences",
@@ -187,6 +207,7 @@ static CommandLine *list_subcommands[] = {
 	&list_collations_command,
 	&list_tables_command,
 	&list_table_parts_command,
+	&list_schedule_command,
 	&list_sequences_command,
 	&list_indexes_command,
 	&list_depends_command,
@@ -210,7 +231,18 @@ cli_list_getenv(ListDBOptions *options)
 {
 	int errors = 0;
 
+	options->tableJobs = DEFAULT_TABLE_JOBS;
+	options->indexJobs = DEFAULT_INDEX_JOBS;
+
 	EnvParser parsers[] = {
+		{
+			PGCOPYDB_TABLE_JOBS, ENV_TYPE_INT,
+			&(options->tableJobs), 0, true, 1, true, 128
+		},
+		{
+			PGCOPYDB_INDEX_JOBS, ENV_TYPE_INT,
+			&(options->indexJobs), 0, true, 1, true, 128
+		},
 		{
 			PGCOPYDB_SPLIT_MAX_PARTS, ENV_TYPE_INT,
 			&(options->splitMaxParts), 0, true, 1
@@ -269,6 +301,8 @@ cli_list_db_getopts(int argc, char **argv)
 		{ "split-tables-larger-than", required_argument, NULL, 'L' },
 		{ "split-max-parts", required_argument, NULL, 'u' },
 		{ "split-at", required_argument, NULL, 'L' },
+		{ "table-jobs", required_argument, NULL, 'j' },
+		{ "index-jobs", required_argument, NULL, 'i' },
 		{ "estimate-table-sizes", no_argument, NULL, 'm' },
 		{ "skip-split-by-ctid", no_argument, NULL, 'k' },
 		{ "force", no_argument, NULL, 'f' },
@@ -298,7 +332,7 @@ cli_list_db_getopts(int argc, char **argv)
 		exit(EXIT_CODE_BAD_ARGS);
 	}
 
-	const char *optstring = "S:D:s:t:F:xPL:u:k:mfyarJRIN:Vdzvqh";
+	const char *optstring = "S:D:s:t:F:xPL:u:j:i:k:mfyarJRIN:Vdzvqh";
 
 	while ((c = getopt_long(argc, argv, optstring,
 							long_options, &option_index)) != -1)
@@ -369,11 +403,9 @@ cli_list_db_getopts(int argc, char **argv)
 
 			case 'L':
 			{
-				if (!cli_parse_bytes_pretty(
+				if (!cli_parse_split_tables_larger_than(
 						optarg,
-						&(options.splitTablesLargerThan.bytes),
-						(char *) &(options.splitTablesLargerThan.bytesPretty),
-						sizeof(options.splitTablesLargerThan.bytesPretty)))
+						&(options.splitTablesLargerThan)))
 				{
 					log_fatal("Failed to parse --split-tables-larger-than: \"%s\"",
 							  optarg);
@@ -399,6 +431,34 @@ cli_list_db_getopts(int argc, char **argv)
 				break;
 			}
 
+			case 'j':
+			{
+				if (!stringToInt(optarg, &options.tableJobs) ||
+					options.tableJobs < 1 ||
+					options.tableJobs > 128)
+				{
+					log_fatal("Failed to parse --table-jobs count: \"%s\"",
+							  optarg);
+					++errors;
+				}
+				log_trace("--table-jobs %d", options.tableJobs);
+				break;
+			}
+
+			case 'i':
+			{
+				if (!stringToInt(optarg, &options.indexJobs) ||
+					options.indexJobs < 1 ||
+					options.indexJobs > 128)
+				{
+					log_fatal("Failed to parse --index-jobs count: \"%s\"",
+							  optarg);
+					++errors;
+				}
+				log_trace("--index-jobs %d", options.indexJobs);
+				break;
+			}
+
 			case 'k':
 			{
 				options.skipCtidSplit = true;
@@ -1176,21 +1236,22 @@ cli_list_tables(int argc, char **argv)
 			 stats.relTuplesPretty,
 			 stats.bytesPretty);
 
-	fformat(stdout, "%8s | %20s | %20s | %15s | %15s\n",
+	fformat(stdout, "%8s | %20s | %20s | %15s | %15s | %11s\n",
 			"OID", "Schema Name", "Table Name",
-			"Est. Row Count", "On-disk size");
+			"Est. Row Count", "On-disk size", "COPY Format");
 
-	fformat(stdout, "%8s-+-%20s-+-%20s-+-%15s-+-%15s\n",
+	fformat(stdout, "%8s-+-%20s-+-%20s-+-%15s-+-%15s-+-%11s\n",
 			"--------",
 			"--------------------",
 			"--------------------",
 			"---------------",
-			"---------------");
+			"---------------",
+			"-----------");
 
 	if (listDBoptions.noPKey)
 	{
 		if (!catalog_iter_s_table_nopk(catalog,
-									   NULL,
+									   catalog,
 									   &cli_list_table_print_hook))
 		{
 			exit(EXIT_CODE_INTERNAL_ERROR);
@@ -1198,7 +1259,7 @@ cli_list_tables(int argc, char **argv)
 	}
 	else
 	{
-		if (!catalog_iter_s_table(catalog, NULL, &cli_list_table_print_hook))
+		if (!catalog_iter_s_table(catalog, catalog, &cli_list_table_print_hook))
 		{
 			exit(EXIT_CODE_INTERNAL_ERROR);
 		}
@@ -1220,12 +1281,24 @@ cli_list_table_print_hook(void *context, SourceTable *table)
 		return false;
 	}
 
-	fformat(stdout, "%8d | %20s | %20s | %15lld | %15s\n",
+	DatabaseCatalog *catalog = (DatabaseCatalog *) context;
+
+	/* the COPY format that --copy-format auto uses for this table */
+	SourceTableCopyFormat copyFormat = { 0 };
+
+	if (!catalog_lookup_s_table_copy_format(catalog, table->oid, &copyFormat))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	fformat(stdout, "%8d | %20s | %20s | %15lld | %15s | %11s\n",
 			table->oid,
 			table->nspname,
 			table->relname,
 			(long long) table->reltuples,
-			table->bytesPretty);
+			table->bytesPretty,
+			copyFormat.format);
 
 	return true;
 }
@@ -1244,7 +1317,8 @@ cli_list_table_parts(int argc, char **argv)
 {
 	CopyDataSpec copySpecs = { 0 };
 
-	if (listDBoptions.splitTablesLargerThan.bytes == 0)
+	if (listDBoptions.splitTablesLargerThan.bytes == 0 &&
+		!listDBoptions.splitTablesLargerThan.automatic)
 	{
 		log_warn("Option --split-tables-larger-than is set to zero bytes, "
 				 "skipping");
@@ -1303,6 +1377,21 @@ cli_list_table_parts(int argc, char **argv)
 		exit(EXIT_CODE_INTERNAL_ERROR);
 	}
 
+	/*
+	 * With --split-tables-larger-than auto, explain the size threshold that
+	 * is computed from the other tables to copy and --table-jobs.
+	 */
+	if (listDBoptions.splitTablesLargerThan.automatic)
+	{
+		if (!copydb_prepare_split_auto(&copySpecs))
+		{
+			/* errors have already been logged */
+			exit(EXIT_CODE_INTERNAL_ERROR);
+		}
+
+		listDBoptions.splitTablesLargerThan = copySpecs.splitTablesLargerThan;
+	}
+
 	if (table->bytes < listDBoptions.splitTablesLargerThan.bytes)
 	{
 		log_info("Table %s (%s) will not be split",
@@ -1311,6 +1400,45 @@ cli_list_table_parts(int argc, char **argv)
 		exit(EXIT_CODE_QUIT);
 	}
 
+	/*
+	 * Check whether the parts section was already cached from a previous run.
+	 * If so, re-use the catalog rows directly; otherwise compute them now and
+	 * store them so the next call is instant.
+	 */
+	CatalogSection partsSection = {
+		.section = DATA_SECTION_TABLE_DATA_PARTS
+	};
+
+	if (!catalog_section_state(sourceDB, &partsSection))
+	{
+		/* errors have already been logged */
+		exit(EXIT_CODE_INTERNAL_ERROR);
+	}
+
+	PGSQL pgsql = { 0 };
+
+	if (!partsSection.fetched)
+	{
+		ConnStrings *dsn = &(listDBoptions.connStrings);
+
+		if (!pgsql_init(&pgsql, dsn->source_pguri, PGSQL_CONN_SOURCE))
+		{
+			/* errors have already been logged */
+			exit(EXIT_CODE_SOURCE);
+		}
+
+		/* prefer any unique key to CTID range scans, see copydb_schema.c */
+		if (IS_EMPTY_STRING_BUFFER(table->partKey) &&
+			streq(table->amname, "heap"))
+		{
+			if (!schema_list_split_key(&pgsql, table))
+			{
+				/* errors have already been logged */
+				exit(EXIT_CODE_SOURCE);
+			}
+		}
+	}
+
 	if (IS_EMPTY_STRING_BUFFER(table->partKey) &&
 		streq(table->amname, "heap"))
 	{
@@ -1351,32 +1479,8 @@ cli_list_table_parts(int argc, char **argv)
 		exit(EXIT_CODE_QUIT);
 	}
 
-	/*
-	 * Check whether the parts section was already cached from a previous run.
-	 * If so, re-use the catalog rows directly; otherwise compute them now and
-	 * store them so the next call is instant.
-	 */
-	CatalogSection partsSection = {
-		.section = DATA_SECTION_TABLE_DATA_PARTS
-	};
-
-	if (!catalog_section_state(sourceDB, &partsSection))
-	{
-		/* errors have already been logged */
-		exit(EXIT_CODE_INTERNAL_ERROR);
-	}
-
 	if (!partsSection.fetched)
 	{
-		PGSQL pgsql = { 0 };
-		ConnStrings *dsn = &(listDBoptions.connStrings);
-
-		if (!pgsql_init(&pgsql, dsn->source_pguri, PGSQL_CONN_SOURCE))
-		{
-			/* errors have already been logged */
-			exit(EXIT_CODE_SOURCE);
-		}
-
 		/*
 		 * For CTID-based splits we need fresh relpages from pg_class.
 		 * Run ANALYZE first (unless the user asked for estimates only) so that
@@ -1438,10 +1542,29 @@ cli_list_table_parts(int argc, char **argv)
 			 table->qname,
 			 table->partition.partCount);
 
-	fformat(stdout, "%12s | %12s | %12s | %12s\n",
-			"Part", "Min", "Max", "Count");
+	if (listDBoptions.splitTablesLargerThan.automatic &&
+		table->partition.partCount > 0)
+	{
+		char partPretty[BUFSIZE] = { 0 };
+
+		(void) pretty_print_bytes(partPretty,
+								  sizeof(partPretty),
+								  table->bytes / table->partition.partCount);
 
-	fformat(stdout, "%12s-+-%12s-+-%12s-+-%12s\n",
+		log_info("Table %s is %s large: %d parts of about %s each, "
+				 "no larger than the automatic split size %s",
+				 table->qname,
+				 table->bytesPretty,
+				 table->partition.partCount,
+				 partPretty,
+				 listDBoptions.splitTablesLargerThan.bytesPretty);
+	}
+
+	fformat(stdout, "%12s | %12s | %12s | %12s | %12s\n",
+			"Part", "Min", "Max", "Count", "Est. Rows");
+
+	fformat(stdout, "%12s-+-%12s-+-%12s-+-%12s-+-%12s\n",
+			"------------",
 			"------------",
 			"------------",
 			"------------",
@@ -1476,7 +1599,22 @@ cli_list_table_part_print_hook(void *ctx, SourceTableParts *part)
 	ListTablePartContext *context = (ListTablePartContext *) ctx;
 	SourceTable *table = context->table;
 
-	if (streq(table->partKey, "ctid"))
+	if (part->typed)
+	{
+		char partNC[BUFSIZE] = { 0 };
+
+		sformat(partNC, sizeof(partNC), "%d/%d",
+				part->partNumber,
+				part->partCount);
+
+		fformat(stdout, "%12s | %12s | %12s | %12s | %12lld\n",
+				partNC,
+				IS_EMPTY_STRING_BUFFER(part->minKey) ? "-" : part->minKey,
+				IS_EMPTY_STRING_BUFFER(part->maxKey) ? "-" : part->maxKey,
+				"-",
+				(long long) part->estRows);
+	}
+	else if (streq(table->partKey, "ctid"))
 	{
 		char partNC[BUFSIZE] = { 0 };
 		char partMin[BUFSIZE] = { 0 };
@@ -1489,8 +1627,10 @@ cli_list_table_part_print_hook(void *ctx, SourceTableParts *part)
 		sformat(partMin, BUFSIZE, "(%lld,0)", (long long) part->min);
 		sformat(partMax, BUFSIZE, "(%lld,0)", (long long) part->max);
 
-		fformat(stdout, "%12s | %12s | %12s | %12lld\n",
-				partNC, partMin, partMax, (long long) part->count);
+		fformat(stdout, "%12s | %12s | %12s | %12lld | %12lld\n",
+				partNC, partMin, partMax,
+				(long long) part->count,
+				(long long) part->estRows);
 	}
 	else
 	{
@@ -1500,17 +1640,187 @@ cli_list_table_part_print_hook(void *ctx, SourceTableParts *part)
 				part->partNumber,
 				part->partCount);
 
-		fformat(stdout, "%12s | %12lld | %12lld | %12lld\n",
+		fformat(stdout, "%12s | %12lld | %12lld | %12lld | %12lld\n",
 				partNC,
 				(long long) part->min,
 				(long long) part->max,
-				(long long) part->count);
+				(long long) part->count,
+				(long long) part->estRows);
 	}
 
 	return true;
 }
 
 
+typedef struct ListScheduleContext
+{
+	DatabaseCatalog *catalog;
+	Schedule *schedule;
+} ListScheduleContext;
+
+
+/*
+ * cli_list_schedule implements the command: pgcopydb list schedule
+ *
+ * The COPY and CREATE INDEX jobs are estimated from the source catalogs and
+ * then run in a simulation with --table-jobs and --index-jobs workers, in the
+ * order that pgcopydb clone would use, see schedule.c.
+ */
+static void
+cli_list_schedule(int argc, char **argv)
+{
+	CopyDataSpec copySpecs = { 0 };
+
+	bool createWorkDir = true;
+
+	if (!copydb_init_specs_from_listdboptions(&copySpecs,
+											  &listDBoptions,
+											  DATA_SECTION_ALL,
+											  createWorkDir))
+	{
+		/* errors have already been logged */
+		exit(EXIT_CODE_BAD_ARGS);
+	}
+
+	if (!IS_EMPTY_STRING_BUFFER(listDBoptions.filterFileName))
+	{
+		if (!parse_filters(listDBoptions.filterFileName, &(copySpecs.filters)))
+		{
+			log_error("Failed to parse filters in file \"%s\"",
+					  listDBoptions.filterFileName);
+			exit(EXIT_CODE_BAD_ARGS);
+		}
+	}
+
+	/*
+	 * Prepare our internal catalogs for storing the source database catalog
+	 * query results. When --force is used then we fetch the catalogs again.
+	 */
+	if (!copydb_fetch_schema_and_prepare_specs(&copySpecs))
+	{
+		log_error("Failed to fetch a local copy of the catalogs, "
+				  "see above for details");
+		exit(EXIT_CODE_INTERNAL_ERROR);
+	}
+
+	DatabaseCatalog *sourceDB = &(copySpecs.catalogs.source);
+	Schedule schedule = { 0 };
+
+	ListScheduleContext context = {
+		.catalog = sourceDB,
+		.schedule = &schedule
+	};
+
+	if (!catalog_iter_s_table(sourceDB, &context, &cli_list_schedule_hook))
+	{
+		log_error("Failed to estimate the COPY jobs, see above for details");
+		exit(EXIT_CODE_INTERNAL_ERROR);
+	}
+
+	if (!schedule_add_indexes(sourceDB, &schedule))
+	{
+		log_error("Failed to estimate the CREATE INDEX jobs, "
+				  "see above for details");
+		exit(EXIT_CODE_INTERNAL_ERROR);
+	}
+
+	/* the catalog order is by table size, as before cost-based scheduling */
+	ScheduleSimulation catalogOrder = { 0 };
+	ScheduleSimulation simulation = { 0 };
+
+	if (!schedule_simulate(&schedule,
+						   listDBoptions.tableJobs,
+						   listDBoptions.indexJobs,
+						   &catalogOrder))
+	{
+		/* errors have already been logged */
+		exit(EXIT_CODE_INTERNAL_ERROR);
+	}
+
+	(void) schedule_sort(&schedule);
+
+	if (!schedule_simulate(&schedule,
+						   listDBoptions.tableJobs,
+						   listDBoptions.indexJobs,
+						   &simulation))
+	{
+		/* errors have already been logged */
+		exit(EXIT_CODE_INTERNAL_ERROR);
+	}
+
+	log_info("Simulating %d COPY jobs and %d CREATE INDEX jobs "
+			 "with --table-jobs %d and --index-jobs %d",
+			 schedule.count,
+			 schedule.indexCount,
+			 listDBoptions.tableJobs,
+			 listDBoptions.indexJobs);
+
+	fformat(stdout, "%10s | %10s | %6s | %6s | %s\n",
+			"Start", "End", "Worker", "Step", "Object");
+
+	fformat(stdout, "%10s-+-%10s-+-%6s-+-%6s-+-%s\n",
+			"----------",
+			"----------",
+			"------",
+			"------",
+			"--------------------");
+
+	for (int i = 0; i < simulation.count; i++)
+	{
+		ScheduleStep *step = &(simulation.steps[i]);
+
+		char start[BUFSIZE] = { 0 };
+		char end[BUFSIZE] = { 0 };
+
+		(void) IntervalToString((uint64_t) (step->start * 1000),
+								start, sizeof(start));
+		(void) IntervalToString((uint64_t) (step->end * 1000),
+								end, sizeof(end));
+
+		fformat(stdout, "%10s | %10s | %6d | %6s | %s\n",
+				start,
+				end,
+				step->worker,
+				step->isIndex ? "INDEX" : "COPY",
+				step->object);
+	}
+
+	char duration[BUFSIZE] = { 0 };
+	char copyDuration[BUFSIZE] = { 0 };
+	char catalogDuration[BUFSIZE] = { 0 };
+
+	(void) IntervalToString((uint64_t) (simulation.duration * 1000),
+							duration, sizeof(duration));
+	(void) IntervalToString((uint64_t) (simulation.copyDuration * 1000),
+							copyDuration, sizeof(copyDuration));
+	(void) IntervalToString((uint64_t) (catalogOrder.duration * 1000),
+							catalogDuration, sizeof(catalogDuration));
+
+	fformat(stdout, "\n");
+	fformat(stdout, "Predicted duration: %s (COPY done at %s), "
+					"%s when processing tables by size\n",
+			duration,
+			copyDuration,
+			catalogDuration);
+
+	(void) schedule_simulation_free(&catalogOrder);
+	(void) schedule_simulation_free(&simulation);
+	(void) schedule_free(&schedule);
+}
+
+
+/*
+ * cli_list_schedule_hook is an iterator callback function.
+ */
+static bool
+cli_list_schedule_hook(void *ctx, SourceTable *table)
+{
+	ListScheduleContext *context = (ListScheduleContext *) ctx;
+
+	return schedule_add_table(context->catalog, context->schedule, table);
+}
+
+
 /*
  * cli_list_sequences implements the command: pgcopydb list sequences
  */
@@ -2156,6 +2466,8 @@ copydb_init_specs_from_listdboptions(CopyDataSpec *copySpecs,
 	options.splitTablesLargerThan = listDBoptions->splitTablesLargerThan;
 	options.splitMaxParts = listDBoptions->splitMaxParts;
 	options.skipCtidSplit = listDBoptions->skipCtidSplit;
+	options.tableJobs = listDBoptions->tableJobs;
+	options.indexJobs = listDBoptions->indexJobs;
 	options.estimateTableSizes = listDBoptions->estimateTableSizes;
 
 	/* process the --resume --not-consistent --snapshot options now */
@@ -41,6 +41,9 @@ typedef struct ListDBOptions
 	SplitTableLargerThan splitTablesLargerThan;
 	int splitMaxParts;
 	bool estimateTableSizes;
+
+	int tableJobs;
+	int indexJobs;
 } ListDBOptions;
 
 
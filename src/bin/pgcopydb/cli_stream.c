@@ -43,6 +43,7 @@ static void cli_stream_apply(int argc, char **argv);
 static void cli_stream_setup(int argc, char **argv);
 static void cli_stream_cleanup(int argc, char **argv);
 static void cli_stream_prune(int argc, char **argv);
+static void cli_stream_ratelimit(int argc, char **argv);
 
 static void cli_stream_prefetch(int argc, char **argv);
 static void cli_stream_catchup(int argc, char **argv);
@@ -98,6 +99,18 @@ static CommandLine stream_prune_command =
 		cli_stream_getopts,
 		cli_stream_prune);
 
+static CommandLine stream_ratelimit_command =
+	make_command(
+		"ratelimit",
+		"Get or set the bandwidth limits of a running pgcopydb process",
+		" --host ... [ --port ... ] [ --max-bandwidth ... ] ",
+		"  --host                  Host of the running pgcopydb follow process to connect to\n"
+		"  --port                  Port of the running pgcopydb follow process to connect to\n"
+		"  --max-bandwidth         Maximum bandwidth used to read from the source, per second\n"
+		"  --max-worker-bandwidth  Maximum bandwidth per worker process, per second\n",
+		cli_stream_getopts,
+		cli_stream_ratelimit);
+
 static CommandLine stream_prefetch_command =
 	make_command(
 		"prefetch",
@@ -189,6 +202,7 @@ static CommandLine *stream_subcommands[] = {
 	&stream_setup_command,
 	&stream_cleanup_command,
 	&stream_prune_command,
+	&stream_ratelimit_command,
 	&stream_prefetch_command,
 	&stream_catchup_command,
 	&stream_replay_command,
@@ -229,6 +243,8 @@ cli_stream_getopts(int argc, char **argv)
 		{ "host", required_argument, NULL, 1001 },
 		{ "port", required_argument, NULL, 1002 },
 		{ "dry-run", no_argument, NULL, 1005 },
+		{ "max-bandwidth", required_argument, NULL, 1006 },
+		{ "max-worker-bandwidth", required_argument, NULL, 1007 },
 		{ "restart", no_argument, NULL, 'r' },
 		{ "resume", no_argument, NULL, 'R' },
 		{ "not-consistent", no_argument, NULL, 'C' },
@@ -379,6 +395,41 @@ cli_stream_getopts(int argc, char **argv)
 				break;
 			}
 
+			case 1006:      /* --max-bandwidth */
+			{
+				if (!cli_parse_bytes_pretty(
+						optarg,
+						&(options.maxBandwidth),
+						(char *) &(options.maxBandwidthPretty),
+						sizeof(options.maxBandwidthPretty)))
+				{
+					log_fatal("Failed to parse --max-bandwidth: \"%s\"",
+							  optarg);
+					++errors;
+				}
+
+				log_trace("--max-bandwidth %s", options.maxBandwidthPretty);
+				break;
+			}
+
+			case 1007:      /* --max-worker-bandwidth */
+			{
+				if (!cli_parse_bytes_pretty(
+						optarg,
+						&(options.maxWorkerBandwidth),
+						(char *) &(options.maxWorkerBandwidthPretty),
+						sizeof(options.maxWorkerBandwidthPretty)))
+				{
+					log_fatal("Failed to parse --max-worker-bandwidth: \"%s\"",
+							  optarg);
+					++errors;
+				}
+
+				log_trace("--max-worker-bandwidth %s",
+						  options.maxWorkerBandwidthPretty);
+				break;
+			}
+
 			case 1003:
 			{
 				if (!parse_pretty_printed_bytes(optarg,
@@ -903,6 +954,90 @@ cli_stream_prune(int argc, char **argv)
 }
 
 
+/*
+ * cli_stream_ratelimit connects to the follow coordinator of a running
+ * pgcopydb clone --follow process to change its bandwidth limits, or just
+ * display them when no limit is given. A limit of zero removes the limit.
+ */
+static void
+cli_stream_ratelimit(int argc, char **argv)
+{
+	if (argc > 0)
+	{
+		commandline_help(stderr);
+		exit(EXIT_CODE_BAD_ARGS);
+	}
+
+	ServiceEndpoint service =
+		ld_service_endpoint(streamDBoptions.host, streamDBoptions.port);
+
+	if (!service.enabled)
+	{
+		log_fatal("Option --host is mandatory");
+		exit(EXIT_CODE_BAD_ARGS);
+	}
+
+	IPCMessage request = { 0 };
+
+	IPC_INIT_MESSAGE(request, IPC_MSG_RATELIMIT);
+	IPCPayloadRateLimit *cmd = (IPCPayloadRateLimit *) request.payload;
+
+	cmd->set_bandwidth =
+		IS_EMPTY_STRING_BUFFER(streamDBoptions.maxBandwidthPretty) ? 0 : 1;
+	cmd->bandwidth = streamDBoptions.maxBandwidth;
+
+	cmd->set_worker_bandwidth =
+		IS_EMPTY_STRING_BUFFER(streamDBoptions.maxWorkerBandwidthPretty) ? 0 : 1;
+	cmd->worker_bandwidth = streamDBoptions.maxWorkerBandwidth;
+
+	request.payload_len = sizeof(IPCPayloadRateLimit);
+
+	IPCMessage response = { 0 };
+
+	if (!ld_service_send_command(service, &request, &response))
+	{
+		log_error("Failed to reach the follow coordinator at %s:%d",
+				  service.host, service.port);
+		exit(EXIT_CODE_INTERNAL_ERROR);
+	}
+
+	if (response.type != IPC_MSG_RATELIMIT_REPLY)
+	{
+		log_error("Unexpected reply from the follow coordinator");
+		exit(EXIT_CODE_INTERNAL_ERROR);
+	}
+
+	IPCPayloadRateLimitReply *reply =
+		(IPCPayloadRateLimitReply *) response.payload;
+
+	char bandwidth[BUFSIZE] = "unlimited";
+	char workerBandwidth[BUFSIZE] = "unlimited";
+	char bytes[BUFSIZE] = { 0 };
+
+	if (reply->bandwidth > 0)
+	{
+		pretty_print_bytes(bytes, sizeof(bytes), reply->bandwidth);
+		sformat(bandwidth, sizeof(bandwidth), "%s/s", bytes);
+	}
+
+	if (reply->worker_bandwidth > 0)
+	{
+		pretty_print_bytes(bytes, sizeof(bytes), reply->worker_bandwidth);
+		sformat(workerBandwidth, sizeof(workerBandwidth), "%s/s", bytes);
+	}
+
+	pretty_print_bytes(bytes, sizeof(bytes), reply->bytes);
+
+	fformat(stdout, "%-20s %s\n", "max-bandwidth", bandwidth);
+	fformat(stdout, "%-20s %s\n", "max-worker-bandwidth", workerBandwidth);
+	fformat(stdout, "%-20s %s\n", "bytes", bytes);
+	fformat(stdout, "%-20s %llu\n", "waits",
+			(unsigned long long) reply->waits);
+	fformat(stdout, "%-20s %llu ms\n", "wait time",
+			(unsigned long long) reply->wait_ms);
+}
+
+
 /*
  * cli_stream_catchup replays the SQL files that already exist, keeping track
  * and updating the replication origin.
@@ -0,0 +1,917 @@
+/*
+ * src/bin/pgcopydb/concurrency.c
+ *   Implementation of the adaptive concurrency controller for the COPY and
+ *   CREATE INDEX worker pools.
+ *
+ * The worker processes are all started at the beginning of the operation, as
+ * usual, and the shared memory area only tracks how many of them may process
+ * a queue message concurrently. This way the controller never has to fork or
+ * kill processes at runtime, and the STOP messages protocol is unchanged.
+ *
+ * The controller itself runs in the supervisor process, every few seconds,
+ * and implements a simple feedback loop:
+ *
+ *  - when most of the active target backends are waiting on locks or I/O,
+ *    park one worker,
+ *
+ *  - when starting a worker did not improve the aggregate throughput, park
+ *    it again and hold for a while,
+ *
+ *  - otherwise, when there is room for one more worker and the target is
+ *    not busy waiting, start one.
+ *
+ * Each decision is logged and recorded in the concurrency_log catalog table.
+ *
+ * The --total-jobs budget is shared by all the worker pools. When workers
+ * of different kinds are waiting for a budget token, the kinds that are the
+ * furthest down the pipeline go first: VACUUM, then CREATE INDEX, then COPY,
+ * and then Large Objects. This keeps the queues short, and the COPY workers
+ * can not fill-in the CREATE INDEX queue while the index workers wait.
+ *
+ * The CREATE INDEX jobs that are idle may lend their CPU to the parallel
+ * workers of a large index build. The parallel workers are reserved for the
+ * duration of the build, so that the target runs no more than --index-jobs
+ * CREATE INDEX processes in total.
+ *
+ * The --index-memory budget is handed out to the CREATE INDEX workers, one
+ * grant per index. An index is granted as much memory as the size of the same
+ * index on the source database, so that large indexes get a bigger slice, and
+ * the grant is then used as its maintenance_work_mem setting. A single index
+ * can not get more than what leaves the minimum grant to each of the other
+ * workers, and when the budget is short, an index gets what is left of it.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "postgres_fe.h"
+
+#include "catalog.h"
+#include "concurrency.h"
+#include "defaults.h"
+#include "file_utils.h"
+#include "log.h"
+#include "signals.h"
+#include "string_utils.h"
+
+
+typedef struct ConcurrencyPoolState
+{
+	int active;                 /* how many workers may run concurrently */
+	int running;                /* how many tokens are currently taken */
+	int minJobs;
+	int maxJobs;
+	bool stopping;              /* a worker received its STOP message */
+} ConcurrencyPoolState;
+
+
+typedef struct ConcurrencyArea
+{
+	bool adaptive;
+	ConcurrencyPoolState pools[CONCURRENCY_POOL_COUNT];
+
+	int totalJobs;              /* --total-jobs budget, zero when unlimited */
+	int busy;                   /* how many budget tokens are taken */
+	int waiting[CONCURRENCY_POOL_COUNT];
+
+	uint64_t indexMemory;       /* --index-memory budget, zero when unused */
+	uint64_t indexMemoryUsed;   /* granted to the running CREATE INDEX */
+
+	int indexBuilding;          /* CREATE INDEX workers building an index */
+	int parallelWorkersInUse;   /* parallel workers of the running builds */
+} ConcurrencyArea;
+
+
+/* budget tokens go to the pools in that order, see above */
+static ConcurrencyPool budgetPriority[] = {
+	CONCURRENCY_POOL_VACUUM,
+	CONCURRENCY_POOL_INDEX,
+	CONCURRENCY_POOL_COPY,
+	CONCURRENCY_POOL_BLOB
+};
+
+
+/* the shared memory area, inherited by sub-processes at fork() time */
+static ConcurrencyArea *area = NULL;
+
+/* budget tokens held by the current process */
+static int budgetHeld[CONCURRENCY_POOL_COUNT] = { 0 };
+
+
+static bool concurrency_count_bytes(ConcurrencyController *controller,
+									uint64_t *bytes);
+static ConcurrencyAction concurrency_decide(ConcurrencyController *controller,
+											int active,
+											uint64_t throughput,
+											int waitRatio,
+											char *reason,
+											size_t size);
+static bool concurrency_log_decision(ConcurrencyController *controller,
+									 ConcurrencyAction action,
+									 int active,
+									 uint64_t throughput,
+									 int waitRatio,
+									 char *reason);
+
+
+/*
+ * concurrency_init creates the shared memory area for the worker pools and
+ * installs the given settings. It must be called before forking the
+ * supervisor processes.
+ */
+bool
+concurrency_init(ConcurrencySettings *settings)
+{
+	if (area == NULL)
+	{
+		void *mem = mmap(NULL, sizeof(ConcurrencyArea),
+						 PROT_READ | PROT_WRITE,
+						 MAP_SHARED | MAP_ANONYMOUS,
+						 -1, 0);
+
+		if (mem == MAP_FAILED)
+		{
+			log_error("Failed to create the adaptive concurrency "
+					  "shared memory area: %m");
+			return false;
+		}
+
+		memset(mem, 0, sizeof(ConcurrencyArea));
+		area = (ConcurrencyArea *) mem;
+	}
+
+	area->adaptive = settings->adaptive;
+	area->totalJobs = settings->totalJobs;
+	area->indexMemory = settings->indexMemory;
+	area->indexMemoryUsed = 0;
+	area->indexBuilding = 0;
+	area->parallelWorkersInUse = 0;
+
+	for (int i = 0; i < CONCURRENCY_POOL_COUNT; i++)
+	{
+		ConcurrencyPoolState *state = &(area->pools[i]);
+
+		state->maxJobs = settings->maxJobs[i];
+		state->minJobs =
+			settings->minJobs[i] < 1 ? 1
+			: settings->minJobs[i] > state->maxJobs ? state->maxJobs
+			: settings->minJobs[i];
+	}
+
+	return true;
+}
+
+
+/*
+ * concurrency_is_adaptive returns true when --adaptive-jobs is in use.
+ */
+bool
+concurrency_is_adaptive(void)
+{
+	return area != NULL && area->adaptive;
+}
+
+
+/*
+ * concurrency_reset prepares the given pool for a new set of workers, all of
+ * them active. The supervisor calls it before forking the workers.
+ */
+void
+concurrency_reset(ConcurrencyPool pool)
+{
+	if (!concurrency_is_adaptive())
+	{
+		return;
+	}
+
+	ConcurrencyPoolState *state = &(area->pools[pool]);
+
+	__atomic_store_n(&(state->active), state->maxJobs, __ATOMIC_RELEASE);
+	__atomic_store_n(&(state->running), 0, __ATOMIC_RELEASE);
+	__atomic_store_n(&(state->stopping), false, __ATOMIC_RELEASE);
+}
+
+
+/*
+ * concurrency_acquire takes a token from the given pool, and parks the
+ * calling worker until one is available. Returns false when the process has
+ * been asked to stop while parked.
+ */
+bool
+concurrency_acquire(ConcurrencyPool pool)
+{
+	if (!concurrency_is_adaptive())
+	{
+		return true;
+	}
+
+	ConcurrencyPoolState *state = &(area->pools[pool]);
+	bool parked = false;
+
+	for (;;)
+	{
+		if (asked_to_stop || asked_to_stop_fast || asked_to_quit)
+		{
+			return false;
+		}
+
+		int running = __atomic_load_n(&(state->running), __ATOMIC_ACQUIRE);
+		int active = __atomic_load_n(&(state->active), __ATOMIC_ACQUIRE);
+
+		/* once the STOP messages are out, every worker must get its own */
+		bool stopping = __atomic_load_n(&(state->stopping), __ATOMIC_ACQUIRE);
+
+		if ((running < active || stopping) &&
+			__atomic_compare_exchange_n(&(state->running),
+										&running,
+										running + 1,
+										false,
+										__ATOMIC_ACQ_REL,
+										__ATOMIC_ACQUIRE))
+		{
+			if (parked)
+			{
+				log_notice("%s worker %d resumes processing",
+						   ConcurrencyPoolToString(pool),
+						   getpid());
+			}
+
+			return true;
+		}
+
+		if (!parked)
+		{
+			log_notice("%s worker %d is parked (%d active workers)",
+					   ConcurrencyPoolToString(pool),
+					   getpid(),
+					   active);
+			parked = true;
+		}
+
+		pg_usleep(100 * 1000); /* 100 ms */
+	}
+
+	return true;
+}
+
+
+/*
+ * concurrency_release gives back the token taken with concurrency_acquire.
+ */
+void
+concurrency_release(ConcurrencyPool pool)
+{
+	if (!concurrency_is_adaptive())
+	{
+		return;
+	}
+
+	(void) __atomic_sub_fetch(&(area->pools[pool].running),
+							  1,
+							  __ATOMIC_ACQ_REL);
+}
+
+
+/*
+ * concurrency_stopping is called by a worker that received a STOP message,
+ * so that the parked workers get to receive theirs.
+ */
+void
+concurrency_stopping(ConcurrencyPool pool)
+{
+	if (!concurrency_is_adaptive())
+	{
+		return;
+	}
+
+	__atomic_store_n(&(area->pools[pool].stopping), true, __ATOMIC_RELEASE);
+}
+
+
+/*
+ * concurrency_get_active returns how many workers of the pool may currently
+ * process a queue message.
+ */
+int
+concurrency_get_active(ConcurrencyPool pool)
+{
+	if (area == NULL)
+	{
+		return 0;
+	}
+
+	return __atomic_load_n(&(area->pools[pool].active), __ATOMIC_ACQUIRE);
+}
+
+
+/*
+ * concurrency_budget_acquire takes a token from the --total-jobs budget, and
+ * waits until one is available and no pool with a higher priority is waiting
+ * for one. Returns false when the process has been asked to stop while
+ * waiting.
+ */
+bool
+concurrency_budget_acquire(ConcurrencyPool pool)
+{
+	if (area == NULL || area->totalJobs == 0)
+	{
+		return true;
+	}
+
+	bool success = false;
+
+	(void) __atomic_add_fetch(&(area->waiting[pool]), 1, __ATOMIC_ACQ_REL);
+
+	while (!(asked_to_stop || asked_to_stop_fast || asked_to_quit))
+	{
+		bool yield = false;
+
+		for (int i = 0; budgetPriority[i] != pool; i++)
+		{
+			ConcurrencyPool other = budgetPriority[i];
+
+			if (__atomic_load_n(&(area->waiting[other]), __ATOMIC_ACQUIRE) > 0)
+			{
+				yield = true;
+				break;
+			}
+		}
+
+		int busy = __atomic_load_n(&(area->busy), __ATOMIC_ACQUIRE);
+
+		if (!yield &&
+			busy < area->totalJobs &&
+			__atomic_compare_exchange_n(&(area->busy),
+										&busy,
+										busy + 1,
+										false,
+										__ATOMIC_ACQ_REL,
+										__ATOMIC_ACQUIRE))
+		{
+			success = true;
+			break;
+		}
+
+		pg_usleep(10 * 1000); /* 10 ms */
+	}
+
+	(void) __atomic_sub_fetch(&(area->waiting[pool]), 1, __ATOMIC_ACQ_REL);
+
+	if (success)
+	{
+		++budgetHeld[pool];
+	}
+
+	return success;
+}
+
+
+/*
+ * concurrency_budget_release gives back the token taken with
+ * concurrency_budget_acquire. It is a no-op when the current process does not
+ * hold a token, so that it is safe to call on every exit path.
+ */
+void
+concurrency_budget_release(ConcurrencyPool pool)
+{
+	if (area == NULL || area->totalJobs == 0 || budgetHeld[pool] == 0)
+	{
+		return;
+	}
+
+	--budgetHeld[pool];
+
+	(void) __atomic_sub_fetch(&(area->busy), 1, __ATOMIC_ACQ_REL);
+}
+
+
+/*
+ * concurrency_budget_held returns true when the current process holds a token
+ * from the --total-jobs budget.
+ */
+bool
+concurrency_budget_held(ConcurrencyPool pool)
+{
+	return area != NULL && area->totalJobs > 0 && budgetHeld[pool] > 0;
+}
+
+
+/*
+ * concurrency_has_index_memory returns true when --index-memory is in use.
+ */
+bool
+concurrency_has_index_memory(void)
+{
+	return area != NULL && area->indexMemory > 0;
+}
+
+
+/*
+ * concurrency_index_memory_acquire grants memory from the --index-memory
+ * budget for building an index of the given size, and waits until at least
+ * the minimum grant is available. Grants are rounded to a kB, the unit of
+ * maintenance_work_mem. Returns false when the process has been asked to stop
+ * while waiting.
+ */
+bool
+concurrency_index_memory_acquire(uint64_t indexBytes, uint64_t *grant)
+{
+	*grant = 0;
+
+	if (!concurrency_has_index_memory())
+	{
+		return true;
+	}
+
+	uint64_t budget = area->indexMemory;
+	uint64_t jobs = area->pools[CONCURRENCY_POOL_INDEX].maxJobs;
+
+	if (jobs < 1)
+	{
+		jobs = 1;
+	}
+
+	/* Postgres accepts maintenance_work_mem values of 1MB and more */
+	uint64_t minGrant = INDEX_MEMORY_MIN_GRANT;
+
+	if (minGrant > budget / jobs)
+	{
+		minGrant = budget / jobs;
+	}
+
+	if (minGrant < 1024 * 1024)
+	{
+		minGrant = 1024 * 1024;
+	}
+
+	/* leave the minimum grant to each of the other workers */
+	uint64_t maxGrant = minGrant;
+
+	if (budget > jobs * minGrant)
+	{
+		maxGrant = budget - (jobs - 1) * minGrant;
+	}
+
+	uint64_t wanted =
+		indexBytes < minGrant ? minGrant
+		: indexBytes > maxGrant ? maxGrant
+		: indexBytes;
+
+	bool waiting = false;
+
+	while (!(asked_to_stop || asked_to_stop_fast || asked_to_quit))
+	{
+		uint64_t used =
+			__atomic_load_n(&(area->indexMemoryUsed), __ATOMIC_ACQUIRE);
+		uint64_t available = used < budget ? budget - used : 0;
+
+		if (available >= minGrant)
+		{
+			uint64_t amount = wanted < available ? wanted : available;
+
+			amount -= amount % 1024;
+
+			if (__atomic_compare_exchange_n(&(area->indexMemoryUsed),
+											&used,
+											used + amount,
+											false,
+											__ATOMIC_ACQ_REL,
+											__ATOMIC_ACQUIRE))
+			{
+				*grant = amount;
+				return true;
+			}
+
+			continue;
+		}
+
+		if (!waiting)
+		{
+			log_notice("CREATE INDEX worker %d waits for index memory "
+					   "(%lld bytes available)",
+					   getpid(),
+					   (long long) available);
+			waiting = true;
+		}
+
+		pg_usleep(100 * 1000); /* 100 ms */
+	}
+
+	return false;
+}
+
+
+/*
+ * concurrency_index_memory_release gives back a grant obtained with
+ * concurrency_index_memory_acquire.
+ */
+void
+concurrency_index_memory_release(uint64_t grant)
+{
+	if (!concurrency_has_index_memory() || grant == 0)
+	{
+		return;
+	}
+
+	(void) __atomic_sub_fetch(&(area->indexMemoryUsed), grant, __ATOMIC_ACQ_REL);
+}
+
+
+/*
+ * concurrency_index_build_start registers that the calling CREATE INDEX
+ * worker is building an index.
+ */
+void
+concurrency_index_build_start(void)
+{
+	if (area == NULL)
+	{
+		return;
+	}
+
+	(void) __atomic_add_fetch(&(area->indexBuilding), 1, __ATOMIC_ACQ_REL);
+}
+
+
+/*
+ * concurrency_index_build_done registers that the calling CREATE INDEX worker
+ * is done building its index, and gives back the parallel workers obtained
+ * with concurrency_index_parallel_acquire.
+ */
+void
+concurrency_index_build_done(int parallelWorkers)
+{
+	if (area == NULL)
+	{
+		return;
+	}
+
+	if (parallelWorkers > 0)
+	{
+		(void) __atomic_sub_fetch(&(area->parallelWorkersInUse),
+								  parallelWorkers,
+								  __ATOMIC_ACQ_REL);
+	}
+
+	(void) __atomic_sub_fetch(&(area->indexBuilding), 1, __ATOMIC_ACQ_REL);
+}
+
+
+/*
+ * concurrency_index_parallel_acquire reserves up to the given count of
+ * parallel workers for an index build, within the CREATE INDEX jobs that are
+ * neither building an index nor already reserved by another parallel build.
+ * Returns how many workers have been reserved, possibly zero.
+ *
+ * The count is computed and reserved in a single compare-and-swap, so that
+ * two large indexes starting together do not both take the same idle jobs.
+ */
+int
+concurrency_index_parallel_acquire(int wanted)
+{
+	if (area == NULL || wanted <= 0)
+	{
+		return 0;
+	}
+
+	int jobs = area->pools[CONCURRENCY_POOL_INDEX].maxJobs;
+
+	for (;;)
+	{
+		int building =
+			__atomic_load_n(&(area->indexBuilding), __ATOMIC_ACQUIRE);
+		int inUse =
+			__atomic_load_n(&(area->parallelWorkersInUse), __ATOMIC_ACQUIRE);
+
+		int idle = jobs - building - inUse;
+		int degree = wanted < idle ? wanted : idle;
+
+		if (degree <= 0)
+		{
+			return 0;
+		}
+
+		if (__atomic_compare_exchange_n(&(area->parallelWorkersInUse),
+										&inUse,
+										inUse + degree,
+										false,
+										__ATOMIC_ACQ_REL,
+										__ATOMIC_ACQUIRE))
+		{
+			return degree;
+		}
+	}
+}
+
+
+/*
+ * concurrency_controller_init prepares a controller for the given pool. The
+ * catalog must be open in the supervisor process.
+ */
+bool
+concurrency_controller_init(ConcurrencyController *controller,
+							ConcurrencyPool pool,
+							DatabaseCatalog *catalog,
+							char *target_pguri)
+{
+	*controller = (ConcurrencyController) {
+		.pool = pool,
+		.catalog = catalog,
+		.target_pguri = target_pguri,
+		.lastAction = CONCURRENCY_ACTION_NONE
+	};
+
+	if (!concurrency_is_adaptive())
+	{
+		return true;
+	}
+
+	if (!pgsql_init(&(controller->target), target_pguri, PGSQL_CONN_TARGET))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* keep the connection open in between controller ticks */
+	controller->target.connectionStatementType =
+		PGSQL_CONNECTION_MULTI_STATEMENT;
+
+	ConcurrencyPoolState *state = &(area->pools[pool]);
+
+	log_info("Adaptive %s concurrency: between %d and %d active workers",
+			 ConcurrencyPoolToString(pool),
+			 state->minJobs,
+			 state->maxJobs);
+
+	return true;
+}
+
+
+/*
+ * concurrency_controller_finish closes the controller target connection.
+ */
+void
+concurrency_controller_finish(ConcurrencyController *controller)
+{
+	if (!concurrency_is_adaptive())
+	{
+		return;
+	}
+
+	(void) pgsql_finish(&(controller->target));
+}
+
+
+/*
+ * concurrency_tick is called repeatedly from the supervisor process while
+ * waiting for its workers, and runs the controller every
+ * CONCURRENCY_TICK_INTERVAL seconds.
+ */
+bool
+concurrency_tick(void *context)
+{
+	ConcurrencyController *controller = (ConcurrencyController *) context;
+
+	if (!concurrency_is_adaptive())
+	{
+		return true;
+	}
+
+	time_t now = time(NULL);
+
+	if (controller->lastTick > 0 &&
+		(now - controller->lastTick) < CONCURRENCY_TICK_INTERVAL)
+	{
+		return true;
+	}
+
+	uint64_t bytes = 0;
+
+	if (!concurrency_count_bytes(controller, &bytes))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* the first tick only installs the baseline */
+	if (controller->lastTick == 0)
+	{
+		controller->lastTick = now;
+		controller->lastBytes = bytes;
+		return true;
+	}
+
+	uint64_t throughput =
+		bytes > controller->lastBytes
+		? (bytes - controller->lastBytes) / (now - controller->lastTick)
+		: 0;
+
+	int waitRatio = 0;
+
+	if (!pgsql_get_wait_ratio(&(controller->target), &waitRatio))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	int active = concurrency_get_active(controller->pool);
+	char reason[BUFSIZE] = { 0 };
+
+	ConcurrencyAction action =
+		concurrency_decide(controller,
+						   active,
+						   throughput,
+						   waitRatio,
+						   reason,
+						   sizeof(reason));
+
+	if (action != CONCURRENCY_ACTION_NONE)
+	{
+		int newActive =
+			action == CONCURRENCY_ACTION_START ? active + 1 : active - 1;
+
+		__atomic_store_n(&(area->pools[controller->pool].active),
+						 newActive,
+						 __ATOMIC_RELEASE);
+
+		log_info("Adaptive %s concurrency: %s one worker, "
+				 "%d active workers: %s",
+				 ConcurrencyPoolToString(controller->pool),
+				 action == CONCURRENCY_ACTION_START ? "start" : "park",
+				 newActive,
+				 reason);
+
+		if (!concurrency_log_decision(controller,
+									  action,
+									  newActive,
+									  throughput,
+									  waitRatio,
+									  reason))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+	}
+
+	controller->lastTick = now;
+	controller->lastBytes = bytes;
+	controller->lastThroughput = throughput;
+	controller->lastAction = action;
+
+	return true;
+}
+
+
+/*
+ * concurrency_decide implements the controller rules, see the top of this
+ * file.
+ */
+static ConcurrencyAction
+concurrency_decide(ConcurrencyController *controller,
+				   int active,
+				   uint64_t throughput,
+				   int waitRatio,
+				   char *reason,
+				   size_t size)
+{
+	ConcurrencyPoolState *state = &(area->pools[controller->pool]);
+
+	char bytesPerSec[BUFSIZE] = { 0 };
+	pretty_print_bytes(bytesPerSec, sizeof(bytesPerSec), throughput);
+
+	if (controller->holdTicks > 0)
+	{
+		--controller->holdTicks;
+		return CONCURRENCY_ACTION_NONE;
+	}
+
+	if (waitRatio >= CONCURRENCY_WAIT_RATIO_HIGH && active > state->minJobs)
+	{
+		sformat(reason, size,
+				"%d%% of the target backends are waiting", waitRatio);
+		controller->holdTicks = 1;
+		return CONCURRENCY_ACTION_PARK;
+	}
+
+	if (controller->lastAction == CONCURRENCY_ACTION_START &&
+		throughput < controller->lastThroughput * CONCURRENCY_MIN_GAIN &&
+		active > state->minJobs)
+	{
+		char lastBytesPerSec[BUFSIZE] = { 0 };
+		pretty_print_bytes(lastBytesPerSec,
+						   sizeof(lastBytesPerSec),
+						   controller->lastThroughput);
+
+		sformat(reason, size,
+				"throughput %s/s did not improve from %s/s",
+				bytesPerSec,
+				lastBytesPerSec);
+		controller->holdTicks = CONCURRENCY_HOLD_TICKS;
+		return CONCURRENCY_ACTION_PARK;
+	}
+
+	if (waitRatio < CONCURRENCY_WAIT_RATIO_LOW && active < state->maxJobs)
+	{
+		sformat(reason, size,
+				"throughput %s/s with %d%% of the target backends waiting",
+				bytesPerSec,
+				waitRatio);
+		return CONCURRENCY_ACTION_START;
+	}
+
+	return CONCURRENCY_ACTION_NONE;
+}
+
+
+/*
+ * concurrency_count_bytes returns the amount of work done so far in the
+ * controller pool: bytes copied for COPY, and the size of the tables that
+ * have been indexed for CREATE INDEX.
+ */
+static bool
+concurrency_count_bytes(ConcurrencyController *controller, uint64_t *bytes)
+{
+	CatalogBytesCounts count = { 0 };
+
+	if (!catalog_count_bytes(controller->catalog, &count))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	*bytes =
+		controller->pool == CONCURRENCY_POOL_COPY
+		? count.done + count.inProgress
+		: count.indexed;
+
+	return true;
+}
+
+
+/*
+ * concurrency_log_decision records a controller decision in the catalogs.
+ */
+static bool
+concurrency_log_decision(ConcurrencyController *controller,
+						 ConcurrencyAction action,
+						 int active,
+						 uint64_t throughput,
+						 int waitRatio,
+						 char *reason)
+{
+	ConcurrencyPoolState *state = &(area->pools[controller->pool]);
+
+	CatalogConcurrencyDecision decision = {
+		.timestamp = time(NULL),
+		.section = ConcurrencyPoolToString(controller->pool),
+		.action = action == CONCURRENCY_ACTION_START ? "start" : "park",
+		.active = active,
+		.minJobs = state->minJobs,
+		.maxJobs = state->maxJobs,
+		.throughput = throughput,
+		.waitRatio = waitRatio,
+		.reason = reason
+	};
+
+	return catalog_add_concurrency_decision(controller->catalog, &decision);
+}
+
+
+/*
+ * ConcurrencyPoolToString returns a string representation of a pool.
+ */
+char *
+ConcurrencyPoolToString(ConcurrencyPool pool)
+{
+	switch (pool)
+	{
+		case CONCURRENCY_POOL_COPY:
+		{
+			return "COPY";
+		}
+
+		case CONCURRENCY_POOL_INDEX:
+		{
+			return "CREATE INDEX";
+		}
+
+		case CONCURRENCY_POOL_VACUUM:
+		{
+			return "VACUUM";
+		}
+
+		case CONCURRENCY_POOL_BLOB:
+		{
+			return "Large Objects";
+		}
+
+		default:
+		{
+			return "unknown";
+		}
+	}
+}
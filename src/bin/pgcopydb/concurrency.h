@@ -0,0 +1,117 @@
+/*
+ * src/bin/pgcopydb/concurrency.h
+ *   Adaptive concurrency and shared budgets for the worker pools
+ */
+
+#ifndef CONCURRENCY_H
+#define CONCURRENCY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "catalog.h"
+#include "pgsql.h"
+
+/*
+ * With --adaptive-jobs the supervisors still start --table-jobs COPY workers
+ * and --index-jobs CREATE INDEX workers, and a controller then decides how
+ * many of them are active at any time, within the --min-table-jobs and
+ * --min-index-jobs lower bounds.
+ *
+ * Workers take a token from a shared memory area before receiving their next
+ * message from the queue, and give it back when done with the message. When
+ * the controller lowers the active count, the workers that can not take a
+ * token are parked until the count goes up again.
+ *
+ * With --total-jobs the COPY, CREATE INDEX, VACUUM, and Large Objects worker
+ * pools also share a global budget: a worker takes a budget token for each
+ * work item it receives, so that no more than --total-jobs work items are
+ * processed at the same time, whatever their kind.
+ *
+ * With --index-memory the CREATE INDEX workers share a maintenance_work_mem
+ * budget: each index gets a grant sized from the size of the same index on
+ * the source database, taken from the budget for the duration of the build.
+ *
+ * The area also counts the CREATE INDEX workers that are building an index,
+ * so that with --parallel-index-larger-than a large index may use the CPU of
+ * the idle index workers for a parallel build.
+ */
+typedef enum
+{
+	CONCURRENCY_POOL_COPY = 0,
+	CONCURRENCY_POOL_INDEX,
+	CONCURRENCY_POOL_VACUUM,
+	CONCURRENCY_POOL_BLOB,
+	CONCURRENCY_POOL_COUNT
+} ConcurrencyPool;
+
+
+typedef struct ConcurrencySettings
+{
+	bool adaptive;
+	int totalJobs;              /* --total-jobs, zero when not used */
+	uint64_t indexMemory;       /* --index-memory in bytes, zero when not used */
+	int minJobs[CONCURRENCY_POOL_COUNT];
+	int maxJobs[CONCURRENCY_POOL_COUNT];
+} ConcurrencySettings;
+
+
+typedef enum
+{
+	CONCURRENCY_ACTION_NONE = 0,
+	CONCURRENCY_ACTION_START,
+	CONCURRENCY_ACTION_PARK
+} ConcurrencyAction;
+
+
+/* the controller runs in the supervisor process, see concurrency_tick */
+typedef struct ConcurrencyController
+{
+	ConcurrencyPool pool;
+	DatabaseCatalog *catalog;
+
+	PGSQL target;
+	char *target_pguri;
+
+	time_t lastTick;
+	uint64_t lastBytes;
+	uint64_t lastThroughput;    /* bytes per second */
+
+	ConcurrencyAction lastAction;
+	int holdTicks;
+} ConcurrencyController;
+
+
+bool concurrency_init(ConcurrencySettings *settings);
+bool concurrency_is_adaptive(void);
+
+void concurrency_reset(ConcurrencyPool pool);
+bool concurrency_acquire(ConcurrencyPool pool);
+void concurrency_release(ConcurrencyPool pool);
+void concurrency_stopping(ConcurrencyPool pool);
+
+int concurrency_get_active(ConcurrencyPool pool);
+
+bool concurrency_budget_acquire(ConcurrencyPool pool);
+void concurrency_budget_release(ConcurrencyPool pool);
+bool concurrency_budget_held(ConcurrencyPool pool);
+
+bool concurrency_has_index_memory(void);
+bool concurrency_index_memory_acquire(uint64_t indexBytes, uint64_t *grant);
+void concurrency_index_memory_release(uint64_t grant);
+
+void concurrency_index_build_start(void);
+void concurrency_index_build_done(int parallelWorkers);
+int concurrency_index_parallel_acquire(int wanted);
+
+bool concurrency_controller_init(ConcurrencyController *controller,
+								 ConcurrencyPool pool,
+								 DatabaseCatalog *catalog,
+								 char *target_pguri);
+bool concurrency_tick(void *context);
+void concurrency_controller_finish(ConcurrencyController *controller);
+
+char * ConcurrencyPoolToString(ConcurrencyPool pool);
+
+#endif /* CONCURRENCY_H */
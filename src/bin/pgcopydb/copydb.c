@@ -12,12 +12,14 @@
 #include "parson.h"
 
 #include "cli_common.h"
+#include "concurrency.h"
 #include "copydb.h"
 #include "env_utils.h"
 #include "lock_utils.h"
 #include "log.h"
 #include "parsing_utils.h"
 #include "pidfile.h"
+#include "ratelimit.h"
 #include "schema.h"
 #include "signals.h"
 #include "string_utils.h"
@@ -154,6 +156,7 @@ copydb_init_workdir(CopyDataSpec *copySpecs,
 		cfPaths->schemadir,
 		cfPaths->cdc.dir,
 		cfPaths->compare.dir,
+		cfPaths->spool.dir,
 		NULL
 	};
 
@@ -166,6 +169,21 @@ copydb_init_workdir(CopyDataSpec *copySpecs,
 		}
 	}
 
+	/*
+	 * The spool done files signal that the source snapshot may be closed
+	 * early (see --spool), they must not survive from a previous run.
+	 */
+	if (createWorkDir && serviceName == NULL)
+	{
+		if (!unlink_file(cfPaths->spool.tablesDoneFile) ||
+			!unlink_file(cfPaths->spool.blobsDoneFile) ||
+			!unlink_file(cfPaths->spool.extensionsDoneFile))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+	}
+
 	return true;
 }
 
@@ -403,6 +421,21 @@ copydb_prepare_filepaths(CopyFilePaths *cfPaths,
 			"%s/target-data.json",
 			cfPaths->compare.dir);
 
+	/* COPY data spool files, see --spool */
+	sformat(cfPaths->spool.dir, MAXPGPATH, "%s/spool", cfPaths->topdir);
+
+	sformat(cfPaths->spool.tablesDoneFile, MAXPGPATH,
+			"%s/tables.done",
+			cfPaths->spool.dir);
+
+	sformat(cfPaths->spool.blobsDoneFile, MAXPGPATH,
+			"%s/blobs.done",
+			cfPaths->spool.dir);
+
+	sformat(cfPaths->spool.extensionsDoneFile, MAXPGPATH,
+			"%s/extensions.done",
+			cfPaths->spool.dir);
+
 	return true;
 }
 
@@ -517,6 +550,10 @@ copydb_init_specs(CopyDataSpec *specs,
 		.noRolesPasswords = options->noRolesPasswords,
 		.failFast = options->failFast,
 		.useCopyBinary = options->useCopyBinary,
+		.copyFormat = options->copyFormat,
+		.useCopyThreads = options->useCopyThreads,
+		.useSpool = options->useSpool,
+		.unloggedLoad = options->unloggedLoad,
 
 		.restart = options->restart,
 		.resume = options->resume,
@@ -534,8 +571,18 @@ copydb_init_specs(CopyDataSpec *specs,
 		/* at the moment we don't have --vacuumJobs separately */
 		.vacuumJobs = options->tableJobs,
 
+		.adaptiveJobs = options->adaptiveJobs,
+		.minTableJobs = options->minTableJobs,
+		.minIndexJobs = options->minIndexJobs,
+		.totalJobs = options->totalJobs,
+		.indexMemory = options->indexMemory,
+		.parallelIndexLargerThan = options->parallelIndexLargerThan,
+		.parallelVacuumLargerThan = options->parallelVacuumLargerThan,
+		.fkeyJobs = options->fkeyJobs,
+
 		.splitTablesLargerThan = options->splitTablesLargerThan,
 		.splitMaxParts = options->splitMaxParts,
+		.copyChunkSize = options->copyChunkSize,
 		.estimateTableSizes = options->estimateTableSizes,
 
 		.preDataQueue = { NULL, -1 },
@@ -613,6 +660,112 @@ copydb_init_specs(CopyDataSpec *specs,
 		specs->skipLargeObjects = true;
 	}
 
+	/* --copy-format takes precedence over --use-copy-binary */
+	if (specs->copyFormat == COPY_FORMAT_UNKNOWN)
+	{
+		specs->copyFormat =
+			specs->useCopyBinary ? COPY_FORMAT_BINARY : COPY_FORMAT_TEXT;
+	}
+
+	specs->useCopyBinary = specs->copyFormat == COPY_FORMAT_BINARY;
+
+	/* COPY chunks are committed and tracked on a single target database */
+	if (specs->copyChunkSize > 0 &&
+		(specs->useSpool || specs->connStrings.fanoutCount > 0))
+	{
+		log_warn("Ignoring --copy-chunk-size, which is not supported "
+				 "with --spool or --fanout-target");
+		specs->copyChunkSize = 0;
+	}
+
+	/* tables are switched back to LOGGED in the index and vacuum chain */
+	if (specs->unloggedLoad && specs->section != DATA_SECTION_ALL)
+	{
+		log_warn("Ignoring --unlogged-load, which is only supported "
+				 "with pgcopydb clone and pgcopydb copy db");
+		specs->unloggedLoad = false;
+	}
+
+	/*
+	 * The bandwidth limiter is shared with all the sub-processes that we fork
+	 * from now on, and can be changed at runtime from the follow coordinator.
+	 */
+	RateLimitSettings rateLimit = {
+		.bytesPerSec = options->maxBandwidth,
+		.workerBytesPerSec = options->maxWorkerBandwidth
+	};
+
+	if (!ratelimit_init(&rateLimit))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	if (options->maxBandwidth > 0)
+	{
+		log_info("Limiting source bandwidth to %s/s",
+				 options->maxBandwidthPretty);
+	}
+
+	if (options->maxWorkerBandwidth > 0)
+	{
+		log_info("Limiting source bandwidth to %s/s per worker process",
+				 options->maxWorkerBandwidthPretty);
+	}
+
+	/*
+	 * With --adaptive-jobs the COPY and CREATE INDEX supervisors tune the
+	 * number of active workers at runtime, with --total-jobs all the workers
+	 * share a jobs budget, and with --index-memory the CREATE INDEX workers
+	 * share a maintenance_work_mem budget, using a shared memory area.
+	 */
+	ConcurrencySettings concurrency = {
+		.adaptive = specs->adaptiveJobs,
+		.totalJobs = specs->totalJobs,
+		.indexMemory = specs->indexMemory,
+		.minJobs = { specs->minTableJobs, specs->minIndexJobs, 1, 1 },
+		.maxJobs = {
+			specs->tableJobs,
+			specs->indexJobs,
+			specs->vacuumJobs,
+			specs->lObjectJobs
+		}
+	};
+
+	if (!concurrency_init(&concurrency))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	if (specs->totalJobs > 0)
+	{
+		log_info("Sharing a budget of %d concurrent jobs between COPY, "
+				 "CREATE INDEX, VACUUM, and Large Objects workers",
+				 specs->totalJobs);
+	}
+
+	if (specs->indexMemory > 0)
+	{
+		log_info("Sharing a budget of %s of maintenance_work_mem between "
+				 "%d CREATE INDEX workers",
+				 options->indexMemoryPretty,
+				 specs->indexJobs);
+	}
+
+	if (specs->parallelIndexLargerThan > 0)
+	{
+		log_info("Using idle CREATE INDEX workers for parallel builds of "
+				 "btree indexes larger than %s",
+				 options->parallelIndexLargerThanPretty);
+	}
+
+	if (specs->parallelVacuumLargerThan > 0)
+	{
+		log_info("Using parallel VACUUM for tables larger than %s",
+				 options->parallelVacuumLargerThanPretty);
+	}
+
 	return true;
 }
 
@@ -657,14 +810,28 @@ copydb_init_table_specs(CopyTableDataSpec *tableSpecs,
 		tableSpecs->part.min = source->partition.min;
 		tableSpecs->part.max = source->partition.max;
 
+		tableSpecs->part.typed = source->partition.typed;
+
+		strlcpy(tableSpecs->part.minKey,
+				source->partition.minKey,
+				sizeof(tableSpecs->part.minKey));
+
+		strlcpy(tableSpecs->part.maxKey,
+				source->partition.maxKey,
+				sizeof(tableSpecs->part.maxKey));
+
 		/* tables that are partitioned without a partKey are using CTID */
 		if (!IS_EMPTY_STRING_BUFFER(source->partKey))
 		{
-			strlcpy(tableSpecs->part.partKey, source->partKey, NAMEDATALEN);
+			strlcpy(tableSpecs->part.partKey,
+					source->partKey,
+					sizeof(tableSpecs->part.partKey));
 		}
 		else
 		{
-			strlcpy(tableSpecs->part.partKey, "ctid", NAMEDATALEN);
+			strlcpy(tableSpecs->part.partKey,
+					"ctid",
+					sizeof(tableSpecs->part.partKey));
 		}
 	}
 	else
@@ -684,6 +851,87 @@ copydb_init_table_specs(CopyTableDataSpec *tableSpecs,
 }
 
 
+/*
+ * copydb_prepare_target_connection prepares the target connection of a worker
+ * process for its next work item. The connection is kept open between items:
+ * the session is reset to our target settings, and a new connection is only
+ * opened for the first item or when the previous connection has been lost.
+ */
+bool
+copydb_prepare_target_connection(PGSQL *dst, ConnectionReuse *reuse)
+{
+	if (!pgsql_reset_session(dst, dstSettings))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	if (dst->connection != NULL)
+	{
+		++(reuse->reused);
+		copydb_connection_reused(reuse, dst);
+
+		return true;
+	}
+
+	/* pgsql_set_gucs opens a multi-statements connection */
+	if (!pgsql_set_gucs(dst, dstSettings))
+	{
+		log_error("Failed to set our GUC settings on the target connection, "
+				  "see above for details");
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * copydb_connection_reused accounts for the set-up time of the given open
+ * connection as saved, when a work item uses it rather than a new connection.
+ * The retry policy registers the start and end time of the connection set-up.
+ */
+void
+copydb_connection_reused(ConnectionReuse *reuse, PGSQL *pgsql)
+{
+	instr_time duration = pgsql->retryPolicy.connectTime;
+	INSTR_TIME_SUBTRACT(duration, pgsql->retryPolicy.startTime);
+
+	reuse->savedUs += INSTR_TIME_GET_MICROSEC(duration);
+}
+
+
+/*
+ * copydb_report_connection_reuse adds the connection set-up time saved by a
+ * worker process to the "Connections re-used" timing of the summary.
+ */
+bool
+copydb_report_connection_reuse(DatabaseCatalog *catalog,
+							   ConnectionReuse *reuse)
+{
+	if (reuse->reused == 0)
+	{
+		return true;
+	}
+
+	log_debug("Re-used connections for %lld work items, saving %lldms",
+			  (long long) reuse->reused,
+			  (long long) (reuse->savedUs / 1000));
+
+	if (!summary_increment_timing(catalog,
+								  TIMING_SECTION_CONN_REUSE,
+								  reuse->reused,
+								  0, /* bytes */
+								  reuse->savedUs / 1000))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	return true;
+}
+
+
 /*
  * copydb_fatal_exit sends a termination signal to all the subprocess and waits
  * until all the known subprocess are finished, then returns true.
@@ -717,6 +965,20 @@ copydb_fatal_exit(void)
  */
 bool
 copydb_wait_for_subprocesses(bool failFast)
+{
+	return copydb_wait_for_subprocesses_hook(failFast, NULL, NULL);
+}
+
+
+/*
+ * copydb_wait_for_subprocesses_hook waits for sub-processes the same way as
+ * copydb_wait_for_subprocesses, and calls the given hook in between polls.
+ * When the hook fails, it is not called again.
+ */
+bool
+copydb_wait_for_subprocesses_hook(bool failFast,
+								  CopyDBWaitHook *hook,
+								  void *context)
 {
 	bool allReturnCodeAreZero = true;
 	log_debug("Waiting for sub-processes to finish");
@@ -745,6 +1007,13 @@ copydb_wait_for_subprocesses(bool failFast)
 
 			case 0:
 			{
+				if (hook != NULL && !(*hook)(context))
+				{
+					log_warn("Failed to run the sub-processes wait hook, "
+							 "see above for details");
+					hook = NULL;
+				}
+
 				/*
 				 * We're using WNOHANG, 0 means there are no stopped or exited
 				 * children. Sleep for awhile and ask again later.
@@ -890,6 +1159,12 @@ copydb_register_sysv_queue(SysVResArray *array, Queue *queue)
 bool
 copydb_unlink_sysv_queue(SysVResArray *array, Queue *queue)
 {
+	/* shared memory ring queues are not registered */
+	if (queue->kind != QUEUE_KIND_SYSV)
+	{
+		return true;
+	}
+
 	for (int i = 0; i < array->count; i++)
 	{
 		SysVRes *res = &(array->array[i]);
@@ -110,6 +110,9 @@ typedef struct TransactionSnapshot
 
 	char snapshot[BUFSIZE];
 
+	/* process that holds the snapshot, see copydb_spool_close_snapshot */
+	pid_t pid;
+
 	/* indicator for read-only source db */
 	bool isReadOnly;
 } TransactionSnapshot;
@@ -124,6 +127,10 @@ typedef struct CopyTableDataPartSpec
 	int64_t min;                /* WHERE partKey >= min */
 	int64_t max;                /*   AND partKey  < max */
 
+	bool typed;                 /* see SourceTableParts */
+	char minKey[BUFSIZE];
+	char maxKey[BUFSIZE];
+
 	char partKey[PG_NAMEDATALEN];
 } CopyTableDataPartSpec;
 
@@ -151,6 +158,7 @@ typedef struct CopyTableDataSpec
 	CopyTableDataPartSpec part;
 
 	/* summary/activity tracking */
+	uint32_t countParts;
 	uint32_t countPartsDone;
 	pid_t partsDonePid;
 	bool allPartsAreDone;
@@ -161,6 +169,58 @@ typedef struct CopyTableDataSpec
 } CopyTableDataSpec;
 
 
+/*
+ * With --spool the table data is first copied from the source into a series
+ * of compressed segment files, and then drained from the segment files into
+ * the target database, one transaction per segment.
+ */
+typedef struct CopySpool
+{
+	uint32_t oid;
+	int partNumber;
+	pid_t pid;
+
+	char dir[MAXPGPATH];        /* /tmp/pgcopydb/spool/<oid>.<part> */
+
+	int segments;
+	uint64_t bytes;             /* uncompressed COPY data */
+	uint64_t spoolTime;         /* all the data is in the spool */
+
+	int drained;                /* segments committed on the target */
+	uint64_t drainTime;         /* all the segments have been drained */
+	uint64_t pendingXid;        /* target xid of the segment being drained */
+} CopySpool;
+
+
+/*
+ * With --copy-chunk-size the COPY of a table (or table part) is split in a
+ * series of chunks, each committed in its own transaction on the target. The
+ * position is either a block number (ctid ranges) or a value of the part key,
+ * and tells where to restart the COPY on retry or --resume.
+ */
+typedef struct CopyChunk
+{
+	uint32_t oid;
+	int partNumber;
+	pid_t pid;
+
+	int64_t position;           /* next block number, or key value, to copy */
+	int chunks;                 /* chunks committed on the target */
+	uint64_t bytes;             /* bytes committed on the target */
+	uint64_t doneTime;          /* all the chunks have been committed */
+
+	/* the running plan, which idle workers may split, see chunk_steal */
+	int64_t hi;                 /* end of the range to copy, exclusive */
+	int64_t width;              /* chunk width, in blocks or key values */
+	bool unbounded;             /* the last chunk has no upper bound */
+
+	/* the chunk being sent, registered before its target transaction ends */
+	uint64_t pendingXid;        /* target transaction id */
+	int64_t pendingPosition;    /* position once the chunk is committed */
+	bool pendingLast;           /* the chunk is the last one */
+} CopyChunk;
+
+
 typedef struct CopyIndexSpec
 {
 	SourceIndex *sourceIndex;
@@ -275,6 +335,17 @@ typedef struct MultiDbTableEntry
 } MultiDbTableEntry;
 
 
+/*
+ * Worker processes keep their target connection open between work items, and
+ * account for the connection set-up time that this saves.
+ */
+typedef struct ConnectionReuse
+{
+	uint64_t reused;            /* work items that re-used a connection */
+	uint64_t savedUs;           /* connection set-up time saved */
+} ConnectionReuse;
+
+
 /* all that's needed to start a TABLE DATA copy for a whole database */
 typedef struct CopyDataSpec
 {
@@ -289,6 +360,9 @@ typedef struct CopyDataSpec
 	ConnStrings connStrings;
 	TransactionSnapshot sourceSnapshot;
 
+	/* COPY worker connections to the --fanout-target databases */
+	PGSQL fanoutDst[MAX_FANOUT_TARGETS];
+
 	CopyDataSection section;
 	RestoreOptions restoreOptions;
 	bool roles;
@@ -302,6 +376,11 @@ typedef struct CopyDataSpec
 	bool skipCtidSplit;
 	bool noRolesPasswords;
 	bool useCopyBinary;
+	CopyFormat copyFormat;
+	bool useCopyThreads;
+	bool useSpool;
+	bool unloggedLoad;
+	bool walSkip;               /* target wal_level is minimal */
 
 	bool restart;
 	bool resume;
@@ -337,12 +416,24 @@ typedef struct CopyDataSpec
 	int vacuumJobs;
 	int lObjectJobs;
 
+	bool adaptiveJobs;          /* --adaptive-jobs, see concurrency.c */
+	int minTableJobs;
+	int minIndexJobs;
+	int totalJobs;              /* --total-jobs, zero when not used */
+	uint64_t indexMemory;       /* --index-memory, zero when not used */
+	uint64_t parallelIndexLargerThan; /* zero when not used */
+	uint64_t parallelVacuumLargerThan; /* zero when not used */
+	int fkeyJobs;               /* --fkey-jobs, zero when not used */
+
 	SplitTableLargerThan splitTablesLargerThan;
 	int splitMaxParts;
 	bool estimateTableSizes;
 
+	uint64_t copyChunkSize;     /* --copy-chunk-size, 0 when disabled */
+
 	Queue preDataQueue;         /* for --all-databases Phase I parallel pre-data */
 	Queue copyQueue;
+	Queue drainQueue;           /* --spool: tables to drain from the spool */
 	Queue indexQueue;
 	Queue vacuumQueue;
 	Queue loQueue;
@@ -392,11 +483,22 @@ bool copydb_init_table_specs(CopyTableDataSpec *tableSpecs,
 							 SourceTable *source,
 							 int partNumber);
 
+bool copydb_prepare_target_connection(PGSQL *dst, ConnectionReuse *reuse);
+void copydb_connection_reused(ConnectionReuse *reuse, PGSQL *pgsql);
+bool copydb_report_connection_reuse(DatabaseCatalog *catalog,
+									ConnectionReuse *reuse);
+
 bool copydb_export_snapshot(TransactionSnapshot *snapshot);
 
 bool copydb_fatal_exit(void);
 bool copydb_wait_for_subprocesses(bool failFast);
 
+typedef bool (CopyDBWaitHook)(void *context);
+
+bool copydb_wait_for_subprocesses_hook(bool failFast,
+									   CopyDBWaitHook *hook,
+									   void *context);
+
 bool copydb_register_sysv_semaphore(SysVResArray *array, Semaphore *semaphore);
 bool copydb_register_sysv_queue(SysVResArray *array, Queue *queue);
 
@@ -502,6 +604,7 @@ bool copydb_matview_refresh_is_filtered_out(CopyDataSpec *specs,
 											uint32_t oid);
 
 bool copydb_prepare_table_specs(CopyDataSpec *specs, PGSQL *pgsql);
+bool copydb_prepare_split_auto(CopyDataSpec *specs);
 bool copydb_prepare_index_specs(CopyDataSpec *specs, PGSQL *pgsql);
 bool copydb_prepare_namespace_specs(CopyDataSpec *specs, PGSQL *pgsql);
 bool copydb_fetch_filtered_oids(CopyDataSpec *specs, PGSQL *pgsql);
@@ -515,12 +618,12 @@ bool copydb_schema_already_exists(CopyDataSpec *specs,
 bool copydb_copy_all_table_data(CopyDataSpec *specs);
 bool copydb_process_table_data(CopyDataSpec *specs);
 
-bool copydb_start_copy_supervisor(CopyDataSpec *specs);
+bool copydb_start_copy_supervisor(CopyDataSpec *specs, pid_t *pidOut);
 bool copydb_copy_supervisor(CopyDataSpec *specs);
 bool copydb_copy_start_worker_queue_tables(CopyDataSpec *specs);
 bool copydb_copy_worker_queue_tables(CopyDataSpec *specs);
 bool copydb_copy_supervisor_send_stop(CopyDataSpec *specs);
-bool copydb_start_table_data_workers(CopyDataSpec *specs);
+bool copydb_start_table_data_workers(CopyDataSpec *specs, pid_t *pids);
 bool copydb_table_data_worker(CopyDataSpec *specs);
 
 bool copydb_add_copy(CopyDataSpec *specs, uint32_t oid, uint32_t part);
@@ -536,6 +639,19 @@ bool copydb_copy_worker_queue_tables_multidb(CopyDataSpec *parentSpecs);
 bool copydb_copy_table(CopyDataSpec *specs, PGSQL *src, PGSQL *dst,
 					   CopyTableDataSpec *tableSpecs);
 
+bool copydb_prepare_copy_targets(CopyDataSpec *specs,
+								 CopyTableDataSpec *tableSpecs,
+								 PGSQL *dst,
+								 PGSQL **dsts,
+								 int *targets,
+								 int *dstCount);
+
+bool copydb_mark_copy_targets_done(CopyDataSpec *specs,
+								   CopyTableDataSpec *tableSpecs,
+								   CopyStats *stats,
+								   PGSQL **dsts,
+								   int *targets);
+
 
 bool copydb_table_create_lockfile(CopyDataSpec *specs,
 								  CopyTableDataSpec *tableSpecs,
@@ -550,12 +666,19 @@ bool copydb_table_parts_are_all_done(CopyDataSpec *specs,
 									 bool *allPartsDone,
 									 bool *isBeingProcessed);
 
+bool copydb_prepare_copy_args(CopyDataSpec *specs,
+							  CopyTableDataSpec *tableSpecs,
+							  PGSQL *dst);
+
 bool copydb_prepare_copy_query(CopyTableDataSpec *tableSpecs, CopyArgs *args);
 
 bool copydb_prepare_summary_command(CopyTableDataSpec *tableSpecs);
 
 bool copydb_check_table_exists(PGSQL *pgsql, SourceTable *table, bool *exists);
 
+bool copydb_check_wal_skip(CopyDataSpec *specs);
+bool copydb_table_truncate_is_deferred(CopyDataSpec *specs, SourceTable *table);
+
 /* blobs.c */
 bool copydb_start_blob_process(CopyDataSpec *specs);
 
@@ -568,12 +691,74 @@ bool copydb_queue_largeobject_metadata(CopyDataSpec *specs, uint64_t *count);
 bool copydb_add_blob(CopyDataSpec *specs, uint32_t oid);
 bool copydb_send_lo_stop(CopyDataSpec *specs);
 
+/* spool.c */
+bool copydb_spool_data_by_oid(CopyDataSpec *specs, PGSQL *src, PGSQL *dst,
+							  uint32_t oid, uint32_t part);
+bool copydb_spool_table(CopyDataSpec *specs, PGSQL *src,
+						CopyTableDataSpec *tableSpecs,
+						CopySpool *spool);
+bool copydb_drain_table(CopyDataSpec *specs, PGSQL *dst,
+						CopyTableDataSpec *tableSpecs,
+						CopyStats *stats,
+						void *context,
+						CopyStatsCallback *callback);
+
+bool copydb_start_drain_workers(CopyDataSpec *specs);
+bool copydb_drain_worker(CopyDataSpec *specs);
+bool copydb_add_drain(CopyDataSpec *specs, uint32_t oid, uint32_t part);
+bool copydb_drain_send_stop(CopyDataSpec *specs);
+
+bool copydb_spool_wait_for_workers(CopyDataSpec *specs, pid_t *pids);
+bool copydb_spool_mark_done(const char *filename);
+bool copydb_spool_close_snapshot(CopyDataSpec *specs);
+bool copydb_spool_wait_for_snapshot(CopyDataSpec *specs, pid_t pid);
+
+bool spool_init_table(CopyDataSpec *specs,
+					  CopyTableDataSpec *tableSpecs,
+					  CopySpool *spool);
+bool spool_lookup_table(DatabaseCatalog *catalog, CopySpool *spool);
+bool spool_add_table(DatabaseCatalog *catalog, CopySpool *spool);
+bool spool_update_drained(DatabaseCatalog *catalog, CopySpool *spool);
+bool spool_delete_table(DatabaseCatalog *catalog, CopySpool *spool);
+
+/* chunks.c */
+bool copydb_copy_table_use_chunks(CopyDataSpec *specs,
+								  CopyTableDataSpec *tableSpecs);
+bool copydb_copy_table_chunks(CopyDataSpec *specs, PGSQL *src, PGSQL *dst,
+							  CopyTableDataSpec *tableSpecs,
+							  CopyStats *stats,
+							  void *context,
+							  CopyStatsCallback *callback);
+
+bool copydb_copy_steal_table_parts(CopyDataSpec *specs,
+								   PGSQL *src, PGSQL *dst,
+								   uint64_t *errors);
+
+bool chunk_lookup_table(DatabaseCatalog *catalog, CopyChunk *chunk);
+bool chunk_update_table(DatabaseCatalog *catalog, CopyChunk *chunk);
+bool chunk_register_plan(DatabaseCatalog *catalog, CopyChunk *chunk);
+bool chunk_steal(DatabaseCatalog *catalog, CopyChunk *stolen, bool *found);
+bool chunk_table_has_progress(DatabaseCatalog *catalog,
+							  uint32_t oid,
+							  bool *hasProgress);
+
+/* unlogged.c */
+bool copydb_set_tables_unlogged(CopyDataSpec *specs);
+bool copydb_set_table_logged(CopyDataSpec *specs, PGSQL *dst,
+							 SourceTable *table);
+bool copydb_set_tables_logged(CopyDataSpec *specs);
+
+/* fkeys.c */
+bool copydb_create_fkeys(CopyDataSpec *specs);
+bool copydb_start_fkey_workers(CopyDataSpec *specs, Queue *queue);
+bool copydb_fkey_worker(CopyDataSpec *specs, Queue *queue);
+
 /* vacuum.c */
 bool vacuum_start_supervisor(CopyDataSpec *specs, pid_t *pidOut);
 bool vacuum_supervisor(CopyDataSpec *specs);
 bool vacuum_start_workers(CopyDataSpec *specs);
 bool vacuum_worker(CopyDataSpec *specs);
-bool vacuum_analyze_table_by_oid(CopyDataSpec *specs, uint32_t oid);
+bool vacuum_analyze_table_by_oid(CopyDataSpec *specs, PGSQL *dst, uint32_t oid);
 bool vacuum_add_table(CopyDataSpec *specs, uint32_t oid, const char *datname);
 bool vacuum_send_stop(CopyDataSpec *specs);
 
@@ -671,6 +856,20 @@ bool summary_update_table_copy_stats(DatabaseCatalog *catalog,
 bool summary_delete_table(DatabaseCatalog *catalog,
 						  CopyTableDataSpec *tableSpecs);
 
+bool summary_lookup_table_targets(DatabaseCatalog *catalog,
+								  CopyTableDataSpec *tableSpecs);
+
+bool summary_table_target_fetch(SQLiteQuery *query);
+
+bool summary_finish_table_target(DatabaseCatalog *catalog,
+								 CopyTableDataSpec *tableSpecs,
+								 int target);
+
+bool summary_lookup_table_targets_total(DatabaseCatalog *catalog,
+										uint32_t tableoid,
+										CopyTargetSummary *targets,
+										int *count);
+
 bool summary_delete_incomplete_table_copy(DatabaseCatalog *catalog);
 
 bool summary_table_count_parts_done(DatabaseCatalog *catalog,
@@ -686,12 +885,35 @@ bool summary_lookup_table_parts_done(DatabaseCatalog *catalog,
 
 bool summary_table_parts_done_fetch(SQLiteQuery *query);
 
+bool summary_add_table_truncate(DatabaseCatalog *catalog, SourceTable *table);
+
+bool summary_set_table_truncate(DatabaseCatalog *catalog,
+								SourceTable *table,
+								const char *state);
+
+bool summary_lookup_table_truncate(DatabaseCatalog *catalog,
+								   SourceTable *table,
+								   char *state,
+								   size_t size);
+
 bool summary_add_vacuum(DatabaseCatalog *catalog,
 						CopyTableDataSpec *tableSpecs);
 
 bool summary_finish_vacuum(DatabaseCatalog *catalog,
 						   CopyTableDataSpec *tableSpecs);
 
+bool summary_add_fkey(DatabaseCatalog *catalog, CopyFKeySummary *summary);
+bool summary_finish_fkey(DatabaseCatalog *catalog, CopyFKeySummary *summary);
+
+bool summary_add_unlogged(DatabaseCatalog *catalog,
+						  CopyUnloggedTableSummary *summary);
+
+bool summary_lookup_unlogged(DatabaseCatalog *catalog,
+							 CopyUnloggedTableSummary *summary);
+
+bool summary_finish_unlogged(DatabaseCatalog *catalog,
+							 CopyUnloggedTableSummary *summary);
+
 /*
  * Summary for Create Index and Constraints
  */
@@ -32,6 +32,16 @@ typedef struct ComparePaths
 } ComparePaths;
 
 
+/* COPY data spool paths (--spool) */
+typedef struct SpoolPaths
+{
+	char dir[MAXPGPATH];            /* /tmp/pgcopydb/spool */
+	char tablesDoneFile[MAXPGPATH]; /* /tmp/pgcopydb/spool/tables.done */
+	char blobsDoneFile[MAXPGPATH];  /* /tmp/pgcopydb/spool/blobs.done */
+	char extensionsDoneFile[MAXPGPATH]; /* .../spool/extensions.done */
+} SpoolPaths;
+
+
 /* maintain all the internal paths we need in one place */
 typedef struct CopyFilePaths
 {
@@ -48,6 +58,7 @@ typedef struct CopyFilePaths
 
 	CDCPaths cdc;
 	ComparePaths compare;
+	SpoolPaths spool;
 } CopyFilePaths;
 
 
@@ -26,6 +26,7 @@ static bool copydb_fetch_previous_run_state(CopyDataSpec *specs);
 static bool copydb_fetch_source_schema(CopyDataSpec *specs, PGSQL *src);
 
 static bool copydb_prepare_table_specs_hook(void *ctx, SourceTable *source);
+static bool copydb_target_imports_stats(CopyDataSpec *specs);
 
 
 /*
@@ -641,6 +642,70 @@ copydb_fetch_source_schema(CopyDataSpec *specs, PGSQL *src)
 }
 
 
+/*
+ * copydb_prepare_split_auto computes the --split-tables-larger-than size
+ * threshold when using "auto", from the total size of the tables to copy and
+ * the --table-jobs setting: no COPY part is larger than a fraction of the
+ * total work, so that the last jobs to finish are not much longer than the
+ * others, and tables are not split in parts smaller than
+ * SPLIT_AUTO_MIN_PART_SIZE either.
+ *
+ * When resuming from catalogs where the table parts have already been
+ * computed, the threshold has been read from the setup already.
+ */
+bool
+copydb_prepare_split_auto(CopyDataSpec *specs)
+{
+	DatabaseCatalog *sourceDB = &(specs->catalogs.source);
+	SplitTableLargerThan *split = &(specs->splitTablesLargerThan);
+
+	CatalogTableStats stats = { 0 };
+
+	if (!catalog_s_table_stats(sourceDB, &stats))
+	{
+		log_error("Failed to compute source table statistics, "
+				  "see above for details");
+		return false;
+	}
+
+	int tableJobs = specs->tableJobs > 0 ? specs->tableJobs : 1;
+	int fraction = tableJobs * SPLIT_AUTO_PARTS_PER_JOB;
+
+	if (split->bytes == 0)
+	{
+		split->bytes = stats.totalBytes / fraction;
+
+		if (split->bytes < SPLIT_AUTO_MIN_PART_SIZE)
+		{
+			split->bytes = SPLIT_AUTO_MIN_PART_SIZE;
+		}
+
+		(void) pretty_print_bytes(split->bytesPretty,
+								  sizeof(split->bytesPretty),
+								  split->bytes);
+	}
+
+	char minPretty[BUFSIZE] = { 0 };
+
+	(void) pretty_print_bytes(minPretty,
+							  sizeof(minPretty),
+							  SPLIT_AUTO_MIN_PART_SIZE);
+
+	log_info("Automatic split: %lld tables and %s of data to copy "
+			 "with --table-jobs %d, parts are limited to 1/%d "
+			 "of the total (and at least %s): "
+			 "splitting tables larger than %s",
+			 (long long) stats.count,
+			 stats.bytesPretty,
+			 tableJobs,
+			 fraction,
+			 minPretty,
+			 split->bytesPretty);
+
+	return true;
+}
+
+
 typedef struct PrepareTableSpecsContext
 {
 	CopyDataSpec *specs;
@@ -716,6 +781,22 @@ copydb_prepare_table_specs(CopyDataSpec *specs, PGSQL *pgsql)
 		}
 	}
 
+	/*
+	 * Export the planner statistics of the tables from within our snapshot,
+	 * so that the VACUUM step can import them on Postgres 18 targets rather
+	 * than running ANALYZE on every table we just copied. When the export
+	 * fails the tables are analyzed on the target as usual.
+	 */
+	if (!specs->skipVacuum && copydb_target_imports_stats(specs))
+	{
+		if (!schema_list_table_stats(pgsql, sourceDB))
+		{
+			log_warn("Failed to export planner statistics from the source "
+					 "database, tables are going to be analyzed on the target "
+					 "database instead");
+		}
+	}
+
 	(void) catalog_stop_timing(&timing);
 
 	if (!catalog_register_section(sourceDB, &timing))
@@ -724,6 +805,15 @@ copydb_prepare_table_specs(CopyDataSpec *specs, PGSQL *pgsql)
 		return false;
 	}
 
+	if (specs->splitTablesLargerThan.automatic)
+	{
+		if (!copydb_prepare_split_auto(specs))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+	}
+
 	if (specs->splitTablesLargerThan.bytes > 0)
 	{
 		log_info("Splitting source candidate tables larger than %s",
@@ -818,7 +908,8 @@ copydb_prepare_table_specs_hook(void *ctx, SourceTable *source)
 
 	/*
 	 * Now compute partition scheme for same-table COPY concurrency, either
-	 * using a integer field that is unique, or relying on CTID range scans
+	 * using a integer field that is unique, or another unique key (uuid,
+	 * text, timestamp, or several columns), or relying on CTID range scans
 	 * otherwise.
 	 *
 	 * When the Table Access Method used is not "heap" we don't know if the
@@ -838,6 +929,21 @@ copydb_prepare_table_specs_hook(void *ctx, SourceTable *source)
 		return true;
 	}
 
+	/*
+	 * CTID ranges of heavily updated tables contain very different amounts
+	 * of live rows, so we prefer splitting on any unique key when the table
+	 * does not have a unique integer column.
+	 */
+	if (IS_EMPTY_STRING_BUFFER(source->partKey) &&
+		streq(source->amname, "heap"))
+	{
+		if (!schema_list_split_key(context->pgsql, source))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+	}
+
 	if (IS_EMPTY_STRING_BUFFER(source->partKey) &&
 		streq(source->amname, "heap"))
 	{
@@ -965,6 +1071,13 @@ copydb_prepare_index_specs(CopyDataSpec *specs, PGSQL *pgsql)
 		return false;
 	}
 
+	/* foreign keys are created with the post-data section, see --fkey-jobs */
+	if (!schema_list_fkeys(pgsql, sourceDB))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
 	(void) catalog_stop_timing(&timing);
 
 	if (!catalog_register_section(sourceDB, &timing))
@@ -1557,6 +1670,37 @@ copydb_fetch_filtered_oids(CopyDataSpec *specs, PGSQL *pgsql)
 }
 
 
+/*
+ * copydb_target_imports_stats returns true when the target database runs
+ * Postgres 18 or later, where the VACUUM step imports the planner statistics
+ * exported from the source database. When the target version can not be
+ * fetched, the statistics are not exported.
+ */
+static bool
+copydb_target_imports_stats(CopyDataSpec *specs)
+{
+	PGSQL dst = { 0 };
+
+	if (specs->connStrings.target_pguri == NULL)
+	{
+		return false;
+	}
+
+	if (!pgsql_init(&dst, specs->connStrings.target_pguri, PGSQL_CONN_TARGET) ||
+		!pgsql_server_version(&dst))
+	{
+		log_warn("Failed to get the target database version, skipping the "
+				 "export of planner statistics from the source database");
+		(void) pgsql_finish(&dst);
+		return false;
+	}
+
+	(void) pgsql_finish(&dst);
+
+	return dst.pgversion_num >= 180000;
+}
+
+
 /*
  * copydb_prepare_target_catalog connects to the target database and fetches
  * pieces of the catalogs that we need, such as the list of the already
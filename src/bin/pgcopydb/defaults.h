@@ -70,7 +70,22 @@
 #define PGCOPYDB_SKIP_DB_PROPERTIES "PGCOPYDB_SKIP_DB_PROPERTIES"
 #define PGCOPYDB_SKIP_CTID_SPLIT "PGCOPYDB_SKIP_CTID_SPLIT"
 #define PGCOPYDB_USE_COPY_BINARY "PGCOPYDB_USE_COPY_BINARY"
+#define PGCOPYDB_COPY_FORMAT "PGCOPYDB_COPY_FORMAT"
+#define PGCOPYDB_COPY_CHUNK_SIZE "PGCOPYDB_COPY_CHUNK_SIZE"
+#define PGCOPYDB_MAX_BANDWIDTH "PGCOPYDB_MAX_BANDWIDTH"
+#define PGCOPYDB_MAX_WORKER_BANDWIDTH "PGCOPYDB_MAX_WORKER_BANDWIDTH"
+#define PGCOPYDB_USE_COPY_THREADS "PGCOPYDB_USE_COPY_THREADS"
+#define PGCOPYDB_SPOOL "PGCOPYDB_SPOOL"
+#define PGCOPYDB_UNLOGGED_LOAD "PGCOPYDB_UNLOGGED_LOAD"
 #define PGCOPYDB_REPLAY_NO_OP_UPDATES "PGCOPYDB_REPLAY_NO_OP_UPDATES"
+#define PGCOPYDB_ADAPTIVE_JOBS "PGCOPYDB_ADAPTIVE_JOBS"
+#define PGCOPYDB_MIN_TABLE_JOBS "PGCOPYDB_MIN_TABLE_JOBS"
+#define PGCOPYDB_MIN_INDEX_JOBS "PGCOPYDB_MIN_INDEX_JOBS"
+#define PGCOPYDB_TOTAL_JOBS "PGCOPYDB_TOTAL_JOBS"
+#define PGCOPYDB_FKEY_JOBS "PGCOPYDB_FKEY_JOBS"
+#define PGCOPYDB_INDEX_MEMORY "PGCOPYDB_INDEX_MEMORY"
+#define PGCOPYDB_PARALLEL_INDEX_LARGER_THAN "PGCOPYDB_PARALLEL_INDEX_LARGER_THAN"
+#define PGCOPYDB_PARALLEL_VACUUM_LARGER_THAN "PGCOPYDB_PARALLEL_VACUUM_LARGER_THAN"
 
 /* default values for the command line options */
 #define DEFAULT_TABLE_JOBS 4
@@ -78,6 +93,42 @@
 #define DEFAULT_RESTORE_JOBS 0
 #define DEFAULT_LARGE_OBJECTS_JOBS 4
 #define DEFAULT_SPLIT_TABLES_LARGER_THAN 0 /* no COPY partitioning by default */
+#define DEFAULT_MIN_TABLE_JOBS 1
+#define DEFAULT_MIN_INDEX_JOBS 1
+
+/* --spool segment files hold up to that much uncompressed COPY data */
+#define SPOOL_SEGMENT_SIZE (64 * 1024 * 1024) /* 64 MB */
+
+/* split boundaries are sampled from the source when pg_stats has nothing */
+#define SPLIT_SAMPLE_BUCKETS 100
+
+/* split boundaries are computed from a sample of that many blocks */
+#define SPLIT_SAMPLE_PAGES 3000
+
+/* equal-width split ranges are kept unless a part gets twice its share */
+#define SPLIT_SKEW_THRESHOLD 2.0
+
+/* --split-tables-larger-than auto: parts are at most 1/(2 x jobs) of data */
+#define SPLIT_AUTO_PARTS_PER_JOB 2
+#define SPLIT_AUTO_MIN_PART_SIZE (16 * 1024 * 1024) /* 16 MB */
+
+/* cost model used to order the COPY and CREATE INDEX jobs, see schedule.c */
+#define SCHEDULE_COPY_BYTES_PER_SEC (100 * 1024 * 1024) /* 100 MB/s */
+#define SCHEDULE_COPY_ROWS_PER_SEC 1000000
+#define SCHEDULE_INDEX_SCAN_BYTES_PER_SEC (400 * 1024 * 1024) /* 400 MB/s */
+#define SCHEDULE_INDEX_SORT_ROWS_PER_SEC 4000000
+#define SCHEDULE_ROW_WIDTH 100   /* bytes, when reltuples is unknown */
+#define SCHEDULE_JOB_OVERHEAD 0.02  /* seconds */
+
+/* --adaptive-jobs: the controller runs every 10s, see concurrency.c */
+#define CONCURRENCY_TICK_INTERVAL 10   /* seconds */
+#define CONCURRENCY_WAIT_RATIO_HIGH 50 /* percent of target backends waiting */
+#define CONCURRENCY_WAIT_RATIO_LOW 20
+#define CONCURRENCY_MIN_GAIN 1.05      /* a new worker must add 5% throughput */
+#define CONCURRENCY_HOLD_TICKS 3       /* after reverting a start */
+
+/* --index-memory: each CREATE INDEX gets at least that much, when possible */
+#define INDEX_MEMORY_MIN_GRANT (64 * 1024 * 1024) /* 64 MB */
 
 #define POSTGRES_CONNECT_TIMEOUT "10"
 
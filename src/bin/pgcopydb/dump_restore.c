@@ -619,6 +619,13 @@ copydb_target_finalize_schema(CopyDataSpec *specs)
 		return false;
 	}
 
+	/* with --fkey-jobs, create the foreign keys that pg_restore skipped */
+	if (!copydb_create_fkeys(specs))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
 	/*
 	 * Some extensions such as timescaledb need a post restore step.
 	 */
@@ -644,6 +651,7 @@ typedef struct RestoreListContext
 	CopyDataSpec *specs;
 	FILE *outStream;
 	bool schemasOnly;   /* write only SCHEMA entries (first pass) */
+	bool fkeys;         /* skip FK CONSTRAINT entries, see --fkey-jobs */
 } RestoreListContext;
 
 /*
@@ -720,7 +728,8 @@ copydb_write_restore_list(CopyDataSpec *specs, PostgresDumpSection section)
 
 	RestoreListContext context = {
 		.specs = specs,
-		.outStream = out
+		.outStream = out,
+		.fkeys = section == PG_DUMP_SECTION_POST_DATA && specs->fkeyJobs > 0
 	};
 
 	if (!archive_iter_toc(listOutFilename,
@@ -1001,6 +1010,42 @@ copydb_write_restore_list_hook(void *ctx, ArchiveContentItem *item)
 				  item->restoreListName);
 	}
 
+	/*
+	 * With --fkey-jobs, the foreign keys that we have in our catalogs are
+	 * created by pgcopydb after pg_restore, see copydb_create_fkeys.
+	 */
+	if (!skip && context->fkeys && item->desc == ARCHIVE_TAG_FK_CONSTRAINT)
+	{
+		DatabaseCatalog *sourceDB = &(specs->catalogs.source);
+		SourceForeignKey fkey = { 0 };
+
+		if (!catalog_lookup_s_fkey(sourceDB, oid, &fkey))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+
+		if (fkey.oid != 0)
+		{
+			free(fkey.condef);
+
+			if (!catalog_s_fkey_set_restore(sourceDB, oid))
+			{
+				/* errors have already been logged */
+				return false;
+			}
+
+			skip = true;
+
+			log_debug("Skipping foreign key dumpId %d: %s %u %s "
+					  "(created with --fkey-jobs)",
+					  item->dumpId,
+					  item->description,
+					  item->objectOid,
+					  item->restoreListName);
+		}
+	}
+
 	PQExpBuffer buf = createPQExpBuffer();
 
 	printfPQExpBuffer(buf, "%s%d; %u %u %s %s\n",
@@ -79,6 +79,15 @@ copydb_start_extension_data_process(CopyDataSpec *specs, bool createExtensions)
 				exit(EXIT_CODE_INTERNAL_ERROR);
 			}
 
+			/* with --spool, let the snapshot owner know we're done with it */
+			char *doneFile = specs->cfPaths.spool.extensionsDoneFile;
+
+			if (specs->useSpool && !copydb_spool_mark_done(doneFile))
+			{
+				/* errors have already been logged */
+				exit(EXIT_CODE_INTERNAL_ERROR);
+			}
+
 			exit(EXIT_CODE_QUIT);
 		}
 
@@ -0,0 +1,571 @@
+/*
+ * src/bin/pgcopydb/fkeys.c
+ *     Create the foreign keys NOT VALID and then validate them concurrently
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "catalog.h"
+#include "copydb.h"
+#include "log.h"
+#include "pqexpbuffer.h"
+#include "queue_utils.h"
+#include "signals.h"
+#include "summary.h"
+
+
+typedef struct FKeyQueueContext
+{
+	CopyDataSpec *specs;
+	PGSQL *dst;
+	Queue *queue;
+	uint32_t lastConrelid;
+	int fkeyCount;
+	int validateCount;
+} FKeyQueueContext;
+
+
+static bool copydb_add_fkey_hook(void *ctx, SourceForeignKey *fkey);
+static bool copydb_queue_fkey_table_hook(void *ctx, SourceForeignKey *fkey);
+static bool copydb_validate_fkey_hook(void *ctx, SourceForeignKey *fkey);
+
+
+/*
+ * copydb_create_fkeys creates the foreign keys that have been skipped from
+ * the pg_restore post-data list when using --fkey-jobs.
+ *
+ * The foreign keys are first created as NOT VALID, which only takes a brief
+ * SHARE ROW EXCLUSIVE lock on both the referencing and the referenced tables
+ * and does not scan them. Because this lock conflicts with VALIDATE
+ * CONSTRAINT, all the foreign keys are created in this process first.
+ *
+ * Then --fkey-jobs worker processes run VALIDATE CONSTRAINT, one referencing
+ * table at a time, so that two workers never wait for each other's SHARE
+ * UPDATE EXCLUSIVE lock on the same table. The largest referencing tables
+ * are validated first.
+ *
+ * When resuming, the foreign keys that already exist on the target database
+ * are not created again, and only those that are still NOT VALID there are
+ * validated.
+ */
+bool
+copydb_create_fkeys(CopyDataSpec *specs)
+{
+	DatabaseCatalog *sourceDB = &(specs->catalogs.source);
+
+	if (specs->fkeyJobs == 0)
+	{
+		return true;
+	}
+
+	PGSQL dst = { 0 };
+
+	if (!pgsql_init(&dst, specs->connStrings.target_pguri, PGSQL_CONN_TARGET))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* open connection to target and set GUC values */
+	if (!pgsql_set_gucs(&dst, dstSettings))
+	{
+		log_error("Failed to set our GUC settings on the target connection, "
+				  "see above for details");
+		return false;
+	}
+
+	FKeyQueueContext context = {
+		.specs = specs,
+		.dst = &dst
+	};
+
+	if (!catalog_iter_s_fkey(sourceDB, 0, &context, &copydb_add_fkey_hook))
+	{
+		log_error("Failed to create foreign keys, see above for details");
+		(void) pgsql_finish(&dst);
+		return false;
+	}
+
+	(void) pgsql_finish(&dst);
+
+	if (context.validateCount == 0)
+	{
+		return true;
+	}
+
+	log_info("Created %d foreign keys NOT VALID, "
+			 "validating %d foreign keys using %d processes",
+			 context.fkeyCount,
+			 context.validateCount,
+			 specs->fkeyJobs);
+
+	Queue queue = { 0 };
+
+	if (!queue_create(&queue, "foreign keys"))
+	{
+		log_error("Failed to create the foreign keys process queue");
+		return false;
+	}
+
+	/*
+	 * Close the catalog before forking so that each worker opens its own
+	 * SQLite connection.
+	 */
+	if (!catalog_close(sourceDB))
+	{
+		/* errors have already been logged */
+		(void) queue_unlink(&queue);
+		return false;
+	}
+
+	if (!copydb_start_fkey_workers(specs, &queue))
+	{
+		log_error("Failed to start %d foreign keys workers", specs->fkeyJobs);
+		(void) queue_unlink(&queue);
+		return false;
+	}
+
+	if (!catalog_open(sourceDB))
+	{
+		/* errors have already been logged */
+		(void) queue_unlink(&queue);
+		return false;
+	}
+
+	FKeyQueueContext queueContext = {
+		.specs = specs,
+		.queue = &queue
+	};
+
+	if (!catalog_iter_s_fkey(sourceDB, 0, &queueContext,
+							 &copydb_queue_fkey_table_hook))
+	{
+		log_error("Failed to queue foreign keys, see above for details");
+		(void) queue_unlink(&queue);
+		return false;
+	}
+
+	for (int i = 0; i < specs->fkeyJobs; i++)
+	{
+		QMessage stop = { .type = QMSG_TYPE_STOP, .data.oid = 0 };
+
+		log_trace("Adding STOP message to foreign keys queue %d", queue.qId);
+
+		if (!queue_send(&queue, &stop))
+		{
+			/* errors have already been logged */
+			continue;
+		}
+	}
+
+	if (!copydb_wait_for_subprocesses(specs->failFast))
+	{
+		log_error("Some foreign keys worker process(es) have exited with "
+				  "error, see above for details");
+
+		(void) queue_unlink(&queue);
+		return false;
+	}
+
+	if (!queue_unlink(&queue))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * copydb_add_fkey_hook is an iterator callback function that creates the
+ * given foreign key on the target database, NOT VALID when the foreign key is
+ * valid on the source database. A foreign key that already exists on the
+ * target database, from a previous run, is skipped.
+ */
+static bool
+copydb_add_fkey_hook(void *ctx, SourceForeignKey *fkey)
+{
+	FKeyQueueContext *context = (FKeyQueueContext *) ctx;
+
+	if (asked_to_stop || asked_to_stop_fast || asked_to_quit)
+	{
+		log_error("Foreign keys creation has been interrupted");
+		return false;
+	}
+
+	bool exists = false;
+	bool validated = false;
+
+	if (!pgsql_fkey_exists(context->dst,
+						   fkey->qname,
+						   fkey->conname,
+						   &exists,
+						   &validated))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	if (exists)
+	{
+		log_notice("Foreign key %s already exists on table %s, skipping",
+				   fkey->conname,
+				   fkey->qname);
+
+		if (fkey->convalidated && !validated)
+		{
+			++(context->validateCount);
+		}
+
+		return true;
+	}
+
+	PQExpBuffer sql = createPQExpBuffer();
+
+	/* pg_get_constraintdef() already ends with NOT VALID otherwise */
+	printfPQExpBuffer(sql, "ALTER TABLE ONLY %s ADD CONSTRAINT %s %s%s",
+					  fkey->qname,
+					  fkey->conname,
+					  fkey->condef,
+					  fkey->convalidated ? " NOT VALID" : "");
+
+	/* memory allocation could have failed while building string */
+	if (PQExpBufferBroken(sql))
+	{
+		log_error("Failed to create foreign key %s: out of memory",
+				  fkey->conname);
+		destroyPQExpBuffer(sql);
+		return false;
+	}
+
+	log_notice("%s", sql->data);
+
+	if (!pgsql_execute(context->dst, sql->data))
+	{
+		log_error("Failed to create foreign key %s on table %s",
+				  fkey->conname,
+				  fkey->qname);
+		destroyPQExpBuffer(sql);
+		return false;
+	}
+
+	destroyPQExpBuffer(sql);
+
+	++(context->fkeyCount);
+
+	if (fkey->convalidated)
+	{
+		++(context->validateCount);
+	}
+
+	return true;
+}
+
+
+/*
+ * copydb_queue_fkey_table_hook is an iterator callback function that sends
+ * the referencing table of the given foreign key to the queue, once per
+ * table. The iteration groups the foreign keys by referencing table.
+ */
+static bool
+copydb_queue_fkey_table_hook(void *ctx, SourceForeignKey *fkey)
+{
+	FKeyQueueContext *context = (FKeyQueueContext *) ctx;
+
+	if (asked_to_stop || asked_to_stop_fast || asked_to_quit)
+	{
+		log_error("Foreign keys validation has been interrupted");
+		return false;
+	}
+
+	if (!fkey->convalidated || fkey->conrelid == context->lastConrelid)
+	{
+		return true;
+	}
+
+	context->lastConrelid = fkey->conrelid;
+
+	QMessage mesg = {
+		.type = QMSG_TYPE_TABLEOID,
+		.data.oid = fkey->conrelid
+	};
+
+	log_trace("copydb_queue_fkey_table_hook(%d): %u",
+			  context->queue->qId,
+			  fkey->conrelid);
+
+	if (!queue_send(context->queue, &mesg))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * copydb_start_fkey_workers create as many sub-process as needed, per
+ * --fkey-jobs.
+ */
+bool
+copydb_start_fkey_workers(CopyDataSpec *specs, Queue *queue)
+{
+	for (int i = 0; i < specs->fkeyJobs; i++)
+	{
+		/*
+		 * Flush stdio channels just before fork, to avoid double-output
+		 * problems.
+		 */
+		fflush(stdout);
+		fflush(stderr);
+
+		int fpid = fork();
+
+		switch (fpid)
+		{
+			case -1:
+			{
+				log_error("Failed to fork a foreign keys worker process: %m");
+				return false;
+			}
+
+			case 0:
+			{
+				/* child process runs the command */
+				(void) set_ps_title("pgcopydb: foreign keys worker");
+
+				if (!copydb_fkey_worker(specs, queue))
+				{
+					/* errors have already been logged */
+					exit(EXIT_CODE_INTERNAL_ERROR);
+				}
+
+				exit(EXIT_CODE_QUIT);
+			}
+
+			default:
+			{
+				/* fork succeeded, in parent */
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+/*
+ * copydb_fkey_worker is a worker process that loops over messages received
+ * from a queue, each message being the Oid of a table for which to validate
+ * the foreign keys on the target database.
+ */
+bool
+copydb_fkey_worker(CopyDataSpec *specs, Queue *queue)
+{
+	pid_t pid = getpid();
+
+	log_notice("Started foreign keys worker %d [%d]", pid, getppid());
+
+	if (!catalog_init_from_specs(specs))
+	{
+		log_error("Failed to open internal catalogs in foreign keys worker "
+				  "process, see above for details");
+		return false;
+	}
+
+	PGSQL dst = { 0 };
+
+	if (!pgsql_init(&dst, specs->connStrings.target_pguri, PGSQL_CONN_TARGET))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* open connection to target and set GUC values */
+	if (!pgsql_set_gucs(&dst, dstSettings))
+	{
+		log_error("Failed to set our GUC settings on the target connection, "
+				  "see above for details");
+		return false;
+	}
+
+	FKeyQueueContext context = {
+		.specs = specs,
+		.dst = &dst,
+		.queue = queue
+	};
+
+	int errors = 0;
+	bool stop = false;
+
+	while (!stop)
+	{
+		QMessage mesg = { 0 };
+		bool recv_ok = queue_receive(queue, &mesg);
+
+		if (asked_to_stop || asked_to_stop_fast || asked_to_quit)
+		{
+			log_error("Foreign keys worker has been interrupted");
+			(void) pgsql_finish(&dst);
+			return false;
+		}
+
+		if (!recv_ok)
+		{
+			/* errors have already been logged */
+			(void) pgsql_finish(&dst);
+			return false;
+		}
+
+		switch (mesg.type)
+		{
+			case QMSG_TYPE_STOP:
+			{
+				stop = true;
+				log_debug("Stop message received by foreign keys worker");
+				break;
+			}
+
+			case QMSG_TYPE_TABLEOID:
+			{
+				if (!catalog_iter_s_fkey(&(specs->catalogs.source),
+										 mesg.data.oid,
+										 &context,
+										 &copydb_validate_fkey_hook))
+				{
+					++errors;
+
+					log_error("Failed to validate foreign keys of table "
+							  "with oid %u, see above for details",
+							  mesg.data.oid);
+
+					if (specs->failFast)
+					{
+						(void) pgsql_finish(&dst);
+						return false;
+					}
+				}
+				break;
+			}
+
+			default:
+			{
+				log_error("Received unknown message type %ld on foreign keys "
+						  "queue %d",
+						  mesg.type,
+						  queue->qId);
+				break;
+			}
+		}
+	}
+
+	(void) pgsql_finish(&dst);
+
+	if (!catalog_close_from_specs(specs))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	bool success = (stop == true && errors == 0);
+
+	if (errors > 0)
+	{
+		log_error("Foreign keys worker %d encountered %d errors, "
+				  "see above for details",
+				  pid,
+				  errors);
+	}
+
+	return success;
+}
+
+
+/*
+ * copydb_validate_fkey_hook is an iterator callback function that validates
+ * the given foreign key on the target database, and registers the duration
+ * of the operation in the fkey_summary table of our catalogs.
+ */
+static bool
+copydb_validate_fkey_hook(void *ctx, SourceForeignKey *fkey)
+{
+	FKeyQueueContext *context = (FKeyQueueContext *) ctx;
+	DatabaseCatalog *sourceDB = &(context->specs->catalogs.source);
+
+	if (asked_to_stop || asked_to_stop_fast || asked_to_quit)
+	{
+		log_error("Foreign keys worker has been interrupted");
+		return false;
+	}
+
+	/* a foreign key that is NOT VALID on the source stays that way */
+	if (!fkey->convalidated)
+	{
+		return true;
+	}
+
+	/* when resuming, the foreign key might have been validated already */
+	bool exists = false;
+	bool validated = false;
+
+	if (!pgsql_fkey_exists(context->dst,
+						   fkey->qname,
+						   fkey->conname,
+						   &exists,
+						   &validated))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	if (validated)
+	{
+		log_notice("Foreign key %s on table %s has already been validated, "
+				   "skipping",
+				   fkey->conname,
+				   fkey->qname);
+		return true;
+	}
+
+	CopyFKeySummary summary = { .fkey = fkey };
+
+	sformat(summary.command, sizeof(summary.command),
+			"ALTER TABLE ONLY %s VALIDATE CONSTRAINT %s",
+			fkey->qname,
+			fkey->conname);
+
+	/* also set the process title for this specific foreign key */
+	char psTitle[BUFSIZE] = { 0 };
+	sformat(psTitle, sizeof(psTitle), "pgcopydb: %s", summary.command);
+	(void) set_ps_title(psTitle);
+
+	log_notice("%s", summary.command);
+
+	if (!summary_add_fkey(sourceDB, &summary))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	if (!pgsql_execute(context->dst, summary.command))
+	{
+		log_error("Failed to validate foreign key %s on table %s",
+				  fkey->conname,
+				  fkey->qname);
+		return false;
+	}
+
+	if (!summary_finish_fkey(sourceDB, &summary))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	return true;
+}
@@ -16,6 +16,7 @@
 #include "ld_store.h"
 #include "log.h"
 #include "follow_coordinator.h"
+#include "ratelimit.h"
 
 
 bool
@@ -215,6 +216,60 @@ follow_coordinator_handle_messages(FollowCoordinator *coord, StreamSpecs *specs)
 			break;
 		}
 
+		case IPC_MSG_RATELIMIT:
+		{
+			IPCPayloadRateLimit *cmd = (IPCPayloadRateLimit *) msg.payload;
+
+			RateLimitSettings settings = { 0 };
+			RateLimitStats stats = { 0 };
+
+			bool success = ratelimit_get(&settings, NULL);
+
+			if (success && (cmd->set_bandwidth || cmd->set_worker_bandwidth))
+			{
+				if (cmd->set_bandwidth)
+				{
+					settings.bytesPerSec = cmd->bandwidth;
+				}
+
+				if (cmd->set_worker_bandwidth)
+				{
+					settings.workerBytesPerSec = cmd->worker_bandwidth;
+				}
+
+				log_info("Coordinator: CLI set bandwidth limits to "
+						 "%llu bytes/s, %llu bytes/s per worker",
+						 (unsigned long long) settings.bytesPerSec,
+						 (unsigned long long) settings.workerBytesPerSec);
+
+				success = ratelimit_set(&settings);
+			}
+
+			success = success && ratelimit_get(&settings, &stats);
+
+			if (!success)
+			{
+				response.type = IPC_MSG_ERROR;
+				const char *err = "Failed to update bandwidth limits";
+				response.payload_len = strlen(err);
+				memcpy(response.payload, err, response.payload_len); /* IGNORE-BANNED */
+			}
+			else
+			{
+				response.type = IPC_MSG_RATELIMIT_REPLY;
+				IPCPayloadRateLimitReply *reply =
+					(IPCPayloadRateLimitReply *) response.payload;
+
+				reply->bandwidth = settings.bytesPerSec;
+				reply->worker_bandwidth = settings.workerBytesPerSec;
+				reply->bytes = stats.bytes;
+				reply->waits = stats.waits;
+				reply->wait_ms = stats.waitMs;
+				response.payload_len = sizeof(IPCPayloadRateLimitReply);
+			}
+			break;
+		}
+
 		case IPC_MSG_PING:
 		{
 			response.type = IPC_MSG_PONG;
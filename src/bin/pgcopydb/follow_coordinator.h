@@ -5,7 +5,7 @@
  *
  * When PGCOPYDB_HOST / PGCOPYDB_PORT are set, a running "pgcopydb follow"
  * listens on that TCP endpoint for CLI commands (SET_ENDPOS, QUERY_STATUS,
- * QUERY_SENTINEL).  Pipeline lifecycle coordination uses pipes and
+ * QUERY_SENTINEL, RATELIMIT).  Pipeline lifecycle coordination uses pipes and
  * pipeline_state instead; the Unix socket path is gone.
  */
 
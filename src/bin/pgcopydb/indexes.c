@@ -6,16 +6,19 @@
 #include <errno.h>
 #include <getopt.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
 #include "catalog.h"
 #include "cli_root.h"
+#include "concurrency.h"
 #include "copydb.h"
 #include "env_utils.h"
 #include "lock_utils.h"
 #include "log.h"
 #include "pidfile.h"
+#include "schedule.h"
 #include "schema.h"
 #include "signals.h"
 #include "string_utils.h"
@@ -25,6 +28,10 @@
 static bool copydb_add_table_indexes_hook(void *context, SourceIndex *index);
 static bool copydb_create_constraints_hook(void *context, SourceIndex *index);
 static bool copydb_copy_all_indexes_hook(void *ctx, SourceIndex *index);
+static bool copydb_set_index_memory(PGSQL *dst, CopyIndexSpec *indexSpecs);
+static bool copydb_set_index_parallel_workers(CopyDataSpec *specs,
+											  PGSQL *dst,
+											  CopyIndexSpec *indexSpecs);
 
 
 /*
@@ -151,10 +158,29 @@ copydb_index_supervisor(CopyDataSpec *specs)
 		return false;
 	}
 
+	/* with --adaptive-jobs, tune the count of active workers as we wait */
+	ConcurrencyController controller = { 0 };
+
+	if (!concurrency_controller_init(&controller,
+									 CONCURRENCY_POOL_INDEX,
+									 sourceDB,
+									 specs->connStrings.target_pguri))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
 	/*
 	 * Now just wait for the create index processes to be done.
 	 */
-	if (!copydb_wait_for_subprocesses(specs->failFast))
+	bool success =
+		copydb_wait_for_subprocesses_hook(specs->failFast,
+										  &concurrency_tick,
+										  &controller);
+
+	concurrency_controller_finish(&controller);
+
+	if (!success)
 	{
 		log_error("Some INDEX worker process(es) have exited with error, "
 				  "see above for details");
@@ -218,6 +244,8 @@ copydb_start_index_workers(CopyDataSpec *specs)
 	log_info("STEP 6: starting %d CREATE INDEX processes", specs->indexJobs);
 	log_info("STEP 7: constraints are built by the CREATE INDEX processes");
 
+	concurrency_reset(CONCURRENCY_POOL_INDEX);
+
 	for (int i = 0; i < specs->indexJobs; i++)
 	{
 		/*
@@ -286,9 +314,13 @@ copydb_index_worker(CopyDataSpec *specs)
 	 * Singledb path: open a single target connection reused for all indexes.
 	 * Multidb path: maintain a lightweight pool keyed by datname; each entry
 	 * holds a per-db CopyDataSpec (catalog) and a target connection.
+	 *
+	 * In both cases the connection is checked and its session is reset before
+	 * each index, see copydb_prepare_target_connection.
 	 */
 	PGSQL dst = { 0 };
 	MultiDbContext idxCtx = { 0 };
+	ConnectionReuse reuse = { 0 };
 
 	if (specs->allDatabases)
 	{
@@ -306,13 +338,6 @@ copydb_index_worker(CopyDataSpec *specs)
 		{
 			return false;
 		}
-
-		if (!pgsql_set_gucs(&dst, dstSettings))
-		{
-			log_fatal("Failed to set our GUC settings on the target connection, "
-					  "see above for details");
-			return false;
-		}
 	}
 
 	int errors = 0;
@@ -320,12 +345,22 @@ copydb_index_worker(CopyDataSpec *specs)
 
 	while (!stop)
 	{
+		/* with --adaptive-jobs, we might have to wait for our turn */
+		if (!concurrency_acquire(CONCURRENCY_POOL_INDEX))
+		{
+			log_error("CREATE INDEX worker has been interrupted");
+			(void) pgsql_finish(&dst);
+			(void) multidb_index_context_close_all(&idxCtx);
+			return false;
+		}
+
 		QMessage mesg = { 0 };
 		bool recv_ok = queue_receive(&(specs->indexQueue), &mesg);
 
 		if (asked_to_stop || asked_to_stop_fast || asked_to_quit)
 		{
 			log_error("CREATE INDEX worker has been interrupted");
+			concurrency_release(CONCURRENCY_POOL_INDEX);
 			(void) pgsql_finish(&dst);
 			(void) multidb_index_context_close_all(&idxCtx);
 			return false;
@@ -334,6 +369,17 @@ copydb_index_worker(CopyDataSpec *specs)
 		if (!recv_ok)
 		{
 			/* errors have already been logged */
+			concurrency_release(CONCURRENCY_POOL_INDEX);
+			(void) pgsql_finish(&dst);
+			(void) multidb_index_context_close_all(&idxCtx);
+			return false;
+		}
+
+		/* with --total-jobs, wait until the jobs budget allows for it */
+		if (!concurrency_budget_acquire(CONCURRENCY_POOL_INDEX))
+		{
+			log_error("CREATE INDEX worker has been interrupted");
+			concurrency_release(CONCURRENCY_POOL_INDEX);
 			(void) pgsql_finish(&dst);
 			(void) multidb_index_context_close_all(&idxCtx);
 			return false;
@@ -345,6 +391,9 @@ copydb_index_worker(CopyDataSpec *specs)
 			{
 				stop = true;
 				log_debug("Stop message received by create index worker");
+
+				/* parked workers now need to get their STOP message too */
+				concurrency_stopping(CONCURRENCY_POOL_INDEX);
 				break;
 			}
 
@@ -369,6 +418,8 @@ copydb_index_worker(CopyDataSpec *specs)
 
 						if (specs->failFast)
 						{
+							concurrency_budget_release(CONCURRENCY_POOL_INDEX);
+							concurrency_release(CONCURRENCY_POOL_INDEX);
 							(void) multidb_index_context_close_all(&idxCtx);
 							return false;
 						}
@@ -379,7 +430,8 @@ copydb_index_worker(CopyDataSpec *specs)
 					useDst = &entry->dst;
 				}
 
-				if (!copydb_create_index_by_oid(useSpecs, useDst, oid))
+				if (!copydb_prepare_target_connection(useDst, &reuse) ||
+					!copydb_create_index_by_oid(useSpecs, useDst, oid))
 				{
 					++errors;
 
@@ -389,6 +441,8 @@ copydb_index_worker(CopyDataSpec *specs)
 
 					if (specs->failFast)
 					{
+						concurrency_budget_release(CONCURRENCY_POOL_INDEX);
+						concurrency_release(CONCURRENCY_POOL_INDEX);
 						(void) pgsql_finish(&dst);
 						(void) multidb_index_context_close_all(&idxCtx);
 						return false;
@@ -405,11 +459,20 @@ copydb_index_worker(CopyDataSpec *specs)
 				break;
 			}
 		}
+
+		concurrency_budget_release(CONCURRENCY_POOL_INDEX);
+		concurrency_release(CONCURRENCY_POOL_INDEX);
 	}
 
 	pgsql_finish(&dst);
 	(void) multidb_index_context_close_all(&idxCtx);
 
+	if (!copydb_report_connection_reuse(&(specs->catalogs.source), &reuse))
+	{
+		log_warn("Failed to register connection re-use timings, "
+				 "see above for details");
+	}
+
 	if (!catalog_delete_process(&(specs->catalogs.source), pid))
 	{
 		log_warn("Failed to delete catalog process entry for pid %d", pid);
@@ -524,7 +587,8 @@ copydb_create_index_by_oid(CopyDataSpec *specs, PGSQL *dst, uint32_t indexOid)
 		 * Once the indexes are built, it's time to:
 		 *
 		 *  1. build the constraints, some of them on-top of the indexes
-		 *  2. send the table to the VACUUM ANALYZE job queue.
+		 *  2. switch the table back to LOGGED (see --unlogged-load)
+		 *  3. send the table to the VACUUM ANALYZE job queue.
 		 */
 
 		if (!copydb_create_constraints(specs, dst, table))
@@ -534,6 +598,12 @@ copydb_create_index_by_oid(CopyDataSpec *specs, PGSQL *dst, uint32_t indexOid)
 			return false;
 		}
 
+		if (!copydb_set_table_logged(specs, dst, table))
+		{
+			log_error("Failed to SET LOGGED table %s", table->qname);
+			return false;
+		}
+
 		if (!specs->skipVacuum)
 		{
 			if (!vacuum_add_table(specs, table->oid, table->datname))
@@ -617,6 +687,7 @@ typedef struct IndexOIDArray
 {
 	int count;
 	uint32_t *array;            /* malloc'ed area */
+	double *costs;              /* malloc'ed area */
 } IndexOIDArray;
 
 typedef struct QueueTableIndexesContext
@@ -634,7 +705,7 @@ bool
 copydb_add_table_indexes(CopyDataSpec *specs, CopyTableDataSpec *tableSpecs)
 {
 	DatabaseCatalog *sourceDB = &(specs->catalogs.source);
-	IndexOIDArray indexArray = { 0, NULL };
+	IndexOIDArray indexArray = { 0, NULL, NULL };
 
 	if (!catalog_s_table_count_indexes(sourceDB, tableSpecs->sourceTable))
 	{
@@ -661,10 +732,13 @@ copydb_add_table_indexes(CopyDataSpec *specs, CopyTableDataSpec *tableSpecs)
 	int indexCount = tableSpecs->sourceTable->indexCount;
 	indexArray.count = 0;
 	indexArray.array = (uint32_t *) calloc(indexCount, sizeof(uint32_t));
+	indexArray.costs = (double *) calloc(indexCount, sizeof(double));
 
-	if (indexArray.array == NULL)
+	if (indexArray.array == NULL || indexArray.costs == NULL)
 	{
 		log_error(ALLOCATION_FAILED_ERROR);
+		free(indexArray.array);
+		free(indexArray.costs);
 		return false;
 	}
 
@@ -716,20 +790,40 @@ copydb_add_table_indexes(CopyDataSpec *specs, CopyTableDataSpec *tableSpecs)
 		}
 	}
 
+	free(indexArray.array);
+	free(indexArray.costs);
+
 	return true;
 }
 
 
 /*
  * copydb_add_table_indexes_hook is an iterator callback function.
+ *
+ * The indexArray is kept sorted by estimated cost, longest index build first,
+ * so that the CREATE INDEX workers do not start the most expensive index of a
+ * table last.
  */
 static bool
 copydb_add_table_indexes_hook(void *ctx, SourceIndex *index)
 {
 	QueueTableIndexesContext *context = (QueueTableIndexesContext *) ctx;
 	IndexOIDArray *indexArray = context->indexArray;
+	SourceTable *table = context->tableSpecs->sourceTable;
+
+	double cost =
+		schedule_index_cost(table->reltuples, table->bytes, index->indexDef);
 
-	indexArray->array[(indexArray->count)++] = index->indexOid;
+	int i = indexArray->count++;
+
+	for (; i > 0 && indexArray->costs[i - 1] < cost; i--)
+	{
+		indexArray->array[i] = indexArray->array[i - 1];
+		indexArray->costs[i] = indexArray->costs[i - 1];
+	}
+
+	indexArray->array[i] = index->indexOid;
+	indexArray->costs[i] = cost;
 
 	return true;
 }
@@ -932,7 +1026,30 @@ copydb_create_index(CopyDataSpec *specs,
 			log_notice("%s", indexSummary->command);
 		}
 
-		if (!pgsql_execute(dst, indexSummary->command))
+		/* with --index-memory, size maintenance_work_mem for this index */
+		if (!copydb_set_index_memory(dst, &indexSpecs))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+
+		concurrency_index_build_start();
+
+		/* with --parallel-index-larger-than, use the idle index workers */
+		if (!copydb_set_index_parallel_workers(specs, dst, &indexSpecs))
+		{
+			/* errors have already been logged */
+			concurrency_index_build_done(indexSummary->parallelWorkers);
+			concurrency_index_memory_release(indexSummary->memoryGrant);
+			return false;
+		}
+
+		bool success = pgsql_execute(dst, indexSummary->command);
+
+		concurrency_index_build_done(indexSummary->parallelWorkers);
+		concurrency_index_memory_release(indexSummary->memoryGrant);
+
+		if (!success)
 		{
 			/* errors have already been logged */
 			return false;
@@ -949,6 +1066,134 @@ copydb_create_index(CopyDataSpec *specs,
 }
 
 
+/*
+ * copydb_set_index_memory takes a grant from the --index-memory budget for
+ * the given index, and sets maintenance_work_mem to the granted amount on the
+ * target connection. The grant is registered in the index summary.
+ */
+static bool
+copydb_set_index_memory(PGSQL *dst, CopyIndexSpec *indexSpecs)
+{
+	SourceIndex *index = indexSpecs->sourceIndex;
+	CopyIndexSummary *indexSummary = &(indexSpecs->summary);
+
+	if (!concurrency_has_index_memory())
+	{
+		return true;
+	}
+
+	uint64_t grant = 0;
+
+	if (!concurrency_index_memory_acquire(index->bytes, &grant))
+	{
+		log_error("CREATE INDEX worker has been interrupted");
+		return false;
+	}
+
+	char grantPretty[BUFSIZE] = { 0 };
+	char bytesPretty[BUFSIZE] = { 0 };
+
+	pretty_print_bytes(grantPretty, sizeof(grantPretty), grant);
+	pretty_print_bytes(bytesPretty, sizeof(bytesPretty), index->bytes);
+
+	log_notice("Granted %s of maintenance_work_mem to index %s (%s on source)",
+			   grantPretty,
+			   index->indexQname,
+			   bytesPretty);
+
+	char sql[BUFSIZE] = { 0 };
+
+	sformat(sql, sizeof(sql),
+			"SET maintenance_work_mem TO '%lldkB'",
+			(long long) (grant / 1024));
+
+	if (!pgsql_execute(dst, sql))
+	{
+		log_error("Failed to set maintenance_work_mem for index %s",
+				  index->indexQname);
+		concurrency_index_memory_release(grant);
+		return false;
+	}
+
+	indexSummary->memoryGrant = grant;
+
+	return true;
+}
+
+
+/*
+ * copydb_set_index_parallel_workers sets max_parallel_maintenance_workers for
+ * the given index on the target connection. Only btree indexes larger than
+ * --parallel-index-larger-than on the source are built in parallel, using
+ * one parallel worker per threshold of index size, and no more than the
+ * number of CREATE INDEX workers that are currently idle. The parallel
+ * workers are reserved until concurrency_index_build_done.
+ */
+static bool
+copydb_set_index_parallel_workers(CopyDataSpec *specs,
+								  PGSQL *dst,
+								  CopyIndexSpec *indexSpecs)
+{
+	SourceIndex *index = indexSpecs->sourceIndex;
+	CopyIndexSummary *indexSummary = &(indexSpecs->summary);
+
+	if (specs->parallelIndexLargerThan == 0)
+	{
+		return true;
+	}
+
+	/* parallel CREATE INDEX is available from Postgres 11 onward */
+	if (!pgsql_server_version(dst))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	if (dst->pgversion_num < 110000)
+	{
+		return true;
+	}
+
+	int degree = 0;
+	bool isBtree = strstr(index->indexDef, " USING btree ") != NULL;
+
+	if (isBtree &&
+		index->bytes > 0 &&
+		(uint64_t) index->bytes >= specs->parallelIndexLargerThan)
+	{
+		uint64_t sizeDegree = index->bytes / specs->parallelIndexLargerThan;
+		int wanted = sizeDegree < INT_MAX ? (int) sizeDegree : INT_MAX;
+
+		degree = concurrency_index_parallel_acquire(wanted);
+	}
+
+	/* registered first, so that the caller gives the workers back */
+	indexSummary->parallelWorkers = degree;
+
+	char sql[BUFSIZE] = { 0 };
+
+	sformat(sql, sizeof(sql),
+			"SET max_parallel_maintenance_workers TO %d",
+			degree);
+
+	if (!pgsql_execute(dst, sql))
+	{
+		log_error("Failed to set max_parallel_maintenance_workers for index %s",
+				  index->indexQname);
+		return false;
+	}
+
+	if (degree > 0)
+	{
+		log_notice("Building index %s with %d parallel workers",
+				   index->indexQname,
+				   degree);
+	}
+
+	return true;
+}
+
+
 /*
  * copydb_index_is_being_processed checks lock and done files to see if a given
  * index is already being processed, or has been processed entirely by another
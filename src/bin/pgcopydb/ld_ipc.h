@@ -47,6 +47,9 @@ typedef enum
 	IPC_MSG_CLEANUP = 10,         /* CLI → coordinator: cleanup old CDC files */
 	IPC_MSG_CLEANUP_REPLY = 11,   /* coordinator → CLI: cleanup result */
 
+	IPC_MSG_RATELIMIT = 12,       /* CLI → coordinator: get/set bandwidth caps */
+	IPC_MSG_RATELIMIT_REPLY = 13, /* coordinator → CLI: bandwidth caps, stats */
+
 	IPC_MSG_ACK_CONFIRMED = 18,   /* coordinator → CLI: request accepted */
 	IPC_MSG_ERROR = 99,           /* generic error */
 } IPCMessageType;
@@ -108,6 +111,28 @@ typedef struct
 	uint8_t dry_run;
 } IPCPayloadCleanupReply;
 
+/*
+ * Payload for IPC_MSG_RATELIMIT: caps are in bytes per second, zero meaning
+ * unlimited, and are only changed when the matching set_* flag is non-zero.
+ */
+typedef struct
+{
+	uint8_t set_bandwidth;
+	uint8_t set_worker_bandwidth;
+	uint64_t bandwidth;
+	uint64_t worker_bandwidth;
+} IPCPayloadRateLimit;
+
+/* Payload for IPC_MSG_RATELIMIT_REPLY */
+typedef struct
+{
+	uint64_t bandwidth;
+	uint64_t worker_bandwidth;
+	uint64_t bytes;          /* bytes read from the source so far */
+	uint64_t waits;          /* times a process waited to respect the caps */
+	uint64_t wait_ms;        /* cumulative time spent waiting */
+} IPCPayloadRateLimitReply;
+
 /* Payload for IPC_MSG_ERROR */
 typedef struct
 {
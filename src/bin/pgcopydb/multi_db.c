@@ -2228,6 +2228,8 @@ multidb_init_entry(MultiDbEntry *entry, CopyDataSpec *parentSpecs,
 	dbSpecs->noRolesPasswords = parentSpecs->noRolesPasswords;
 	dbSpecs->failFast = parentSpecs->failFast;
 	dbSpecs->useCopyBinary = parentSpecs->useCopyBinary;
+	dbSpecs->copyFormat = parentSpecs->copyFormat;
+	dbSpecs->useCopyThreads = parentSpecs->useCopyThreads;
 	dbSpecs->restart = false;
 	dbSpecs->resume = parentSpecs->resume;
 	dbSpecs->consistent = parentSpecs->consistent;
@@ -2239,6 +2241,7 @@ multidb_init_entry(MultiDbEntry *entry, CopyDataSpec *parentSpecs,
 	dbSpecs->lObjectJobs = parentSpecs->lObjectJobs;
 	dbSpecs->splitTablesLargerThan = parentSpecs->splitTablesLargerThan;
 	dbSpecs->splitMaxParts = parentSpecs->splitMaxParts;
+	dbSpecs->copyChunkSize = parentSpecs->copyChunkSize;
 	dbSpecs->estimateTableSizes = parentSpecs->estimateTableSizes;
 	dbSpecs->allDatabases = false;  /* per-db context, not the global flag */
 
@@ -2610,6 +2613,8 @@ multidb_init_db_specs(CopyDataSpec *dbSpecs,
 	dbSpecs->noRolesPasswords = parent->noRolesPasswords;
 	dbSpecs->failFast = parent->failFast;
 	dbSpecs->useCopyBinary = parent->useCopyBinary;
+	dbSpecs->copyFormat = parent->copyFormat;
+	dbSpecs->useCopyThreads = parent->useCopyThreads;
 	dbSpecs->restart = parent->restart;
 	dbSpecs->resume = parent->resume;
 	dbSpecs->consistent = parent->consistent;
@@ -2621,6 +2626,7 @@ multidb_init_db_specs(CopyDataSpec *dbSpecs,
 	dbSpecs->lObjectJobs = parent->lObjectJobs;
 	dbSpecs->splitTablesLargerThan = parent->splitTablesLargerThan;
 	dbSpecs->splitMaxParts = parent->splitMaxParts;
+	dbSpecs->copyChunkSize = parent->copyChunkSize;
 	dbSpecs->estimateTableSizes = parent->estimateTableSizes;
 	dbSpecs->extRequirements = parent->extRequirements;
 
@@ -86,6 +86,9 @@ typedef struct SafeURI
 } SafeURI;
 
 
+/* --fanout-target may be used that many times */
+#define MAX_FANOUT_TARGETS 3
+
 typedef struct ConnStrings
 {
 	char *source_pguri;         /* malloc'ed area */
@@ -94,6 +97,11 @@ typedef struct ConnStrings
 
 	SafeURI safeSourcePGURI;
 	SafeURI safeTargetPGURI;
+
+	/* --fanout-target: more target databases for the table data */
+	int fanoutCount;
+	char *fanout_pguri[MAX_FANOUT_TARGETS];     /* malloc'ed area */
+	SafeURI safeFanoutPGURI[MAX_FANOUT_TARGETS];
 } ConnStrings;
 
 
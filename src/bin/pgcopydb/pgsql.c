@@ -2,7 +2,11 @@
  * src/bin/pgcopydb/pgsql.c
  *	 API for sending SQL commands to a PostgreSQL server
  */
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
 #include <regex.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <time.h>
 #include <unistd.h>
@@ -33,6 +37,7 @@
 #include "pgsql_timeline.h"
 #include "pgsql_utils.h"
 #include "pg_utils.h"
+#include "ratelimit.h"
 #include "signals.h"
 #include "string_utils.h"
 
@@ -60,13 +65,115 @@ static bool build_parameters_list(PQExpBuffer buffer,
 								  int paramCount,
 								  const char **paramValues);
 
-static bool pg_copy_data(PGSQL *src, PGSQL *dst,
+static bool pg_copy_data(PGSQL *src, PGSQL **dsts, int dstCount,
 						 CopyArgs *args, CopyStats *stats,
 						 void *context, CopyStatsCallback *callback);
 
+static bool pg_copy_begin_target(PGSQL *dst, CopyArgs *args, char *relkind);
+
 static bool pg_copy_send_query(PGSQL *pgsql, CopyArgs *args,
 							   ExecStatusType status);
 
+/*
+ * The COPY relay fills-in buffers from the source with pg_copy_buffer_fill,
+ * which returns one of the following status.
+ */
+typedef enum
+{
+	COPY_FILL_FULL = 0,         /* the buffer threshold has been reached */
+	COPY_FILL_IDLE,             /* no more data available without blocking */
+	COPY_FILL_DONE,             /* COPY is done on the source */
+	COPY_FILL_ERROR
+} CopyFillStatus;
+
+/*
+ * With --use-copy-threads, a reader thread fills-in a bounded ring of
+ * buffers from the source and the main thread sends them to the targets. The
+ * ring is single-producer single-consumer and lock-free: only the reader
+ * advances head, only the writer advances tail, and both sides wake-up the
+ * other one using a non-blocking pipe.
+ */
+typedef struct CopyRing
+{
+	PGSQL *src;
+	pthread_t reader;
+
+	int depth;
+	CopyBuffer slots[COPY_RING_DEPTH];
+
+	uint64_t head;              /* count of slots published by the reader */
+	uint64_t tail;              /* count of slots sent to all the targets */
+
+	bool stop;                  /* the writer asks the reader to stop */
+	bool readerDone;            /* published after the last head update */
+	CopyFillStatus readerStatus;
+	PGresult *result;
+
+	int dataReady[2];           /* reader to writer wake-up pipe */
+	int spaceReady[2];          /* writer to reader wake-up pipe */
+
+	uint64_t readerStalls;      /* the reader waited for a free slot */
+	int notifyErrno;            /* the reader failed to wake-up the writer */
+} CopyRing;
+
+/*
+ * A COPY relay target, see pg_copy_fanout.
+ */
+typedef struct CopyTarget
+{
+	PGSQL *pgsql;
+	CopyTargetStats *stats;
+
+	bool failed;
+	bool busy;                  /* libpq could not queue or flush our data */
+	bool sent;                  /* the current buffer has been queued */
+	uint64_t tail;              /* count of ring slots queued */
+} CopyTarget;
+
+static bool pg_copy_relay(PGSQL *src, CopyTarget *targets, int count,
+						  CopyStats *stats,
+						  void *context, CopyStatsCallback *callback,
+						  bool *failedOnSrc);
+
+static bool pg_copy_relay_threads(PGSQL *src, CopyTarget *targets, int count,
+								  CopyStats *stats,
+								  void *context, CopyStatsCallback *callback,
+								  bool *failedOnSrc);
+
+static void * pg_copy_ring_reader(void *arg);
+static bool pg_copy_ring_init(CopyRing *ring);
+static void pg_copy_ring_free(CopyRing *ring);
+static int pg_copy_ring_notify(int fd);
+static void pg_copy_ring_drain(int fd);
+static int pg_copy_ring_poll(int fd1, int fd2);
+
+static void pg_copy_buffer_init(CopyBuffer *buffer, size_t threshold);
+static void pg_copy_buffer_free(CopyBuffer *buffer);
+
+static CopyFillStatus pg_copy_buffer_fill(PGconn *srcConn,
+										  CopyBuffer *buffer,
+										  PGresult **result);
+
+static bool pg_copy_fill_result(PGSQL *src,
+								CopyFillStatus status,
+								PGresult *res,
+								CopyStats *stats);
+
+static void pg_copy_target_send(CopyTarget *target, CopyBuffer *buffer);
+static void pg_copy_target_fail(CopyTarget *target, const char *context);
+static void pg_copy_targets_flush(CopyTarget *targets, int count);
+static bool pg_copy_targets_alive(CopyTarget *targets, int count);
+static bool pg_copy_targets_busy(CopyTarget *targets, int count);
+
+static void pg_copy_stats_callback(CopyStats *stats,
+								   void *context,
+								   CopyStatsCallback *callback);
+
+static bool pg_copy_wait(int readfd, CopyTarget *targets, int count,
+						 CopyStats *stats);
+
+static uint64_t pg_copy_elapsed_us(instr_time start);
+
 static void pgcopy_log_error(PGSQL *pgsql, PGresult *res, const char *context);
 
 static void getSequenceValue(void *ctx, PGresult *result);
@@ -1225,6 +1332,44 @@ pgsql_has_database_privilege(PGSQL *pgsql, const char *privilege, bool *granted)
 }
 
 
+/*
+ * pgsql_get_wait_ratio computes the percentage of the active client backends
+ * that are currently waiting on a lock or on I/O, as seen in
+ * pg_stat_activity.
+ */
+bool
+pgsql_get_wait_ratio(PGSQL *pgsql, int *ratio)
+{
+	SingleValueResultContext parseContext = { { 0 }, PGSQL_RESULT_INT, false };
+
+	char *sql =
+		"select coalesce(round(100.0 * count(*) filter("
+		"         where wait_event_type in ('Lock', 'LWLock', 'IO', 'BufferPin')"
+		"       ) / nullif(count(*), 0)), 0)::int"
+		"  from pg_stat_activity"
+		" where backend_type = 'client backend'"
+		"   and state = 'active'"
+		"   and pid <> pg_backend_pid()";
+
+	if (!pgsql_execute_with_params(pgsql, sql, 0, NULL, NULL,
+								   &parseContext, &parseSingleValueResult))
+	{
+		log_error("Failed to query pg_stat_activity");
+		return false;
+	}
+
+	if (!parseContext.parsedOk)
+	{
+		log_error("Failed to query pg_stat_activity");
+		return false;
+	}
+
+	*ratio = parseContext.intVal;
+
+	return true;
+}
+
+
 /*
  * pgsql_has_sequence_privilege calls has_sequence_privilege() and copies the
  * result in the granted boolean pointer given.
@@ -1344,6 +1489,139 @@ pgsql_get_table_relkind(PGSQL *pgsql, const char *qname, char *relkind)
 }
 
 
+/*
+ * pgsql_get_table_relpersistence queries pg_class for the relpersistence of
+ * the given qualified table name: 'p' for permanent tables, 'u' for unlogged
+ * tables, and 't' for temporary tables.
+ */
+bool
+pgsql_get_table_relpersistence(PGSQL *pgsql, const char *qname,
+							   char *relpersistence)
+{
+	SingleValueResultContext parseContext = { { 0 }, PGSQL_RESULT_STRING, false };
+
+	char *sql = "select relpersistence from pg_class where oid = $1::regclass;";
+
+	int paramCount = 1;
+	Oid paramTypes[1] = { TEXTOID };
+	const char *paramValues[1] = { qname };
+
+	if (!pgsql_execute_with_params(pgsql, sql,
+								   paramCount, paramTypes, paramValues,
+								   &parseContext, &parseSingleValueResult))
+	{
+		log_error("Failed to query pg_class for relpersistence of table %s",
+				  qname);
+		return false;
+	}
+
+	if (!parseContext.parsedOk)
+	{
+		log_error("Failed to parse relpersistence result for table %s "
+				  "(expected 1 row, got %d)",
+				  qname, parseContext.ntuples);
+		return false;
+	}
+
+	*relpersistence = parseContext.strVal[0];
+
+	free(parseContext.strVal);
+
+	return true;
+}
+
+
+/*
+ * pgsql_txid_current returns the transaction id of the current transaction,
+ * assigning one when needed.
+ */
+bool
+pgsql_txid_current(PGSQL *pgsql, uint64_t *xid)
+{
+	SingleValueResultContext context = { { 0 }, PGSQL_RESULT_BIGINT, false };
+
+	const char *sql = "select txid_current()";
+
+	if (!pgsql_execute_with_params(pgsql, sql, 0, NULL, NULL,
+								   &context, &parseSingleValueResult))
+	{
+		log_error("Failed to get the current transaction id");
+		return false;
+	}
+
+	if (!context.parsedOk || context.isNull)
+	{
+		log_error("Failed to parse the current transaction id");
+		return false;
+	}
+
+	*xid = context.bigint;
+
+	return true;
+}
+
+
+/*
+ * pgsql_txid_committed sets committed to true when the given transaction has
+ * been committed, and to false when it has been aborted. A transaction that
+ * is still in progress, or too old for its status to be known, is an error.
+ *
+ * This uses txid_status() which is available from Postgres 10 onward.
+ */
+bool
+pgsql_txid_committed(PGSQL *pgsql, uint64_t xid, bool *committed)
+{
+	SingleValueResultContext context = { { 0 }, PGSQL_RESULT_STRING, false };
+
+	char xidString[BUFSIZE] = { 0 };
+	sformat(xidString, sizeof(xidString), "%lld", (long long) xid);
+
+	const char *sql = "select txid_status($1::bigint)";
+	int paramCount = 1;
+	Oid paramTypes[1] = { TEXTOID };
+	const char *paramValues[1] = { xidString };
+
+	if (!pgsql_execute_with_params(pgsql, sql,
+								   paramCount, paramTypes, paramValues,
+								   &context, &parseSingleValueResult))
+	{
+		log_error("Failed to get the status of transaction %lld",
+				  (long long) xid);
+		return false;
+	}
+
+	if (!context.parsedOk || context.isNull)
+	{
+		log_error("Failed to get the status of transaction %lld: "
+				  "the transaction is too old",
+				  (long long) xid);
+		return false;
+	}
+
+	bool known = true;
+
+	if (streq(context.strVal, "committed"))
+	{
+		*committed = true;
+	}
+	else if (streq(context.strVal, "aborted"))
+	{
+		*committed = false;
+	}
+	else
+	{
+		log_error("Transaction %lld is %s on the target database",
+				  (long long) xid,
+				  context.strVal);
+		known = false;
+	}
+
+	free(context.strVal);
+
+	return known;
+}
+
+
 /*
  * pgsql_get_search_path runs the query "show search_path" and copies the
  * result in the given pre-allocated string buffer.
@@ -2747,33 +3025,67 @@ pg_copy(PGSQL *src, PGSQL *dst,
 		CopyArgs *args, CopyStats *stats,
 		void *context, CopyStatsCallback *callback)
 {
+	return pg_copy_fanout(src, &dst, 1, args, stats, context, callback);
+}
+
+
+/*
+ * pg_copy_fanout implements a COPY operation from a source Postgres instance
+ * (src) to several target Postgres instances (dsts) at once: the data is read
+ * only once from the source and then written to each of the targets, each
+ * target consuming the data at its own pace.
+ *
+ * When a target fails, the COPY continues with the other ones. The per-target
+ * results are found in stats->targets, in the same order as dsts, and the
+ * function returns true only when the COPY succeeded on all the targets.
+ */
+bool
+pg_copy_fanout(PGSQL *src, PGSQL **dsts, int dstCount,
+			   CopyArgs *args, CopyStats *stats,
+			   void *context, CopyStatsCallback *callback)
+{
+	if (dstCount < 1 || dstCount > COPY_MAX_TARGETS)
+	{
+		log_error("BUG: pg_copy_fanout called with %d targets", dstCount);
+		return false;
+	}
+
 	bool srcConnIsOurs = src->connection == NULL;
 	if (!pgsql_open_connection(src))
 	{
 		return false;
 	}
 
-	bool dstConnIsOurs = dst->connection == NULL;
-	if (!pgsql_open_connection(dst))
+	bool dstConnIsOurs[COPY_MAX_TARGETS] = { 0 };
+	bool opened = true;
+
+	for (int i = 0; i < dstCount; i++)
 	{
-		/* errors have already been logged */
-		if (srcConnIsOurs)
+		dstConnIsOurs[i] = dsts[i]->connection == NULL;
+
+		if (!pgsql_open_connection(dsts[i]))
 		{
-			pgsql_finish(src);
+			/* errors have already been logged */
+			opened = false;
+			break;
 		}
-		return false;
 	}
 
-	bool result = pg_copy_data(src, dst, args, stats, context, callback);
+	bool result =
+		opened &&
+		pg_copy_data(src, dsts, dstCount, args, stats, context, callback);
 
 	if (srcConnIsOurs)
 	{
 		pgsql_finish(src);
 	}
 
-	if (dstConnIsOurs)
+	for (int i = 0; i < dstCount; i++)
 	{
-		pgsql_finish(dst);
+		if (dstConnIsOurs[i])
+		{
+			pgsql_finish(dsts[i]);
+		}
 	}
 
 	return result;
@@ -2782,20 +3094,27 @@ pg_copy(PGSQL *src, PGSQL *dst,
 
 /*
  * pg_copy_data implements the core of pg_copy. That is, COPY operation from a
- * source Postgres instance (src) to a target Postgres instance (dst). It
- * expects src and dst are opened connection and doesn't manage their lifetime.
+ * source Postgres instance (src) to target Postgres instances (dsts). It
+ * expects src and dsts are opened connection and doesn't manage their
+ * lifetime.
  */
 static bool
-pg_copy_data(PGSQL *src, PGSQL *dst,
+pg_copy_data(PGSQL *src, PGSQL **dsts, int dstCount,
 			 CopyArgs *args, CopyStats *stats,
 			 void *context, CopyStatsCallback *callback)
 {
-	PGconn *srcConn = src->connection;
-	PGconn *dstConn = dst->connection;
+	CopyTarget targets[COPY_MAX_TARGETS] = { 0 };
 
-	if (!pgsql_begin(dst))
+	stats->targetCount = dstCount;
+
+	for (int i = 0; i < dstCount; i++)
 	{
-		return false;
+		CopyTargetStats empty = { 0 };
+
+		stats->targets[i] = empty;
+
+		targets[i].pgsql = dsts[i];
+		targets[i].stats = &(stats->targets[i]);
 	}
 
 	/*
@@ -2803,16 +3122,11 @@ pg_copy_data(PGSQL *src, PGSQL *dst,
 	 * to avoid Postgres errors on partitioned tables. '\0' on lookup failure
 	 * falls back to the flat-table path (TRUNCATE ONLY, freeze unchanged).
 	 */
-	char relkind = '\0';
+	char relkind[COPY_MAX_TARGETS] = { 0 };
 
-	if (args->truncate || args->freeze)
-	{
-		(void) pgsql_get_table_relkind(dst, args->dstQname, &relkind);
-	}
-
-	if (args->truncate)
+	for (int i = 0; i < dstCount; i++)
 	{
-		if (!pgsql_truncate(dst, args->dstQname, relkind, args->datname))
+		if (!pg_copy_begin_target(dsts[i], args, &(relkind[i])))
 		{
 			/* errors have already been logged */
 			return false;
@@ -2827,11 +3141,14 @@ pg_copy_data(PGSQL *src, PGSQL *dst,
 	 */
 	args->freeze &= args->truncate;
 
-	if (args->freeze && relkind == 'p')
+	for (int i = 0; i < dstCount; i++)
 	{
-		log_notice("disabling COPY FREEZE on partitioned target table %s",
-				   args->dstQname);
-		args->freeze = false;
+		if (args->freeze && relkind[i] == 'p')
+		{
+			log_notice("disabling COPY FREEZE on partitioned target table %s",
+					   args->dstQname);
+			args->freeze = false;
+		}
 	}
 
 	/* make sure to log TRUNCATE before we log COPY, avoid confusion */
@@ -2851,204 +3168,1393 @@ pg_copy_data(PGSQL *src, PGSQL *dst,
 	}
 
 	/* DST: COPY schema.table FROM STDIN WITH (FREEZE) */
-	if (!pg_copy_send_query(dst, args, PGRES_COPY_IN))
+	for (int i = 0; i < dstCount; i++)
 	{
-		return false;
+		if (!pg_copy_send_query(dsts[i], args, PGRES_COPY_IN))
+		{
+			return false;
+		}
 	}
 
-	/* now implement the copy loop */
-	char *copybuf;
+	/*
+	 * Now implement the copy loop.
+	 *
+	 * Rather than relaying each CopyData message (one row) from the source
+	 * to the target with its own PQputCopyData call, we gather as many
+	 * messages as are readily available in large contiguous buffers and send
+	 * a whole buffer at once. The target connections are switched to
+	 * non-blocking mode, so that the source keeps being read while the
+	 * targets ingest data.
+	 *
+	 * With --use-copy-threads, reading from the source happens in a separate
+	 * thread that fills-in a ring of buffers, and this process only writes to
+	 * the targets.
+	 */
 	bool failedOnSrc = false;
-	bool failedOnDst = false;
 
 	/* also init and maintain copy statistics */
 	stats->startTime = time(NULL);
 	stats->bytesTransmitted = 0;
+	stats->rows = 0;
+	stats->messages = 0;
+	stats->srcWaitUs = 0;
+	stats->dstWaitUs = 0;
+	stats->throttleUs = 0;
+	stats->clientUs = 0;
 
-	for (;;)
+	instr_time copyStart;
+	INSTR_TIME_SET_CURRENT(copyStart);
+
+	for (int i = 0; i < dstCount; i++)
 	{
-		/* handle signals */
-		if (asked_to_quit || asked_to_stop || asked_to_stop_fast)
+		if (PQsetnonblocking(dsts[i]->connection, 1) != 0)
 		{
-			log_debug("COPY was asked to stop");
+			pgcopy_log_error(dsts[i], NULL,
+							 "Failed to set target connection non-blocking");
 			return false;
 		}
+	}
 
-		int bufsize = PQgetCopyData(srcConn, &copybuf, 1);
+	bool relayed =
+		args->useCopyThreads
+		? pg_copy_relay_threads(src, targets, dstCount,
+								stats, context, callback,
+								&failedOnSrc)
+		: pg_copy_relay(src, targets, dstCount,
+						stats, context, callback,
+						&failedOnSrc);
 
-		/*
-		 * A result of -2 indicates that an error occurred.
-		 */
-		if (bufsize == -2)
-		{
-			failedOnSrc = true;
+	bool allFailed = true;
 
-			pgcopy_log_error(src, NULL, "Failed to fetch data from source");
-			break;
-		}
+	for (int i = 0; i < dstCount; i++)
+	{
+		CopyTarget *target = &(targets[i]);
+		PGconn *dstConn = target->pgsql->connection;
 
-		/*
-		 * PQgetCopyData returns -1 to indicate that the COPY is done. Call
-		 * PQgetResult to obtain the final result status of the COPY command.
-		 */
-		else if (bufsize == -1)
+		/* back to blocking mode, also flushing any pending data */
+		if (relayed && !target->failed && PQsetnonblocking(dstConn, 0) != 0)
 		{
-			PGresult *res = PQgetResult(srcConn);
+			pg_copy_target_fail(target, "Failed to copy data to target");
+		}
 
-			if (PQresultStatus(res) != PGRES_COMMAND_OK)
-			{
-				failedOnSrc = true;
+		if (!relayed || target->failed)
+		{
+			(void) PQsetnonblocking(dstConn, 0);
+		}
 
-				pgcopy_log_error(src, res, "Failed to fetch data from source");
-				break;
-			}
+		allFailed = allFailed && target->failed;
+	}
 
-			/* we're done here */
-			clear_results(src);
+	/* the COPY was interrupted by a signal */
+	if (!relayed)
+	{
+		return false;
+	}
 
-			/* make sure to pass through and send this last COPY buffer */
-		}
+	if (allFailed)
+	{
+		clear_results(src);
+	}
 
-		/*
-		 * In async mode, and no data available.
-		 */
-		else if (bufsize == 0)
-		{
-			fd_set input_mask;
-			int sock = PQsocket(srcConn);
+	/*
+	 * The COPY loop is over now.
+	 *
+	 * Time to send end-of-data indication to the server during COPY_IN state.
+	 * Waiting for the targets to process the end of the COPY and to COMMIT is
+	 * accounted for as target wait time.
+	 */
+	bool success = !failedOnSrc;
 
-			if (sock < 0)
-			{
-				failedOnSrc = true;
+	instr_time endStart;
+	INSTR_TIME_SET_CURRENT(endStart);
 
-				pgcopy_log_error(src, NULL, "invalid socket");
-				break;
-			}
+	for (int i = 0; i < dstCount; i++)
+	{
+		CopyTarget *target = &(targets[i]);
+		PGSQL *dst = target->pgsql;
+		PGconn *dstConn = dst->connection;
 
-			struct timeval timeout;
-			struct timeval *timeoutptr = NULL;
+		if (target->failed)
+		{
+			success = false;
+			continue;
+		}
 
-			/* sleep for 10ms to wait for input on the Postgres socket */
-			timeout.tv_sec = 0;
-			timeout.tv_usec = 10000;
-			timeoutptr = &timeout;
+		char *errormsg =
+			failedOnSrc ? "Failed to get data from source" : NULL;
 
-			FD_ZERO(&input_mask);
-			FD_SET(sock, &input_mask);
+		int res = PQputCopyEnd(dstConn, errormsg);
 
-			int r = select(sock + 1, &input_mask, NULL, NULL, timeoutptr);
+		if (res > 0)
+		{
+			PGresult *res = PQgetResult(dstConn);
 
-			if (r == 0 || (r < 0 && errno == EINTR))
+			if (PQresultStatus(res) != PGRES_COMMAND_OK)
 			{
-				/*
-				 * Got a timeout or signal. Continue the loop and either
-				 * deliver a status packet to the server or just go back into
-				 * blocking.
-				 */
-				continue;
+				target->failed = true;
+				pgcopy_log_error(dst, res, "Failed to copy data to target");
 			}
-			else if (r < 0)
-			{
-				failedOnSrc = true;
+		}
 
-				pgcopy_log_error(src, NULL, "select failed: %m");
-				break;
-			}
+		clear_results(dst);
 
-			/* there is actually data on the socket */
-			if (PQconsumeInput(srcConn) == 0)
+		if (!target->failed)
+		{
+			if (!pgsql_execute(dst, "COMMIT"))
 			{
-				failedOnSrc = true;
+				target->failed = true;
+			}
+		}
+
+		target->stats->done = !target->failed;
+		success = success && !target->failed;
+	}
+
+	stats->dstWaitUs += pg_copy_elapsed_us(endStart);
+
+	/* client time is what's left once we remove known wait times */
+	uint64_t totalUs = pg_copy_elapsed_us(copyStart);
+	uint64_t waitUs = stats->srcWaitUs + stats->dstWaitUs + stats->throttleUs;
+
+	stats->clientUs = totalUs > waitUs ? totalUs - waitUs : 0;
+
+	return success;
+}
+
+
+/*
+ * pg_copy_begin_target opens a transaction on the target connection and
+ * TRUNCATE the target table when asked to. The target relkind is looked-up
+ * for the caller, as both TRUNCATE and COPY FREEZE need it. When a begin
+ * callback is set, it is given the target transaction id.
+ */
+static bool
+pg_copy_begin_target(PGSQL *dst, CopyArgs *args, char *relkind)
+{
+	if (!pgsql_begin(dst))
+	{
+		return false;
+	}
+
+	if (args->truncate || args->freeze)
+	{
+		(void) pgsql_get_table_relkind(dst, args->dstQname, relkind);
+	}
+
+	if (args->truncate)
+	{
+		if (!pgsql_truncate(dst, args->dstQname, *relkind, args->datname))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+	}
+
+	if (args->beginCallback != NULL)
+	{
+		uint64_t xid = 0;
+
+		if (!pgsql_txid_current(dst, &xid))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+
+		if (!(*args->beginCallback)(args->beginContext, xid))
+		{
+			log_error("Failed to register target transaction %lld",
+					  (long long) xid);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/*
+ * pg_copy_out runs COPY TO STDOUT on the source connection and calls the
+ * given callback function for each CopyData message received, allowing the
+ * caller to store the data somewhere else than in a target database.
+ */
+bool
+pg_copy_out(PGSQL *src, CopyArgs *args, CopyStats *stats,
+			void *context, CopyDataCallback *callback)
+{
+	if (args->datname != NULL && args->datname[0] != '\0')
+	{
+		log_notice("%s: %s", args->datname, args->logCommand);
+	}
+	else
+	{
+		log_notice("%s", args->logCommand);
+	}
+
+	/* SRC: COPY schema.table TO STDOUT */
+	if (!pg_copy_send_query(src, args, PGRES_COPY_OUT))
+	{
+		return false;
+	}
+
+	stats->startTime = time(NULL);
+	stats->bytesTransmitted = 0;
+	stats->rows = 0;
+	stats->messages = 0;
+	stats->srcWaitUs = 0;
+	stats->dstWaitUs = 0;
+	stats->throttleUs = 0;
+	stats->clientUs = 0;
+
+	instr_time copyStart;
+	INSTR_TIME_SET_CURRENT(copyStart);
+
+	for (;;)
+	{
+		if (asked_to_quit || asked_to_stop || asked_to_stop_fast)
+		{
+			log_debug("COPY was asked to stop");
+			return false;
+		}
+
+		/* PQgetCopyData blocks here, that's time spent waiting for the source */
+		instr_time waitStart;
+		INSTR_TIME_SET_CURRENT(waitStart);
+
+		char *copybuf = NULL;
+		int bufsize = PQgetCopyData(src->connection, &copybuf, 0);
+
+		stats->srcWaitUs += pg_copy_elapsed_us(waitStart);
+
+		if (bufsize > 0)
+		{
+			bool success = (*callback)(context, copybuf, bufsize);
+
+			PQfreemem(copybuf);
+
+			if (!success)
+			{
+				/* errors have already been logged */
+				return false;
+			}
+
+			stats->bytesTransmitted += bufsize;
+			++stats->messages;
+
+			/* respect --max-bandwidth, waiting here when needed */
+			stats->throttleUs += ratelimit_consume(bufsize);
+		}
+
+		/*
+		 * PQgetCopyData returns -1 to indicate that the COPY is done. Call
+		 * PQgetResult to obtain the final result status of the COPY command.
+		 */
+		else if (bufsize == -1)
+		{
+			PGresult *res = PQgetResult(src->connection);
+
+			bool success =
+				pg_copy_fill_result(src, COPY_FILL_DONE, res, stats);
+
+			/* the callback spent the rest of the time storing the data */
+			uint64_t totalUs = pg_copy_elapsed_us(copyStart);
+			uint64_t waitUs = stats->srcWaitUs + stats->throttleUs;
+
+			stats->clientUs = totalUs > waitUs ? totalUs - waitUs : 0;
+
+			return success;
+		}
+
+		/* a result of -2 indicates that an error occurred */
+		else
+		{
+			return pg_copy_fill_result(src, COPY_FILL_ERROR, NULL, stats);
+		}
+	}
+
+	return true;
+}
+
+
+/*
+ * pg_copy_in_start opens a transaction on the target connection, TRUNCATE the
+ * target table when asked to, and then runs COPY FROM STDIN. The caller then
+ * sends data with pg_copy_in_data and finishes with pg_copy_in_finish.
+ */
+bool
+pg_copy_in_start(PGSQL *dst, CopyArgs *args)
+{
+	char relkind = '\0';
+
+	if (!pg_copy_begin_target(dst, args, &relkind))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* see pg_copy_data about COPY FREEZE */
+	args->freeze &= args->truncate;
 
-				pgcopy_log_error(src, NULL, "could not receive data");
+	if (args->freeze && relkind == 'p')
+	{
+		log_notice("disabling COPY FREEZE on partitioned target table %s",
+				   args->dstQname);
+		args->freeze = false;
+	}
+
+	/* DST: COPY schema.table FROM STDIN WITH (FREEZE) */
+	return pg_copy_send_query(dst, args, PGRES_COPY_IN);
+}
+
+
+/*
+ * pg_copy_in_data sends COPY data to the target connection, in blocking mode.
+ */
+bool
+pg_copy_in_data(PGSQL *dst, const char *buffer, int length)
+{
+	if (PQputCopyData(dst->connection, buffer, length) != 1)
+	{
+		pgcopy_log_error(dst, NULL, "Failed to copy data to target");
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * pg_copy_in_finish sends the end-of-data indication to the target and
+ * checks the COPY result, then commits the transaction. When errormsg is not
+ * NULL the COPY is aborted on the target, and the transaction rolled back.
+ */
+bool
+pg_copy_in_finish(PGSQL *dst, const char *errormsg)
+{
+	PGconn *dstConn = dst->connection;
+	bool success = errormsg == NULL;
+
+	if (PQputCopyEnd(dstConn, errormsg) != 1)
+	{
+		pgcopy_log_error(dst, NULL, "Failed to copy data to target");
+		return false;
+	}
+
+	PGresult *res = PQgetResult(dstConn);
+
+	if (success && PQresultStatus(res) != PGRES_COMMAND_OK)
+	{
+		pgcopy_log_error(dst, res, "Failed to copy data to target");
+		success = false;
+	}
+
+	PQclear(res);
+	clear_results(dst);
+
+	if (!success)
+	{
+		(void) pgsql_rollback(dst);
+		return false;
+	}
+
+	return pgsql_execute(dst, "COMMIT");
+}
+
+
+/*
+ * pg_copy_relay implements the copy loop in a single process: read from the
+ * source as much data as is available without blocking, send it to the
+ * targets, and wait on all the sockets at once with poll(). Returns false when
+ * interrupted by a signal, otherwise errors are reported with failedOnSrc and
+ * in each target.
+ */
+static bool
+pg_copy_relay(PGSQL *src, CopyTarget *targets, int count, CopyStats *stats,
+			  void *context, CopyStatsCallback *callback,
+			  bool *failedOnSrc)
+{
+	CopyBuffer buffer = { 0 };
+
+	pg_copy_buffer_init(&buffer, COPY_RELAY_BUFFER_SIZE);
+
+	bool srcDone = false;
+	bool interrupted = false;
+
+	for (;;)
+	{
+		/* handle signals */
+		if (asked_to_quit || asked_to_stop || asked_to_stop_fast)
+		{
+			log_debug("COPY was asked to stop");
+			interrupted = true;
+			break;
+		}
+
+		/*
+		 * Read from the source as much as is available without blocking, up
+		 * to filling-in our buffer. Once the buffer has been queued to some of
+		 * the targets, we can't add data to it anymore.
+		 */
+		bool srcIdle = false;
+		bool pending = false;
+
+		for (int i = 0; i < count; i++)
+		{
+			targets[i].busy = false;
+			pending = pending || (!targets[i].failed && targets[i].sent);
+		}
+
+		if (!srcDone && !pending && buffer.len < buffer.threshold)
+		{
+			PGresult *res = NULL;
+			size_t len = buffer.len;
+
+			CopyFillStatus status =
+				pg_copy_buffer_fill(src->connection, &buffer, &res);
+
+			stats->bytesTransmitted += buffer.len - len;
+
+			/* respect --max-bandwidth, waiting here when needed */
+			stats->throttleUs += ratelimit_consume(buffer.len - len);
+
+			if (!pg_copy_fill_result(src, status, res, stats))
+			{
+				*failedOnSrc = true;
+				break;
+			}
+
+			srcDone = status == COPY_FILL_DONE;
+			srcIdle = status == COPY_FILL_IDLE;
+		}
+
+		/*
+		 * Send the buffer to the targets when it's full, or when the source
+		 * has nothing more for us at the moment. The buffer is released once
+		 * all the targets have queued it.
+		 */
+		if (buffer.len > 0 &&
+			(pending || srcDone || srcIdle || buffer.len >= buffer.threshold))
+		{
+			bool allSent = true;
+
+			for (int i = 0; i < count; i++)
+			{
+				CopyTarget *target = &(targets[i]);
+
+				if (!target->failed && !target->sent)
+				{
+					pg_copy_target_send(target, &buffer);
+				}
+
+				allSent = allSent && (target->failed || target->sent);
+			}
+
+			if (allSent)
+			{
+				stats->messages += buffer.messages;
+
+				buffer.len = 0;
+				buffer.messages = 0;
+
+				for (int i = 0; i < count; i++)
+				{
+					targets[i].sent = false;
+				}
+
+				pg_copy_stats_callback(stats, context, callback);
+			}
+		}
+
+		/* push queued data to the targets without blocking */
+		pg_copy_targets_flush(targets, count);
+
+		if (!pg_copy_targets_alive(targets, count))
+		{
+			break;
+		}
+
+		/* when we've reached the end of COPY from the source, stop here */
+		bool busy = pg_copy_targets_busy(targets, count);
+
+		if (srcDone && buffer.len == 0 && !busy)
+		{
+			break;
+		}
+
+		/*
+		 * Wait until either the source has more data for us or a target can
+		 * accept more data from us, whichever comes first.
+		 */
+		bool waitSrc = !srcDone && srcIdle && buffer.len < buffer.threshold;
+
+		if (waitSrc || busy)
+		{
+			int srcSock = -1;
+
+			if (waitSrc)
+			{
+				srcSock = PQsocket(src->connection);
+
+				if (srcSock < 0)
+				{
+					*failedOnSrc = true;
+					pgcopy_log_error(src, NULL, "invalid socket");
+					break;
+				}
+			}
+
+			if (!pg_copy_wait(srcSock, targets, count, stats))
+			{
 				break;
 			}
 		}
+	}
+
+	pg_copy_buffer_free(&buffer);
+
+	return !interrupted;
+}
+
+
+/*
+ * pg_copy_relay_threads implements the copy loop with two threads of
+ * execution: a reader thread fetches CopyData messages from the source and
+ * fills-in a bounded ring of buffers, and the calling thread sends those
+ * buffers to the targets. Returns false when interrupted by a signal,
+ * otherwise errors are reported with failedOnSrc and in each target.
+ *
+ * Each target keeps its own position in the ring, so that a slow target only
+ * holds back the reader once it lags a whole ring behind the fastest one.
+ *
+ * The reader thread must not use the garbage collected heap, nor log, nor
+ * touch the target connections: it only ever uses the source connection, the
+ * ring, and the wake-up pipes.
+ */
+static bool
+pg_copy_relay_threads(PGSQL *src, CopyTarget *targets, int count,
+					  CopyStats *stats,
+					  void *context, CopyStatsCallback *callback,
+					  bool *failedOnSrc)
+{
+	CopyRing ring = { .src = src, .depth = COPY_RING_DEPTH };
+
+	if (!pg_copy_ring_init(&ring))
+	{
+		/* errors have already been logged */
+		*failedOnSrc = true;
+		pg_copy_ring_free(&ring);
+		return true;
+	}
+
+	/*
+	 * Signals are to be processed by the main thread only, so block all of
+	 * them in the reader thread, which inherits the current signal mask.
+	 */
+	sigset_t mask;
+	sigset_t oldmask;
+
+	sigfillset(&mask);
+	(void) pthread_sigmask(SIG_SETMASK, &mask, &oldmask);
+
+	int err = pthread_create(&(ring.reader), NULL, pg_copy_ring_reader, &ring);
+
+	(void) pthread_sigmask(SIG_SETMASK, &oldmask, NULL);
+
+	if (err != 0)
+	{
+		*failedOnSrc = true;
+		log_error("Failed to create COPY reader thread: %s", strerror(err));
+		pg_copy_ring_free(&ring);
+		return true;
+	}
+
+	stats->ringDepth = ring.depth;
+
+	bool interrupted = false;
+
+	for (;;)
+	{
+		/* handle signals */
+		if (asked_to_quit || asked_to_stop || asked_to_stop_fast)
+		{
+			log_debug("COPY was asked to stop");
+			interrupted = true;
+			break;
+		}
+
+		/* fetch readerDone first, so that head is final when it's true */
+		bool readerDone = __atomic_load_n(&(ring.readerDone), __ATOMIC_ACQUIRE);
+		uint64_t head = __atomic_load_n(&(ring.head), __ATOMIC_ACQUIRE);
+
+		/* each target sends the next slot it has not queued yet */
+		for (int i = 0; i < count; i++)
+		{
+			CopyTarget *target = &(targets[i]);
+
+			target->busy = false;
+
+			if (!target->failed && target->tail < head)
+			{
+				CopyBuffer *slot = &(ring.slots[target->tail % ring.depth]);
+
+				pg_copy_target_send(target, slot);
+
+				if (target->sent)
+				{
+					target->sent = false;
+					++target->tail;
+				}
+			}
+		}
+
+		/* hand back to the reader the slots that all the targets queued */
+		uint64_t tail = head;
+
+		for (int i = 0; i < count; i++)
+		{
+			if (!targets[i].failed && targets[i].tail < tail)
+			{
+				tail = targets[i].tail;
+			}
+		}
+
+		if (ring.tail < tail)
+		{
+			uint64_t released = 0;
+
+			for (uint64_t s = ring.tail; s < tail; s++)
+			{
+				CopyBuffer *slot = &(ring.slots[s % ring.depth]);
+
+				stats->bytesTransmitted += slot->len;
+				stats->ringOccupancy += head - s;
+				++stats->ringSamples;
+
+				stats->messages += slot->messages;
+
+				released += slot->len;
+				slot->len = 0;
+				slot->messages = 0;
+			}
+
+			/* respect --max-bandwidth before the reader may use the slots */
+			stats->throttleUs += ratelimit_consume(released);
+
+			__atomic_store_n(&(ring.tail), tail, __ATOMIC_RELEASE);
+
+			int notifyErrno = pg_copy_ring_notify(ring.spaceReady[1]);
+
+			if (notifyErrno != 0)
+			{
+				log_error("Failed to notify COPY reader thread: %s",
+						  strerror(notifyErrno));
+			}
+
+			pg_copy_stats_callback(stats, context, callback);
+		}
+
+		/* push queued data to the targets without blocking */
+		pg_copy_targets_flush(targets, count);
+
+		if (!pg_copy_targets_alive(targets, count))
+		{
+			break;
+		}
+
+		/* when the reader is done and we sent everything, stop here */
+		bool busy = pg_copy_targets_busy(targets, count);
+
+		if (readerDone && ring.tail == head && !busy)
+		{
+			break;
+		}
+
+		/* a target that has more slots to send should not wait */
+		bool ready = false;
+
+		for (int i = 0; i < count; i++)
+		{
+			CopyTarget *target = &(targets[i]);
+
+			ready = ready ||
+					(!target->failed && !target->busy && target->tail < head);
+		}
+
+		if (ready)
+		{
+			continue;
+		}
+
+		/* when the ring is empty, wait for the reader to publish a slot */
+		bool waitRing = !readerDone && ring.tail == head;
+
+		if (waitRing)
+		{
+			++stats->ringEmpty;
+		}
+
+		if (!readerDone || busy)
+		{
+			int readfd = readerDone ? -1 : ring.dataReady[0];
+
+			if (!pg_copy_wait(readfd, targets, count, stats))
+			{
+				break;
+			}
+
+			pg_copy_ring_drain(ring.dataReady[0]);
+		}
+	}
+
+	/* stop the reader thread, if it's still running, and wait for it */
+	__atomic_store_n(&(ring.stop), true, __ATOMIC_RELEASE);
+
+	int notifyErrno = pg_copy_ring_notify(ring.spaceReady[1]);
+
+	if (notifyErrno != 0)
+	{
+		log_error("Failed to notify COPY reader thread: %s",
+				  strerror(notifyErrno));
+	}
+
+	err = pthread_join(ring.reader, NULL);
+
+	if (err != 0)
+	{
+		log_error("Failed to join COPY reader thread: %s", strerror(err));
+		*failedOnSrc = true;
+	}
+
+	/* the reader thread must not log, report its errors now */
+	if (ring.notifyErrno != 0)
+	{
+		log_error("COPY reader thread failed to notify the writer: %s",
+				  strerror(ring.notifyErrno));
+	}
+
+	stats->ringFull += ring.readerStalls;
+
+	/* now process the reader thread results from the main thread */
+	if (!interrupted &&
+		pg_copy_targets_alive(targets, count) &&
+		ring.readerDone)
+	{
+		if (!pg_copy_fill_result(src, ring.readerStatus, ring.result, stats))
+		{
+			*failedOnSrc = true;
+		}
+	}
+	else if (ring.result != NULL)
+	{
+		PQclear(ring.result);
+	}
+
+	pg_copy_ring_free(&ring);
+
+	return !interrupted;
+}
+
+
+/*
+ * pg_copy_ring_reader is the reader thread main function. It fills-in the
+ * ring slots with data read from the source connection, publishing a slot to
+ * the writer when it's full, or when the source is idle and the writer has
+ * nothing else to send. When the ring is full, the reader waits for the
+ * writer to hand back a slot.
+ */
+static void *
+pg_copy_ring_reader(void *arg)
+{
+	CopyRing *ring = (CopyRing *) arg;
+	PGconn *srcConn = ring->src->connection;
+	int srcSock = PQsocket(srcConn);
+
+	for (;;)
+	{
+		if (__atomic_load_n(&(ring->stop), __ATOMIC_ACQUIRE))
+		{
+			break;
+		}
+
+		uint64_t head = ring->head;
+		uint64_t tail = __atomic_load_n(&(ring->tail), __ATOMIC_ACQUIRE);
+
+		/* the ring is full, wait until the writer hands back a slot */
+		if (head - tail >= (uint64_t) ring->depth)
+		{
+			++ring->readerStalls;
+			(void) pg_copy_ring_poll(ring->spaceReady[0], -1);
+			pg_copy_ring_drain(ring->spaceReady[0]);
+			continue;
+		}
+
+		CopyBuffer *slot = &(ring->slots[head % ring->depth]);
+		PGresult *res = NULL;
+
+		CopyFillStatus status = pg_copy_buffer_fill(srcConn, slot, &res);
+
+		/*
+		 * When the source is idle, publish what we have only when the writer
+		 * is waiting for us, otherwise keep filling-in the current slot so
+		 * that the writer sends larger buffers. The writer wakes us up each
+		 * time it hands back a slot, we might then publish ours.
+		 */
+		if (status == COPY_FILL_IDLE && (slot->len == 0 || head > tail))
+		{
+			if (srcSock < 0 || pg_copy_ring_poll(srcSock, ring->spaceReady[0]) < 0)
+			{
+				status = COPY_FILL_ERROR;
+			}
+			else
+			{
+				pg_copy_ring_drain(ring->spaceReady[0]);
+				continue;
+			}
+		}
+
+		bool done = status == COPY_FILL_DONE || status == COPY_FILL_ERROR;
+
+		if (slot->len > 0)
+		{
+			__atomic_store_n(&(ring->head), head + 1, __ATOMIC_RELEASE);
+		}
+
+		if (done)
+		{
+			ring->readerStatus = status;
+			ring->result = res;
+			__atomic_store_n(&(ring->readerDone), true, __ATOMIC_RELEASE);
+		}
+
+		int notifyErrno = pg_copy_ring_notify(ring->dataReady[1]);
+
+		/* keep the first error for the main thread to report */
+		if (notifyErrno != 0 && ring->notifyErrno == 0)
+		{
+			ring->notifyErrno = notifyErrno;
+		}
+
+		if (done)
+		{
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+
+/*
+ * pg_copy_ring_init allocates the ring slots and the wake-up pipes.
+ */
+static bool
+pg_copy_ring_init(CopyRing *ring)
+{
+	int *pipes[] = { ring->dataReady, ring->spaceReady };
+
+	ring->dataReady[0] = ring->dataReady[1] = -1;
+	ring->spaceReady[0] = ring->spaceReady[1] = -1;
+
+	for (int p = 0; p < 2; p++)
+	{
+		if (pipe(pipes[p]) != 0)
+		{
+			log_error("Failed to create pipe: %m");
+			return false;
+		}
+
+		for (int i = 0; i < 2; i++)
+		{
+			int flags = fcntl(pipes[p][i], F_GETFL, 0);
+
+			if (flags < 0 ||
+				fcntl(pipes[p][i], F_SETFL, flags | O_NONBLOCK) != 0)
+			{
+				log_error("Failed to set pipe non-blocking: %m");
+				return false;
+			}
+		}
+	}
+
+	for (int i = 0; i < ring->depth; i++)
+	{
+		pg_copy_buffer_init(&(ring->slots[i]), COPY_RELAY_BUFFER_SIZE);
+	}
+
+	return true;
+}
+
+
+/*
+ * pg_copy_ring_free releases the memory and pipes used by the ring.
+ */
+static void
+pg_copy_ring_free(CopyRing *ring)
+{
+	for (int i = 0; i < ring->depth; i++)
+	{
+		pg_copy_buffer_free(&(ring->slots[i]));
+	}
+
+	int fds[] = {
+		ring->dataReady[0], ring->dataReady[1],
+		ring->spaceReady[0], ring->spaceReady[1]
+	};
+
+	for (int i = 0; i < 4; i++)
+	{
+		if (fds[i] >= 0)
+		{
+			(void) close(fds[i]);
+		}
+	}
+}
+
+
+/*
+ * pg_copy_ring_notify wakes up the other thread. When the pipe is full, a
+ * wake-up is already pending, which is all we need. Returns the errno of a
+ * failed write, or zero, and does not log as the reader thread calls it.
+ */
+static int
+pg_copy_ring_notify(int fd)
+{
+	char c = 0;
+
+	if (write(fd, &c, 1) != 1 && errno != EAGAIN && errno != EINTR)
+	{
+		return errno;
+	}
+
+	return 0;
+}
+
+
+/*
+ * pg_copy_ring_drain consumes the pending wake-ups from a pipe.
+ */
+static void
+pg_copy_ring_drain(int fd)
+{
+	char buf[64];
+
+	while (read(fd, buf, sizeof(buf)) > 0)
+	{ }
+}
+
+
+/*
+ * pg_copy_ring_poll waits until one of the given file descriptors is ready
+ * for reading, or for COPY_RELAY_POLL_TIMEOUT. The second file descriptor is
+ * optional (-1). It's used in the reader thread and so doesn't log anything.
+ */
+static int
+pg_copy_ring_poll(int fd1, int fd2)
+{
+	struct pollfd fds[2] = {
+		{ .fd = fd1, .events = POLLIN },
+		{ .fd = fd2, .events = POLLIN }
+	};
+
+	int r = poll(fds, fd2 < 0 ? 1 : 2, COPY_RELAY_POLL_TIMEOUT);
+
+	return r < 0 && errno != EINTR ? -1 : r;
+}
+
+
+/*
+ * pg_copy_buffer_init allocates the memory area for a CopyBuffer. The buffer
+ * is allocated with some room after the threshold so that we don't have to
+ * realloc() it each time a CopyData message crosses the threshold.
+ *
+ * CopyBuffer memory is not garbage collected, as it's shared with the COPY
+ * reader thread when using --use-copy-threads.
+ */
+static void
+pg_copy_buffer_init(CopyBuffer *buffer, size_t threshold)
+{
+	buffer->threshold = threshold;
+	buffer->size = 2 * threshold;
+	buffer->len = 0;
+	buffer->data = (char *) pg_malloc(buffer->size * sizeof(char));
+}
+
+
+/*
+ * pg_copy_buffer_free releases the memory area of a CopyBuffer.
+ */
+static void
+pg_copy_buffer_free(CopyBuffer *buffer)
+{
+	if (buffer->data != NULL)
+	{
+		pg_free(buffer->data);
+		buffer->data = NULL;
+	}
+}
+
+
+/*
+ * pg_copy_buffer_fill reads CopyData messages from the source connection and
+ * appends them to the given buffer, until either the buffer threshold is
+ * reached (COPY_FILL_FULL), or the source has no more data available without
+ * blocking (COPY_FILL_IDLE), or the COPY is done on the source
+ * (COPY_FILL_DONE, then result is set to the final COPY result).
+ *
+ * This function is called from the COPY reader thread and must not log.
+ */
+static CopyFillStatus
+pg_copy_buffer_fill(PGconn *srcConn, CopyBuffer *buffer, PGresult **result)
+{
+	bool consumed = false;
+
+	while (buffer->len < buffer->threshold)
+	{
+		char *copybuf = NULL;
+		int bufsize = PQgetCopyData(srcConn, &copybuf, 1);
+
+		/*
+		 * If successful PQgetCopyData returns the row length as a result.
+		 */
+		if (bufsize > 0)
+		{
+			if (buffer->size < buffer->len + bufsize)
+			{
+				buffer->size = buffer->len + bufsize;
+				buffer->data = (char *) pg_realloc(buffer->data, buffer->size);
+			}
+
+			memcpy(buffer->data + buffer->len, copybuf, bufsize);
+			buffer->len += bufsize;
+			++buffer->messages;
+
+			PQfreemem(copybuf);
+
+			consumed = false;
+		}
+
+		/*
+		 * In async mode, and no data available. Read what's available on the
+		 * socket without blocking, and when that brings nothing new, then the
+		 * source connection is idle.
+		 */
+		else if (bufsize == 0)
+		{
+			if (consumed)
+			{
+				return COPY_FILL_IDLE;
+			}
+
+			if (PQconsumeInput(srcConn) == 0)
+			{
+				return COPY_FILL_ERROR;
+			}
+
+			consumed = true;
+		}
+
+		/*
+		 * PQgetCopyData returns -1 to indicate that the COPY is done. Call
+		 * PQgetResult to obtain the final result status of the COPY command.
+		 */
+		else if (bufsize == -1)
+		{
+			*result = PQgetResult(srcConn);
+			return COPY_FILL_DONE;
+		}
+
+		/*
+		 * A result of -2 indicates that an error occurred.
+		 */
+		else
+		{
+			return COPY_FILL_ERROR;
+		}
+	}
+
+	return COPY_FILL_FULL;
+}
+
+
+/*
+ * pg_copy_fill_result processes the status returned by pg_copy_buffer_fill,
+ * logging errors and checking the final result of the COPY on the source. The
+ * count of rows sent by the source is registered in the stats.
+ */
+static bool
+pg_copy_fill_result(PGSQL *src, CopyFillStatus status, PGresult *res,
+					CopyStats *stats)
+{
+	if (status == COPY_FILL_ERROR)
+	{
+		pgcopy_log_error(src, NULL, "Failed to fetch data from source");
+		return false;
+	}
+
+	if (status == COPY_FILL_DONE)
+	{
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		{
+			pgcopy_log_error(src, res, "Failed to fetch data from source");
+			return false;
+		}
+
+		char *tuples = PQcmdTuples(res);
+
+		if (tuples != NULL && tuples[0] != '\0')
+		{
+			if (!stringToUInt64(tuples, &(stats->rows)))
+			{
+				log_debug("Failed to parse COPY row count \"%s\"", tuples);
+			}
+		}
+
+		/* we're done here */
+		PQclear(res);
+		clear_results(src);
+	}
+
+	return true;
+}
+
+
+/*
+ * pg_copy_target_send queues the buffer contents to the target connection,
+ * which is in non-blocking mode. When libpq could not queue the data, the
+ * target is marked busy and we should wait until its socket is writable.
+ */
+static void
+pg_copy_target_send(CopyTarget *target, CopyBuffer *buffer)
+{
+	PGconn *dstConn = target->pgsql->connection;
+	int ret = PQputCopyData(dstConn, buffer->data, buffer->len);
+
+	if (ret == -1)
+	{
+		pg_copy_target_fail(target, "Failed to copy data to target");
+	}
+	else if (ret == 0)
+	{
+		target->busy = true;
+	}
+	else
+	{
+		target->sent = true;
+		target->stats->bytesTransmitted += buffer->len;
+	}
+}
+
+
+/*
+ * pg_copy_target_fail marks a COPY target as failed, the COPY continues with
+ * the other targets, if any.
+ */
+static void
+pg_copy_target_fail(CopyTarget *target, const char *context)
+{
+	target->failed = true;
+	target->busy = false;
+
+	pgcopy_log_error(target->pgsql, NULL, context);
+}
+
+
+/*
+ * pg_copy_targets_flush pushes queued data to the targets without blocking,
+ * marking busy the targets that still have data queued in libpq.
+ */
+static void
+pg_copy_targets_flush(CopyTarget *targets, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		CopyTarget *target = &(targets[i]);
+
+		if (target->failed)
+		{
+			continue;
+		}
+
+		int flush = PQflush(target->pgsql->connection);
+
+		if (flush == -1)
+		{
+			pg_copy_target_fail(target, "Failed to copy data to target");
+		}
+		else if (flush == 1)
+		{
+			target->busy = true;
+		}
+	}
+}
+
+
+/*
+ * pg_copy_targets_alive returns true when at least one target has not failed.
+ */
+static bool
+pg_copy_targets_alive(CopyTarget *targets, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (!targets[i].failed)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+/*
+ * pg_copy_targets_busy returns true when at least one target is busy.
+ */
+static bool
+pg_copy_targets_busy(CopyTarget *targets, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (!targets[i].failed && targets[i].busy)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+/*
+ * pg_copy_stats_callback calls the Copy Stats user callback, if any. The
+ * callback is allowed to fail, we still continue with the copy.
+ */
+static void
+pg_copy_stats_callback(CopyStats *stats,
+					   void *context, CopyStatsCallback *callback)
+{
+	if (callback != NULL)
+	{
+		if (!(*callback)(context, stats))
+		{
+			log_debug("Copy Stats Callback failed, see above for details");
+		}
+	}
+}
+
+
+/*
+ * pg_copy_wait waits until the given file descriptor is ready for reading
+ * (when readfd is not -1) or one of the busy targets sockets is ready for
+ * writing, whichever comes first. A timeout or a signal is not an error, the
+ * caller loops over and checks for interrupts.
+ *
+ * The time spent waiting is accounted for as target wait time when at least
+ * one target is busy, because then we can't make progress until that target
+ * accepts more data from us, and as source wait time otherwise.
+ */
+static bool
+pg_copy_wait(int readfd, CopyTarget *targets, int count, CopyStats *stats)
+{
+	struct pollfd fds[COPY_MAX_TARGETS + 1] = { 0 };
+	CopyTarget *polled[COPY_MAX_TARGETS + 1] = { 0 };
+	int nfds = 0;
+
+	if (readfd >= 0)
+	{
+		fds[nfds].fd = readfd;
+		fds[nfds].events = POLLIN;
+		++nfds;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		CopyTarget *target = &(targets[i]);
+
+		if (target->failed || !target->busy)
+		{
+			continue;
+		}
+
+		int sock = PQsocket(target->pgsql->connection);
+
+		if (sock < 0)
+		{
+			pg_copy_target_fail(target, "invalid socket");
+			continue;
+		}
 
-		/*
-		 * If successful PQgetCopyData returns the row length as a result.
-		 */
-		else if (bufsize > 0)
-		{
-			stats->bytesTransmitted += bufsize;
+		/* also watch for input, Postgres may send us an error message */
+		fds[nfds].fd = sock;
+		fds[nfds].events = POLLIN | POLLOUT;
+		polled[nfds] = target;
+		++nfds;
 
-			if (callback != NULL)
-			{
-				/*
-				 * Allow the Copy Stats user callback to fail, still continue
-				 * with the copy.
-				 */
-				if (!(*callback)(context, stats))
-				{
-					log_debug("Copy Stats Callback failed, "
-							  "see above for details");
-				}
-			}
-		}
+		++target->stats->stalls;
+	}
 
-		/*
-		 * We got a COPY buffer from the source database, send it over as-is to
-		 * the target database, which speaks the same COPY protocol, after all.
-		 */
-		if (copybuf)
-		{
-			int ret = PQputCopyData(dstConn, copybuf, bufsize);
-			PQfreemem(copybuf);
+	bool busy = nfds > (readfd >= 0 ? 1 : 0);
 
-			if (ret == -1)
-			{
-				failedOnDst = true;
+	instr_time waitStart;
+	INSTR_TIME_SET_CURRENT(waitStart);
 
-				pgcopy_log_error(dst, NULL, "Failed to copy data to target");
+	int r = poll(fds, nfds, COPY_RELAY_POLL_TIMEOUT);
 
-				clear_results(src);
+	uint64_t waitUs = pg_copy_elapsed_us(waitStart);
 
-				break;
-			}
-		}
+	if (busy)
+	{
+		stats->dstWaitUs += waitUs;
+	}
+	else
+	{
+		stats->srcWaitUs += waitUs;
+	}
 
-		/* when we've reached the end of COPY from the source, stop here */
-		if (bufsize == -1)
+	if (r < 0 && errno != EINTR)
+	{
+		log_error("Failed to COPY data: poll failed: %m");
+
+		for (int i = 0; i < count; i++)
 		{
-			break;
+			targets[i].failed = true;
 		}
+
+		return false;
 	}
 
 	/*
-	 * The COPY loop is over now.
-	 *
-	 * Time to send end-of-data indication to the server during COPY_IN state.
+	 * When a target has sent us something (such as an error), have libpq
+	 * process it now, so that the next PQputCopyData or PQflush call fails.
 	 */
-	if (!failedOnDst)
+	for (int i = 0; r > 0 && i < nfds; i++)
 	{
-		char *errormsg =
-			failedOnSrc ? "Failed to get data from source" : NULL;
-
-		int res = PQputCopyEnd(dstConn, errormsg);
+		CopyTarget *target = polled[i];
 
-		if (res > 0)
+		if (target != NULL && (fds[i].revents & POLLIN))
 		{
-			PGresult *res = PQgetResult(dstConn);
-
-			if (PQresultStatus(res) != PGRES_COMMAND_OK)
+			if (PQconsumeInput(target->pgsql->connection) == 0)
 			{
-				failedOnDst = true;
-				pgcopy_log_error(dst, res, "Failed to copy data to target");
+				pg_copy_target_fail(target, "Failed to copy data to target");
 			}
 		}
+	}
 
-		clear_results(dst);
+	return true;
+}
 
-		if (!failedOnDst)
-		{
-			if (!pgsql_execute(dst, "COMMIT"))
-			{
-				failedOnDst = true;
-			}
-		}
-	}
 
-	return !failedOnSrc && !failedOnDst;
+/*
+ * pg_copy_elapsed_us returns how many microseconds elapsed since start.
+ */
+static uint64_t
+pg_copy_elapsed_us(instr_time start)
+{
+	instr_time duration;
+
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, start);
+
+	return INSTR_TIME_GET_MICROSEC(duration);
 }
 
 
@@ -3490,6 +4996,84 @@ pgsql_set_gucs(PGSQL *pgsql, GUC *settings)
 }
 
 
+/*
+ * pgsql_reset_session prepares a connection that is kept open between work
+ * items for the next item. A connection that has been lost is closed, so that
+ * the next query opens a new one using the connection retry policy. An open
+ * transaction is rolled back, and the session settings are reset to the given
+ * GUC values, in a single round-trip.
+ */
+bool
+pgsql_reset_session(PGSQL *pgsql, GUC *settings)
+{
+	/* not connected yet, nothing to reset */
+	if (pgsql->connection == NULL)
+	{
+		return true;
+	}
+
+	if (PQstatus(pgsql->connection) != CONNECTION_OK)
+	{
+		log_warn("Connection to %s database at \"%s\" has been lost, "
+				 "reconnecting",
+				 ConnectionTypeToString(pgsql->connectionType),
+				 pgsql->safeURI.pguri);
+
+		(void) pgsql_finish(pgsql);
+		return true;
+	}
+
+	if (pgsql->connectionStatementType != PGSQL_CONNECTION_MULTI_STATEMENT)
+	{
+		log_error("BUG: calling pgsql_reset_session with a "
+				  "non PGSQL_CONNECTION_MULTI_STATEMENT connection");
+		pgsql_finish(pgsql);
+		return false;
+	}
+
+	PQExpBuffer sql = createPQExpBuffer();
+
+	if (PQtransactionStatus(pgsql->connection) != PQTRANS_IDLE)
+	{
+		appendPQExpBufferStr(sql, "ROLLBACK; ");
+	}
+
+	appendPQExpBufferStr(sql, "RESET ALL");
+
+	for (int i = 0; settings[i].name != NULL; i++)
+	{
+		appendPQExpBuffer(sql, "; SET %s TO %s",
+						  settings[i].name, settings[i].value);
+	}
+
+	if (PQExpBufferBroken(sql))
+	{
+		log_error("Failed to create session reset query: out of memory");
+		destroyPQExpBuffer(sql);
+		return false;
+	}
+
+	bool success = pgsql_execute(pgsql, sql->data);
+
+	destroyPQExpBuffer(sql);
+
+	/* the server might have closed the connection since the last item */
+	if (!success &&
+		(pgsql->connection == NULL || pgsql_state_is_connection_error(pgsql)))
+	{
+		log_warn("Failed to reset the session on %s database at \"%s\", "
+				 "reconnecting",
+				 ConnectionTypeToString(pgsql->connectionType),
+				 pgsql->safeURI.pguri);
+
+		(void) pgsql_finish(pgsql);
+		return true;
+	}
+
+	return success;
+}
+
+
 /*
  * pg_copy_large_object copies given large object found on the src database
  * into the dst database. The copy includes re-using the same OID for the large
@@ -3846,6 +5430,9 @@ pg_copy_large_object(PGSQL *src,
 		}
 
 		*bytesTransmitted += bytesRead;
+
+		/* respect --max-bandwidth, waiting here when needed */
+		(void) ratelimit_consume(bytesRead);
 	} while (bytesRead > 0);
 
 	lo_close(src->connection, srcfd);
@@ -3965,6 +5552,60 @@ OutputPluginToString(StreamOutputPlugin plugin)
 }
 
 
+/*
+ * CopyFormatFromString returns an enum value from its string representation.
+ */
+CopyFormat
+CopyFormatFromString(const char *format)
+{
+	if (strcmp(format, "text") == 0)
+	{
+		return COPY_FORMAT_TEXT;
+	}
+	else if (strcmp(format, "binary") == 0)
+	{
+		return COPY_FORMAT_BINARY;
+	}
+	else if (strcmp(format, "auto") == 0)
+	{
+		return COPY_FORMAT_AUTO;
+	}
+
+	return COPY_FORMAT_UNKNOWN;
+}
+
+
+/*
+ * CopyFormatToString converts a CopyFormat enum to string.
+ */
+char *
+CopyFormatToString(CopyFormat format)
+{
+	switch (format)
+	{
+		case COPY_FORMAT_TEXT:
+		{
+			return "text";
+		}
+
+		case COPY_FORMAT_BINARY:
+		{
+			return "binary";
+		}
+
+		case COPY_FORMAT_AUTO:
+		{
+			return "auto";
+		}
+
+		default:
+		{
+			return "unknown";
+		}
+	}
+}
+
+
 /*
  * GUC settings applied to the replication connection before issuing
  * CREATE_REPLICATION_SLOT, so that server-level timeouts (most importantly
@@ -4965,6 +6606,123 @@ pgsql_get_block_size(PGSQL *pgsql, int *blockSize)
 }
 
 
+/*
+ * pgsql_get_wal_level gets the wal_level setting from the connected Postgres
+ * instance, and copies it in the given pre-allocated string buffer.
+ */
+bool
+pgsql_get_wal_level(PGSQL *pgsql, char *walLevel, size_t size)
+{
+	SingleValueResultContext context = { { 0 }, PGSQL_RESULT_STRING, false };
+	const char *query = "SELECT current_setting('wal_level')";
+
+	if (!pgsql_execute_with_params(pgsql, query, 0, NULL, NULL,
+								   &context, &parseSingleValueResult))
+	{
+		/* errors have been logged already */
+		return false;
+	}
+
+	if (!context.parsedOk)
+	{
+		log_error("Failed to get result from current_setting('wal_level')");
+		return false;
+	}
+
+	strlcpy(walLevel, context.strVal, size);
+	free(context.strVal);
+
+	log_sql("pgsql_get_wal_level: %s", walLevel);
+	return true;
+}
+
+
+/*
+ * pgsql_get_relation_pages gets the current size of the given relation, as a
+ * number of blocks. Contrary to pg_class.relpages this is not an estimate.
+ */
+bool
+pgsql_get_relation_pages(PGSQL *pgsql, const char *qname, int64_t *pages)
+{
+	SingleValueResultContext context = { { 0 }, PGSQL_RESULT_BIGINT, false };
+
+	const char *sql =
+		"select pg_relation_size($1::regclass) "
+		"     / current_setting('block_size')::bigint";
+
+	int paramCount = 1;
+	Oid paramTypes[1] = { TEXTOID };
+	const char *paramValues[1] = { qname };
+
+	if (!pgsql_execute_with_params(pgsql, sql,
+								   paramCount, paramTypes, paramValues,
+								   &context, &parseSingleValueResult))
+	{
+		/* errors have been logged already */
+		return false;
+	}
+
+	if (!context.parsedOk)
+	{
+		log_error("Failed to get the size of relation %s", qname);
+		return false;
+	}
+
+	*pages = (int64_t) context.bigint;
+
+	log_sql("pgsql_get_relation_pages: %s %lld", qname, (long long) *pages);
+	return true;
+}
+
+
+/*
+ * pgsql_get_column_max gets the maximum value of the given integer column in
+ * the given table. When the table is empty, isNull is set to true.
+ */
+bool
+pgsql_get_column_max(PGSQL *pgsql, const char *qname, const char *column,
+					 int64_t *max, bool *isNull)
+{
+	SingleValueResultContext context = { { 0 }, PGSQL_RESULT_STRING, false };
+
+	char sql[BUFSIZE] = { 0 };
+
+	sformat(sql, sizeof(sql), "select max(%s)::text from only %s",
+			column, qname);
+
+	if (!pgsql_execute_with_params(pgsql, sql, 0, NULL, NULL,
+								   &context, &parseSingleValueResult))
+	{
+		/* errors have been logged already */
+		return false;
+	}
+
+	if (!context.parsedOk)
+	{
+		log_error("Failed to get the maximum value of %s in table %s",
+				  column, qname);
+		return false;
+	}
+
+	*isNull = context.isNull;
+
+	if (!context.isNull && !stringToInt64(context.strVal, max))
+	{
+		log_error("Failed to parse maximum value \"%s\" of %s in table %s",
+				  context.strVal, column, qname);
+		free(context.strVal);
+		return false;
+	}
+
+	if (context.strVal != NULL)
+	{
+		free(context.strVal);
+	}
+
+	return true;
+}
+
+
 /*
  * pgsql_replication_origin_oid calls pg_replication_origin_oid().
  */
@@ -5542,6 +7300,48 @@ pgsql_table_exists(PGSQL *pgsql,
 }
 
 
+/*
+ * pgsql_fkey_exists checks that a foreign key with the given name exists on
+ * the given table on the Postgres server, and when it does, whether it has
+ * been validated already.
+ */
+bool
+pgsql_fkey_exists(PGSQL *pgsql,
+				  const char *qname,
+				  const char *conname,
+				  bool *exists,
+				  bool *validated)
+{
+	SingleValueResultContext context = { { 0 }, PGSQL_RESULT_BOOL, false };
+
+	char *sql =
+		"select c.convalidated "
+		"  from pg_constraint c "
+		" where c.conrelid = $1::regclass "
+		"   and c.contype = 'f' "
+		"   and format('%I', c.conname) = $2";
+
+	int paramCount = 2;
+	const Oid paramTypes[2] = { TEXTOID, TEXTOID };
+	const char *paramValues[2] = { qname, conname };
+
+	if (!pgsql_execute_with_params(pgsql, sql,
+								   paramCount, paramTypes, paramValues,
+								   &context, &parseSingleValueResult))
+	{
+		log_error("Failed to check if foreign key %s exists on table %s",
+				  conname,
+				  qname);
+		return false;
+	}
+
+	*exists = context.ntuples == 1;
+	*validated = *exists && context.parsedOk && context.boolVal;
+
+	return true;
+}
+
+
 /*
  * pgsql_role_exists checks that a role with the given roleName exists on the
  * Postgres server.
@@ -49,6 +49,32 @@
 #define LOBBUFSIZE 16 * 1024 * 1024 /* 16 MB */
 
 
+/*
+ * Size of the buffer used to relay COPY data from the source to the target:
+ * we gather as many CopyData messages as possible until we reach that size,
+ * and then send the whole buffer to the target at once.
+ */
+#define COPY_RELAY_BUFFER_SIZE (1024 * 1024) /* 1 MB */
+
+/*
+ * When the COPY relay has nothing to do, it waits for either the source or the
+ * target socket to be ready, using this timeout in milliseconds.
+ */
+#define COPY_RELAY_POLL_TIMEOUT 100
+
+/*
+ * With --use-copy-threads, the COPY reader thread fills-in a ring of that
+ * many buffers of COPY_RELAY_BUFFER_SIZE each.
+ */
+#define COPY_RING_DEPTH 8
+
+/*
+ * pg_copy_fanout sends the same COPY data to the main target and to as many
+ * as MAX_FANOUT_TARGETS other targets.
+ */
+#define COPY_MAX_TARGETS (MAX_FANOUT_TARGETS + 1)
+
+
 /*
  * pg_stat_replication.sync_state is one if:
  *   sync, async, quorum, potential
@@ -275,6 +301,8 @@ bool pgsql_set_transaction(PGSQL *pgsql,
 
 bool pgsql_is_in_recovery(PGSQL *pgsql, bool *is_in_recovery);
 
+bool pgsql_get_wait_ratio(PGSQL *pgsql, int *ratio);
+
 bool pgsql_has_database_privilege(PGSQL *pgsql, const char *privilege,
 								  bool *granted);
 
@@ -289,6 +317,11 @@ bool pgsql_has_table_privilege(PGSQL *pgsql,
 							   bool *granted);
 
 bool pgsql_get_table_relkind(PGSQL *pgsql, const char *qname, char *relkind);
+bool pgsql_get_table_relpersistence(PGSQL *pgsql, const char *qname,
+									char *relpersistence);
+
+bool pgsql_txid_current(PGSQL *pgsql, uint64_t *xid);
+bool pgsql_txid_committed(PGSQL *pgsql, uint64_t xid, bool *committed);
 
 bool pgsql_get_search_path(PGSQL *pgsql, char *search_path, size_t size);
 bool pgsql_set_search_path(PGSQL *pgsql, char *search_path, bool local);
@@ -325,6 +358,27 @@ bool pgsql_lock_table(PGSQL *pgsql, const char *qname, const char *lockmode);
 bool pgsql_truncate(PGSQL *pgsql, const char *qname, char relkind,
 					const char *datname);
 
+/*
+ * COPY format selection: --copy-format text|binary|auto.
+ */
+typedef enum
+{
+	COPY_FORMAT_UNKNOWN = 0,
+	COPY_FORMAT_TEXT,
+	COPY_FORMAT_BINARY,
+	COPY_FORMAT_AUTO
+} CopyFormat;
+
+CopyFormat CopyFormatFromString(const char *format);
+char * CopyFormatToString(CopyFormat format);
+
+/*
+ * The begin callback is given the target transaction id before any data is
+ * sent, so that callers may register it and later use txid_status() to know
+ * whether a COPY interrupted around its COMMIT has been committed.
+ */
+typedef bool (CopyBeginCallback)(void *context, uint64_t xid);
+
 typedef struct CopyArgs
 {
 	char *srcQname;
@@ -337,21 +391,82 @@ typedef struct CopyArgs
 	bool truncate;
 	bool freeze;
 	bool useCopyBinary;
+	bool useCopyThreads;
+	CopyBeginCallback *beginCallback;
+	void *beginContext;
 } CopyArgs;
 
 
+typedef struct CopyTargetStats
+{
+	bool done;                  /* COPY has been committed on this target */
+	uint64_t bytesTransmitted;
+	uint64_t stalls;            /* times we waited for this target */
+} CopyTargetStats;
+
+
 typedef struct CopyStats
 {
 	uint64_t startTime;
 	uint64_t bytesTransmitted;
+
+	/* --use-copy-threads ring statistics */
+	int ringDepth;
+	uint64_t ringSamples;       /* count of slots sent to the target */
+	uint64_t ringOccupancy;     /* sum of ring occupancy at each send */
+	uint64_t ringFull;          /* times the reader waited for the writer */
+	uint64_t ringEmpty;         /* times the writer waited for the reader */
+
+	/*
+	 * Wait-time attribution: where the COPY spent its time, in microseconds.
+	 * Time blocked on the source and on the targets is measured around our
+	 * waits, and client time is what's left of the whole COPY duration.
+	 */
+	uint64_t rows;              /* as reported by the source COPY command */
+	uint64_t messages;          /* count of CopyData messages */
+	uint64_t srcWaitUs;         /* blocked waiting for the source */
+	uint64_t dstWaitUs;         /* blocked waiting for the targets */
+	uint64_t throttleUs;        /* waiting to respect --max-bandwidth */
+	uint64_t clientUs;          /* running pgcopydb code */
+
+	/* per-target statistics, see pg_copy_fanout */
+	int targetCount;
+	CopyTargetStats targets[COPY_MAX_TARGETS];
 } CopyStats;
 
 typedef bool (CopyStatsCallback)(void *context, CopyStats *stats);
 
+/* pg_copy_out calls a CopyDataCallback for each CopyData message */
+typedef bool (CopyDataCallback)(void *context, char *buffer, int length);
+
+/*
+ * A CopyBuffer is a contiguous area of memory where we concatenate CopyData
+ * messages from the source, to relay them in a single call to the target.
+ */
+typedef struct CopyBuffer
+{
+	char *data;                 /* pg_malloc'ed area */
+	size_t size;                /* allocated size of the data area */
+	size_t len;                 /* current length of the data */
+	size_t threshold;           /* flush to target when len >= threshold */
+	uint64_t messages;          /* count of CopyData messages in the data */
+} CopyBuffer;
+
 bool pg_copy(PGSQL *src, PGSQL *dst,
 			 CopyArgs *args, CopyStats *stats,
 			 void *context, CopyStatsCallback *callback);
 
+bool pg_copy_fanout(PGSQL *src, PGSQL **dsts, int dstCount,
+					CopyArgs *args, CopyStats *stats,
+					void *context, CopyStatsCallback *callback);
+
+bool pg_copy_out(PGSQL *src, CopyArgs *args, CopyStats *stats,
+				 void *context, CopyDataCallback *callback);
+
+bool pg_copy_in_start(PGSQL *dst, CopyArgs *args);
+bool pg_copy_in_data(PGSQL *dst, const char *buffer, int length);
+bool pg_copy_in_finish(PGSQL *dst, const char *errormsg);
+
 bool pg_copy_from_stdin(PGSQL *pgsql, const char *qname);
 bool pg_copy_row_from_stdin(PGSQL *pgsql, char *fmt, ...);
 bool pg_copy_end(PGSQL *pgsql);
@@ -361,6 +476,7 @@ bool pgsql_get_sequence(PGSQL *pgsql, const char *qname,
 						bool *isCalled);
 
 bool pgsql_set_gucs(PGSQL *pgsql, GUC *settings);
+bool pgsql_reset_session(PGSQL *pgsql, GUC *settings);
 
 bool pg_copy_large_object(PGSQL *src,
 						  PGSQL *dst,
@@ -528,6 +644,10 @@ bool pgsql_stream_logical(LogicalStreamClient *client,
 						  LogicalStreamContext *context);
 
 bool pgsql_get_block_size(PGSQL *pgsql, int *blockSize);
+bool pgsql_get_wal_level(PGSQL *pgsql, char *walLevel, size_t size);
+bool pgsql_get_relation_pages(PGSQL *pgsql, const char *qname, int64_t *pages);
+bool pgsql_get_column_max(PGSQL *pgsql, const char *qname, const char *column,
+						  int64_t *max, bool *isNull);
 
 bool pgsql_replication_origin_oid(PGSQL *pgsql, char *nodeName, uint32_t *oid);
 bool pgsql_replication_origin_create(PGSQL *pgsql, char *nodeName);
@@ -569,6 +689,12 @@ bool pgsql_table_exists(PGSQL *pgsql,
 						const char *relname,
 						bool *exists);
 
+bool pgsql_fkey_exists(PGSQL *pgsql,
+					   const char *qname,
+					   const char *conname,
+					   bool *exists,
+					   bool *validated);
+
 bool pgsql_current_wal_flush_lsn(PGSQL *pgsql, uint64_t *lsn);
 
 char * pgsql_escape_identifier(PGSQL *pgsql, char *src);
@@ -390,6 +390,33 @@ copydb_table_array_as_json_hook(void *ctx, SourceTable *table)
 								  table->targetChecksum.checksum);
 	}
 
+	/* COPY progress and wait-time attribution, from the summary */
+	if (table->copyMessages > 0)
+	{
+		json_object_dotset_number(jsTableObj,
+								  "copy.duration", table->durationMs);
+		json_object_dotset_number(jsTableObj,
+								  "copy.bytes", table->bytesTransmitted);
+		json_object_dotset_number(jsTableObj,
+								  "copy.rows", table->copyRows);
+		json_object_dotset_number(jsTableObj,
+								  "copy.messages", table->copyMessages);
+		json_object_dotset_number(jsTableObj,
+								  "copy.source-wait", table->srcWaitMs);
+		json_object_dotset_number(jsTableObj,
+								  "copy.target-wait", table->dstWaitMs);
+		json_object_dotset_number(jsTableObj,
+								  "copy.throttle-wait", table->throttleMs);
+		json_object_dotset_number(jsTableObj,
+								  "copy.client", table->clientMs);
+		json_object_dotset_string(jsTableObj,
+								  "copy.bound",
+								  summary_copy_bound(table->srcWaitMs,
+													 table->dstWaitMs,
+													 table->throttleMs,
+													 table->clientMs));
+	}
+
 	json_array_append_value(jsTableArray, jsTable);
 
 	return true;
@@ -412,6 +439,13 @@ copydb_table_parts_array_as_json_hook(void *ctx, SourceTableParts *part)
 	json_object_set_number(jsPartObj, "min", (double) part->min);
 	json_object_set_number(jsPartObj, "max", (double) part->max);
 	json_object_set_number(jsPartObj, "count", (double) part->count);
+	json_object_set_number(jsPartObj, "est-rows", (double) part->estRows);
+
+	if (part->typed)
+	{
+		json_object_set_string(jsPartObj, "min-key", part->minKey);
+		json_object_set_string(jsPartObj, "max-key", part->maxKey);
+	}
 
 	json_array_append_value(jsPartArray, jsPart);
 
@@ -1,17 +1,39 @@
 /*
  * src/bin/pgcopydb/queue_utils.c
  *   Utility functions for inter-process queueing
+ *
+ * Queues are implemented by default as a bounded multi-producer
+ * multi-consumer ring of messages in a shared memory area. Each slot of the
+ * ring has a sequence number that tells producers and consumers whether the
+ * slot is free or holds a message for them, so that sending and receiving a
+ * message only takes a couple of atomic operations in the common case, and
+ * no system call. Processes that find the ring empty (or full) sleep on a
+ * futex, and are woken up when a message is sent (or received).
+ *
+ * The shared memory area is created with mmap() before forking the
+ * processes that use the queue, and the kernel releases it when the last of
+ * those processes exits, so there is nothing to clean-up at exit.
+ *
+ * System V message queues are still available with queue_create_kind.
  */
 
 #include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/ipc.h>
 #include <sys/msg.h>
+#include <time.h>
 #include <unistd.h>
 
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
 #include "copydb.h"
 #include "defaults.h"
 #include "log.h"
@@ -19,14 +41,550 @@
 #include "signals.h"
 
 
+/* number of messages in a ring, must be a power of two */
+#define QUEUE_RING_CAPACITY 16384
+
+/* sleep at most that long, so that we check for signals regularly */
+#define QUEUE_RING_WAIT_MS 100
+
+
+typedef struct QueueSlot
+{
+	uint64_t seq;
+	QMessage msg;
+} QueueSlot;
+
+
+/*
+ * The producers and consumers positions are kept on separate cache lines,
+ * and so are the futex words that waiting processes sleep on.
+ */
+struct QueueRing
+{
+	uint64_t capacity;
+	uint64_t mask;
+
+	uint64_t head __attribute__((aligned(64)));      /* next slot to send */
+	uint64_t tail __attribute__((aligned(64)));      /* next slot to receive */
+
+	uint32_t notEmpty __attribute__((aligned(64)));  /* futex word */
+	uint32_t receivers;                               /* waiting on notEmpty */
+
+	uint32_t notFull __attribute__((aligned(64)));   /* futex word */
+	uint32_t senders;                                 /* waiting on notFull */
+
+	pid_t lastSendPid;
+	pid_t lastReceivePid;
+
+	QueueSlot slots[] __attribute__((aligned(64)));
+};
+
+
+/* identifies ring queues in the logs, as System V queues are */
+static int ringCount = 0;
+
+
+static bool queue_ring_create(Queue *queue);
+static bool queue_ring_unlink(Queue *queue);
+static bool queue_ring_send(Queue *queue, QMessage *msg);
+static bool queue_ring_receive(Queue *queue, QMessage *msg);
+static bool queue_ring_stats(Queue *queue, QueueStats *stats);
+
+static bool queue_ring_try_send(QueueRing *ring, QMessage *msg);
+static bool queue_ring_try_receive(QueueRing *ring, QMessage *msg);
+static void queue_ring_wait(uint32_t *word, uint32_t value);
+static void queue_ring_wake(uint32_t *word, uint32_t *waiters);
+
+static bool queue_sysv_create(Queue *queue);
+static bool queue_sysv_unlink(Queue *queue);
+static bool queue_sysv_send(Queue *queue, QMessage *msg);
+static bool queue_sysv_receive(Queue *queue, QMessage *msg);
+static bool queue_sysv_stats(Queue *queue, QueueStats *stats);
+
+
 /*
  * queue_create creates a new message queue.
  */
 bool
 queue_create(Queue *queue, char *name)
+{
+	return queue_create_kind(queue, name, QUEUE_KIND_RING);
+}
+
+
+/*
+ * queue_create_kind creates a new message queue of the given kind.
+ */
+bool
+queue_create_kind(Queue *queue, char *name, QueueKind kind)
 {
 	queue->name = name;
 	queue->owner = getpid();
+	queue->kind = kind;
+	queue->ring = NULL;
+
+	switch (kind)
+	{
+		case QUEUE_KIND_RING:
+		{
+			return queue_ring_create(queue);
+		}
+
+		case QUEUE_KIND_SYSV:
+		{
+			return queue_sysv_create(queue);
+		}
+
+		default:
+		{
+			log_error("BUG: queue_create_kind called with unknown kind %d",
+					  kind);
+			return false;
+		}
+	}
+}
+
+
+/*
+ * queue_unlink removes an existing message queue.
+ */
+bool
+queue_unlink(Queue *queue)
+{
+	if (queue->kind == QUEUE_KIND_SYSV)
+	{
+		return queue_sysv_unlink(queue);
+	}
+
+	return queue_ring_unlink(queue);
+}
+
+
+/*
+ * queue_send sends a message on the queue.
+ */
+bool
+queue_send(Queue *queue, QMessage *msg)
+{
+	if (queue->kind == QUEUE_KIND_SYSV)
+	{
+		return queue_sysv_send(queue, msg);
+	}
+
+	return queue_ring_send(queue, msg);
+}
+
+
+/*
+ * queue_receive receives a message from the queue.
+ */
+bool
+queue_receive(Queue *queue, QMessage *msg)
+{
+	if (queue->kind == QUEUE_KIND_SYSV)
+	{
+		return queue_sysv_receive(queue, msg);
+	}
+
+	return queue_ring_receive(queue, msg);
+}
+
+
+/*
+ * queue_stats retrieves statistics from the queue.
+ */
+bool
+queue_stats(Queue *queue, QueueStats *stats)
+{
+	if (queue->kind == QUEUE_KIND_SYSV)
+	{
+		return queue_sysv_stats(queue, stats);
+	}
+
+	return queue_ring_stats(queue, stats);
+}
+
+
+/*
+ * queue_ring_create creates the shared memory area of a new ring queue.
+ */
+static bool
+queue_ring_create(Queue *queue)
+{
+	size_t size =
+		sizeof(QueueRing) + QUEUE_RING_CAPACITY * sizeof(QueueSlot);
+
+	void *area = mmap(NULL, size,
+					  PROT_READ | PROT_WRITE,
+					  MAP_SHARED | MAP_ANONYMOUS,
+					  -1, 0);
+
+	if (area == MAP_FAILED)
+	{
+		log_fatal("Failed to create %s queue shared memory area: %m",
+				  queue->name);
+		return false;
+	}
+
+	QueueRing *ring = (QueueRing *) area;
+
+	memset(ring, 0, sizeof(QueueRing));
+
+	ring->capacity = QUEUE_RING_CAPACITY;
+	ring->mask = QUEUE_RING_CAPACITY - 1;
+
+	/* slot i is free for the producer that gets position i */
+	for (uint64_t i = 0; i < ring->capacity; i++)
+	{
+		ring->slots[i].seq = i;
+	}
+
+	queue->ring = ring;
+	queue->qId = ++ringCount;
+
+	log_debug("Created message %s queue %d (shared memory ring of %lld slots)",
+			  queue->name,
+			  queue->qId,
+			  (long long) ring->capacity);
+
+	return true;
+}
+
+
+/*
+ * queue_ring_unlink unmaps the ring shared memory area in this process. The
+ * kernel releases the memory once all the processes that share it have
+ * either unmapped it or exited.
+ */
+static bool
+queue_ring_unlink(Queue *queue)
+{
+	if (queue->ring == NULL)
+	{
+		log_error("BUG: queue_unlink called on %s queue %d, "
+				  "which has not been created",
+				  queue->name,
+				  queue->qId);
+		return false;
+	}
+
+	log_debug("munmap %s queue %d", queue->name, queue->qId);
+
+	size_t size =
+		sizeof(QueueRing) + queue->ring->capacity * sizeof(QueueSlot);
+
+	if (munmap(queue->ring, size) != 0)
+	{
+		log_error("Failed to delete %s message queue %d: %m",
+				  queue->name,
+				  queue->qId);
+		return false;
+	}
+
+	queue->ring = NULL;
+
+	return true;
+}
+
+
+/*
+ * queue_ring_send sends a message on the ring, waiting for a slot to be free
+ * when the ring is full.
+ */
+static bool
+queue_ring_send(Queue *queue, QMessage *msg)
+{
+	QueueRing *ring = queue->ring;
+
+	if (ring == NULL)
+	{
+		log_error("BUG: queue_send called on %s queue %d, "
+				  "which has not been created",
+				  queue->name,
+				  queue->qId);
+		return false;
+	}
+
+	for (;;)
+	{
+		if (asked_to_stop || asked_to_stop_fast || asked_to_quit)
+		{
+			return false;
+		}
+
+		if (queue_ring_try_send(ring, msg))
+		{
+			break;
+		}
+
+		/*
+		 * Read the futex word before registering as a waiter and checking
+		 * the ring again: a receiver that frees a slot after our check then
+		 * changes the futex word, and our wait returns immediately.
+		 */
+		uint32_t value = __atomic_load_n(&(ring->notFull), __ATOMIC_SEQ_CST);
+
+		(void) __atomic_add_fetch(&(ring->senders), 1, __ATOMIC_SEQ_CST);
+
+		bool sent = queue_ring_try_send(ring, msg);
+
+		if (!sent)
+		{
+			queue_ring_wait(&(ring->notFull), value);
+		}
+
+		(void) __atomic_sub_fetch(&(ring->senders), 1, __ATOMIC_SEQ_CST);
+
+		if (sent)
+		{
+			break;
+		}
+	}
+
+	__atomic_store_n(&(ring->lastSendPid), getpid(), __ATOMIC_RELAXED);
+
+	queue_ring_wake(&(ring->notEmpty), &(ring->receivers));
+
+	return true;
+}
+
+
+/*
+ * queue_ring_receive receives a message from the ring, waiting for a message
+ * to be sent when the ring is empty.
+ */
+static bool
+queue_ring_receive(Queue *queue, QMessage *msg)
+{
+	QueueRing *ring = queue->ring;
+
+	if (ring == NULL)
+	{
+		log_error("BUG: queue_receive called on %s queue %d, "
+				  "which has not been created",
+				  queue->name,
+				  queue->qId);
+		return false;
+	}
+
+	for (;;)
+	{
+		if (asked_to_stop || asked_to_stop_fast || asked_to_quit)
+		{
+			return false;
+		}
+
+		if (queue_ring_try_receive(ring, msg))
+		{
+			break;
+		}
+
+		/* see queue_ring_send for the ordering of those operations */
+		uint32_t value = __atomic_load_n(&(ring->notEmpty), __ATOMIC_SEQ_CST);
+
+		(void) __atomic_add_fetch(&(ring->receivers), 1, __ATOMIC_SEQ_CST);
+
+		bool received = queue_ring_try_receive(ring, msg);
+
+		if (!received)
+		{
+			queue_ring_wait(&(ring->notEmpty), value);
+		}
+
+		(void) __atomic_sub_fetch(&(ring->receivers), 1, __ATOMIC_SEQ_CST);
+
+		if (received)
+		{
+			break;
+		}
+	}
+
+	__atomic_store_n(&(ring->lastReceivePid), getpid(), __ATOMIC_RELAXED);
+
+	queue_ring_wake(&(ring->notFull), &(ring->senders));
+
+	return true;
+}
+
+
+/*
+ * queue_ring_try_send copies the message in the next free slot of the ring,
+ * and returns false when the ring is full.
+ *
+ * A producer first claims a position by moving the head forward, then
+ * copies its message in the slot, and then publishes the slot by setting its
+ * sequence number to the position plus one.
+ */
+static bool
+queue_ring_try_send(QueueRing *ring, QMessage *msg)
+{
+	uint64_t pos = __atomic_load_n(&(ring->head), __ATOMIC_RELAXED);
+
+	for (;;)
+	{
+		QueueSlot *slot = &(ring->slots[pos & ring->mask]);
+		uint64_t seq = __atomic_load_n(&(slot->seq), __ATOMIC_ACQUIRE);
+		int64_t diff = (int64_t) (seq - pos);
+
+		if (diff == 0)
+		{
+			if (__atomic_compare_exchange_n(&(ring->head), &pos, pos + 1,
+											true,
+											__ATOMIC_RELAXED,
+											__ATOMIC_RELAXED))
+			{
+				slot->msg = *msg;
+				__atomic_store_n(&(slot->seq), pos + 1, __ATOMIC_RELEASE);
+
+				return true;
+			}
+
+			/* another producer got that position, pos has been updated */
+		}
+		else if (diff < 0)
+		{
+			/* the slot still holds the message sent one lap ago */
+			return false;
+		}
+		else
+		{
+			pos = __atomic_load_n(&(ring->head), __ATOMIC_RELAXED);
+		}
+	}
+}
+
+
+/*
+ * queue_ring_try_receive copies the message from the next published slot of
+ * the ring, and returns false when the ring is empty.
+ *
+ * A consumer first claims a position by moving the tail forward, then copies
+ * the message from the slot, and then frees the slot for the producer that
+ * gets the same slot on the next lap of the ring.
+ */
+static bool
+queue_ring_try_receive(QueueRing *ring, QMessage *msg)
+{
+	uint64_t pos = __atomic_load_n(&(ring->tail), __ATOMIC_RELAXED);
+
+	for (;;)
+	{
+		QueueSlot *slot = &(ring->slots[pos & ring->mask]);
+		uint64_t seq = __atomic_load_n(&(slot->seq), __ATOMIC_ACQUIRE);
+		int64_t diff = (int64_t) (seq - (pos + 1));
+
+		if (diff == 0)
+		{
+			if (__atomic_compare_exchange_n(&(ring->tail), &pos, pos + 1,
+											true,
+											__ATOMIC_RELAXED,
+											__ATOMIC_RELAXED))
+			{
+				*msg = slot->msg;
+				__atomic_store_n(&(slot->seq), pos + ring->capacity,
+								 __ATOMIC_RELEASE);
+
+				return true;
+			}
+
+			/* another consumer got that position, pos has been updated */
+		}
+		else if (diff < 0)
+		{
+			/* the slot has not been published yet */
+			return false;
+		}
+		else
+		{
+			pos = __atomic_load_n(&(ring->tail), __ATOMIC_RELAXED);
+		}
+	}
+}
+
+
+/*
+ * queue_ring_wait sleeps until the futex word changes from the given value,
+ * or QUEUE_RING_WAIT_MS have elapsed, or a signal is received.
+ *
+ * On other systems than Linux we do not have futexes, and we sleep for a
+ * short while instead.
+ */
+static void
+queue_ring_wait(uint32_t *word, uint32_t value)
+{
+#if defined(__linux__)
+	struct timespec timeout = {
+		.tv_sec = 0,
+		.tv_nsec = QUEUE_RING_WAIT_MS * 1000 * 1000
+	};
+
+	/* EAGAIN, EINTR, and ETIMEDOUT all have the caller check again */
+	(void) syscall(SYS_futex, word, FUTEX_WAIT, value, &timeout, NULL, 0);
+#else
+	if (__atomic_load_n(word, __ATOMIC_SEQ_CST) == value)
+	{
+		pg_usleep(1000);        /* 1 ms */
+	}
+#endif
+}
+
+
+/*
+ * queue_ring_wake changes the futex word, and wakes up one of the processes
+ * that are waiting on it, if any.
+ */
+static void
+queue_ring_wake(uint32_t *word, uint32_t *waiters)
+{
+	(void) __atomic_add_fetch(word, 1, __ATOMIC_SEQ_CST);
+
+	if (__atomic_load_n(waiters, __ATOMIC_SEQ_CST) == 0)
+	{
+		return;
+	}
+
+#if defined(__linux__)
+	(void) syscall(SYS_futex, word, FUTEX_WAKE, 1, NULL, NULL, 0);
+#endif
+}
+
+
+/*
+ * queue_ring_stats computes statistics about the ring.
+ */
+static bool
+queue_ring_stats(Queue *queue, QueueStats *stats)
+{
+	QueueRing *ring = queue->ring;
+
+	if (ring == NULL)
+	{
+		log_error("Failed to get stats for %s message queue %d: "
+				  "the queue has not been created",
+				  queue->name,
+				  queue->qId);
+		return false;
+	}
+
+	uint64_t head = __atomic_load_n(&(ring->head), __ATOMIC_RELAXED);
+	uint64_t tail = __atomic_load_n(&(ring->tail), __ATOMIC_RELAXED);
+
+	stats->msg_qnum = head > tail ? head - tail : 0;
+	stats->msg_cbytes = stats->msg_qnum * sizeof(((QMessage *) 0)->data);
+	stats->msg_lspid = __atomic_load_n(&(ring->lastSendPid), __ATOMIC_RELAXED);
+	stats->msg_lrpid =
+		__atomic_load_n(&(ring->lastReceivePid), __ATOMIC_RELAXED);
+
+	return true;
+}
+
+
+/*
+ * queue_sysv_create creates a new System V message queue.
+ */
+static bool
+queue_sysv_create(Queue *queue)
+{
 	queue->qId = msgget(IPC_PRIVATE, 0600);
 
 	if (queue->qId < 0)
@@ -52,10 +610,10 @@ queue_create(Queue *queue, char *name)
 
 
 /*
- * queue_unlink removes an existing message queue.
+ * queue_sysv_unlink removes an existing System V message queue.
  */
-bool
-queue_unlink(Queue *queue)
+static bool
+queue_sysv_unlink(Queue *queue)
 {
 	log_debug("iprm -q %d (%s)", queue->qId, queue->name);
 
@@ -79,10 +637,10 @@ queue_unlink(Queue *queue)
 
 
 /*
- * queue_send sends a message on the queue.
+ * queue_sysv_send sends a message on the System V queue.
  */
-bool
-queue_send(Queue *queue, QMessage *msg)
+static bool
+queue_sysv_send(Queue *queue, QMessage *msg)
 {
 	int errStatus;
 	bool firstLoop = true;
@@ -120,10 +678,10 @@ queue_send(Queue *queue, QMessage *msg)
 
 
 /*
- * queue_receive receives a message from the queue.
+ * queue_sysv_receive receives a message from the System V queue.
  */
-bool
-queue_receive(Queue *queue, QMessage *msg)
+static bool
+queue_sysv_receive(Queue *queue, QMessage *msg)
 {
 	int errStatus;
 	bool firstLoop = true;
@@ -159,10 +717,10 @@ queue_receive(Queue *queue, QMessage *msg)
 
 
 /*
- * queue_stats retrieves statistics from the queue.
+ * queue_sysv_stats retrieves statistics from the System V queue.
  */
-bool
-queue_stats(Queue *queue, QueueStats *stats)
+static bool
+queue_sysv_stats(Queue *queue, QueueStats *stats)
 {
 	struct msqid_ds ds = { 0 };
 
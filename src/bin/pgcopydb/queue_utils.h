@@ -14,11 +14,26 @@
 
 #include "postgres.h"
 
+/*
+ * Queues are either a ring of messages in a shared memory area, created with
+ * mmap() before forking the processes that use the queue, or a System V
+ * message queue.
+ */
+typedef enum
+{
+	QUEUE_KIND_RING = 0,
+	QUEUE_KIND_SYSV
+} QueueKind;
+
+typedef struct QueueRing QueueRing;
+
 typedef struct Queue
 {
 	char *name;
 	int qId;
 	pid_t owner;
+	QueueKind kind;
+	QueueRing *ring;            /* shared memory area, when using a ring */
 } Queue;
 
 
@@ -59,6 +74,7 @@ typedef struct QMessage
 } QMessage;
 
 bool queue_create(Queue *queue, char *name);
+bool queue_create_kind(Queue *queue, char *name, QueueKind kind);
 bool queue_unlink(Queue *queue);
 
 bool queue_send(Queue *queue, QMessage *msg);
@@ -0,0 +1,308 @@
+/*
+ * src/bin/pgcopydb/ratelimit.c
+ *   Implementation of a bandwidth limiter shared by all the pgcopydb
+ *   processes.
+ *
+ * The limiter implements a token bucket in its virtual scheduling form (also
+ * known as GCRA): a shared "theoretical arrival time" is pushed forward by the
+ * time it takes to transfer the given amount of bytes at the configured rate,
+ * and the caller only waits until its own reservation begins. Concurrent
+ * processes then get the whole bandwidth under the cap between them, and a
+ * process waits only when the cap would otherwise be exceeded.
+ *
+ * The shared state is only ever updated with atomic operations, so that a
+ * process that is killed can not leave a lock behind.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "postgres_fe.h"
+
+#include "defaults.h"
+#include "log.h"
+#include "ratelimit.h"
+
+
+/* allow for bursts of up to 100ms worth of data after an idle period */
+#define RATELIMIT_BURST_NS ((uint64_t) 100 * 1000 * 1000)
+
+/* account for bytes in batches, limiting contention on the shared state */
+#define RATELIMIT_QUANTUM (64 * 1024)
+
+#define NS_PER_SEC ((uint64_t) 1000 * 1000 * 1000)
+
+
+typedef struct RateLimiter
+{
+	uint64_t bytesPerSec;
+	uint64_t workerBytesPerSec;
+
+	uint64_t tat;               /* theoretical arrival time, in ns */
+
+	uint64_t bytes;
+	uint64_t waits;
+	uint64_t waitNs;
+} RateLimiter;
+
+
+/* the shared memory area, inherited by sub-processes at fork() time */
+static RateLimiter *limiter = NULL;
+
+/* per-process state, reset when we detect that we have been forked */
+static pid_t workerPid = 0;
+static uint64_t workerTat = 0;
+static uint64_t workerPending = 0;
+
+
+static uint64_t ratelimit_now(void);
+static uint64_t ratelimit_reserve(uint64_t *tat, bool shared,
+								  uint64_t rate, uint64_t bytes, uint64_t now);
+
+
+/*
+ * ratelimit_init creates the shared memory area for the limiter and installs
+ * the given settings. It must be called before forking the processes that
+ * share the limiter. When the area exists already, we keep the current
+ * settings, which might have been changed at runtime.
+ */
+bool
+ratelimit_init(RateLimitSettings *settings)
+{
+	if (limiter != NULL)
+	{
+		return true;
+	}
+
+	void *area = mmap(NULL, sizeof(RateLimiter),
+					  PROT_READ | PROT_WRITE,
+					  MAP_SHARED | MAP_ANONYMOUS,
+					  -1, 0);
+
+	if (area == MAP_FAILED)
+	{
+		log_error("Failed to create the bandwidth limiter "
+				  "shared memory area: %m");
+		return false;
+	}
+
+	memset(area, 0, sizeof(RateLimiter));
+	limiter = (RateLimiter *) area;
+
+	return ratelimit_set(settings);
+}
+
+
+/*
+ * ratelimit_set installs new limiter settings, which all the processes take
+ * into account at their next call to ratelimit_consume.
+ */
+bool
+ratelimit_set(RateLimitSettings *settings)
+{
+	if (limiter == NULL)
+	{
+		log_error("BUG: ratelimit_set called before ratelimit_init");
+		return false;
+	}
+
+	__atomic_store_n(&(limiter->bytesPerSec),
+					 settings->bytesPerSec,
+					 __ATOMIC_RELEASE);
+
+	__atomic_store_n(&(limiter->workerBytesPerSec),
+					 settings->workerBytesPerSec,
+					 __ATOMIC_RELEASE);
+
+	/* forget about reservations made at the previous rate */
+	__atomic_store_n(&(limiter->tat), 0, __ATOMIC_RELEASE);
+
+	return true;
+}
+
+
+/*
+ * ratelimit_get reads the current limiter settings and statistics.
+ */
+bool
+ratelimit_get(RateLimitSettings *settings, RateLimitStats *stats)
+{
+	if (limiter == NULL)
+	{
+		log_error("BUG: ratelimit_get called before ratelimit_init");
+		return false;
+	}
+
+	settings->bytesPerSec =
+		__atomic_load_n(&(limiter->bytesPerSec), __ATOMIC_ACQUIRE);
+
+	settings->workerBytesPerSec =
+		__atomic_load_n(&(limiter->workerBytesPerSec), __ATOMIC_ACQUIRE);
+
+	if (stats != NULL)
+	{
+		stats->bytes = __atomic_load_n(&(limiter->bytes), __ATOMIC_RELAXED);
+		stats->waits = __atomic_load_n(&(limiter->waits), __ATOMIC_RELAXED);
+		stats->waitMs =
+			__atomic_load_n(&(limiter->waitNs), __ATOMIC_RELAXED) / 1000000;
+	}
+
+	return true;
+}
+
+
+/*
+ * ratelimit_consume accounts for the given amount of bytes read from the
+ * source database, and waits as long as needed to respect the global and
+ * per-process caps. It's a no-op when no cap has been set. Returns how long
+ * we waited, in microseconds.
+ *
+ * This function is safe to call from the COPY reader thread: it does not
+ * allocate memory nor log anything.
+ */
+uint64_t
+ratelimit_consume(uint64_t bytes)
+{
+	if (limiter == NULL)
+	{
+		return 0;
+	}
+
+	uint64_t rate =
+		__atomic_load_n(&(limiter->bytesPerSec), __ATOMIC_ACQUIRE);
+
+	uint64_t workerRate =
+		__atomic_load_n(&(limiter->workerBytesPerSec), __ATOMIC_ACQUIRE);
+
+	if (rate == 0 && workerRate == 0)
+	{
+		return 0;
+	}
+
+	pid_t pid = getpid();
+
+	if (workerPid != pid)
+	{
+		workerPid = pid;
+		workerTat = 0;
+		workerPending = 0;
+	}
+
+	/*
+	 * Account for bytes in batches of at most 100ms worth of data at the
+	 * lowest rate, so that low caps still result in short waits.
+	 */
+	uint64_t minRate =
+		rate == 0 ? workerRate
+		: workerRate == 0 ? rate
+		: rate < workerRate ? rate : workerRate;
+
+	uint64_t quantum = minRate / 10;
+
+	if (quantum > RATELIMIT_QUANTUM)
+	{
+		quantum = RATELIMIT_QUANTUM;
+	}
+
+	workerPending += bytes;
+
+	if (workerPending < quantum)
+	{
+		return 0;
+	}
+
+	bytes = workerPending;
+	workerPending = 0;
+
+	uint64_t now = ratelimit_now();
+	uint64_t start = now;
+
+	if (rate > 0)
+	{
+		start = ratelimit_reserve(&(limiter->tat), true, rate, bytes, now);
+	}
+
+	if (workerRate > 0)
+	{
+		uint64_t workerStart =
+			ratelimit_reserve(&workerTat, false, workerRate, bytes, now);
+
+		if (workerStart > start)
+		{
+			start = workerStart;
+		}
+	}
+
+	(void) __atomic_add_fetch(&(limiter->bytes), bytes, __ATOMIC_RELAXED);
+
+	if (start > now)
+	{
+		uint64_t waitNs = start - now;
+
+		(void) __atomic_add_fetch(&(limiter->waits), 1, __ATOMIC_RELAXED);
+		(void) __atomic_add_fetch(&(limiter->waitNs), waitNs, __ATOMIC_RELAXED);
+
+		pg_usleep(waitNs / 1000);
+
+		return waitNs / 1000;
+	}
+
+	return 0;
+}
+
+
+/*
+ * ratelimit_reserve pushes the given theoretical arrival time forward by the
+ * time it takes to transfer bytes at the given rate, and returns the time at
+ * which the reservation begins, which might be now.
+ */
+static uint64_t
+ratelimit_reserve(uint64_t *tat, bool shared,
+				  uint64_t rate, uint64_t bytes, uint64_t now)
+{
+	uint64_t cost = bytes * NS_PER_SEC / rate;
+	uint64_t earliest = now > RATELIMIT_BURST_NS ? now - RATELIMIT_BURST_NS : 0;
+
+	if (!shared)
+	{
+		uint64_t start = *tat > earliest ? *tat : earliest;
+
+		*tat = start + cost;
+
+		return start;
+	}
+
+	uint64_t current = __atomic_load_n(tat, __ATOMIC_ACQUIRE);
+
+	for (;;)
+	{
+		uint64_t start = current > earliest ? current : earliest;
+
+		if (__atomic_compare_exchange_n(tat, &current, start + cost,
+										false,
+										__ATOMIC_ACQ_REL,
+										__ATOMIC_ACQUIRE))
+		{
+			return start;
+		}
+	}
+}
+
+
+/*
+ * ratelimit_now returns the current time in nanoseconds, using a clock that
+ * is shared by all the processes on the system.
+ */
+static uint64_t
+ratelimit_now(void)
+{
+	struct timespec ts = { 0 };
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t) ts.tv_sec * NS_PER_SEC + (uint64_t) ts.tv_nsec;
+}
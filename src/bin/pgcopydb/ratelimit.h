@@ -0,0 +1,44 @@
+/*
+ * src/bin/pgcopydb/ratelimit.h
+ *   Bandwidth limiter shared by all the pgcopydb processes
+ */
+
+#ifndef RATELIMIT_H
+#define RATELIMIT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * pgcopydb reads data from the source database in many concurrent processes
+ * (COPY workers, large objects workers). To protect a production source
+ * server, the rate at which all those processes read data can be capped
+ * globally, and optionally per process.
+ *
+ * The limiter lives in a shared memory area that is created in the main
+ * process before forking sub-processes, so that all of them share the same
+ * settings and the same bucket. Settings can be changed at runtime from the
+ * follow coordinator TCP endpoint.
+ */
+typedef struct RateLimitSettings
+{
+	uint64_t bytesPerSec;       /* global cap, zero when unlimited */
+	uint64_t workerBytesPerSec; /* per-process cap, zero when unlimited */
+} RateLimitSettings;
+
+
+typedef struct RateLimitStats
+{
+	uint64_t bytes;             /* bytes accounted for in all the processes */
+	uint64_t waits;             /* count of times a process had to wait */
+	uint64_t waitMs;            /* cumulative time spent waiting */
+} RateLimitStats;
+
+
+bool ratelimit_init(RateLimitSettings *settings);
+bool ratelimit_set(RateLimitSettings *settings);
+bool ratelimit_get(RateLimitSettings *settings, RateLimitStats *stats);
+
+uint64_t ratelimit_consume(uint64_t bytes);
+
+#endif /* RATELIMIT_H */
@@ -0,0 +1,756 @@
+/*
+ * src/bin/pgcopydb/schedule.c
+ *	 Cost model and ordering of the COPY and CREATE INDEX jobs.
+ *
+ *	 The duration of a clone is driven by its longest chain of work: the COPY
+ *	 of a table (or of its parts) followed by the CREATE INDEX commands for
+ *	 that table. We estimate the cost of each COPY job and each index build
+ *	 from the source catalogs, and queue the COPY jobs longest first, counting
+ *	 the index builds that follow them, so that the large tables and the
+ *	 tables with expensive indexes do not start last.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+
+#include "catalog.h"
+#include "defaults.h"
+#include "file_utils.h"
+#include "log.h"
+#include "schedule.h"
+#include "schema.h"
+#include "string_utils.h"
+
+
+typedef struct ScheduleTablePartsContext
+{
+	int count;
+	int64_t *estRows;
+} ScheduleTablePartsContext;
+
+
+static bool schedule_append_item(Schedule *schedule, ScheduleItem *item);
+static bool schedule_table_parts_hook(void *ctx, SourceTableParts *part);
+static bool schedule_add_index_hook(void *ctx, SourceIndex *index);
+static double schedule_index_factor(const char *indexDef);
+static int64_t schedule_rows(int64_t reltuples, int64_t bytes);
+static int schedule_compare_items(const void *a, const void *b);
+static int schedule_compare_catalog_rank(const void *a, const void *b);
+static int schedule_compare_indexes(const void *a, const void *b);
+static int schedule_compare_steps(const void *a, const void *b);
+static int schedule_pick_worker(double *workers, int count);
+
+
+/*
+ * schedule_rows returns the estimated number of rows of a table, using its
+ * on-disk size when the table has never been analyzed.
+ */
+static int64_t
+schedule_rows(int64_t reltuples, int64_t bytes)
+{
+	if (reltuples > 0)
+	{
+		return reltuples;
+	}
+
+	return bytes / SCHEDULE_ROW_WIDTH;
+}
+
+
+/*
+ * schedule_copy_cost returns the estimated duration of the COPY of the given
+ * table, in seconds. Narrow tables with many rows cost more per byte than
+ * wide tables, hence the rows term.
+ */
+double
+schedule_copy_cost(SourceTable *table)
+{
+	if (table->excludeData)
+	{
+		return SCHEDULE_JOB_OVERHEAD;
+	}
+
+	int64_t rows = schedule_rows(table->reltuples, table->bytes);
+
+	return SCHEDULE_JOB_OVERHEAD +
+		   (double) table->bytes / SCHEDULE_COPY_BYTES_PER_SEC +
+		   (double) rows / SCHEDULE_COPY_ROWS_PER_SEC;
+}
+
+
+/*
+ * schedule_index_cost returns the estimated duration of building an index on
+ * a table of the given size, in seconds: a scan of the table then a sort of
+ * its rows, weighted by the index access method and key.
+ */
+double
+schedule_index_cost(int64_t reltuples, int64_t bytes, const char *indexDef)
+{
+	int64_t rows = schedule_rows(reltuples, bytes);
+	double sort = rows > 1 ? (double) rows * log2((double) rows) : 0;
+
+	return SCHEDULE_JOB_OVERHEAD +
+		   (double) bytes / SCHEDULE_INDEX_SCAN_BYTES_PER_SEC +
+		   schedule_index_factor(indexDef) * sort /
+		   SCHEDULE_INDEX_SORT_ROWS_PER_SEC;
+}
+
+
+/*
+ * schedule_index_factor parses an index definition as given by
+ * pg_get_indexdef() and returns how much more expensive than a single column
+ * btree index it is to build.
+ */
+static double
+schedule_index_factor(const char *indexDef)
+{
+	struct
+	{
+		const char *name;
+		double factor;
+	}
+	methods[] = {
+		{ "btree", 1.0 },
+		{ "hash", 0.6 },
+		{ "brin", 0.05 },
+		{ "spgist", 2.0 },
+		{ "gist", 4.0 },
+		{ "gin", 3.0 }
+	};
+
+	double factor = 1.0;
+
+	if (indexDef == NULL)
+	{
+		return factor;
+	}
+
+	const char *key = indexDef;
+	const char *using = strstr(indexDef, " USING ");
+
+	if (using != NULL)
+	{
+		const char *method = using + strlen(" USING ");
+		int count = sizeof(methods) / sizeof(methods[0]);
+
+		/* unknown access methods are considered as expensive as spgist */
+		factor = 2.0;
+
+		for (int i = 0; i < count; i++)
+		{
+			size_t len = strlen(methods[i].name);
+
+			if (strncmp(method, methods[i].name, len) == 0 &&
+				method[len] == ' ')
+			{
+				factor = methods[i].factor;
+				break;
+			}
+		}
+
+		key = method;
+	}
+
+	/* count the key columns, and whether some of them are expressions */
+	const char *p = strchr(key, '(');
+	int columns = 1;
+	int depth = 0;
+	bool quoted = false;
+	bool expression = false;
+
+	for (; p != NULL && *p != '\0'; p++)
+	{
+		if (*p == '"')
+		{
+			quoted = !quoted;
+		}
+		else if (quoted)
+		{
+			continue;
+		}
+		else if (*p == '(')
+		{
+			if (++depth > 1)
+			{
+				expression = true;
+			}
+		}
+		else if (*p == ')')
+		{
+			if (--depth == 0)
+			{
+				break;
+			}
+		}
+		else if (*p == ',' && depth == 1)
+		{
+			++columns;
+		}
+	}
+
+	factor *= 1.0 + 0.25 * (columns - 1);
+
+	if (expression)
+	{
+		factor *= 1.5;
+	}
+
+	/* partial indexes only sort the rows that match their predicate */
+	if (p != NULL && *p != '\0' && strstr(p, " WHERE ") != NULL)
+	{
+		factor *= 0.5;
+	}
+
+	return factor;
+}
+
+
+/*
+ * schedule_add_table adds the COPY jobs of the given table to the schedule,
+ * one job per part when the table is split.
+ */
+bool
+schedule_add_table(DatabaseCatalog *catalog,
+				   Schedule *schedule,
+				   SourceTable *table)
+{
+	ScheduleTable *entry = (ScheduleTable *) calloc(1, sizeof(ScheduleTable));
+
+	if (entry == NULL)
+	{
+		log_error(ALLOCATION_FAILED_ERROR);
+		return false;
+	}
+
+	entry->oid = table->oid;
+	entry->partCount = table->partition.partCount;
+	entry->bytes = table->bytes;
+	entry->reltuples = table->reltuples;
+	entry->copyCost = schedule_copy_cost(table);
+
+	strlcpy(entry->qname, table->qname, sizeof(entry->qname));
+
+	HASH_ADD(hh, schedule->tables, oid, sizeof(uint32_t), entry);
+
+	if (entry->partCount == 0)
+	{
+		ScheduleItem item = {
+			.oid = table->oid,
+			.partNumber = 0,
+			.cost = entry->copyCost,
+			.table = entry
+		};
+
+		entry->maxPartCost = item.cost;
+
+		return schedule_append_item(schedule, &item);
+	}
+
+	/*
+	 * Parts of a split table cover about the same number of rows, unless the
+	 * key distribution is skewed: use the estimated rows of each part when we
+	 * have them.
+	 */
+	ScheduleTablePartsContext context = {
+		.count = 0,
+		.estRows = (int64_t *) calloc(entry->partCount, sizeof(int64_t))
+	};
+
+	if (context.estRows == NULL)
+	{
+		log_error(ALLOCATION_FAILED_ERROR);
+		return false;
+	}
+
+	if (!catalog_iter_s_table_parts(catalog,
+									table->oid,
+									&context,
+									&schedule_table_parts_hook))
+	{
+		/* errors have already been logged */
+		free(context.estRows);
+		return false;
+	}
+
+	int64_t totalRows = 0;
+
+	for (int i = 0; i < context.count; i++)
+	{
+		totalRows += context.estRows[i];
+	}
+
+	for (int i = 0; i < entry->partCount; i++)
+	{
+		double share =
+			totalRows > 0 && i < context.count
+			? (double) context.estRows[i] / totalRows
+			: 1.0 / entry->partCount;
+
+		ScheduleItem item = {
+			.oid = table->oid,
+			.partNumber = i + 1,
+			.cost = SCHEDULE_JOB_OVERHEAD + entry->copyCost * share,
+			.table = entry
+		};
+
+		if (entry->maxPartCost < item.cost)
+		{
+			entry->maxPartCost = item.cost;
+		}
+
+		if (!schedule_append_item(schedule, &item))
+		{
+			/* errors have already been logged */
+			free(context.estRows);
+			return false;
+		}
+	}
+
+	free(context.estRows);
+
+	return true;
+}
+
+
+/*
+ * schedule_table_parts_hook is an iterator callback function.
+ */
+static bool
+schedule_table_parts_hook(void *ctx, SourceTableParts *part)
+{
+	ScheduleTablePartsContext *context = (ScheduleTablePartsContext *) ctx;
+
+	int i = part->partNumber - 1;
+
+	if (i >= 0 && i < part->partCount)
+	{
+		context->estRows[i] = part->estRows > 0 ? part->estRows : 0;
+
+		if (context->count < i + 1)
+		{
+			context->count = i + 1;
+		}
+	}
+
+	return true;
+}
+
+
+/*
+ * schedule_append_item appends a COPY job to the schedule, in catalog order.
+ */
+static bool
+schedule_append_item(Schedule *schedule, ScheduleItem *item)
+{
+	if (schedule->count == schedule->capacity)
+	{
+		int capacity = schedule->capacity == 0 ? 64 : 2 * schedule->capacity;
+
+		ScheduleItem *array =
+			(ScheduleItem *) realloc(schedule->array,
+									 capacity * sizeof(ScheduleItem));
+
+		if (array == NULL)
+		{
+			log_error(ALLOCATION_FAILED_ERROR);
+			return false;
+		}
+
+		schedule->array = array;
+		schedule->capacity = capacity;
+	}
+
+	item->catalogRank = schedule->count;
+	schedule->array[(schedule->count)++] = *item;
+
+	return true;
+}
+
+
+/*
+ * schedule_add_indexes adds the CREATE INDEX jobs of the tables that have
+ * been added to the schedule.
+ */
+bool
+schedule_add_indexes(DatabaseCatalog *catalog, Schedule *schedule)
+{
+	if (!catalog_iter_s_index(catalog, schedule, &schedule_add_index_hook))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * schedule_add_index_hook is an iterator callback function.
+ */
+static bool
+schedule_add_index_hook(void *ctx, SourceIndex *index)
+{
+	Schedule *schedule = (Schedule *) ctx;
+	ScheduleTable *table = NULL;
+
+	HASH_FIND(hh, schedule->tables, &(index->tableOid), sizeof(uint32_t), table);
+
+	if (table == NULL)
+	{
+		log_debug("Skipping index %s on table %s not found in the schedule",
+				  index->indexQname,
+				  index->tableQname);
+		return true;
+	}
+
+	if (schedule->indexCount == schedule->indexCapacity)
+	{
+		int capacity =
+			schedule->indexCapacity == 0 ? 64 : 2 * schedule->indexCapacity;
+
+		ScheduleIndex *array =
+			(ScheduleIndex *) realloc(schedule->indexArray,
+									  capacity * sizeof(ScheduleIndex));
+
+		if (array == NULL)
+		{
+			log_error(ALLOCATION_FAILED_ERROR);
+			return false;
+		}
+
+		schedule->indexArray = array;
+		schedule->indexCapacity = capacity;
+	}
+
+	ScheduleIndex *entry = &(schedule->indexArray[(schedule->indexCount)++]);
+
+	entry->indexOid = index->indexOid;
+	entry->cost = schedule_index_cost(table->reltuples,
+									  table->bytes,
+									  index->indexDef);
+	entry->table = table;
+
+	strlcpy(entry->indexQname, index->indexQname, sizeof(entry->indexQname));
+
+	++(table->indexCount);
+	table->indexCost += entry->cost;
+
+	if (table->maxIndexCost < entry->cost)
+	{
+		table->maxIndexCost = entry->cost;
+	}
+
+	return true;
+}
+
+
+/*
+ * schedule_sort sorts the COPY jobs longest first. A job is as long as the
+ * longest part of its table followed by the longest index build of the same
+ * table, which can only start when all the parts are done.
+ *
+ * All the parts of a table share the same priority and are kept together in
+ * part order: when the TRUNCATE is deferred to the first part, the other
+ * parts wait for it.
+ */
+void
+schedule_sort(Schedule *schedule)
+{
+	for (int i = 0; i < schedule->count; i++)
+	{
+		ScheduleItem *item = &(schedule->array[i]);
+
+		item->priority = item->table->maxPartCost + item->table->maxIndexCost;
+	}
+
+	qsort(schedule->array, schedule->count, sizeof(ScheduleItem), /* IGNORE-BANNED */
+		  schedule_compare_items);
+}
+
+
+/*
+ * schedule_sort_catalog_order sorts the COPY jobs back in catalog order, that
+ * is by table size, largest first.
+ */
+void
+schedule_sort_catalog_order(Schedule *schedule)
+{
+	qsort(schedule->array, schedule->count, sizeof(ScheduleItem), /* IGNORE-BANNED */
+		  schedule_compare_catalog_rank);
+}
+
+
+/*
+ * schedule_compare_items is a qsort comparison function that sorts COPY jobs
+ * by priority descending, then in catalog order.
+ */
+static int
+schedule_compare_items(const void *a, const void *b)
+{
+	const ScheduleItem *ia = (const ScheduleItem *) a;
+	const ScheduleItem *ib = (const ScheduleItem *) b;
+
+	if (ia->priority > ib->priority)
+	{
+		return -1;
+	}
+	else if (ia->priority < ib->priority)
+	{
+		return 1;
+	}
+
+	return schedule_compare_catalog_rank(a, b);
+}
+
+
+/*
+ * schedule_compare_catalog_rank is a qsort comparison function that sorts
+ * COPY jobs in catalog order.
+ */
+static int
+schedule_compare_catalog_rank(const void *a, const void *b)
+{
+	const ScheduleItem *ia = (const ScheduleItem *) a;
+	const ScheduleItem *ib = (const ScheduleItem *) b;
+
+	return ia->catalogRank - ib->catalogRank;
+}
+
+
+/*
+ * schedule_simulate runs the schedule with the given count of COPY and CREATE
+ * INDEX workers, in the current order of the COPY jobs. The indexes of a
+ * table are queued when its last part is done, as copydb_add_table_indexes
+ * does, longest first.
+ */
+bool
+schedule_simulate(Schedule *schedule,
+				  int tableJobs,
+				  int indexJobs,
+				  ScheduleSimulation *simulation)
+{
+	int stepCount = schedule->count + schedule->indexCount;
+
+	double *tableWorkers = (double *) calloc(tableJobs, sizeof(double));
+	double *indexWorkers = (double *) calloc(indexJobs, sizeof(double));
+	ScheduleStep *steps =
+		(ScheduleStep *) calloc(stepCount + 1, sizeof(ScheduleStep));
+
+	if (tableWorkers == NULL || indexWorkers == NULL || steps == NULL)
+	{
+		log_error(ALLOCATION_FAILED_ERROR);
+		free(tableWorkers);
+		free(indexWorkers);
+		free(steps);
+		return false;
+	}
+
+	simulation->count = 0;
+	simulation->steps = steps;
+	simulation->copyDuration = 0;
+	simulation->duration = 0;
+
+	ScheduleTable *table = NULL;
+	ScheduleTable *tmp = NULL;
+
+	HASH_ITER(hh, schedule->tables, table, tmp)
+	{
+		table->done = 0;
+	}
+
+	for (int i = 0; i < schedule->count; i++)
+	{
+		ScheduleItem *item = &(schedule->array[i]);
+		ScheduleStep *step = &(steps[(simulation->count)++]);
+
+		int w = schedule_pick_worker(tableWorkers, tableJobs);
+
+		step->start = tableWorkers[w];
+		step->end = step->start + item->cost;
+		step->worker = w + 1;
+		step->isIndex = false;
+
+		if (item->partNumber == 0)
+		{
+			strlcpy(step->object, item->table->qname, sizeof(step->object));
+		}
+		else
+		{
+			sformat(step->object, sizeof(step->object), "%s [%d/%d]",
+					item->table->qname,
+					item->partNumber,
+					item->table->partCount);
+		}
+
+		tableWorkers[w] = step->end;
+
+		if (item->table->done < step->end)
+		{
+			item->table->done = step->end;
+		}
+
+		if (simulation->copyDuration < step->end)
+		{
+			simulation->copyDuration = step->end;
+		}
+	}
+
+	simulation->duration = simulation->copyDuration;
+
+	qsort(schedule->indexArray, schedule->indexCount,     /* IGNORE-BANNED */
+		  sizeof(ScheduleIndex),
+		  schedule_compare_indexes);
+
+	for (int i = 0; i < schedule->indexCount; i++)
+	{
+		ScheduleIndex *index = &(schedule->indexArray[i]);
+		ScheduleStep *step = &(steps[(simulation->count)++]);
+
+		int w = schedule_pick_worker(indexWorkers, indexJobs);
+
+		step->start = indexWorkers[w] > index->table->done
+					  ? indexWorkers[w]
+					  : index->table->done;
+		step->end = step->start + index->cost;
+		step->worker = w + 1;
+		step->isIndex = true;
+
+		strlcpy(step->object, index->indexQname, sizeof(step->object));
+
+		indexWorkers[w] = step->end;
+
+		if (simulation->duration < step->end)
+		{
+			simulation->duration = step->end;
+		}
+	}
+
+	qsort(steps, simulation->count, sizeof(ScheduleStep), /* IGNORE-BANNED */
+		  schedule_compare_steps);
+
+	free(tableWorkers);
+	free(indexWorkers);
+
+	return true;
+}
+
+
+/*
+ * schedule_pick_worker returns the worker that is available first.
+ */
+static int
+schedule_pick_worker(double *workers, int count)
+{
+	int w = 0;
+
+	for (int i = 1; i < count; i++)
+	{
+		if (workers[i] < workers[w])
+		{
+			w = i;
+		}
+	}
+
+	return w;
+}
+
+
+/*
+ * schedule_compare_indexes is a qsort comparison function that sorts CREATE
+ * INDEX jobs in the order they are queued: by table completion, then longest
+ * first.
+ */
+static int
+schedule_compare_indexes(const void *a, const void *b)
+{
+	const ScheduleIndex *ia = (const ScheduleIndex *) a;
+	const ScheduleIndex *ib = (const ScheduleIndex *) b;
+
+	if (ia->table->done < ib->table->done)
+	{
+		return -1;
+	}
+	else if (ia->table->done > ib->table->done)
+	{
+		return 1;
+	}
+
+	if (ia->cost > ib->cost)
+	{
+		return -1;
+	}
+	else if (ia->cost < ib->cost)
+	{
+		return 1;
+	}
+
+	return ia->indexOid < ib->indexOid ? -1 : ia->indexOid > ib->indexOid;
+}
+
+
+/*
+ * schedule_compare_steps is a qsort comparison function that sorts the steps
+ * of a simulation in timeline order.
+ */
+static int
+schedule_compare_steps(const void *a, const void *b)
+{
+	const ScheduleStep *sa = (const ScheduleStep *) a;
+	const ScheduleStep *sb = (const ScheduleStep *) b;
+
+	if (sa->start < sb->start)
+	{
+		return -1;
+	}
+	else if (sa->start > sb->start)
+	{
+		return 1;
+	}
+
+	if (sa->isIndex != sb->isIndex)
+	{
+		return sa->isIndex ? 1 : -1;
+	}
+
+	return sa->worker - sb->worker;
+}
+
+
+/*
+ * schedule_free frees the memory allocated for the given schedule.
+ */
+void
+schedule_free(Schedule *schedule)
+{
+	ScheduleTable *table = NULL;
+	ScheduleTable *tmp = NULL;
+
+	HASH_ITER(hh, schedule->tables, table, tmp)
+	{
+		HASH_DEL(schedule->tables, table);
+		free(table);
+	}
+
+	free(schedule->array);
+	free(schedule->indexArray);
+
+	schedule->array = NULL;
+	schedule->indexArray = NULL;
+	schedule->count = schedule->capacity = 0;
+	schedule->indexCount = schedule->indexCapacity = 0;
+}
+
+
+/*
+ * schedule_simulation_free frees the memory allocated for the given
+ * simulation.
+ */
+void
+schedule_simulation_free(ScheduleSimulation *simulation)
+{
+	free(simulation->steps);
+
+	simulation->steps = NULL;
+	simulation->count = 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * src/bin/pgcopydb/schedule.h
+ *     Cost model and ordering of the COPY and CREATE INDEX jobs
+ */
+
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include "catalog.h"
+#include "schema.h"
+
+
+/*
+ * The cost model estimates durations in seconds from the source catalogs.
+ * The absolute values only matter for `pgcopydb list schedule`, the ordering
+ * of the jobs only depends on the relative costs.
+ */
+typedef struct ScheduleTable
+{
+	uint32_t oid;
+	char qname[PG_NAMEDATALEN_FQ];
+
+	int partCount;
+	int64_t bytes;
+	int64_t reltuples;
+
+	double copyCost;            /* all the parts of the table */
+	double indexCost;           /* all the indexes of the table */
+	double maxIndexCost;        /* longest index build of the table */
+	double maxPartCost;         /* longest part of the table */
+	int indexCount;
+
+	double done;                /* used by the simulation */
+
+	UT_hash_handle hh;          /* makes this structure hashable */
+} ScheduleTable;
+
+
+/* a COPY job, one per table or per part of a split table */
+typedef struct ScheduleItem
+{
+	uint32_t oid;
+	int partNumber;             /* zero when the table is not split */
+	int catalogRank;            /* position in the catalog order */
+
+	double cost;                /* estimated COPY duration */
+	double priority;            /* longest job first, index builds included */
+
+	ScheduleTable *table;
+} ScheduleItem;
+
+
+/* a CREATE INDEX job, ready when all the parts of its table are done */
+typedef struct ScheduleIndex
+{
+	uint32_t indexOid;
+	char indexQname[PG_NAMEDATALEN_FQ];
+
+	double cost;                /* estimated CREATE INDEX duration */
+
+	ScheduleTable *table;
+} ScheduleIndex;
+
+
+typedef struct Schedule
+{
+	int count;
+	int capacity;
+	ScheduleItem *array;        /* malloc'ed area */
+
+	int indexCount;
+	int indexCapacity;
+	ScheduleIndex *indexArray;  /* malloc'ed area */
+
+	ScheduleTable *tables;      /* hash table, by oid */
+} Schedule;
+
+
+/* one step of a simulated run, see `pgcopydb list schedule` */
+typedef struct ScheduleStep
+{
+	double start;
+	double end;
+	int worker;
+	bool isIndex;
+	char object[PG_NAMEDATALEN_FQ + 16];
+} ScheduleStep;
+
+
+typedef struct ScheduleSimulation
+{
+	double copyDuration;
+	double duration;
+
+	int count;
+	ScheduleStep *steps;        /* malloc'ed area */
+} ScheduleSimulation;
+
+
+double schedule_copy_cost(SourceTable *table);
+double schedule_index_cost(int64_t reltuples, int64_t bytes, const char *indexDef);
+
+bool schedule_add_table(DatabaseCatalog *catalog,
+						Schedule *schedule,
+						SourceTable *table);
+bool schedule_add_indexes(DatabaseCatalog *catalog, Schedule *schedule);
+
+void schedule_sort(Schedule *schedule);
+void schedule_sort_catalog_order(Schedule *schedule);
+
+bool schedule_simulate(Schedule *schedule,
+					   int tableJobs,
+					   int indexJobs,
+					   ScheduleSimulation *simulation);
+
+void schedule_free(Schedule *schedule);
+void schedule_simulation_free(ScheduleSimulation *simulation);
+
+
+#endif  /* SCHEDULE_H */
@@ -113,6 +113,56 @@ typedef struct SourceTablePartKeyMinMaxValueContext
 	bool parsedOk;
 } SourceTablePartKeyMinMaxValueContext;
 
+/*
+ * Context used when fetching the distribution of a candidate partition key,
+ * as a list of bounds that divide the non-null values into groups of about
+ * the same number of rows.
+ */
+typedef struct SourceTablePartKeyHistogramContext
+{
+	char sqlstate[SQLSTATE_LENGTH];
+	int count;
+	int64_t *bounds;            /* malloc'ed area */
+	double nullFrac;
+	int64_t rows;               /* estimated count of rows in the table */
+	bool parsedOk;
+} SourceTablePartKeyHistogramContext;
+
+/*
+ * Context used when sampling the density of live tuples of a table, as a
+ * count of sampled tuples per bucket of bucketPages blocks.
+ */
+typedef struct SourceTableCtidDensityContext
+{
+	char sqlstate[SQLSTATE_LENGTH];
+	int count;                  /* number of buckets */
+	int64_t bucketPages;
+	int64_t pages;
+	int64_t *tuples;            /* malloc'ed area */
+	int64_t sampled;            /* total count of sampled tuples */
+	int64_t rows;               /* estimated count of rows in the table */
+	bool parsedOk;
+} SourceTableCtidDensityContext;
+
+/* Context used when looking for a unique key to split a table on */
+typedef struct SourceTableSplitKeyContext
+{
+	char sqlstate[SQLSTATE_LENGTH];
+	SourceTable *table;
+	bool found;
+	bool parsedOk;
+} SourceTableSplitKeyContext;
+
+/* Context used when fetching typed split boundaries from a table sample */
+typedef struct SourceTableKeyBoundsContext
+{
+	char sqlstate[SQLSTATE_LENGTH];
+	int count;
+	char **bounds;              /* malloc'ed area */
+	int64_t rows;               /* estimated count of rows in the table */
+	bool parsedOk;
+} SourceTableKeyBoundsContext;
+
 /* Context used when fetching all the sequence definitions */
 typedef struct SourceSequenceArrayContext
 {
@@ -138,6 +188,22 @@ typedef struct SourceDependArrayContext
 	bool parsedOk;
 } SourceDependArrayContext;
 
+/* Context used when fetching all the foreign keys */
+typedef struct SourceFKeyArrayContext
+{
+	char sqlstate[SQLSTATE_LENGTH];
+	DatabaseCatalog *catalog;
+	bool parsedOk;
+} SourceFKeyArrayContext;
+
+/* Context used when fetching the planner statistics of the tables */
+typedef struct SourceTableStatsArrayContext
+{
+	char sqlstate[SQLSTATE_LENGTH];
+	DatabaseCatalog *catalog;
+	bool parsedOk;
+} SourceTableStatsArrayContext;
+
 /* Context used when fetching a table's rowcount and checksum */
 typedef struct ChecksumContext
 {
@@ -193,6 +259,63 @@ static void parsePartKeyMinMaxValue(void *ctx, PGresult *result);
 
 static bool getPartKeyMinMaxValue(PGSQL *pgsql, SourceTable *table);
 
+static bool getSplitSamplePercent(PGSQL *pgsql,
+								  SourceTable *table,
+								  double *percent);
+
+static bool getPartKeyHistogram(PGSQL *pgsql,
+								SourceTable *table,
+								SourceTablePartKeyHistogramContext *context);
+static void parsePartKeyHistogram(void *ctx, PGresult *result);
+
+static bool schema_split_is_skewed(SourceTable *table,
+								   SourceTablePartKeyHistogramContext *hist,
+								   int64_t rangeCount,
+								   int64_t rangeSize);
+
+static bool schema_split_by_histogram(SourceTable *table,
+									  SourceTablePartKeyHistogramContext *hist,
+									  int64_t rangeCount,
+									  int64_t *bounds);
+
+static double partKeyHistogramFraction(SourceTablePartKeyHistogramContext *hist,
+									   int64_t value);
+
+static bool getCtidDensity(PGSQL *pgsql,
+						   SourceTable *table,
+						   int64_t pages,
+						   int64_t partsCount,
+						   SourceTableCtidDensityContext *context);
+static void parseCtidDensity(void *ctx, PGresult *result);
+
+static bool schema_split_density_is_skewed(SourceTable *table,
+										   SourceTableCtidDensityContext *density,
+										   int64_t partsCount,
+										   int64_t partsSize);
+
+static bool schema_split_by_density(SourceTable *table,
+									SourceTableCtidDensityContext *density,
+									int64_t partsCount,
+									int64_t *bounds);
+
+static double ctidDensityFraction(SourceTableCtidDensityContext *density,
+								  int64_t page);
+
+static void parseSplitKey(void *ctx, PGresult *result);
+
+static bool schema_list_key_partitions(PGSQL *pgsql,
+									   DatabaseCatalog *catalog,
+									   SourceTable *table,
+									   uint64_t partSize,
+									   int splitMaxParts);
+
+static bool getPartKeyBounds(PGSQL *pgsql,
+							 SourceTable *table,
+							 int64_t partsCount,
+							 SourceTableKeyBoundsContext *context);
+static void parsePartKeyBounds(void *ctx, PGresult *result);
+static void freePartKeyBounds(SourceTableKeyBoundsContext *context);
+
 static bool schema_list_table_attributes(PGSQL *pgsql, DatabaseCatalog *catalog);
 
 static void getSequenceArray(void *ctx, PGresult *result);
@@ -213,6 +336,15 @@ static bool parseCurrentSourceDepend(PGresult *result,
 									 int rowNumber,
 									 SourceDepend *depend);
 
+static void getFKeyArray(void *ctx, PGresult *result);
+
+static bool parseCurrentSourceFKey(PGresult *result,
+								   int rowNumber,
+								   SourceForeignKey *fkey);
+
+static void getTableStatsArray(void *ctx, PGresult *result);
+
+
 static void getTableChecksum(void *ctx, PGresult *result);
 
 
@@ -925,6 +1057,14 @@ schema_list_ordinary_tables(PGSQL *pgsql,
 		return false;
 	}
 
+	if (catalog != NULL &&
+		catalog->db != NULL &&
+		!catalog_prepare_s_table_copy_format(catalog))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
 	return true;
 }
 
@@ -1068,8 +1208,8 @@ schema_get_sequence_value(PGSQL *pgsql, SourceSequence *seq)
 
 
 /*
- * schema_list_relpages fetches the number of pages for the given table
- * and updates our internal catalog with that information.
+ * schema_list_relpages fetches the number of pages and rows for the given
+ * table and updates our internal catalog with the number of pages.
  */
 bool
 schema_list_relpages(PGSQL *pgsql, SourceTable *table, DatabaseCatalog *catalog)
@@ -1098,6 +1238,26 @@ schema_list_relpages(PGSQL *pgsql, SourceTable *table, DatabaseCatalog *catalog)
 
 	table->relpages = parseContext.intVal;
 
+	/* also refresh reltuples, used to estimate the rows in each part */
+	SingleValueResultContext tuplesContext = {
+		{ 0 }, PGSQL_RESULT_BIGINT, false
+	};
+
+	char *tuplesSql =
+		"select greatest(reltuples, 0)::bigint "
+		"  from pg_class where oid = $1::regclass";
+
+	if (!pgsql_execute_with_params(pgsql, tuplesSql,
+								   paramCount, paramTypes, paramValues,
+								   &tuplesContext, &parseSingleValueResult) ||
+		!tuplesContext.parsedOk)
+	{
+		log_error("Failed to get number of rows for table %s", table->qname);
+		return false;
+	}
+
+	table->reltuples = (int64_t) tuplesContext.bigint;
+
 	if (catalog != NULL && catalog->db != NULL)
 	{
 		if (!catalog_update_s_table_relpages(catalog, table))
@@ -1309,6 +1469,140 @@ schema_list_pg_depend(PGSQL *pgsql,
 }
 
 
+/*
+ * schema_list_fkeys grabs the list of foreign key constraints of the tables
+ * in our catalogs from the given source Postgres instance, and stores the
+ * result in the SQLite catalog.
+ *
+ * Uses list_source_fkeys.sql with one parameter:
+ *   $1::oid[] = table OIDs from s_table (NULL = no table filter)
+ */
+bool
+schema_list_fkeys(PGSQL *pgsql, DatabaseCatalog *catalog)
+{
+	SourceFKeyArrayContext context = { { 0 }, catalog, false };
+
+	log_trace("schema_list_fkeys");
+
+	char *table_oids = NULL;
+	int table_count = 0;
+
+	if (!catalog_s_table_oid_array(catalog, &table_oids, &table_count))
+	{
+		log_error("Failed to build table OID array for foreign keys query");
+		return false;
+	}
+
+	const char *sql = NULL;
+
+	if (!pgcopydb_sql_list_source_fkeys(&sql))
+	{
+		return false;
+	}
+
+	int paramCount = 1;
+	Oid paramTypes[1] = { TEXTOID };
+	const char *paramValues[1] = { table_oids };
+
+	if (!pgsql_execute_with_params(pgsql, sql,
+								   paramCount, paramTypes, paramValues,
+								   &context, &getFKeyArray))
+	{
+		log_error("Failed to list foreign keys");
+		return false;
+	}
+
+	if (!context.parsedOk)
+	{
+		log_error("Failed to list foreign keys");
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * schema_list_table_stats grabs the planner statistics of the tables in our
+ * catalogs from the given source Postgres instance, and stores the result in
+ * the SQLite catalog, so that the statistics can be imported on Postgres 18
+ * targets rather than running ANALYZE there.
+ *
+ * Uses list_source_table_stats.sql with one parameter:
+ *   $1::oid[] = table OIDs from s_table (NULL = no table filter)
+ */
+bool
+schema_list_table_stats(PGSQL *pgsql, DatabaseCatalog *catalog)
+{
+	SourceTableStatsArrayContext context = { { 0 }, catalog, false };
+
+	log_trace("schema_list_table_stats");
+
+	if (pgsql->pgversion_num == 0)
+	{
+		if (!pgsql_server_version(pgsql))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+	}
+
+	/* we need pg_statistic_ext to skip tables with extended statistics */
+	if (pgsql->pgversion_num < 100000)
+	{
+		log_debug("Skipping planner statistics export from Postgres %s",
+				  pgsql->pgversion);
+		return true;
+	}
+
+	char *table_oids = NULL;
+	int table_count = 0;
+
+	if (!catalog_s_table_oid_array(catalog, &table_oids, &table_count))
+	{
+		log_error("Failed to build table OID array for statistics query");
+		return false;
+	}
+
+	if (table_count == 0)
+	{
+		free(table_oids);
+		return true;
+	}
+
+	const char *sql = NULL;
+
+	if (!pgcopydb_sql_list_source_table_stats(&sql))
+	{
+		free(table_oids);
+		return false;
+	}
+
+	int paramCount = 1;
+	Oid paramTypes[1] = { TEXTOID };
+	const char *paramValues[1] = { table_oids };
+
+	if (!pgsql_execute_with_params(pgsql, sql,
+								   paramCount, paramTypes, paramValues,
+								   &context, &getTableStatsArray))
+	{
+		log_error("Failed to list table statistics");
+		free(table_oids);
+		return false;
+	}
+
+	free(table_oids);
+
+	if (!context.parsedOk)
+	{
+		log_error("Failed to list table statistics");
+		return false;
+	}
+
+	return true;
+}
+
+
 /*
  * schema_list_partitions prepares the list of partitions that we can drive from
  * our parameters: table size, --split-tables-larger-than, and
@@ -1335,6 +1629,16 @@ schema_list_partitions(PGSQL *pgsql,
 		return true;
 	}
 
+	/* unique keys other than a single integer column use typed ranges */
+	if (!IS_EMPTY_STRING_BUFFER(table->partKeyExpr))
+	{
+		return schema_list_key_partitions(pgsql,
+										  catalog,
+										  table,
+										  partSize,
+										  splitMaxParts);
+	}
+
 	/* if we have a partKey and it's not "ctid", calculate key bounds  */
 	if (!IS_EMPTY_STRING_BUFFER(table->partKey) && !streq(table->partKey, "ctid"))
 	{
@@ -1351,19 +1655,64 @@ schema_list_partitions(PGSQL *pgsql,
 	int64_t partsCount = 1;
 	int64_t partsSize = max - min + 1;
 
+	/* estimated rows per part are derived from reltuples */
+	double reltuples = table->reltuples > 0 ? (double) table->reltuples : 0.0;
+
+	/* integer keys split boundaries, when computed from the key distribution */
+	SourceTablePartKeyHistogramContext hist = { 0 };
+	int64_t *bounds = NULL;
+
+	/* ctid split boundaries, when computed from the live tuples density */
+	SourceTableCtidDensityContext density = { 0 };
+
 	/*
 	 * When the partition key is set to "ctid", it means that the table will be
 	 * partitioned based on the physical location of the rows in the table.
 	 *
-	 * The relpages value represents the total number of pages in the table,
-	 * which can be used as the maximum value for the partition range. By
-	 * setting min to 0 and max to table->relpages, we ensure that each
-	 * partition covers the entire range of pages in the table.
+	 * The current size of the table, in blocks, is used as the maximum value
+	 * for the partition range. pg_class.relpages is only updated by VACUUM
+	 * and ANALYZE, and when the table has grown since then the last part
+	 * would get all the extra blocks. By setting min to 0 and max to the
+	 * number of blocks, we ensure that each partition covers the entire range
+	 * of pages in the table.
 	 */
 	bool splitByCTID = streq(table->partKey, "ctid");
 
 	if (splitByCTID)
 	{
+		int64_t pages = 0;
+
+		if (!pgsql_get_relation_pages(pgsql, table->qname, &pages))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+
+		if (pages != table->relpages)
+		{
+			log_notice("Table %s has %lld blocks, pg_class.relpages is %lld",
+					   table->qname,
+					   (long long) pages,
+					   (long long) table->relpages);
+
+			/* scale the estimated rows the same way the planner does */
+			if (table->relpages > 0)
+			{
+				reltuples = reltuples * pages / (double) table->relpages;
+			}
+
+			table->relpages = pages;
+
+			if (catalog != NULL && catalog->db != NULL)
+			{
+				if (!catalog_update_s_table_relpages(catalog, table))
+				{
+					/* errors have already been logged */
+					return false;
+				}
+			}
+		}
+
 		min = 0;
 		max = table->relpages;
 
@@ -1388,6 +1737,50 @@ schema_list_partitions(PGSQL *pgsql,
 		}
 
 		partsSize = ceil((double) table->relpages / partsCount);
+
+		/*
+		 * Blocks hold very different amounts of live tuples when parts of the
+		 * table have been bulk deleted or updated, and then equal-width block
+		 * ranges take very different times to copy. Sample the table to see
+		 * where the live tuples are, and compute ranges that contain about
+		 * the same number of live tuples instead.
+		 */
+		if (partsCount > 1)
+		{
+			if (!getCtidDensity(pgsql, table, max, partsCount, &density))
+			{
+				/* errors have already been logged */
+				free(density.tuples);
+				return false;
+			}
+
+			if (density.sampled > 0)
+			{
+				reltuples = (double) density.rows;
+			}
+
+			if (schema_split_density_is_skewed(table, &density,
+											   partsCount, partsSize))
+			{
+				bounds = (int64_t *) calloc(partsCount + 1, sizeof(int64_t));
+
+				if (bounds == NULL)
+				{
+					log_error(ALLOCATION_FAILED_ERROR);
+					free(density.tuples);
+					return false;
+				}
+
+				if (!schema_split_by_density(table, &density, partsCount, bounds))
+				{
+					log_notice("Table %s split uses equal-width block ranges",
+							   table->qname);
+
+					free(bounds);
+					bounds = NULL;
+				}
+			}
+		}
 	}
 
 	/*
@@ -1420,6 +1813,52 @@ schema_list_partitions(PGSQL *pgsql,
 		}
 
 		partsSize = ceil((double) (max - min + 1) / partsCount);
+
+		/*
+		 * Key values are often sparse (sequence jumps, bulk deletes), and then
+		 * equal-width ranges contain very different amounts of rows. When we
+		 * know about the key distribution, compute ranges that contain about
+		 * the same number of rows instead.
+		 */
+		int64_t rangeCount = partsCount - 1;
+
+		if (rangeCount > 1)
+		{
+			if (!getPartKeyHistogram(pgsql, table, &hist))
+			{
+				/* errors have already been logged */
+				free(hist.bounds);
+				return false;
+			}
+
+			/* the table might have been analyzed since we listed it */
+			if (hist.count >= 2 && hist.rows > 0)
+			{
+				reltuples = (double) hist.rows;
+			}
+
+			if (schema_split_is_skewed(table, &hist, rangeCount, partsSize))
+			{
+				bounds = (int64_t *) calloc(rangeCount + 1, sizeof(int64_t));
+
+				if (bounds == NULL)
+				{
+					log_error(ALLOCATION_FAILED_ERROR);
+					free(hist.bounds);
+					return false;
+				}
+
+				if (!schema_split_by_histogram(table, &hist, rangeCount, bounds))
+				{
+					log_notice("Table %s split uses equal-width %s ranges",
+							   table->qname,
+							   table->partKey);
+
+					free(bounds);
+					bounds = NULL;
+				}
+			}
+		}
 	}
 
 	/*
@@ -1441,12 +1880,59 @@ schema_list_partitions(PGSQL *pgsql,
 			parts->min = -1;
 			parts->max = -1;
 			parts->count = -1;
+			parts->estRows = llround(reltuples * hist.nullFrac);
 		}
 		else if (splitByCTID)
 		{
-			parts->min = min + (i * partsSize);
-			parts->max = min + ((i + 1) * partsSize) - 1;
+			if (bounds != NULL)
+			{
+				/* ranges that hold about the same number of live tuples */
+				parts->min = bounds[i];
+				parts->max = bounds[i + 1] - 1;
+			}
+			else
+			{
+				parts->min = min + (i * partsSize);
+				parts->max = min + ((i + 1) * partsSize) - 1;
+			}
+
+			parts->count = parts->max - parts->min + 1;
+
+			/* the last part covers the remaining pages */
+			int64_t hi =
+				partNumber == partsCount ? max : parts->max + 1;
+
+			if (density.sampled > 0)
+			{
+				double fraction =
+					ctidDensityFraction(&density, hi) -
+					ctidDensityFraction(&density, parts->min);
+
+				parts->estRows = llround(reltuples * fraction);
+			}
+			else
+			{
+				int64_t pages = hi - parts->min;
+
+				parts->estRows =
+					table->relpages > 0 && pages > 0
+					? llround(reltuples * pages / table->relpages)
+					: 0;
+			}
+		}
+		else if (bounds != NULL)
+		{
+			/* ranges that hold about the same number of rows */
+			parts->min = bounds[i - 1];
+			parts->max = bounds[i] - 1;
 			parts->count = parts->max - parts->min + 1;
+
+			double fraction =
+				partKeyHistogramFraction(&hist, bounds[i]) -
+				partKeyHistogramFraction(&hist, bounds[i - 1]);
+
+			parts->estRows =
+				llround(reltuples * (1.0 - hist.nullFrac) * fraction);
 		}
 		else
 		{
@@ -1457,6 +1943,16 @@ schema_list_partitions(PGSQL *pgsql,
 			parts->min = min + ((i - 1) * partsSize);
 			parts->max = min + (i * partsSize) - 1;
 			parts->count = parts->max - parts->min + 1;
+
+			/* the last part covers the remaining key values */
+			int64_t width =
+				partNumber == partsCount ? max - parts->min + 1 : partsSize;
+
+			parts->estRows =
+				width > 0
+				? llround(reltuples * (1.0 - hist.nullFrac) *
+						  width / (double) (max - min + 1))
+				: 0;
 		}
 
 		/* the last partition has no upper bound */
@@ -1466,13 +1962,14 @@ schema_list_partitions(PGSQL *pgsql,
 			parts->count = -1;
 		}
 
-		log_debug("Partition %s #%d/%d: [%lld .. %lld] (%lld)",
+		log_debug("Partition %s #%d/%d: [%lld .. %lld] (%lld), ~%lld rows",
 				  table->qname,
 				  parts->partNumber,
 				  parts->partCount,
 				  (long long) parts->min,
 				  (long long) parts->max,
-				  (long long) parts->count);
+				  (long long) parts->count,
+				  (long long) parts->estRows);
 
 		if (catalog != NULL && catalog->db != NULL)
 		{
@@ -1483,875 +1980,1847 @@ schema_list_partitions(PGSQL *pgsql,
 		}
 	}
 
+	free(bounds);
+	free(hist.bounds);
+	free(density.tuples);
+
 	return true;
 }
 
 
 /*
- * schema_checksum_table runs a SQL query that computes the number of rows of a
- * table and also a checksum for all the rows contents.
+ * schema_list_split_key looks for a unique key of the given table that can be
+ * used to split the table in ranges of key values, when the table does not
+ * have a unique column of type integer. Any btree unique index on NOT NULL
+ * columns qualifies, which includes uuid, text and timestamp columns, and
+ * multi-column primary keys such as (tenant_id, id).
+ *
+ * When such a key is found, table->partKey is set to the list of the key
+ * columns, and table->partKeyExpr to an SQL expression that formats the key
+ * columns of a row as a list of typed SQL literals.
  */
 bool
-schema_send_table_checksum(PGSQL *pgsql, SourceTable *table)
+schema_list_split_key(PGSQL *pgsql, SourceTable *table)
 {
-	if (table->attributes.count == 0)
-	{
-		char sql[BUFSIZE] = { 0 };
+	char *sql =
+		"with idx as "
+		" ( "
+		"      select x.indrelid, x.indkey "
+		"        from pg_catalog.pg_index x "
+		"             join pg_catalog.pg_class i on i.oid = x.indexrelid "
+		"             join pg_catalog.pg_am am on am.oid = i.relam "
+		"       where x.indrelid = $1::regclass "
+		"         and (x.indisprimary or x.indisunique) "
+		"         and x.indisvalid "
+		"         and x.indpred is null "
+		"         and x.indexprs is null "
+		"         and am.amname = 'btree' "
+		"         and not exists "
+		"             ( "
+		"               select 1 "
+		"                 from pg_catalog.pg_attribute a "
+		"                where a.attrelid = x.indrelid "
+		"                  and a.attnum = any(x.indkey::int2[]) "
+		"                  and not a.attnotnull "
+		"             ) "
+		"    order by not x.indisprimary, x.indnatts, x.indexrelid "
+		"       limit 1 "
+		" ) "
+		"select string_agg(format('%I', a.attname), ', ' order by k.n), "
+		"       string_agg(format('format(%L, %I, pg_typeof(%I))', "
+		"                         '%L::%s', a.attname, a.attname), "
+		"                  ' || '', '' || ' order by k.n) "
+		"  from idx, "
+		"       unnest(idx.indkey::int2[]) with ordinality as k(attnum, n), "
+		"       pg_catalog.pg_attribute a "
+		" where a.attrelid = idx.indrelid "
+		"   and a.attnum = k.attnum";
 
-		sformat(sql, sizeof(sql),
-				"select count(1) as cnt, 0 as chksum from only %s",
-				table->qname);
+	int paramCount = 1;
+	Oid paramTypes[1] = { TEXTOID };
+	const char *paramValues[1] = { table->qname };
 
-		if (!pgsql_send_with_params(pgsql, sql, 0, NULL, NULL))
-		{
-			log_error("Failed to compute checksum for table %s", table->qname);
-			return false;
-		}
+	SourceTableSplitKeyContext context = { { 0 }, table, false, false };
 
-		return true;
+	if (!pgsql_execute_with_params(pgsql, sql,
+								   paramCount, paramTypes, paramValues,
+								   &context, &parseSplitKey))
+	{
+		log_error("Failed to list unique keys of table %s", table->qname);
+		return false;
 	}
 
-	/* first prepare the column list */
-	PQExpBuffer attrList = createPQExpBuffer();
-
-	appendPQExpBuffer(attrList, "(");
-
-	for (int c = 0; c < table->attributes.count; c++)
+	if (!context.parsedOk)
 	{
-		char *srcAttName = table->attributes.array[c].attname;
-
-		appendPQExpBuffer(attrList, "%s%s",
-						  c > 0 ? ", " : "",
-						  srcAttName);
+		log_error("Failed to parse unique keys of table %s", table->qname);
+		return false;
 	}
 
-	appendPQExpBuffer(attrList, ")");
-
-	if (PQExpBufferBroken(attrList))
+	if (context.found)
 	{
-		(void) destroyPQExpBuffer(attrList);
-		log_error("Failed to build attribute list: Out of Memory");
-		return false;
+		log_debug("Table %s can be split on its unique key (%s)",
+				  table->qname,
+				  table->partKey);
 	}
 
-	/* now prepare the actual query */
-	PQExpBuffer sql = createPQExpBuffer();
+	return true;
+}
 
-	/*
-	 * Compute the hashtext of every single row in the table, and aggregate the
-	 * results as a sum of bigint numbers. Because the sum of bigint could
-	 * overflow to numeric, the aggregated sum is then hashed with SHA256.
-	 *
-	 * Also, to lower the chances of a collision, include the row count in the
-	 * computation of the hash by appending it to the input string.
-	 *
-	 * SHA256 is used instead of MD5 so that the query works on FIPS-compliant
-	 * systems (e.g. Azure Database for PostgreSQL) where md5() is disabled.
-	 * sha256() has been built into PostgreSQL since version 11.
-	 */
-	appendPQExpBuffer(sql,
-					  "select count(1) as cnt, "
-					  "encode(sha256(format('%%s-%%s', "
-					  "      sum(hashtext(%s::text)::bigint),"
-					  "      count(1))::bytea), 'hex') as chksum "
-					  "from only %s",
-					  attrList->data,
-					  table->qname);
 
-	(void) destroyPQExpBuffer(attrList);
+/*
+ * parseSplitKey parses the result of the schema_list_split_key query, which
+ * is a single row with NULL values when the table has no suitable key.
+ */
+static void
+parseSplitKey(void *ctx, PGresult *result)
+{
+	SourceTableSplitKeyContext *context = (SourceTableSplitKeyContext *) ctx;
+	SourceTable *table = context->table;
 
-	if (PQExpBufferBroken(sql))
+	if (PQnfields(result) != 2)
 	{
-		(void) destroyPQExpBuffer(sql);
-		log_error("Failed to build attribute list: Out of Memory");
-		return false;
+		log_error("Query returned %d columns, expected 2", PQnfields(result));
+		context->parsedOk = false;
+		return;
 	}
 
-	if (!pgsql_send_with_params(pgsql, sql->data, 0, NULL, NULL))
+	context->parsedOk = true;
+
+	if (PQntuples(result) != 1 ||
+		PQgetisnull(result, 0, 0) ||
+		PQgetisnull(result, 0, 1))
 	{
-		log_error("Failed to compute checksum for table %s", table->qname);
-		(void) destroyPQExpBuffer(sql);
-		return false;
+		return;
 	}
 
-	(void) destroyPQExpBuffer(sql);
+	char *partKey = PQgetvalue(result, 0, 0);
+	char *partKeyExpr = PQgetvalue(result, 0, 1);
 
-	return true;
+	if (strlen(partKey) >= sizeof(table->partKey) ||
+		strlen(partKeyExpr) >= sizeof(table->partKeyExpr))
+	{
+		log_debug("Table %s unique key (%s) is too large to split on",
+				  table->qname,
+				  partKey);
+		return;
+	}
+
+	strlcpy(table->partKey, partKey, sizeof(table->partKey));
+	strlcpy(table->partKeyExpr, partKeyExpr, sizeof(table->partKeyExpr));
+
+	context->found = true;
 }
 
 
 /*
- * schema_fetch_table_checksum fetches the results from the
- * schema_send_table_checksum async query.
+ * schema_list_key_partitions prepares the list of partitions of a table that
+ * is split on a unique key other than a single integer column. Range
+ * boundaries are the quantiles of the key values found in a sample of the
+ * table, so that each part holds about the same number of rows.
+ *
+ * The parts are (partKey) < (b1), then (partKey) >= (b1) and (partKey) < (b2),
+ * etc, and the last part is (partKey) >= (bn). Row-wise comparisons allow the
+ * COPY queries to use range scans on the unique key index.
  */
-bool
-schema_fetch_table_checksum(PGSQL *pgsql, TableChecksum *sum, bool *done)
+static bool
+schema_list_key_partitions(PGSQL *pgsql,
+						   DatabaseCatalog *catalog,
+						   SourceTable *table,
+						   uint64_t partSize,
+						   int splitMaxParts)
 {
-	ChecksumContext parseContext = { { 0 }, sum, false };
+	int64_t partsCount = ceil((double) table->bytes / (double) partSize);
 
-	if (!pgsql_fetch_results(pgsql, done, &parseContext, &getTableChecksum))
+	if (splitMaxParts > 0 && partsCount > splitMaxParts)
 	{
-		log_error("Failed to fetch table checksum results");
-		return false;
+		partsCount = splitMaxParts;
 	}
 
-	return true;
-}
-
+	if (partsCount < 2)
+	{
+		table->partition.partCount = 0;
+		return true;
+	}
 
-/*
- * getSchemaList loops over the SQL result for the schema array query and
- * allocates an array of schemas then populates it with the query result.
- */
-static void
-getSchemaList(void *ctx, PGresult *result)
-{
-	SourceSchemaArrayContext *context = (SourceSchemaArrayContext *) ctx;
-	int nTuples = PQntuples(result);
+	SourceTableKeyBoundsContext context = { 0 };
 
-	if (PQnfields(result) != 3)
+	if (!getPartKeyBounds(pgsql, table, partsCount, &context))
 	{
-		log_error("Query returned %d columns, expected 3", PQnfields(result));
-		context->parsedOk = false;
-		return;
+		/* errors have already been logged */
+		freePartKeyBounds(&context);
+		return false;
 	}
 
-	int errors = 0;
+	/* the sample might have fewer rows than the parts we want */
+	partsCount = context.count + 1;
 
-	for (int rowNumber = 0; rowNumber < nTuples; rowNumber++)
+	if (partsCount < 2)
 	{
-		SourceSchema *schema = (SourceSchema *) calloc(1, sizeof(SourceSchema));
+		log_notice("Table %s sample is too small to split on (%s)",
+				   table->qname,
+				   table->partKey);
 
-		if (schema == NULL)
+		freePartKeyBounds(&context);
+		table->partition.partCount = 0;
+		return true;
+	}
+
+	for (int i = 0; i < context.count; i++)
+	{
+		if (strlen(context.bounds[i]) >= sizeof(table->partition.minKey))
 		{
-			++errors;
-			log_error(ALLOCATION_FAILED_ERROR);
-			break;
+			log_notice("Table %s key values are too large to split on (%s)",
+					   table->qname,
+					   table->partKey);
+
+			freePartKeyBounds(&context);
+			table->partition.partCount = 0;
+			return true;
 		}
+	}
 
-		/* 1. oid */
-		char *value = PQgetvalue(result, rowNumber, 0);
+	double rows =
+		table->reltuples > 0 ? (double) table->reltuples : (double) context.rows;
 
-		if (!stringToUInt32(value, &(schema->oid)) || schema->oid == 0)
+	/*
+	 * The table listing query only considers unique integer columns, so the
+	 * partition key has to be registered in our catalogs for the COPY
+	 * processes to find it.
+	 */
+	if (catalog != NULL && catalog->db != NULL)
+	{
+		if (!catalog_update_s_table_part_key(catalog, table))
 		{
-			log_error("Invalid OID \"%s\"", value);
-			++errors;
+			/* errors have already been logged */
+			freePartKeyBounds(&context);
+			return false;
 		}
+	}
 
-		/* 2. nspname */
-		value = PQgetvalue(result, rowNumber, 1);
-		int length = strlcpy(schema->nspname, value, PG_NAMEDATALEN);
+	for (int64_t i = 0; i < partsCount; i++)
+	{
+		SourceTableParts *parts = &(table->partition);
 
-		if (length >= PG_NAMEDATALEN)
+		bzero(parts, sizeof(SourceTableParts));
+
+		parts->partNumber = i + 1;
+		parts->partCount = partsCount;
+		parts->typed = true;
+
+		if (i > 0)
 		{
-			log_error("Schema name \"%s\" is %d bytes long, "
-					  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
-					  value, length, PG_NAMEDATALEN - 1);
-			++errors;
+			strlcpy(parts->minKey, context.bounds[i - 1], sizeof(parts->minKey));
 		}
 
-		/* 3. restoreListName */
-		value = PQgetvalue(result, rowNumber, 2);
-		length = strlcpy(schema->restoreListName, value, RESTORE_LIST_NAMEDATALEN);
-
-		if (length >= RESTORE_LIST_NAMEDATALEN)
+		if (i < partsCount - 1)
 		{
-			log_error("Schema restore list name \"%s\" is %d bytes long, "
-					  "the maximum expected is %d (RESTORE_LIST_NAMEDATALEN - 1)",
-					  value, length, RESTORE_LIST_NAMEDATALEN - 1);
-			++errors;
+			strlcpy(parts->maxKey, context.bounds[i], sizeof(parts->maxKey));
 		}
 
-		log_trace("getSchemaList: %u \"%s\" %s",
-				  schema->oid,
-				  schema->nspname,
-				  schema->restoreListName);
+		parts->estRows = llround(rows / partsCount);
 
-		if (context->catalog != NULL && context->catalog->db != NULL)
+		log_debug("Partition %s #%d/%d: [%s .. %s), ~%lld rows",
+				  table->qname,
+				  parts->partNumber,
+				  parts->partCount,
+				  parts->minKey,
+				  parts->maxKey,
+				  (long long) parts->estRows);
+
+		if (catalog != NULL && catalog->db != NULL)
 		{
-			if (!catalog_add_s_namespace(context->catalog, schema))
+			if (!catalog_add_s_table_part(catalog, table))
 			{
 				/* errors have already been logged */
-				++errors;
-				break;
 			}
 		}
 	}
 
-	context->parsedOk = errors == 0;
+	freePartKeyBounds(&context);
+
+	return true;
 }
 
 
 /*
- * getRoleList loops over the SQL result for the role array query and
- * allocates an array of roles then populates it with the query result.
+ * schema_split_is_skewed returns true when the equal-width partition key
+ * ranges would give one of the parts more than SPLIT_SKEW_THRESHOLD times its
+ * share of the rows, given the key distribution.
  */
-static void
-getRoleList(void *ctx, PGresult *result)
+static bool
+schema_split_is_skewed(SourceTable *table,
+					   SourceTablePartKeyHistogramContext *hist,
+					   int64_t rangeCount,
+					   int64_t rangeSize)
 {
-	SourceRoleArrayContext *context = (SourceRoleArrayContext *) ctx;
-	int nTuples = PQntuples(result);
-
-	if (PQnfields(result) != 2)
+	if (hist->count < 2)
 	{
-		log_error("Query returned %d columns, expected 2", PQnfields(result));
-		context->parsedOk = false;
-		return;
+		return false;
 	}
 
-	int errors = 0;
-
-	for (int rowNumber = 0; rowNumber < nTuples; rowNumber++)
+	for (int64_t i = 1; i <= rangeCount; i++)
 	{
-		SourceRole *role = (SourceRole *) calloc(1, sizeof(SourceRole));
+		int64_t lo = table->partmin + ((i - 1) * rangeSize);
+		int64_t hi =
+			i == rangeCount
+			? table->partmax + 1
+			: table->partmin + (i * rangeSize);
 
-		if (role == NULL)
+		double fraction =
+			partKeyHistogramFraction(hist, hi) -
+			partKeyHistogramFraction(hist, lo);
+
+		if (fraction * rangeCount > SPLIT_SKEW_THRESHOLD)
 		{
-			++errors;
-			log_error(ALLOCATION_FAILED_ERROR);
-			break;
+			log_notice("Table %s key range [%lld .. %lld] holds %.0f%% of "
+					   "the rows, splitting %s using its distribution",
+					   table->qname,
+					   (long long) lo,
+					   (long long) hi - 1,
+					   fraction * 100.0,
+					   table->partKey);
+			return true;
 		}
+	}
 
-		/* 1. oid */
-		char *value = PQgetvalue(result, rowNumber, 0);
+	return false;
+}
 
-		if (!stringToUInt32(value, &(role->oid)) || role->oid == 0)
+
+/*
+ * schema_split_by_histogram computes rangeCount + 1 boundaries for the
+ * partition key ranges of a table, so that each range contains about the same
+ * number of rows, given the key distribution. Range i is then [ bounds[i-1],
+ * bounds[i] ). Returns false when the distribution is unknown or does not
+ * allow for rangeCount non-empty ranges.
+ */
+static bool
+schema_split_by_histogram(SourceTable *table,
+						  SourceTablePartKeyHistogramContext *hist,
+						  int64_t rangeCount,
+						  int64_t *bounds)
+{
+	if (hist->count < 2)
+	{
+		return false;
+	}
+
+	bounds[0] = table->partmin;
+	bounds[rangeCount] = table->partmax + 1;
+
+	int buckets = hist->count - 1;
+
+	for (int64_t k = 1; k < rangeCount; k++)
+	{
+		/* interpolate the k-th quantile within its histogram bucket */
+		double pos = (double) k * buckets / rangeCount;
+		int idx = (int) floor(pos);
+
+		if (idx >= buckets)
 		{
-			log_error("Invalid OID \"%s\"", value);
-			++errors;
+			idx = buckets - 1;
 		}
 
-		/* 2. rolname */
-		value = PQgetvalue(result, rowNumber, 1);
-		int length = strlcpy(role->rolname, value, PG_NAMEDATALEN);
+		int64_t lo = hist->bounds[idx];
+		int64_t hi = hist->bounds[idx + 1];
+		int64_t bound = lo + llround((pos - idx) * (double) (hi - lo));
 
-		if (length >= PG_NAMEDATALEN)
+		/* ranges must not be empty, and must stay within [min .. max] */
+		if (bound <= bounds[k - 1])
 		{
-			log_error("Role name \"%s\" is %d bytes long, "
-					  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
-					  value, length, PG_NAMEDATALEN - 1);
-			++errors;
+			bound = bounds[k - 1] + 1;
 		}
 
-		log_trace("getRoleList: %u %s", role->oid, role->rolname);
-
-		if (context->catalog != NULL && context->catalog->db != NULL)
+		if (bound > bounds[rangeCount] - (rangeCount - k))
 		{
-			if (!catalog_add_s_role(context->catalog, role))
-			{
-				/* errors have already been logged */
-				++errors;
-				break;
-			}
+			return false;
 		}
+
+		bounds[k] = bound;
 	}
 
-	context->parsedOk = errors == 0;
+	return true;
 }
 
 
 /*
- * getDatabaseList loops over the SQL result for the database array query and
- * allocates an array of databases then populates it with the query result.
+ * schema_split_density_is_skewed returns true when the equal-width block
+ * ranges would give one of the parts more than SPLIT_SKEW_THRESHOLD times its
+ * share of the live tuples, given the sampled density.
  */
-static void
-getDatabaseList(void *ctx, PGresult *result)
+static bool
+schema_split_density_is_skewed(SourceTable *table,
+							   SourceTableCtidDensityContext *density,
+							   int64_t partsCount,
+							   int64_t partsSize)
 {
-	SourceDatabaseArrayContext *context = (SourceDatabaseArrayContext *) ctx;
-	int nTuples = PQntuples(result);
-
-	if (PQnfields(result) != 4)
+	if (density->sampled == 0)
 	{
-		log_error("Query returned %d columns, expected 4", PQnfields(result));
-		context->parsedOk = false;
-		return;
+		return false;
 	}
 
-	bool parsedOk = true;
-
-	for (int rowNumber = 0; rowNumber < nTuples; rowNumber++)
+	for (int64_t i = 0; i < partsCount; i++)
 	{
-		SourceDatabase *database =
-			(SourceDatabase *) calloc(1, sizeof(SourceDatabase));
+		int64_t lo = i * partsSize;
+		int64_t hi = i == partsCount - 1 ? density->pages : (i + 1) * partsSize;
 
-		if (!parseCurrentDatabase(result, rowNumber, database))
-		{
-			parsedOk = false;
-			break;
-		}
+		double fraction =
+			ctidDensityFraction(density, hi) -
+			ctidDensityFraction(density, lo);
 
-		if (context->catalog != NULL && context->catalog->db != NULL)
+		if (fraction * partsCount > SPLIT_SKEW_THRESHOLD)
 		{
-			if (!catalog_add_s_database(context->catalog, database))
-			{
-				/* errors have already been logged */
-				parsedOk = false;
-				break;
-			}
+			log_notice("Table %s blocks [%lld .. %lld] hold %.0f%% of the "
+					   "live tuples, splitting using their density",
+					   table->qname,
+					   (long long) lo,
+					   (long long) hi - 1,
+					   fraction * 100.0);
+			return true;
 		}
 	}
 
-	context->parsedOk = parsedOk;
+	return false;
 }
 
 
 /*
- * parseCurrentDatabase parses a single row of the database listing query
- * result.
+ * schema_split_by_density computes partsCount + 1 block boundaries for the
+ * ctid ranges of a table, so that each range contains about the same number
+ * of live tuples, given the sampled density. Range i is then [ bounds[i],
+ * bounds[i+1] ). Returns false when the density does not allow for
+ * partsCount non-empty ranges.
  */
 static bool
-parseCurrentDatabase(PGresult *result, int rowNumber, SourceDatabase *database)
+schema_split_by_density(SourceTable *table,
+						SourceTableCtidDensityContext *density,
+						int64_t partsCount,
+						int64_t *bounds)
 {
-	int errors = 0;
-
-	/* 1. oid */
-	char *value = PQgetvalue(result, rowNumber, 0);
-
-	if (!stringToUInt32(value, &(database->oid)) || database->oid == 0)
+	if (density->sampled == 0)
 	{
-		log_error("Invalid OID \"%s\"", value);
-		++errors;
+		return false;
 	}
 
-	/* 2. datname */
-	value = PQgetvalue(result, rowNumber, 1);
-	int length = strlcpy(database->datname, value, PG_NAMEDATALEN);
+	bounds[0] = 0;
+	bounds[partsCount] = density->pages;
 
-	if (length >= PG_NAMEDATALEN)
-	{
-		log_error("Database name \"%s\" is %d bytes long, "
-				  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
-				  value, length, PG_NAMEDATALEN - 1);
-		++errors;
-	}
+	int64_t cumulated = 0;
+	int bucket = 0;
 
-	/* 3. bytes */
-	value = PQgetvalue(result, rowNumber, 2);
-	if (PQgetisnull(result, rowNumber, 2))
-	{
-		/*
-		 * It may happen that pg_table_size() returns NULL (when failing to
-		 * open the given relation).
-		 */
-		database->bytes = 0;
-	}
-	else
+	for (int64_t k = 1; k < partsCount; k++)
 	{
-		value = PQgetvalue(result, rowNumber, 2);
+		double target = (double) density->sampled * k / partsCount;
 
-		if (!stringToInt64(value, &(database->bytes)))
+		while (bucket < density->count &&
+			   cumulated + density->tuples[bucket] < target)
 		{
-			log_error("Invalid pg_database_size: \"%s\"", value);
-			++errors;
+			cumulated += density->tuples[bucket++];
 		}
-	}
 
-	/* 4. pg_size_pretty */
-	value = PQgetvalue(result, rowNumber, 3);
-	length = strlcpy(database->bytesPretty, value, PG_NAMEDATALEN);
+		int64_t bound = density->pages;
 
-	if (length >= PG_NAMEDATALEN)
-	{
-		log_error("Pretty printed byte size \"%s\" is %d bytes long, "
-				  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
-				  value, length, PG_NAMEDATALEN - 1);
-		++errors;
+		if (bucket < density->count)
+		{
+			/* interpolate within the bucket that reaches the target */
+			int64_t tuples = density->tuples[bucket];
+			double frac = tuples > 0 ? (target - cumulated) / tuples : 0.0;
+
+			bound =
+				bucket * density->bucketPages +
+				llround(frac * density->bucketPages);
+		}
+
+		/* ranges must not be empty, and must stay within the table */
+		if (bound <= bounds[k - 1])
+		{
+			bound = bounds[k - 1] + 1;
+		}
+
+		if (bound > bounds[partsCount] - (partsCount - k))
+		{
+			return false;
+		}
+
+		bounds[k] = bound;
 	}
 
-	return errors == 0;
+	return true;
 }
 
 
 /*
- * getDatabaseList loops over the SQL result for the database properties array
- * query and allocates an array of GUC settings then populates it with the
- * query result.
+ * ctidDensityFraction returns the fraction of the sampled live tuples that
+ * are found in blocks lower than the given block number, using linear
+ * interpolation within the density buckets.
  */
-static void
-getDatabaseProperties(void *ctx, PGresult *result)
+static double
+ctidDensityFraction(SourceTableCtidDensityContext *density, int64_t page)
 {
-	SourcePropertiesArrayContext *context = (SourcePropertiesArrayContext *) ctx;
-	int nTuples = PQntuples(result);
+	if (density->sampled == 0 || page <= 0)
+	{
+		return 0.0;
+	}
 
-	if (PQnfields(result) != 3)
+	if (page >= density->pages)
 	{
-		log_error("Query returned %d columns, expected 3", PQnfields(result));
-		context->parsedOk = false;
-		return;
+		return 1.0;
 	}
 
-	bool parsedOk = true;
+	int64_t cumulated = 0;
+	int bucket = page / density->bucketPages;
 
-	for (int rowNumber = 0; rowNumber < nTuples; rowNumber++)
+	for (int i = 0; i < bucket && i < density->count; i++)
 	{
-		SourceProperty *property =
-			(SourceProperty *) calloc(1, sizeof(SourceProperty));
+		cumulated += density->tuples[i];
+	}
 
-		if (!parseDatabaseProperty(result, rowNumber, property))
-		{
-			parsedOk = false;
-			break;
-		}
+	double within = 0.0;
 
-		if (context->catalog != NULL && context->catalog->db != NULL)
-		{
-			if (!catalog_add_s_database_properties(context->catalog, property))
-			{
-				/* errors have already been logged */
-				parsedOk = false;
-				break;
-			}
-		}
+	if (bucket < density->count)
+	{
+		int64_t offset = page - bucket * density->bucketPages;
+
+		within =
+			(double) density->tuples[bucket] * offset / density->bucketPages;
 	}
 
-	context->parsedOk = parsedOk;
+	return (cumulated + within) / density->sampled;
 }
 
 
 /*
- * parseCurrentProperty parses a single row of the database properties listing
- * query result.
+ * partKeyHistogramFraction returns the fraction of the non-null partition key
+ * values that are lower than the given value, using linear interpolation
+ * within the histogram buckets.
  */
-static bool
-parseDatabaseProperty(PGresult *result, int rowNumber, SourceProperty *property)
+static double
+partKeyHistogramFraction(SourceTablePartKeyHistogramContext *hist,
+						 int64_t value)
 {
-	int errors = 0;
+	int buckets = hist->count - 1;
 
-	/* 1. datname */
-	if (PQgetisnull(result, rowNumber, 0))
-	{
-		log_error("BUG: parseDatabaseProperty: datname is NULL");
-		++errors;
-	}
-	else
+	if (buckets < 1 || value <= hist->bounds[0])
 	{
-		char *value = PQgetvalue(result, rowNumber, 0);
-		int length = strlcpy(property->datname, value, PG_NAMEDATALEN);
-
-		if (length >= PG_NAMEDATALEN)
-		{
-			log_error("Properties role name \"%s\" is %d bytes long, "
-					  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
-					  value, length, PG_NAMEDATALEN - 1);
-			++errors;
-		}
+		return 0.0;
 	}
 
-	/* 2. rolname */
-	if (PQgetisnull(result, rowNumber, 1))
+	if (value > hist->bounds[buckets])
 	{
-		property->roleInDatabase = false;
+		return 1.0;
 	}
-	else
-	{
-		property->roleInDatabase = true;
 
-		char *value = PQgetvalue(result, rowNumber, 1);
-		int length = strlcpy(property->rolname, value, PG_NAMEDATALEN);
+	for (int i = 0; i < buckets; i++)
+	{
+		int64_t lo = hist->bounds[i];
+		int64_t hi = hist->bounds[i + 1];
 
-		if (length >= PG_NAMEDATALEN)
+		if (value <= hi)
 		{
-			log_error("Properties role name \"%s\" is %d bytes long, "
-					  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
-					  value, length, PG_NAMEDATALEN - 1);
-			++errors;
+			double frac =
+				hi > lo ? (double) (value - lo) / (double) (hi - lo) : 1.0;
+
+			return (i + frac) / buckets;
 		}
 	}
 
-	/* 3. setconfig */
-	if (PQgetisnull(result, rowNumber, 2))
-	{
-		log_error("BUG: parseDatabaseProperty: setconfig is NULL");
-		++errors;
-	}
-	else
+	return 1.0;
+}
+
+
+/*
+ * schema_checksum_table runs a SQL query that computes the number of rows of a
+ * table and also a checksum for all the rows contents.
+ */
+bool
+schema_send_table_checksum(PGSQL *pgsql, SourceTable *table)
+{
+	if (table->attributes.count == 0)
 	{
-		char *value = PQgetvalue(result, rowNumber, 2);
-		int len = strlen(value);
-		int bytes = len + 1;
+		char sql[BUFSIZE] = { 0 };
 
-		property->setconfig = (char *) calloc(bytes, sizeof(char));
+		sformat(sql, sizeof(sql),
+				"select count(1) as cnt, 0 as chksum from only %s",
+				table->qname);
 
-		if (property->setconfig == NULL)
+		if (!pgsql_send_with_params(pgsql, sql, 0, NULL, NULL))
 		{
-			log_fatal(ALLOCATION_FAILED_ERROR);
+			log_error("Failed to compute checksum for table %s", table->qname);
 			return false;
 		}
 
-		strlcpy(property->setconfig, value, bytes);
+		return true;
 	}
 
-	return errors == 0;
-}
-
+	/* first prepare the column list */
+	PQExpBuffer attrList = createPQExpBuffer();
 
-/*
- * getExtensionList loops over the SQL result for the extension array query and
- * allocates an array of extensions then populates it with the query result.
- */
-static void
-getExtensionList(void *ctx, PGresult *result)
-{
-	SourceExtensionArrayContext *context = (SourceExtensionArrayContext *) ctx;
-	int nTuples = PQntuples(result);
+	appendPQExpBuffer(attrList, "(");
 
-	if (PQnfields(result) != 11)
+	for (int c = 0; c < table->attributes.count; c++)
 	{
-		log_error("Query returned %d columns, expected 11", PQnfields(result));
-		context->parsedOk = false;
-		return;
-	}
+		char *srcAttName = table->attributes.array[c].attname;
 
-	bool parsedOk = true;
+		appendPQExpBuffer(attrList, "%s%s",
+						  c > 0 ? ", " : "",
+						  srcAttName);
+	}
 
-	SourceExtension *extension =
-		(SourceExtension *) calloc(1, sizeof(SourceExtension));
+	appendPQExpBuffer(attrList, ")");
 
-	if (extension == NULL)
+	if (PQExpBufferBroken(attrList))
 	{
-		log_error(ALLOCATION_FAILED_ERROR);
-		parsedOk = false;
-		return;
+		(void) destroyPQExpBuffer(attrList);
+		log_error("Failed to build attribute list: Out of Memory");
+		return false;
 	}
 
-	for (int rowNumber = 0; rowNumber < nTuples; rowNumber++)
-	{
-		int confIndex = 0;
+	/* now prepare the actual query */
+	PQExpBuffer sql = createPQExpBuffer();
 
-		(void) bzero(extension, sizeof(SourceExtension));
+	/*
+	 * Compute the hashtext of every single row in the table, and aggregate the
+	 * results as a sum of bigint numbers. Because the sum of bigint could
+	 * overflow to numeric, the aggregated sum is then hashed with SHA256.
+	 *
+	 * Also, to lower the chances of a collision, include the row count in the
+	 * computation of the hash by appending it to the input string.
+	 *
+	 * SHA256 is used instead of MD5 so that the query works on FIPS-compliant
+	 * systems (e.g. Azure Database for PostgreSQL) where md5() is disabled.
+	 * sha256() has been built into PostgreSQL since version 11.
+	 */
+	appendPQExpBuffer(sql,
+					  "select count(1) as cnt, "
+					  "encode(sha256(format('%%s-%%s', "
+					  "      sum(hashtext(%s::text)::bigint),"
+					  "      count(1))::bytea), 'hex') as chksum "
+					  "from only %s",
+					  attrList->data,
+					  table->qname);
 
-		if (!parseCurrentExtension(result, rowNumber, extension, &confIndex))
-		{
-			parsedOk = false;
-			break;
-		}
+	(void) destroyPQExpBuffer(attrList);
 
-		log_trace("getExtensionList: %s [%d/%d]",
-				  extension->extname,
+	if (PQExpBufferBroken(sql))
+	{
+		(void) destroyPQExpBuffer(sql);
+		log_error("Failed to build attribute list: Out of Memory");
+		return false;
+	}
+
+	if (!pgsql_send_with_params(pgsql, sql->data, 0, NULL, NULL))
+	{
+		log_error("Failed to compute checksum for table %s", table->qname);
+		(void) destroyPQExpBuffer(sql);
+		return false;
+	}
+
+	(void) destroyPQExpBuffer(sql);
+
+	return true;
+}
+
+
+/*
+ * schema_fetch_table_checksum fetches the results from the
+ * schema_send_table_checksum async query.
+ */
+bool
+schema_fetch_table_checksum(PGSQL *pgsql, TableChecksum *sum, bool *done)
+{
+	ChecksumContext parseContext = { { 0 }, sum, false };
+
+	if (!pgsql_fetch_results(pgsql, done, &parseContext, &getTableChecksum))
+	{
+		log_error("Failed to fetch table checksum results");
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * getSchemaList loops over the SQL result for the schema array query and
+ * allocates an array of schemas then populates it with the query result.
+ */
+static void
+getSchemaList(void *ctx, PGresult *result)
+{
+	SourceSchemaArrayContext *context = (SourceSchemaArrayContext *) ctx;
+	int nTuples = PQntuples(result);
+
+	if (PQnfields(result) != 3)
+	{
+		log_error("Query returned %d columns, expected 3", PQnfields(result));
+		context->parsedOk = false;
+		return;
+	}
+
+	int errors = 0;
+
+	for (int rowNumber = 0; rowNumber < nTuples; rowNumber++)
+	{
+		SourceSchema *schema = (SourceSchema *) calloc(1, sizeof(SourceSchema));
+
+		if (schema == NULL)
+		{
+			++errors;
+			log_error(ALLOCATION_FAILED_ERROR);
+			break;
+		}
+
+		/* 1. oid */
+		char *value = PQgetvalue(result, rowNumber, 0);
+
+		if (!stringToUInt32(value, &(schema->oid)) || schema->oid == 0)
+		{
+			log_error("Invalid OID \"%s\"", value);
+			++errors;
+		}
+
+		/* 2. nspname */
+		value = PQgetvalue(result, rowNumber, 1);
+		int length = strlcpy(schema->nspname, value, PG_NAMEDATALEN);
+
+		if (length >= PG_NAMEDATALEN)
+		{
+			log_error("Schema name \"%s\" is %d bytes long, "
+					  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
+					  value, length, PG_NAMEDATALEN - 1);
+			++errors;
+		}
+
+		/* 3. restoreListName */
+		value = PQgetvalue(result, rowNumber, 2);
+		length = strlcpy(schema->restoreListName, value, RESTORE_LIST_NAMEDATALEN);
+
+		if (length >= RESTORE_LIST_NAMEDATALEN)
+		{
+			log_error("Schema restore list name \"%s\" is %d bytes long, "
+					  "the maximum expected is %d (RESTORE_LIST_NAMEDATALEN - 1)",
+					  value, length, RESTORE_LIST_NAMEDATALEN - 1);
+			++errors;
+		}
+
+		log_trace("getSchemaList: %u \"%s\" %s",
+				  schema->oid,
+				  schema->nspname,
+				  schema->restoreListName);
+
+		if (context->catalog != NULL && context->catalog->db != NULL)
+		{
+			if (!catalog_add_s_namespace(context->catalog, schema))
+			{
+				/* errors have already been logged */
+				++errors;
+				break;
+			}
+		}
+	}
+
+	context->parsedOk = errors == 0;
+}
+
+
+/*
+ * getRoleList loops over the SQL result for the role array query and
+ * allocates an array of roles then populates it with the query result.
+ */
+static void
+getRoleList(void *ctx, PGresult *result)
+{
+	SourceRoleArrayContext *context = (SourceRoleArrayContext *) ctx;
+	int nTuples = PQntuples(result);
+
+	if (PQnfields(result) != 2)
+	{
+		log_error("Query returned %d columns, expected 2", PQnfields(result));
+		context->parsedOk = false;
+		return;
+	}
+
+	int errors = 0;
+
+	for (int rowNumber = 0; rowNumber < nTuples; rowNumber++)
+	{
+		SourceRole *role = (SourceRole *) calloc(1, sizeof(SourceRole));
+
+		if (role == NULL)
+		{
+			++errors;
+			log_error(ALLOCATION_FAILED_ERROR);
+			break;
+		}
+
+		/* 1. oid */
+		char *value = PQgetvalue(result, rowNumber, 0);
+
+		if (!stringToUInt32(value, &(role->oid)) || role->oid == 0)
+		{
+			log_error("Invalid OID \"%s\"", value);
+			++errors;
+		}
+
+		/* 2. rolname */
+		value = PQgetvalue(result, rowNumber, 1);
+		int length = strlcpy(role->rolname, value, PG_NAMEDATALEN);
+
+		if (length >= PG_NAMEDATALEN)
+		{
+			log_error("Role name \"%s\" is %d bytes long, "
+					  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
+					  value, length, PG_NAMEDATALEN - 1);
+			++errors;
+		}
+
+		log_trace("getRoleList: %u %s", role->oid, role->rolname);
+
+		if (context->catalog != NULL && context->catalog->db != NULL)
+		{
+			if (!catalog_add_s_role(context->catalog, role))
+			{
+				/* errors have already been logged */
+				++errors;
+				break;
+			}
+		}
+	}
+
+	context->parsedOk = errors == 0;
+}
+
+
+/*
+ * getDatabaseList loops over the SQL result for the database array query and
+ * allocates an array of databases then populates it with the query result.
+ */
+static void
+getDatabaseList(void *ctx, PGresult *result)
+{
+	SourceDatabaseArrayContext *context = (SourceDatabaseArrayContext *) ctx;
+	int nTuples = PQntuples(result);
+
+	if (PQnfields(result) != 4)
+	{
+		log_error("Query returned %d columns, expected 4", PQnfields(result));
+		context->parsedOk = false;
+		return;
+	}
+
+	bool parsedOk = true;
+
+	for (int rowNumber = 0; rowNumber < nTuples; rowNumber++)
+	{
+		SourceDatabase *database =
+			(SourceDatabase *) calloc(1, sizeof(SourceDatabase));
+
+		if (!parseCurrentDatabase(result, rowNumber, database))
+		{
+			parsedOk = false;
+			break;
+		}
+
+		if (context->catalog != NULL && context->catalog->db != NULL)
+		{
+			if (!catalog_add_s_database(context->catalog, database))
+			{
+				/* errors have already been logged */
+				parsedOk = false;
+				break;
+			}
+		}
+	}
+
+	context->parsedOk = parsedOk;
+}
+
+
+/*
+ * parseCurrentDatabase parses a single row of the database listing query
+ * result.
+ */
+static bool
+parseCurrentDatabase(PGresult *result, int rowNumber, SourceDatabase *database)
+{
+	int errors = 0;
+
+	/* 1. oid */
+	char *value = PQgetvalue(result, rowNumber, 0);
+
+	if (!stringToUInt32(value, &(database->oid)) || database->oid == 0)
+	{
+		log_error("Invalid OID \"%s\"", value);
+		++errors;
+	}
+
+	/* 2. datname */
+	value = PQgetvalue(result, rowNumber, 1);
+	int length = strlcpy(database->datname, value, PG_NAMEDATALEN);
+
+	if (length >= PG_NAMEDATALEN)
+	{
+		log_error("Database name \"%s\" is %d bytes long, "
+				  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
+				  value, length, PG_NAMEDATALEN - 1);
+		++errors;
+	}
+
+	/* 3. bytes */
+	value = PQgetvalue(result, rowNumber, 2);
+	if (PQgetisnull(result, rowNumber, 2))
+	{
+		/*
+		 * It may happen that pg_table_size() returns NULL (when failing to
+		 * open the given relation).
+		 */
+		database->bytes = 0;
+	}
+	else
+	{
+		value = PQgetvalue(result, rowNumber, 2);
+
+		if (!stringToInt64(value, &(database->bytes)))
+		{
+			log_error("Invalid pg_database_size: \"%s\"", value);
+			++errors;
+		}
+	}
+
+	/* 4. pg_size_pretty */
+	value = PQgetvalue(result, rowNumber, 3);
+	length = strlcpy(database->bytesPretty, value, PG_NAMEDATALEN);
+
+	if (length >= PG_NAMEDATALEN)
+	{
+		log_error("Pretty printed byte size \"%s\" is %d bytes long, "
+				  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
+				  value, length, PG_NAMEDATALEN - 1);
+		++errors;
+	}
+
+	return errors == 0;
+}
+
+
+/*
+ * getDatabaseList loops over the SQL result for the database properties array
+ * query and allocates an array of GUC settings then populates it with the
+ * query result.
+ */
+static void
+getDatabaseProperties(void *ctx, PGresult *result)
+{
+	SourcePropertiesArrayContext *context = (SourcePropertiesArrayContext *) ctx;
+	int nTuples = PQntuples(result);
+
+	if (PQnfields(result) != 3)
+	{
+		log_error("Query returned %d columns, expected 3", PQnfields(result));
+		context->parsedOk = false;
+		return;
+	}
+
+	bool parsedOk = true;
+
+	for (int rowNumber = 0; rowNumber < nTuples; rowNumber++)
+	{
+		SourceProperty *property =
+			(SourceProperty *) calloc(1, sizeof(SourceProperty));
+
+		if (!parseDatabaseProperty(result, rowNumber, property))
+		{
+			parsedOk = false;
+			break;
+		}
+
+		if (context->catalog != NULL && context->catalog->db != NULL)
+		{
+			if (!catalog_add_s_database_properties(context->catalog, property))
+			{
+				/* errors have already been logged */
+				parsedOk = false;
+				break;
+			}
+		}
+	}
+
+	context->parsedOk = parsedOk;
+}
+
+
+/*
+ * parseCurrentProperty parses a single row of the database properties listing
+ * query result.
+ */
+static bool
+parseDatabaseProperty(PGresult *result, int rowNumber, SourceProperty *property)
+{
+	int errors = 0;
+
+	/* 1. datname */
+	if (PQgetisnull(result, rowNumber, 0))
+	{
+		log_error("BUG: parseDatabaseProperty: datname is NULL");
+		++errors;
+	}
+	else
+	{
+		char *value = PQgetvalue(result, rowNumber, 0);
+		int length = strlcpy(property->datname, value, PG_NAMEDATALEN);
+
+		if (length >= PG_NAMEDATALEN)
+		{
+			log_error("Properties role name \"%s\" is %d bytes long, "
+					  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
+					  value, length, PG_NAMEDATALEN - 1);
+			++errors;
+		}
+	}
+
+	/* 2. rolname */
+	if (PQgetisnull(result, rowNumber, 1))
+	{
+		property->roleInDatabase = false;
+	}
+	else
+	{
+		property->roleInDatabase = true;
+
+		char *value = PQgetvalue(result, rowNumber, 1);
+		int length = strlcpy(property->rolname, value, PG_NAMEDATALEN);
+
+		if (length >= PG_NAMEDATALEN)
+		{
+			log_error("Properties role name \"%s\" is %d bytes long, "
+					  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
+					  value, length, PG_NAMEDATALEN - 1);
+			++errors;
+		}
+	}
+
+	/* 3. setconfig */
+	if (PQgetisnull(result, rowNumber, 2))
+	{
+		log_error("BUG: parseDatabaseProperty: setconfig is NULL");
+		++errors;
+	}
+	else
+	{
+		char *value = PQgetvalue(result, rowNumber, 2);
+		int len = strlen(value);
+		int bytes = len + 1;
+
+		property->setconfig = (char *) calloc(bytes, sizeof(char));
+
+		if (property->setconfig == NULL)
+		{
+			log_fatal(ALLOCATION_FAILED_ERROR);
+			return false;
+		}
+
+		strlcpy(property->setconfig, value, bytes);
+	}
+
+	return errors == 0;
+}
+
+
+/*
+ * getExtensionList loops over the SQL result for the extension array query and
+ * allocates an array of extensions then populates it with the query result.
+ */
+static void
+getExtensionList(void *ctx, PGresult *result)
+{
+	SourceExtensionArrayContext *context = (SourceExtensionArrayContext *) ctx;
+	int nTuples = PQntuples(result);
+
+	if (PQnfields(result) != 11)
+	{
+		log_error("Query returned %d columns, expected 11", PQnfields(result));
+		context->parsedOk = false;
+		return;
+	}
+
+	bool parsedOk = true;
+
+	SourceExtension *extension =
+		(SourceExtension *) calloc(1, sizeof(SourceExtension));
+
+	if (extension == NULL)
+	{
+		log_error(ALLOCATION_FAILED_ERROR);
+		parsedOk = false;
+		return;
+	}
+
+	for (int rowNumber = 0; rowNumber < nTuples; rowNumber++)
+	{
+		int confIndex = 0;
+
+		(void) bzero(extension, sizeof(SourceExtension));
+
+		if (!parseCurrentExtension(result, rowNumber, extension, &confIndex))
+		{
+			parsedOk = false;
+			break;
+		}
+
+		log_trace("getExtensionList: %s [%d/%d]",
+				  extension->extname,
 				  confIndex,
 				  extension->config.count);
 
-		/*
-		 * Only the first extension of a series gets into the extension list.
-		 *
-		 * Each extension has an array of extconfig (pg_class oids) and an
-		 * array of extcondition (WHERE clauses, as text) of the same
-		 * dimensions.
-		 *
-		 * The arrays may be empty, in which case confIndex == 0, and we can
-		 * skip the extension configuration parts.
-		 *
-		 * The arrays may contain a single entry, in which case parsing the
-		 * current row is self-contained.
-		 *
-		 * The arrays may contain 2 or more values, in which case the first row
-		 * we read in the loop is where we build the SourceExtension structure
-		 * instance, and then the next rows of the SQL query have the same
-		 * first columns values and vary only in their extconfig/extcondition
-		 * columns. The arrays have been UNNESTed, so each row contains the
-		 * next value from the array.
-		 */
-		if (confIndex == 0 || confIndex == 1)
+		/*
+		 * Only the first extension of a series gets into the extension list.
+		 *
+		 * Each extension has an array of extconfig (pg_class oids) and an
+		 * array of extcondition (WHERE clauses, as text) of the same
+		 * dimensions.
+		 *
+		 * The arrays may be empty, in which case confIndex == 0, and we can
+		 * skip the extension configuration parts.
+		 *
+		 * The arrays may contain a single entry, in which case parsing the
+		 * current row is self-contained.
+		 *
+		 * The arrays may contain 2 or more values, in which case the first row
+		 * we read in the loop is where we build the SourceExtension structure
+		 * instance, and then the next rows of the SQL query have the same
+		 * first columns values and vary only in their extconfig/extcondition
+		 * columns. The arrays have been UNNESTed, so each row contains the
+		 * next value from the array.
+		 */
+		if (confIndex == 0 || confIndex == 1)
+		{
+			if (context->catalog != NULL && context->catalog->db != NULL)
+			{
+				if (!catalog_add_s_extension(context->catalog, extension))
+				{
+					/* errors have already been logged */
+					parsedOk = false;
+					break;
+				}
+			}
+		}
+
+		/* now loop over extension configuration, if any */
+		if (extension->config.count > 0)
+		{
+			SourceExtensionConfig *config =
+				(SourceExtensionConfig *) calloc(1, sizeof(SourceExtensionConfig));
+
+			if (config == NULL)
+			{
+				log_fatal(ALLOCATION_FAILED_ERROR);
+				parsedOk = false;
+				return;
+			}
+
+			if (!parseCurrentExtensionConfig(result, rowNumber, config))
+			{
+				parsedOk = false;
+				break;
+			}
+
+			if (context->catalog != NULL && context->catalog->db != NULL)
+			{
+				config->extoid = extension->oid;
+
+				if (!catalog_add_s_extension_config(context->catalog, config))
+				{
+					/* errors have already been logged */
+					parsedOk = false;
+					break;
+				}
+			}
+		}
+	}
+
+
+	context->parsedOk = parsedOk;
+}
+
+
+/*
+ * parseCurrentExtension parses a single row of the extension listing query
+ * result.
+ */
+static bool
+parseCurrentExtension(PGresult *result,
+					  int rowNumber,
+					  SourceExtension *extension,
+					  int *confIndex)
+{
+	int errors = 0;
+
+	/* 1. oid */
+	char *value = PQgetvalue(result, rowNumber, 0);
+
+	if (!stringToUInt32(value, &(extension->oid)) || extension->oid == 0)
+	{
+		log_error("Invalid OID \"%s\"", value);
+		++errors;
+	}
+
+	/* 2. extname */
+	value = PQgetvalue(result, rowNumber, 1);
+	int length = strlcpy(extension->extname, value, PG_NAMEDATALEN);
+
+	if (length >= PG_NAMEDATALEN)
+	{
+		log_error("Extension name \"%s\" is %d bytes long, "
+				  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
+				  value, length, PG_NAMEDATALEN - 1);
+		++errors;
+	}
+
+	/* 3. extnamespace */
+	value = PQgetvalue(result, rowNumber, 2);
+	length = strlcpy(extension->extnamespace, value, PG_NAMEDATALEN);
+
+	if (length >= PG_NAMEDATALEN)
+	{
+		log_error("Extension extnamespace \"%s\" is %d bytes long, "
+				  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
+				  value, length, PG_NAMEDATALEN - 1);
+		++errors;
+	}
+
+	/* 4. extrelocatable */
+	value = PQgetvalue(result, rowNumber, 3);
+	extension->extrelocatable = (*value) == 't';
+
+	/* 5. array_length(extconfig), or NULL */
+	if (PQgetisnull(result, rowNumber, 4))
+	{
+		extension->config.count = 0;
+	}
+	else
+	{
+		value = PQgetvalue(result, rowNumber, 4);
+
+		if (!stringToInt(value, &(extension->config.count)))
+		{
+			log_error("Invalid extension configuration count \"%s\"", value);
+			++errors;
+		}
+	}
+
+	/* 6. n (position over count), or NULL */
+	if (PQgetisnull(result, rowNumber, 5))
+	{
+		*confIndex = 0;
+	}
+	else
+	{
+		value = PQgetvalue(result, rowNumber, 5);
+
+		if (!stringToInt(value, confIndex))
+		{
+			log_error("Invalid extension configuration index \"%s\"", value);
+			++errors;
+		}
+	}
+
+	return errors == 0;
+}
+
+
+/*
+ * parseCurrentExtensionConfig parses a single row of the extension listing
+ * query and adds the extconfig and extcondition columns to the given array
+ * entry of SourceExtensionConfig.
+ */
+static bool
+parseCurrentExtensionConfig(PGresult *result,
+							int rowNumber,
+							SourceExtensionConfig *extConfig)
+{
+	int errors = 0;
+
+	/* 7. extconfig (pg_class oid) */
+	char *value = PQgetvalue(result, rowNumber, 6);
+
+	if (!stringToUInt32(value, &(extConfig->reloid)))
+	{
+		log_error("Invalid extension configuration OID \"%s\"", value);
+		++errors;
+	}
+
+	/* 8. n.nspname */
+	value = PQgetvalue(result, rowNumber, 7);
+	int length = strlcpy(extConfig->nspname, value, PG_NAMEDATALEN);
+
+	if (length >= PG_NAMEDATALEN)
+	{
+		log_error("Schema name \"%s\" is %d bytes long, "
+				  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
+				  value, length, PG_NAMEDATALEN - 1);
+		++errors;
+	}
+
+	/* 9. c.relname */
+	value = PQgetvalue(result, rowNumber, 8);
+	length = strlcpy(extConfig->relname, value, PG_NAMEDATALEN);
+
+	if (length >= PG_NAMEDATALEN)
+	{
+		log_error("Extension configuration table name \"%s\" is %d bytes long, "
+				  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
+				  value, length, PG_NAMEDATALEN - 1);
+		++errors;
+	}
+
+	/* 10. extcondition */
+	value = PQgetvalue(result, rowNumber, 9);
+	extConfig->condition = strdup(value);
+
+	if (extConfig->condition == NULL)
+	{
+		log_error(ALLOCATION_FAILED_ERROR);
+		++errors;
+	}
+
+	/* 11. relkind */
+	value = PQgetvalue(result, rowNumber, 10);
+	extConfig->relkind = value[0];
+
+	if (extConfig->relkind == 0)
+	{
+		log_error("Extension configuration relkind is empty");
+		++errors;
+	}
+
+	return errors == 0;
+}
+
+
+/*
+ * getExtensionsVersions loops over the SQL result for the available extension
+ * versions list.
+ */
+static void
+getExtensionsVersions(void *ctx, PGresult *result)
+{
+	ExtensionsVersionsArrayContext *context =
+		(ExtensionsVersionsArrayContext *) ctx;
+
+	int nTuples = PQntuples(result);
+
+	if (PQnfields(result) != 4)
+	{
+		log_error("Query returned %d columns, expected 4", PQnfields(result));
+		context->parsedOk = false;
+		return;
+	}
+
+	if (nTuples == 0)
+	{
+		return;
+	}
+
+	/* we're not supposed to re-cycle arrays here */
+	if (context->evArray->array != NULL)
+	{
+		/* issue a warning but let's try anyway */
+		log_warn("BUG? context's array is not null in getExtensionsVersions");
+
+		context->evArray->array = NULL;
+	}
+
+	context->evArray->count = nTuples;
+	context->evArray->array =
+		(ExtensionsVersions *) calloc(nTuples, sizeof(ExtensionsVersions));
+
+	if (context->evArray->array == NULL)
+	{
+		log_fatal(ALLOCATION_FAILED_ERROR);
+		return;
+	}
+
+	int errors = 0;
+
+	for (int rowNumber = 0; rowNumber < nTuples; rowNumber++)
+	{
+		ExtensionsVersions *ev = &(context->evArray->array[rowNumber]);
+
+		/* 1. name */
+		char *value = PQgetvalue(result, rowNumber, 0);
+		int length = strlcpy(ev->name, value, PG_NAMEDATALEN);
+
+		if (length >= PG_NAMEDATALEN)
+		{
+			log_error("Extension name \"%s\" is %d bytes long, "
+					  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
+					  value, length, PG_NAMEDATALEN - 1);
+			++errors;
+		}
+
+		/* 2. defaultVersion */
+		value = PQgetvalue(result, rowNumber, 1);
+		length = strlcpy(ev->defaultVersion, value, PG_NAMEDATALEN);
+
+		if (length >= PG_NAMEDATALEN)
+		{
+			log_error("Extension version \"%s\" is %d bytes long, "
+					  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
+					  value, length, PG_NAMEDATALEN - 1);
+			++errors;
+		}
+
+		/* 3. installedVersion */
+		value = PQgetvalue(result, rowNumber, 2);
+		length = strlcpy(ev->installedVersion, value, PG_NAMEDATALEN);
+
+		if (length >= PG_NAMEDATALEN)
+		{
+			log_error("Extension version \"%s\" is %d bytes long, "
+					  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
+					  value, length, PG_NAMEDATALEN - 1);
+			++errors;
+		}
+
+		/* 4. versions JSON array */
+		if (!PQgetisnull(result, rowNumber, 3))
+		{
+			value = PQgetvalue(result, rowNumber, 3);
+			ev->json = json_parse_string(value);
+
+			if (ev->json == NULL || json_type(ev->json) != JSONArray)
+			{
+				log_error("Failed to parse extension \"%s\" available versions "
+						  "JSON array: %s",
+						  ev->name, value);
+				++errors;
+			}
+		}
+	}
+
+	context->parsedOk = errors == 0;
+}
+
+
+/*
+ * getCollationList loops over the SQL result for the collation array query and
+ * allocates an array of schemas then populates it with the query result.
+ */
+static void
+getCollationList(void *ctx, PGresult *result)
+{
+	SourceCollationArrayContext *context = (SourceCollationArrayContext *) ctx;
+	int nTuples = PQntuples(result);
+
+	if (PQnfields(result) != 4)
+	{
+		log_error("Query returned %d columns, expected 4", PQnfields(result));
+		context->parsedOk = false;
+		return;
+	}
+
+	int errors = 0;
+
+	for (int rowNumber = 0; rowNumber < nTuples; rowNumber++)
+	{
+		SourceCollation *collation =
+			(SourceCollation *) calloc(1, sizeof(SourceCollation));
+
+		if (collation == NULL)
+		{
+			++errors;
+			log_error(ALLOCATION_FAILED_ERROR);
+			break;
+		}
+
+		/* 1. oid */
+		char *value = PQgetvalue(result, rowNumber, 0);
+
+		if (!stringToUInt32(value, &(collation->oid)) || collation->oid == 0)
+		{
+			log_error("Invalid OID \"%s\"", value);
+			++errors;
+		}
+
+		/* 2. collname */
+		value = PQgetvalue(result, rowNumber, 1);
+		int length = strlcpy(collation->collname, value, PG_NAMEDATALEN);
+
+		if (length >= PG_NAMEDATALEN)
+		{
+			log_error("Collation name \"%s\" is %d bytes long, "
+					  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
+					  value, length, PG_NAMEDATALEN - 1);
+			++errors;
+		}
+
+		/* 3. desc */
+		value = PQgetvalue(result, rowNumber, 2);
+		length = strlen(value) + 1;
+		collation->desc = (char *) calloc(length, sizeof(char));
+
+		if (collation->desc == NULL)
 		{
-			if (context->catalog != NULL && context->catalog->db != NULL)
-			{
-				if (!catalog_add_s_extension(context->catalog, extension))
-				{
-					/* errors have already been logged */
-					parsedOk = false;
-					break;
-				}
-			}
+			log_fatal(ALLOCATION_FAILED_ERROR);
+			return;
 		}
 
-		/* now loop over extension configuration, if any */
-		if (extension->config.count > 0)
+		strlcpy(collation->desc, value, length);
+
+		/* 4. restoreListName */
+		value = PQgetvalue(result, rowNumber, 3);
+		length =
+			strlcpy(collation->restoreListName,
+					value,
+					RESTORE_LIST_NAMEDATALEN);
+
+		if (length >= RESTORE_LIST_NAMEDATALEN)
 		{
-			SourceExtensionConfig *config =
-				(SourceExtensionConfig *) calloc(1, sizeof(SourceExtensionConfig));
+			log_error("Collation restore list name \"%s\" is %d bytes long, "
+					  "the maximum expected is %d (RESTORE_LIST_NAMEDATALEN - 1)",
+					  value, length, RESTORE_LIST_NAMEDATALEN - 1);
+			++errors;
+		}
 
-			if (config == NULL)
+		if (context->catalog != NULL && context->catalog->db != NULL)
+		{
+			if (!catalog_add_s_coll(context->catalog, collation))
 			{
-				log_fatal(ALLOCATION_FAILED_ERROR);
-				parsedOk = false;
-				return;
+				/* errors have already been logged */
+				++errors;
+				break;
 			}
+		}
+	}
 
-			if (!parseCurrentExtensionConfig(result, rowNumber, config))
+	context->parsedOk = errors == 0;
+}
+
+
+/*
+ * getTableSizeArray retrieves the table size array from the PostgreSQL result and populates the context.
+ */
+static void
+getTableSizeArray(void *ctx, PGresult *result)
+{
+	SourceTableSizeArrayContext *context = (SourceTableSizeArrayContext *) ctx;
+	int nTuples = PQntuples(result);
+
+	if (PQnfields(result) != 3)
+	{
+		log_error("Query returned %d columns, expected 3", PQnfields(result));
+		context->parsedOk = false;
+		return;
+	}
+
+	bool parsedOk = true;
+
+	for (int rowNumber = 0; rowNumber < nTuples; rowNumber++)
+	{
+		SourceTableSize *tableSize =
+			(SourceTableSize *) calloc(1, sizeof(SourceTableSize));
+
+		if (!parseCurrentSourceTableSize(result, rowNumber, tableSize))
+		{
+			parsedOk = false;
+			break;
+		}
+
+		if (context->catalog != NULL && context->catalog->db != NULL)
+		{
+			if (!catalog_add_s_table_size(context->catalog, tableSize))
 			{
+				/* errors have already been logged */
 				parsedOk = false;
 				break;
 			}
-
-			if (context->catalog != NULL && context->catalog->db != NULL)
-			{
-				config->extoid = extension->oid;
-
-				if (!catalog_add_s_extension_config(context->catalog, config))
-				{
-					/* errors have already been logged */
-					parsedOk = false;
-					break;
-				}
-			}
 		}
 	}
 
-
 	context->parsedOk = parsedOk;
 }
 
 
 /*
- * parseCurrentExtension parses a single row of the extension listing query
- * result.
+ * parseCurrentSourceTableSize parses the current source table size from the given PGresult object.
  */
 static bool
-parseCurrentExtension(PGresult *result,
-					  int rowNumber,
-					  SourceExtension *extension,
-					  int *confIndex)
+parseCurrentSourceTableSize(PGresult *result, int rowNumber, SourceTableSize *tableSize)
 {
 	int errors = 0;
 
+	int fnoid = PQfnumber(result, "oid");
+	int fnbytes = PQfnumber(result, "bytes");
+	int fnbytespretty = PQfnumber(result, "pg_size_pretty");
+
 	/* 1. oid */
-	char *value = PQgetvalue(result, rowNumber, 0);
+	char *value = PQgetvalue(result, rowNumber, fnoid);
 
-	if (!stringToUInt32(value, &(extension->oid)) || extension->oid == 0)
+	if (!stringToUInt32(value, &(tableSize->oid)) || tableSize->oid == 0)
 	{
 		log_error("Invalid OID \"%s\"", value);
 		++errors;
 	}
 
-	/* 2. extname */
-	value = PQgetvalue(result, rowNumber, 1);
-	int length = strlcpy(extension->extname, value, PG_NAMEDATALEN);
+	/* 2. bytes */
+	value = PQgetvalue(result, rowNumber, fnbytes);
 
-	if (length >= PG_NAMEDATALEN)
+	if (!stringToInt64(value, &(tableSize->bytes)))
 	{
-		log_error("Extension name \"%s\" is %d bytes long, "
-				  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
-				  value, length, PG_NAMEDATALEN - 1);
+		log_error("Invalid pg_table_size: \"%s\"", value);
 		++errors;
 	}
 
-	/* 3. extnamespace */
-	value = PQgetvalue(result, rowNumber, 2);
-	length = strlcpy(extension->extnamespace, value, PG_NAMEDATALEN);
+	/* 3. pg_size_pretty */
+	value = PQgetvalue(result, rowNumber, fnbytespretty);
+	int length = strlcpy(tableSize->bytesPretty, value, PG_NAMEDATALEN);
 
 	if (length >= PG_NAMEDATALEN)
 	{
-		log_error("Extension extnamespace \"%s\" is %d bytes long, "
+		log_error("Pretty printed byte size \"%s\" is %d bytes long, "
 				  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
 				  value, length, PG_NAMEDATALEN - 1);
 		++errors;
 	}
 
-	/* 4. extrelocatable */
-	value = PQgetvalue(result, rowNumber, 3);
-	extension->extrelocatable = (*value) == 't';
+	return errors == 0;
+}
 
-	/* 5. array_length(extconfig), or NULL */
-	if (PQgetisnull(result, rowNumber, 4))
+
+/*
+ * getTableArray loops over the SQL result for the tables array query and saves
+ * each source table in our internal catalog.
+ *
+ * If we enabled estimating table sizes, we also store an estimage for the table
+ * sizes in the internal catalog.
+ */
+static void
+getTableArray(void *ctx, PGresult *result)
+{
+	SourceTableArrayContext *context = (SourceTableArrayContext *) ctx;
+
+	int nTuples = PQntuples(result);
+
+	if (PQnfields(result) != 12)
 	{
-		extension->config.count = 0;
+		log_error("Query returned %d columns, expected 12", PQnfields(result));
+		context->parsedOk = false;
+		return;
 	}
-	else
+
+	bool parsedOk = true;
+
+	if (context->catalog == NULL || context->catalog->db == NULL)
 	{
-		value = PQgetvalue(result, rowNumber, 4);
+		context->parsedOk = false;
+		return;
+	}
 
-		if (!stringToInt(value, &(extension->config.count)))
+	/*
+	 * Accumulate regular tables into a batch buffer, flush to SQLite in
+	 * chunks bounded by SQLITE_LIMIT_VARIABLE_NUMBER.  Matviews are rare
+	 * and go through the single-row path.
+	 */
+	int maxVars =
+		sqlite3_limit(context->catalog->db, SQLITE_LIMIT_VARIABLE_NUMBER, -1);
+	int batchCapacity = maxVars / CATALOG_INSERT_NCOLS_S_TABLE;
+
+	SourceTable *tableBatch = (SourceTable *) calloc(batchCapacity, sizeof(SourceTable));
+
+	if (tableBatch == NULL)
+	{
+		log_error("Failed to allocate table batch buffer");
+		context->parsedOk = false;
+		return;
+	}
+
+	int tableBatchCount = 0;
+
+	for (int rowNumber = 0; rowNumber < nTuples && parsedOk; rowNumber++)
+	{
+		SourceTable table = { 0 };
+
+		if (!parseCurrentSourceTable(result, rowNumber, &table))
 		{
-			log_error("Invalid extension configuration count \"%s\"", value);
-			++errors;
+			parsedOk = false;
+			break;
+		}
+
+		strlcpy(table.datname, context->datname, sizeof(table.datname));
+
+		switch (table.relkind)
+		{
+			/* regular or partitioned table — accumulate into batch */
+			case 'r':
+			case 'p':
+			{
+				tableBatch[tableBatchCount++] = table;
+
+				if (tableBatchCount == batchCapacity)
+				{
+					parsedOk = catalog_add_s_table_batch(context->catalog,
+														 tableBatch,
+														 tableBatchCount);
+					tableBatchCount = 0;
+				}
+
+				if (parsedOk && context->estimateTableSizes)
+				{
+					SourceTableSize sourceTableSize = {
+						.oid = table.oid,
+						.bytes = table.bytesEstimate
+					};
+
+					strlcpy(sourceTableSize.bytesPretty,
+							table.bytesEstimatePretty,
+							sizeof(sourceTableSize.bytesPretty));
+
+					parsedOk = catalog_add_s_table_size(context->catalog,
+														&sourceTableSize);
+				}
+
+				break;
+			}
+
+			/* materialized view — infrequent, keep single-row path */
+			case 'm':
+			{
+				parsedOk = catalog_add_s_matview(context->catalog, &table);
+				break;
+			}
+
+			default:
+			{
+				log_error("Unknown relkind \"%c\" for relation \"%s\"",
+						  table.relkind, table.qname);
+				parsedOk = false;
+				break;
+			}
 		}
 	}
 
-	/* 6. n (position over count), or NULL */
-	if (PQgetisnull(result, rowNumber, 5))
+	/* flush remaining regular tables */
+	if (parsedOk && tableBatchCount > 0)
 	{
-		*confIndex = 0;
+		parsedOk = catalog_add_s_table_batch(context->catalog,
+											 tableBatch, tableBatchCount);
 	}
-	else
-	{
-		value = PQgetvalue(result, rowNumber, 5);
 
-		if (!stringToInt(value, confIndex))
-		{
-			log_error("Invalid extension configuration index \"%s\"", value);
-			++errors;
-		}
-	}
+	free(tableBatch);
 
-	return errors == 0;
+	context->parsedOk = parsedOk;
 }
 
 
 /*
- * parseCurrentExtensionConfig parses a single row of the extension listing
- * query and adds the extconfig and extcondition columns to the given array
- * entry of SourceExtensionConfig.
+ * getPartKeyMinMaxValue retrieves the min and max values for the
+ * candidate partition key of the given table.
  */
 static bool
-parseCurrentExtensionConfig(PGresult *result,
-							int rowNumber,
-							SourceExtensionConfig *extConfig)
+getPartKeyMinMaxValue(PGSQL *pgsql, SourceTable *table)
 {
-	int errors = 0;
-
-	/* 7. extconfig (pg_class oid) */
-	char *value = PQgetvalue(result, rowNumber, 6);
-
-	if (!stringToUInt32(value, &(extConfig->reloid)))
-	{
-		log_error("Invalid extension configuration OID \"%s\"", value);
-		++errors;
-	}
+	PQExpBuffer sql = createPQExpBuffer();
+	char *sqlTemplate = "select min(%s), max(%s) "
+						"  from %s ";
 
-	/* 8. n.nspname */
-	value = PQgetvalue(result, rowNumber, 7);
-	int length = strlcpy(extConfig->nspname, value, PG_NAMEDATALEN);
+	appendPQExpBuffer(sql, sqlTemplate, table->partKey, table->partKey, table->qname);
 
-	if (length >= PG_NAMEDATALEN)
+	if (PQExpBufferBroken(sql))
 	{
-		log_error("Schema name \"%s\" is %d bytes long, "
-				  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
-				  value, length, PG_NAMEDATALEN - 1);
-		++errors;
+		(void) destroyPQExpBuffer(sql);
+		log_error(
+			"Failed to allocate memory for SQL query string to get partition key range");
+		return false;
 	}
 
-	/* 9. c.relname */
-	value = PQgetvalue(result, rowNumber, 8);
-	length = strlcpy(extConfig->relname, value, PG_NAMEDATALEN);
-
-	if (length >= PG_NAMEDATALEN)
+	SourceTablePartKeyMinMaxValueContext partKeyMinMaxValueContext = { 0 };
+	if (!pgsql_execute_with_params(pgsql, sql->data, 0, NULL, NULL,
+								   &partKeyMinMaxValueContext, &parsePartKeyMinMaxValue))
 	{
-		log_error("Extension configuration table name \"%s\" is %d bytes long, "
-				  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
-				  value, length, PG_NAMEDATALEN - 1);
-		++errors;
+		(void) destroyPQExpBuffer(sql);
+		log_error("Failed to execute SQL query to get partition key range");
+		return false;
 	}
 
-	/* 10. extcondition */
-	value = PQgetvalue(result, rowNumber, 9);
-	extConfig->condition = strdup(value);
-
-	if (extConfig->condition == NULL)
+	if (!partKeyMinMaxValueContext.parsedOk)
 	{
-		log_error(ALLOCATION_FAILED_ERROR);
-		++errors;
+		(void) destroyPQExpBuffer(sql);
+		log_error("Failed to parse SQL query to get partition key range");
+		return false;
 	}
 
-	/* 11. relkind */
-	value = PQgetvalue(result, rowNumber, 10);
-	extConfig->relkind = value[0];
+	(void) destroyPQExpBuffer(sql);
 
-	if (extConfig->relkind == 0)
-	{
-		log_error("Extension configuration relkind is empty");
-		++errors;
-	}
+	table->partmax = (partKeyMinMaxValueContext.max);
+	table->partmin = (partKeyMinMaxValueContext.min);
 
-	return errors == 0;
+	return true;
 }
 
 
 /*
- * getExtensionsVersions loops over the SQL result for the available extension
- * versions list.
+ * Parses the minimum and maximum values of a partition key from a PostgreSQL result.
  */
 static void
-getExtensionsVersions(void *ctx, PGresult *result)
+parsePartKeyMinMaxValue(void *ctx, PGresult *result)
 {
-	ExtensionsVersionsArrayContext *context =
-		(ExtensionsVersionsArrayContext *) ctx;
+	SourceTablePartKeyMinMaxValueContext *context =
+		(SourceTablePartKeyMinMaxValueContext *) ctx;
 
 	int nTuples = PQntuples(result);
+	int errors = 0;
 
-	if (PQnfields(result) != 4)
+	if (nTuples != 1)
 	{
-		log_error("Query returned %d columns, expected 4", PQnfields(result));
+		log_error("Query returned %d tuples, expected 1", nTuples);
 		context->parsedOk = false;
 		return;
 	}
 
-	if (nTuples == 0)
+	if (PQnfields(result) != 2)
 	{
+		log_error("Query returned %d columns, expected 2", PQnfields(result));
+		context->parsedOk = false;
 		return;
 	}
 
-	/* we're not supposed to re-cycle arrays here */
-	if (context->evArray->array != NULL)
-	{
-		/* issue a warning but let's try anyway */
-		log_warn("BUG? context's array is not null in getExtensionsVersions");
-
-		context->evArray->array = NULL;
-	}
-
-	context->evArray->count = nTuples;
-	context->evArray->array =
-		(ExtensionsVersions *) calloc(nTuples, sizeof(ExtensionsVersions));
-
-	if (context->evArray->array == NULL)
+	/* min and max are both null on empty tables */
+	if (PQgetisnull(result, 0, 0) &&
+		PQgetisnull(result, 0, 1))
 	{
-		log_fatal(ALLOCATION_FAILED_ERROR);
-		return;
+		context->min = 0;
+		context->max = 0;
 	}
-
-	int errors = 0;
-
-	for (int rowNumber = 0; rowNumber < nTuples; rowNumber++)
+	else
 	{
-		ExtensionsVersions *ev = &(context->evArray->array[rowNumber]);
-
-		/* 1. name */
-		char *value = PQgetvalue(result, rowNumber, 0);
-		int length = strlcpy(ev->name, value, PG_NAMEDATALEN);
-
-		if (length >= PG_NAMEDATALEN)
+		/* 1. min */
+		if (PQgetisnull(result, 0, 0))
 		{
-			log_error("Extension name \"%s\" is %d bytes long, "
-					  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
-					  value, length, PG_NAMEDATALEN - 1);
+			log_error("Invalid min value: NULL");
 			++errors;
 		}
-
-		/* 2. defaultVersion */
-		value = PQgetvalue(result, rowNumber, 1);
-		length = strlcpy(ev->defaultVersion, value, PG_NAMEDATALEN);
-
-		if (length >= PG_NAMEDATALEN)
+		else
 		{
-			log_error("Extension version \"%s\" is %d bytes long, "
-					  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
-					  value, length, PG_NAMEDATALEN - 1);
-			++errors;
+			char *value = PQgetvalue(result, 0, 0);
+			if (!stringToInt64(value, &(context->min)))
+			{
+				log_error("Invalid min value: \"%s\"", value);
+				++errors;
+			}
 		}
 
-		/* 3. installedVersion */
-		value = PQgetvalue(result, rowNumber, 2);
-		length = strlcpy(ev->installedVersion, value, PG_NAMEDATALEN);
-
-		if (length >= PG_NAMEDATALEN)
+		/* 2. max */
+		if (PQgetisnull(result, 0, 1))
 		{
-			log_error("Extension version \"%s\" is %d bytes long, "
-					  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
-					  value, length, PG_NAMEDATALEN - 1);
+			log_error("Invalid max value: NULL");
 			++errors;
 		}
-
-		/* 4. versions JSON array */
-		if (!PQgetisnull(result, rowNumber, 3))
+		else
 		{
-			value = PQgetvalue(result, rowNumber, 3);
-			ev->json = json_parse_string(value);
-
-			if (ev->json == NULL || json_type(ev->json) != JSONArray)
+			char *value = PQgetvalue(result, 0, 1);
+			if (!stringToInt64(value, &(context->max)))
 			{
-				log_error("Failed to parse extension \"%s\" available versions "
-						  "JSON array: %s",
-						  ev->name, value);
+				log_error("Invalid max value: \"%s\"", value);
 				++errors;
 			}
 		}
@@ -2362,107 +3831,183 @@ getExtensionsVersions(void *ctx, PGresult *result)
 
 
 /*
- * getCollationList loops over the SQL result for the collation array query and
- * allocates an array of schemas then populates it with the query result.
+ * getSplitSamplePercent computes the TABLESAMPLE SYSTEM percentage that reads
+ * about SPLIT_SAMPLE_PAGES blocks of the given table. The current size of the
+ * table is used, because pg_class statistics are unknown until the table has
+ * been vacuumed or analyzed.
  */
-static void
-getCollationList(void *ctx, PGresult *result)
+static bool
+getSplitSamplePercent(PGSQL *pgsql, SourceTable *table, double *percent)
 {
-	SourceCollationArrayContext *context = (SourceCollationArrayContext *) ctx;
-	int nTuples = PQntuples(result);
+	int64_t pages = 0;
 
-	if (PQnfields(result) != 4)
+	if (!pgsql_get_relation_pages(pgsql, table->qname, &pages))
 	{
-		log_error("Query returned %d columns, expected 4", PQnfields(result));
-		context->parsedOk = false;
-		return;
+		/* errors have already been logged */
+		return false;
 	}
 
-	int errors = 0;
+	*percent =
+		pages > SPLIT_SAMPLE_PAGES
+		? 100.0 * SPLIT_SAMPLE_PAGES / (double) pages
+		: 100.0;
 
-	for (int rowNumber = 0; rowNumber < nTuples; rowNumber++)
+	return true;
+}
+
+
+/*
+ * getPartKeyHistogram retrieves the distribution of the candidate partition
+ * key of the given table, as a list of bounds that divide the non-null key
+ * values into groups of about the same number of rows.
+ *
+ * We use the histogram_bounds that Postgres computes with ANALYZE when it's
+ * available, and otherwise compute quantiles on a sample of the table rows
+ * using TABLESAMPLE. When neither is possible the context count is zero.
+ */
+static bool
+getPartKeyHistogram(PGSQL *pgsql,
+					SourceTable *table,
+					SourceTablePartKeyHistogramContext *context)
+{
+	char *statsSql =
+		"  select b, s.null_frac, c.reltuples::bigint "
+		"    from pg_catalog.pg_stats s "
+		"         join pg_catalog.pg_namespace ns on ns.nspname = s.schemaname "
+		"         join pg_catalog.pg_class c "
+		"           on c.relnamespace = ns.oid and c.relname = s.tablename, "
+		"         unnest(s.histogram_bounds::text::bigint[]) "
+		"           with ordinality as h(b, n) "
+		"   where format('%I', s.schemaname) = $1 "
+		"     and format('%I', s.tablename) = $2 "
+		"     and format('%I', s.attname) = $3 "
+		"     and not s.inherited "
+		"order by h.n";
+
+	int paramCount = 3;
+	Oid paramTypes[3] = { TEXTOID, TEXTOID, TEXTOID };
+	const char *paramValues[3] = {
+		table->nspname,
+		table->relname,
+		table->partKey
+	};
+
+	if (!pgsql_execute_with_params(pgsql, statsSql,
+								   paramCount, paramTypes, paramValues,
+								   context, &parsePartKeyHistogram))
 	{
-		SourceCollation *collation =
-			(SourceCollation *) calloc(1, sizeof(SourceCollation));
+		log_error("Failed to fetch table %s column %s statistics",
+				  table->qname,
+				  table->partKey);
+		return false;
+	}
 
-		if (collation == NULL)
-		{
-			++errors;
-			log_error(ALLOCATION_FAILED_ERROR);
-			break;
-		}
+	if (!context->parsedOk)
+	{
+		log_error("Failed to parse table %s column %s statistics",
+				  table->qname,
+				  table->partKey);
+		return false;
+	}
 
-		/* 1. oid */
-		char *value = PQgetvalue(result, rowNumber, 0);
+	if (context->count >= 2)
+	{
+		log_notice("Table %s split boundaries computed from the "
+				   "pg_stats histogram of column %s (%d bounds)",
+				   table->qname,
+				   table->partKey,
+				   context->count);
+		return true;
+	}
 
-		if (!stringToUInt32(value, &(collation->oid)) || collation->oid == 0)
-		{
-			log_error("Invalid OID \"%s\"", value);
-			++errors;
-		}
+	/* no statistics, sample the table rows instead */
+	double percent = 100.0;
 
-		/* 2. collname */
-		value = PQgetvalue(result, rowNumber, 1);
-		int length = strlcpy(collation->collname, value, PG_NAMEDATALEN);
+	if (!getSplitSamplePercent(pgsql, table, &percent))
+	{
+		/* errors have already been logged */
+		return false;
+	}
 
-		if (length >= PG_NAMEDATALEN)
-		{
-			log_error("Collation name \"%s\" is %d bytes long, "
-					  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
-					  value, length, PG_NAMEDATALEN - 1);
-			++errors;
-		}
+	PQExpBuffer sql = createPQExpBuffer();
 
-		/* 3. desc */
-		value = PQgetvalue(result, rowNumber, 2);
-		length = strlen(value) + 1;
-		collation->desc = (char *) calloc(length, sizeof(char));
+	appendPQExpBuffer(sql,
+					  "  select b, q.null_frac, q.rows "
+					  "    from ( "
+					  "          select percentile_disc(array( "
+					  "                   select g::float8 / %d "
+					  "                     from generate_series(0, %d) as g)) "
+					  "                 within group (order by %s) as p, "
+					  "                 count(*) filter (where %s is null)::float8 "
+					  "                 / greatest(count(*), 1) as null_frac, "
+					  "                 (count(*) * 100 / %g)::bigint as rows "
+					  "            from %s tablesample system(%g) "
+					  "         ) as q, "
+					  "         unnest(q.p) with ordinality as h(b, n) "
+					  "order by n",
+					  SPLIT_SAMPLE_BUCKETS,
+					  SPLIT_SAMPLE_BUCKETS,
+					  table->partKey,
+					  table->partKey,
+					  percent,
+					  table->qname,
+					  percent);
 
-		if (collation->desc == NULL)
-		{
-			log_fatal(ALLOCATION_FAILED_ERROR);
-			return;
-		}
+	if (PQExpBufferBroken(sql))
+	{
+		(void) destroyPQExpBuffer(sql);
+		log_error("Failed to allocate memory for SQL query string to "
+				  "sample partition key values");
+		return false;
+	}
 
-		strlcpy(collation->desc, value, length);
+	free(context->bounds);
+	bzero(context, sizeof(SourceTablePartKeyHistogramContext));
 
-		/* 4. restoreListName */
-		value = PQgetvalue(result, rowNumber, 3);
-		length =
-			strlcpy(collation->restoreListName,
-					value,
-					RESTORE_LIST_NAMEDATALEN);
+	if (!pgsql_execute_with_params(pgsql, sql->data, 0, NULL, NULL,
+								   context, &parsePartKeyHistogram))
+	{
+		(void) destroyPQExpBuffer(sql);
+		log_error("Failed to sample table %s column %s values",
+				  table->qname,
+				  table->partKey);
+		return false;
+	}
 
-		if (length >= RESTORE_LIST_NAMEDATALEN)
-		{
-			log_error("Collation restore list name \"%s\" is %d bytes long, "
-					  "the maximum expected is %d (RESTORE_LIST_NAMEDATALEN - 1)",
-					  value, length, RESTORE_LIST_NAMEDATALEN - 1);
-			++errors;
-		}
+	(void) destroyPQExpBuffer(sql);
 
-		if (context->catalog != NULL && context->catalog->db != NULL)
-		{
-			if (!catalog_add_s_coll(context->catalog, collation))
-			{
-				/* errors have already been logged */
-				++errors;
-				break;
-			}
-		}
+	if (!context->parsedOk)
+	{
+		log_error("Failed to parse table %s column %s sample",
+				  table->qname,
+				  table->partKey);
+		return false;
 	}
 
-	context->parsedOk = errors == 0;
+	if (context->count >= 2)
+	{
+		log_notice("Table %s split boundaries computed from a %g%% sample "
+				   "of column %s",
+				   table->qname,
+				   percent,
+				   table->partKey);
+	}
+
+	return true;
 }
 
 
 /*
- * getTableSizeArray retrieves the table size array from the PostgreSQL result and populates the context.
+ * parsePartKeyHistogram parses the partition key distribution bounds, one per
+ * row, along with the fraction of NULL values and the estimated count of rows
+ * in the table.
  */
 static void
-getTableSizeArray(void *ctx, PGresult *result)
+parsePartKeyHistogram(void *ctx, PGresult *result)
 {
-	SourceTableSizeArrayContext *context = (SourceTableSizeArrayContext *) ctx;
+	SourceTablePartKeyHistogramContext *context =
+		(SourceTablePartKeyHistogramContext *) ctx;
+
 	int nTuples = PQntuples(result);
 
 	if (PQnfields(result) != 3)
@@ -2472,320 +4017,381 @@ getTableSizeArray(void *ctx, PGresult *result)
 		return;
 	}
 
-	bool parsedOk = true;
+	context->count = 0;
+	context->bounds = NULL;
+
+	if (nTuples == 0)
+	{
+		context->parsedOk = true;
+		return;
+	}
+
+	context->bounds = (int64_t *) calloc(nTuples, sizeof(int64_t));
+
+	if (context->bounds == NULL)
+	{
+		log_error(ALLOCATION_FAILED_ERROR);
+		context->parsedOk = false;
+		return;
+	}
 
 	for (int rowNumber = 0; rowNumber < nTuples; rowNumber++)
 	{
-		SourceTableSize *tableSize =
-			(SourceTableSize *) calloc(1, sizeof(SourceTableSize));
+		/* percentile_disc might return NULL on an empty sample */
+		if (PQgetisnull(result, rowNumber, 0))
+		{
+			continue;
+		}
 
-		if (!parseCurrentSourceTableSize(result, rowNumber, tableSize))
+		char *value = PQgetvalue(result, rowNumber, 0);
+		int64_t bound = 0;
+
+		if (!stringToInt64(value, &bound))
 		{
-			parsedOk = false;
-			break;
+			log_error("Invalid histogram bound value: \"%s\"", value);
+			context->parsedOk = false;
+			return;
 		}
 
-		if (context->catalog != NULL && context->catalog->db != NULL)
+		context->bounds[context->count++] = bound;
+	}
+
+	if (!PQgetisnull(result, 0, 1))
+	{
+		char *value = PQgetvalue(result, 0, 1);
+
+		if (!stringToDouble(value, &(context->nullFrac)))
 		{
-			if (!catalog_add_s_table_size(context->catalog, tableSize))
-			{
-				/* errors have already been logged */
-				parsedOk = false;
-				break;
-			}
+			log_error("Invalid null_frac value: \"%s\"", value);
+			context->parsedOk = false;
+			return;
 		}
 	}
 
-	context->parsedOk = parsedOk;
+	if (!PQgetisnull(result, 0, 2))
+	{
+		char *value = PQgetvalue(result, 0, 2);
+
+		if (!stringToInt64(value, &(context->rows)))
+		{
+			log_error("Invalid rows estimate value: \"%s\"", value);
+			context->parsedOk = false;
+			return;
+		}
+	}
+
+	context->parsedOk = true;
 }
 
 
 /*
- * parseCurrentSourceTableSize parses the current source table size from the given PGresult object.
+ * getCtidDensity samples the given table to count its live tuples, as seen
+ * in our snapshot, per bucket of blocks. The sample reads about
+ * SPLIT_SAMPLE_PAGES blocks of the table, picked at random with TABLESAMPLE
+ * SYSTEM, and the buckets are small enough to place partsCount boundaries.
  */
 static bool
-parseCurrentSourceTableSize(PGresult *result, int rowNumber, SourceTableSize *tableSize)
+getCtidDensity(PGSQL *pgsql,
+			   SourceTable *table,
+			   int64_t pages,
+			   int64_t partsCount,
+			   SourceTableCtidDensityContext *context)
 {
-	int errors = 0;
+	if (pages <= 0)
+	{
+		return true;
+	}
 
-	int fnoid = PQfnumber(result, "oid");
-	int fnbytes = PQfnumber(result, "bytes");
-	int fnbytespretty = PQfnumber(result, "pg_size_pretty");
+	int64_t buckets = partsCount * 4;
 
-	/* 1. oid */
-	char *value = PQgetvalue(result, rowNumber, fnoid);
+	if (buckets < SPLIT_SAMPLE_BUCKETS)
+	{
+		buckets = SPLIT_SAMPLE_BUCKETS;
+	}
 
-	if (!stringToUInt32(value, &(tableSize->oid)) || tableSize->oid == 0)
+	if (buckets > pages)
 	{
-		log_error("Invalid OID \"%s\"", value);
-		++errors;
+		buckets = pages;
 	}
 
-	/* 2. bytes */
-	value = PQgetvalue(result, rowNumber, fnbytes);
+	context->pages = pages;
+	context->bucketPages = ceil((double) pages / buckets);
+	context->count = ceil((double) pages / context->bucketPages);
+	context->tuples = (int64_t *) calloc(context->count, sizeof(int64_t));
 
-	if (!stringToInt64(value, &(tableSize->bytes)))
+	if (context->tuples == NULL)
 	{
-		log_error("Invalid pg_table_size: \"%s\"", value);
-		++errors;
+		log_error(ALLOCATION_FAILED_ERROR);
+		return false;
 	}
 
-	/* 3. pg_size_pretty */
-	value = PQgetvalue(result, rowNumber, fnbytespretty);
-	int length = strlcpy(tableSize->bytesPretty, value, PG_NAMEDATALEN);
+	double percent =
+		pages > SPLIT_SAMPLE_PAGES
+		? 100.0 * SPLIT_SAMPLE_PAGES / (double) pages
+		: 100.0;
 
-	if (length >= PG_NAMEDATALEN)
+	char sql[BUFSIZE] = { 0 };
+
+	sformat(sql, sizeof(sql),
+			"  select (ctid::text::point)[0]::bigint / %lld as b, count(*) "
+			"    from only %s tablesample system(%g) "
+			"group by b "
+			"order by b",
+			(long long) context->bucketPages,
+			table->qname,
+			percent);
+
+	if (!pgsql_execute_with_params(pgsql, sql, 0, NULL, NULL,
+								   context, &parseCtidDensity))
 	{
-		log_error("Pretty printed byte size \"%s\" is %d bytes long, "
-				  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
-				  value, length, PG_NAMEDATALEN - 1);
-		++errors;
+		log_error("Failed to sample table %s live tuples", table->qname);
+		return false;
 	}
 
-	return errors == 0;
+	if (!context->parsedOk)
+	{
+		log_error("Failed to parse table %s live tuples sample", table->qname);
+		return false;
+	}
+
+	context->rows = llround(context->sampled * 100.0 / percent);
+
+	log_notice("Table %s has about %lld live tuples in %lld blocks, "
+			   "from a %g%% sample",
+			   table->qname,
+			   (long long) context->rows,
+			   (long long) pages,
+			   percent);
+
+	return true;
 }
 
 
 /*
- * getTableArray loops over the SQL result for the tables array query and saves
- * each source table in our internal catalog.
- *
- * If we enabled estimating table sizes, we also store an estimage for the table
- * sizes in the internal catalog.
+ * parseCtidDensity parses the count of sampled live tuples per bucket of
+ * blocks.
  */
 static void
-getTableArray(void *ctx, PGresult *result)
+parseCtidDensity(void *ctx, PGresult *result)
 {
-	SourceTableArrayContext *context = (SourceTableArrayContext *) ctx;
+	SourceTableCtidDensityContext *context =
+		(SourceTableCtidDensityContext *) ctx;
 
 	int nTuples = PQntuples(result);
 
-	if (PQnfields(result) != 12)
-	{
-		log_error("Query returned %d columns, expected 12", PQnfields(result));
-		context->parsedOk = false;
-		return;
-	}
-
-	bool parsedOk = true;
-
-	if (context->catalog == NULL || context->catalog->db == NULL)
+	if (PQnfields(result) != 2)
 	{
+		log_error("Query returned %d columns, expected 2", PQnfields(result));
 		context->parsedOk = false;
 		return;
 	}
 
-	/*
-	 * Accumulate regular tables into a batch buffer, flush to SQLite in
-	 * chunks bounded by SQLITE_LIMIT_VARIABLE_NUMBER.  Matviews are rare
-	 * and go through the single-row path.
-	 */
-	int maxVars =
-		sqlite3_limit(context->catalog->db, SQLITE_LIMIT_VARIABLE_NUMBER, -1);
-	int batchCapacity = maxVars / CATALOG_INSERT_NCOLS_S_TABLE;
-
-	SourceTable *tableBatch = (SourceTable *) calloc(batchCapacity, sizeof(SourceTable));
+	context->sampled = 0;
 
-	if (tableBatch == NULL)
+	for (int rowNumber = 0; rowNumber < nTuples; rowNumber++)
 	{
-		log_error("Failed to allocate table batch buffer");
-		context->parsedOk = false;
-		return;
-	}
-
-	int tableBatchCount = 0;
+		int64_t bucket = 0;
+		int64_t tuples = 0;
 
-	for (int rowNumber = 0; rowNumber < nTuples && parsedOk; rowNumber++)
-	{
-		SourceTable table = { 0 };
+		char *value = PQgetvalue(result, rowNumber, 0);
 
-		if (!parseCurrentSourceTable(result, rowNumber, &table))
+		if (!stringToInt64(value, &bucket))
 		{
-			parsedOk = false;
-			break;
+			log_error("Invalid block bucket value: \"%s\"", value);
+			context->parsedOk = false;
+			return;
 		}
 
-		strlcpy(table.datname, context->datname, sizeof(table.datname));
+		value = PQgetvalue(result, rowNumber, 1);
 
-		switch (table.relkind)
+		if (!stringToInt64(value, &tuples))
 		{
-			/* regular or partitioned table — accumulate into batch */
-			case 'r':
-			case 'p':
-			{
-				tableBatch[tableBatchCount++] = table;
-
-				if (tableBatchCount == batchCapacity)
-				{
-					parsedOk = catalog_add_s_table_batch(context->catalog,
-														 tableBatch,
-														 tableBatchCount);
-					tableBatchCount = 0;
-				}
-
-				if (parsedOk && context->estimateTableSizes)
-				{
-					SourceTableSize sourceTableSize = {
-						.oid = table.oid,
-						.bytes = table.bytesEstimate
-					};
-
-					strlcpy(sourceTableSize.bytesPretty,
-							table.bytesEstimatePretty,
-							sizeof(sourceTableSize.bytesPretty));
-
-					parsedOk = catalog_add_s_table_size(context->catalog,
-														&sourceTableSize);
-				}
-
-				break;
-			}
-
-			/* materialized view — infrequent, keep single-row path */
-			case 'm':
-			{
-				parsedOk = catalog_add_s_matview(context->catalog, &table);
-				break;
-			}
-
-			default:
-			{
-				log_error("Unknown relkind \"%c\" for relation \"%s\"",
-						  table.relkind, table.qname);
-				parsedOk = false;
-				break;
-			}
+			log_error("Invalid live tuples count value: \"%s\"", value);
+			context->parsedOk = false;
+			return;
 		}
-	}
 
-	/* flush remaining regular tables */
-	if (parsedOk && tableBatchCount > 0)
-	{
-		parsedOk = catalog_add_s_table_batch(context->catalog,
-											 tableBatch, tableBatchCount);
-	}
+		/* rows appended since we measured the table size go to the end */
+		if (bucket >= context->count)
+		{
+			bucket = context->count - 1;
+		}
 
-	free(tableBatch);
+		context->tuples[bucket] += tuples;
+		context->sampled += tuples;
+	}
 
-	context->parsedOk = parsedOk;
+	context->parsedOk = true;
 }
 
 
 /*
- * getPartKeyMinMaxValue retrieves the min and max values for the
- * candidate partition key of the given table.
+ * getPartKeyBounds computes partsCount - 1 boundaries that divide the key
+ * values of the given table in ranges of about the same number of rows, using
+ * a sample of the table rows. Boundaries are given as a list of typed SQL
+ * literals, see schema_list_split_key.
  */
 static bool
-getPartKeyMinMaxValue(PGSQL *pgsql, SourceTable *table)
+getPartKeyBounds(PGSQL *pgsql,
+				 SourceTable *table,
+				 int64_t partsCount,
+				 SourceTableKeyBoundsContext *context)
 {
+	double percent = 100.0;
+
+	if (!getSplitSamplePercent(pgsql, table, &percent))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
 	PQExpBuffer sql = createPQExpBuffer();
-	char *sqlTemplate = "select min(%s), max(%s) "
-						"  from %s ";
 
-	appendPQExpBuffer(sql, sqlTemplate, table->partKey, table->partKey, table->qname);
+	appendPQExpBuffer(sql,
+					  "  select b.k, b.pgcopydb_rows "
+					  "    from ( "
+					  "            select distinct on (s.pgcopydb_tile) "
+					  "                   s.pgcopydb_tile, %s as k, "
+					  "                   s.pgcopydb_rows "
+					  "              from ( "
+					  "                     select %s, "
+					  "                            ntile(%lld) over (order by %s) "
+					  "                              as pgcopydb_tile, "
+					  "                            (count(*) over () * 100 / %g) "
+					  "                              ::bigint as pgcopydb_rows "
+					  "                       from %s tablesample system(%g) "
+					  "                   ) as s "
+					  "          order by s.pgcopydb_tile, %s "
+					  "         ) as b "
+					  "   where b.pgcopydb_tile > 1 "
+					  "order by b.pgcopydb_tile",
+					  table->partKeyExpr,
+					  table->partKey,
+					  (long long) partsCount,
+					  table->partKey,
+					  percent,
+					  table->qname,
+					  percent,
+					  table->partKey);
 
 	if (PQExpBufferBroken(sql))
 	{
 		(void) destroyPQExpBuffer(sql);
-		log_error(
-			"Failed to allocate memory for SQL query string to get partition key range");
+		log_error("Failed to allocate memory for SQL query string to "
+				  "sample unique key values");
 		return false;
 	}
 
-	SourceTablePartKeyMinMaxValueContext partKeyMinMaxValueContext = { 0 };
 	if (!pgsql_execute_with_params(pgsql, sql->data, 0, NULL, NULL,
-								   &partKeyMinMaxValueContext, &parsePartKeyMinMaxValue))
+								   context, &parsePartKeyBounds))
 	{
 		(void) destroyPQExpBuffer(sql);
-		log_error("Failed to execute SQL query to get partition key range");
+		log_error("Failed to sample table %s key (%s) values",
+				  table->qname,
+				  table->partKey);
 		return false;
 	}
 
-	if (!partKeyMinMaxValueContext.parsedOk)
+	(void) destroyPQExpBuffer(sql);
+
+	if (!context->parsedOk)
 	{
-		(void) destroyPQExpBuffer(sql);
-		log_error("Failed to parse SQL query to get partition key range");
+		log_error("Failed to parse table %s key (%s) sample",
+				  table->qname,
+				  table->partKey);
 		return false;
 	}
 
-	(void) destroyPQExpBuffer(sql);
-
-	table->partmax = (partKeyMinMaxValueContext.max);
-	table->partmin = (partKeyMinMaxValueContext.min);
+	log_notice("Table %s split boundaries computed from a %g%% sample "
+			   "of its unique key (%s)",
+			   table->qname,
+			   percent,
+			   table->partKey);
 
 	return true;
 }
 
 
 /*
- * Parses the minimum and maximum values of a partition key from a PostgreSQL result.
+ * parsePartKeyBounds parses the typed key boundaries, one per row, along with
+ * the estimated count of rows in the table.
  */
 static void
-parsePartKeyMinMaxValue(void *ctx, PGresult *result)
+parsePartKeyBounds(void *ctx, PGresult *result)
 {
-	SourceTablePartKeyMinMaxValueContext *context =
-		(SourceTablePartKeyMinMaxValueContext *) ctx;
+	SourceTableKeyBoundsContext *context = (SourceTableKeyBoundsContext *) ctx;
 
 	int nTuples = PQntuples(result);
-	int errors = 0;
 
-	if (nTuples != 1)
+	if (PQnfields(result) != 2)
 	{
-		log_error("Query returned %d tuples, expected 1", nTuples);
+		log_error("Query returned %d columns, expected 2", PQnfields(result));
 		context->parsedOk = false;
 		return;
 	}
 
-	if (PQnfields(result) != 2)
+	context->count = 0;
+	context->bounds = NULL;
+
+	if (nTuples == 0)
 	{
-		log_error("Query returned %d columns, expected 2", PQnfields(result));
-		context->parsedOk = false;
+		context->parsedOk = true;
 		return;
 	}
 
-	/* min and max are both null on empty tables */
-	if (PQgetisnull(result, 0, 0) &&
-		PQgetisnull(result, 0, 1))
+	context->bounds = (char **) calloc(nTuples, sizeof(char *));
+
+	if (context->bounds == NULL)
 	{
-		context->min = 0;
-		context->max = 0;
+		log_error(ALLOCATION_FAILED_ERROR);
+		context->parsedOk = false;
+		return;
 	}
-	else
+
+	for (int rowNumber = 0; rowNumber < nTuples; rowNumber++)
 	{
-		/* 1. min */
-		if (PQgetisnull(result, 0, 0))
-		{
-			log_error("Invalid min value: NULL");
-			++errors;
-		}
-		else
-		{
-			char *value = PQgetvalue(result, 0, 0);
-			if (!stringToInt64(value, &(context->min)))
-			{
-				log_error("Invalid min value: \"%s\"", value);
-				++errors;
-			}
-		}
+		char *value = PQgetvalue(result, rowNumber, 0);
 
-		/* 2. max */
-		if (PQgetisnull(result, 0, 1))
-		{
-			log_error("Invalid max value: NULL");
-			++errors;
-		}
-		else
+		context->bounds[rowNumber] = strdup(value);
+
+		if (context->bounds[rowNumber] == NULL)
 		{
-			char *value = PQgetvalue(result, 0, 1);
-			if (!stringToInt64(value, &(context->max)))
-			{
-				log_error("Invalid max value: \"%s\"", value);
-				++errors;
-			}
+			log_error(ALLOCATION_FAILED_ERROR);
+			context->parsedOk = false;
+			return;
 		}
+
+		++context->count;
 	}
 
-	context->parsedOk = errors == 0;
+	char *value = PQgetvalue(result, 0, 1);
+
+	if (!stringToInt64(value, &(context->rows)))
+	{
+		log_error("Invalid rows estimate value: \"%s\"", value);
+		context->parsedOk = false;
+		return;
+	}
+
+	context->parsedOk = true;
+}
+
+
+/*
+ * freePartKeyBounds frees the memory allocated when parsing key bounds.
+ */
+static void
+freePartKeyBounds(SourceTableKeyBoundsContext *context)
+{
+	for (int i = 0; i < context->count; i++)
+	{
+		free(context->bounds[i]);
+	}
+
+	free(context->bounds);
+
+	context->count = 0;
+	context->bounds = NULL;
 }
 
 
@@ -3468,9 +5074,9 @@ getIndexArray(void *ctx, PGresult *result)
 	SourceIndexArrayContext *context = (SourceIndexArrayContext *) ctx;
 	int nTuples = PQntuples(result);
 
-	if (PQnfields(result) != 16)
+	if (PQnfields(result) != 17)
 	{
-		log_error("Query returned %d columns, expected 16", PQnfields(result));
+		log_error("Query returned %d columns, expected 17", PQnfields(result));
 		context->parsedOk = false;
 		return;
 	}
@@ -3807,6 +5413,15 @@ parseCurrentSourceIndex(PGresult *result, int rowNumber, SourceIndex *index)
 		++errors;
 	}
 
+	/* 17. pg_relation_size(i.oid) */
+	value = PQgetvalue(result, rowNumber, 16);
+
+	if (!stringToInt64(value, &(index->bytes)))
+	{
+		log_error("Invalid index size \"%s\"", value);
+		++errors;
+	}
+
 	return errors == 0;
 }
 
@@ -3992,6 +5607,195 @@ parseCurrentSourceDepend(PGresult *result, int rowNumber, SourceDepend *depend)
 }
 
 
+/*
+ * getFKeyArray loops over the SQL result for the foreign keys query and adds
+ * each foreign key to our catalogs.
+ */
+static void
+getFKeyArray(void *ctx, PGresult *result)
+{
+	SourceFKeyArrayContext *context = (SourceFKeyArrayContext *) ctx;
+	int nTuples = PQntuples(result);
+
+	if (PQnfields(result) != 8)
+	{
+		log_error("Query returned %d columns, expected 8", PQnfields(result));
+		context->parsedOk = false;
+		return;
+	}
+
+	bool parsedOk = true;
+
+	for (int rowNumber = 0; rowNumber < nTuples; rowNumber++)
+	{
+		SourceForeignKey fkey = { 0 };
+
+		if (!parseCurrentSourceFKey(result, rowNumber, &fkey))
+		{
+			parsedOk = false;
+			free(fkey.condef);
+			break;
+		}
+
+		if (context->catalog != NULL && context->catalog->db != NULL)
+		{
+			if (!catalog_add_s_fkey(context->catalog, &fkey))
+			{
+				/* errors have already been logged */
+				parsedOk = false;
+				free(fkey.condef);
+				break;
+			}
+		}
+
+		free(fkey.condef);
+	}
+
+	context->parsedOk = parsedOk;
+}
+
+
+/*
+ * parseCurrentSourceFKey parses a single row of the foreign keys listing query
+ * result.
+ */
+static bool
+parseCurrentSourceFKey(PGresult *result, int rowNumber, SourceForeignKey *fkey)
+{
+	int errors = 0;
+
+	/* 1. c.oid */
+	char *value = PQgetvalue(result, rowNumber, 0);
+
+	if (!stringToUInt32(value, &(fkey->oid)) || fkey->oid == 0)
+	{
+		log_error("Invalid OID \"%s\"", value);
+		++errors;
+	}
+
+	/* 2. c.conrelid */
+	value = PQgetvalue(result, rowNumber, 1);
+
+	if (!stringToUInt32(value, &(fkey->conrelid)) || fkey->conrelid == 0)
+	{
+		log_error("Invalid OID \"%s\"", value);
+		++errors;
+	}
+
+	/* 3. c.confrelid */
+	value = PQgetvalue(result, rowNumber, 2);
+
+	if (!stringToUInt32(value, &(fkey->confrelid)) || fkey->confrelid == 0)
+	{
+		log_error("Invalid OID \"%s\"", value);
+		++errors;
+	}
+
+	/* 4. qname */
+	value = PQgetvalue(result, rowNumber, 3);
+	int length = strlcpy(fkey->qname, value, PG_NAMEDATALEN_FQ);
+
+	if (length >= PG_NAMEDATALEN_FQ)
+	{
+		log_error("Table name \"%s\" is %d bytes long, "
+				  "the maximum expected is %d (PG_NAMEDATALEN_FQ - 1)",
+				  value, length, PG_NAMEDATALEN_FQ - 1);
+		++errors;
+	}
+
+	/* 5. c.conname */
+	value = PQgetvalue(result, rowNumber, 4);
+	length = strlcpy(fkey->conname, value, PG_NAMEDATALEN);
+
+	if (length >= PG_NAMEDATALEN)
+	{
+		log_error("Constraint name \"%s\" is %d bytes long, "
+				  "the maximum expected is %d (PG_NAMEDATALEN - 1)",
+				  value, length, PG_NAMEDATALEN - 1);
+		++errors;
+	}
+
+	/* 6. c.convalidated */
+	value = PQgetvalue(result, rowNumber, 5);
+	fkey->convalidated = (*value) == 't';
+
+	/* 7. bytes */
+	value = PQgetvalue(result, rowNumber, 6);
+
+	if (!stringToInt64(value, &(fkey->bytes)))
+	{
+		log_error("Invalid table size \"%s\"", value);
+		++errors;
+	}
+
+	/* 8. pg_get_constraintdef() */
+	value = PQgetvalue(result, rowNumber, 7);
+	length = strlen(value) + 1;
+	fkey->condef = (char *) calloc(length, sizeof(char));
+
+	if (fkey->condef == NULL)
+	{
+		log_fatal(ALLOCATION_FAILED_ERROR);
+		return false;
+	}
+
+	strlcpy(fkey->condef, value, length);
+
+	return errors == 0;
+}
+
+
+/*
+ * getTableStatsArray loops over the SQL result for the table statistics query
+ * and adds each table statistics statement to our catalogs.
+ */
+static void
+getTableStatsArray(void *ctx, PGresult *result)
+{
+	SourceTableStatsArrayContext *context = (SourceTableStatsArrayContext *) ctx;
+	int nTuples = PQntuples(result);
+
+	if (PQnfields(result) != 2)
+	{
+		log_error("Query returned %d columns, expected 2", PQnfields(result));
+		context->parsedOk = false;
+		return;
+	}
+
+	bool parsedOk = true;
+
+	for (int rowNumber = 0; rowNumber < nTuples; rowNumber++)
+	{
+		SourceTablePgStats stats = { 0 };
+
+		/* 1. c.oid */
+		char *value = PQgetvalue(result, rowNumber, 0);
+
+		if (!stringToUInt32(value, &(stats.oid)) || stats.oid == 0)
+		{
+			log_error("Invalid OID \"%s\"", value);
+			parsedOk = false;
+			break;
+		}
+
+		/* 2. sql, not copied: only used for the duration of this loop */
+		stats.sql = PQgetvalue(result, rowNumber, 1);
+
+		if (context->catalog != NULL && context->catalog->db != NULL)
+		{
+			if (!catalog_add_s_table_pg_stats(context->catalog, &stats))
+			{
+				/* errors have already been logged */
+				parsedOk = false;
+				break;
+			}
+		}
+	}
+
+	context->parsedOk = parsedOk;
+}
+
+
 /*
  * getTableChecksum assigns the rowcount and checksum fields of a table from
  * the result of an SQL query.
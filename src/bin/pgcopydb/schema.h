@@ -118,6 +118,19 @@ typedef struct SourceTableParts
 	int64_t max;                /*   AND partKey  < max */
 
 	int64_t count;              /* max - min + 1 */
+	int64_t estRows;            /* estimated count of rows in the part */
+
+	/*
+	 * Tables split on a non-integer or multi-column unique key use key
+	 * boundaries given as a list of typed SQL literals, such as:
+	 *
+	 *   '42'::integer, 'a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11'::uuid
+	 *
+	 * The first part has no minKey and the last part has no maxKey.
+	 */
+	bool typed;
+	char minKey[BUFSIZE];       /* WHERE (partKey) >= (minKey) */
+	char maxKey[BUFSIZE];       /*   AND (partKey)  < (maxKey) */
 } SourceTableParts;
 
 
@@ -134,6 +147,17 @@ typedef struct SourceTableAttribute
 	char atttypsend[PG_NAMEDATALEN]; /* comma-separated send func names */
 } SourceTableAttribute;
 
+/*
+ * The COPY format computed for a table from its attribute types, used with
+ * --copy-format auto.
+ */
+typedef struct SourceTableCopyFormat
+{
+	uint32_t oid;
+	char format[PG_NAMEDATALEN];    /* "text" or "binary" */
+	char reason[BUFSIZE];
+} SourceTableCopyFormat;
+
 typedef struct SourceTableAttributeArray
 {
 	int count;
@@ -179,6 +203,7 @@ typedef struct SourceTable
 	TableChecksum targetChecksum;
 
 	char partKey[PG_NAMEDATALEN];
+	char partKeyExpr[BUFSIZE];  /* partKey columns as typed SQL literals */
 	SourceTableParts partition;
 
 	char *attrList;             /* malloc'ed area */
@@ -193,6 +218,28 @@ typedef struct SourceTable
 	/* summary information */
 	uint64_t durationMs;
 	uint64_t bytesTransmitted;
+
+	/* --use-copy-threads ring statistics, see CopyStats */
+	int ringDepth;
+	uint64_t ringSamples;
+	uint64_t ringOccupancy;
+	uint64_t ringFull;
+	uint64_t ringEmpty;
+
+	/* count of parts copied without writing WAL (target wal_level=minimal) */
+	uint64_t walSkippedParts;
+
+	/* COPY retries, and the time lost to them */
+	uint64_t retries;
+	uint64_t retryMs;
+
+	/* COPY wait-time attribution, see CopyStats */
+	uint64_t copyRows;
+	uint64_t copyMessages;
+	uint64_t srcWaitMs;
+	uint64_t dstWaitMs;
+	uint64_t throttleMs;
+	uint64_t clientMs;
 } SourceTable;
 
 
@@ -265,6 +312,8 @@ typedef struct SourceIndex
 
 	char indexRestoreListName[RESTORE_LIST_NAMEDATALEN];
 	char constraintRestoreListName[RESTORE_LIST_NAMEDATALEN];
+
+	int64_t bytes;              /* pg_relation_size() on the source */
 } SourceIndex;
 
 
@@ -297,6 +346,36 @@ typedef struct SourceDepend
 } SourceDepend;
 
 
+/*
+ * SourceForeignKey caches the foreign key constraints of the source tables.
+ * With --fkey-jobs pgcopydb creates them itself rather than pg_restore: first
+ * as NOT VALID, and then runs VALIDATE CONSTRAINT concurrently.
+ */
+typedef struct SourceForeignKey
+{
+	uint32_t oid;
+	uint32_t conrelid;
+	uint32_t confrelid;
+	char qname[PG_NAMEDATALEN_FQ];  /* referencing table */
+	char conname[PG_NAMEDATALEN];
+	bool convalidated;
+	int64_t bytes;                  /* referencing table size estimate */
+	char *condef;                   /* malloc'ed area */
+} SourceForeignKey;
+
+
+/*
+ * SourceTablePgStats caches the planner statistics of a source table, as a
+ * single SQL statement that calls the Postgres 18 statistics import functions
+ * pg_restore_relation_stats() and pg_restore_attribute_stats().
+ */
+typedef struct SourceTablePgStats
+{
+	uint32_t oid;
+	char *sql;                      /* malloc'ed area */
+} SourceTablePgStats;
+
+
 /*
  * SourceProperty caches data found in Postgres catalog pg_db_role_setting,
  * allowing to support ALTER DATABASE SET and ALTER ROLE IN DATABASE
@@ -450,6 +529,8 @@ bool schema_list_ordinary_tables(PGSQL *pgsql,
 								 bool estimateTableSizes,
 								 DatabaseCatalog *catalog);
 
+bool schema_list_split_key(PGSQL *pgsql, SourceTable *table);
+
 bool schema_list_partitions(PGSQL *pgsql,
 							DatabaseCatalog *catalog,
 							SourceTable *table,
@@ -473,6 +554,9 @@ bool schema_list_pg_depend(PGSQL *pgsql,
 						   SourceFilters *filters,
 						   DatabaseCatalog *catalog);
 
+bool schema_list_fkeys(PGSQL *pgsql, DatabaseCatalog *catalog);
+bool schema_list_table_stats(PGSQL *pgsql, DatabaseCatalog *catalog);
+
 bool schema_send_table_checksum(PGSQL *pgsql, SourceTable *table);
 bool schema_fetch_table_checksum(PGSQL *pgsql, TableChecksum *sum, bool *done);
 
@@ -106,6 +106,7 @@ copydb_export_snapshot(TransactionSnapshot *snapshot)
 	}
 
 	snapshot->state = SNAPSHOT_STATE_EXPORTED;
+	snapshot->pid = getpid();
 
 	log_info("Exported snapshot \"%s\" from the source database",
 			 snapshot->snapshot);
@@ -194,6 +195,7 @@ copydb_set_snapshot(CopyDataSpec *copySpecs)
 		}
 
 		copySpecs->sourceSnapshot.state = SNAPSHOT_STATE_SET;
+		copySpecs->sourceSnapshot.pid = getpid();
 	}
 	else
 	{
@@ -473,6 +475,7 @@ copydb_create_logical_replication_slot(CopyDataSpec *copySpecs,
 			sizeof(sourceSnapshot->snapshot));
 
 	sourceSnapshot->state = SNAPSHOT_STATE_EXPORTED;
+	sourceSnapshot->pid = getpid();
 	sourceSnapshot->exportedCreateSlotSnapshot = true;
 
 	/* store the snapshot in a file, to support --resume --snapshot ... */
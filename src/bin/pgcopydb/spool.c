@@ -0,0 +1,1448 @@
+/*
+ * src/bin/pgcopydb/spool.c
+ *	 Implementation of the --spool option: table data is first copied from the
+ *	 source database into compressed segment files, and then drained from the
+ *	 segment files into the target database.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <zlib.h>
+
+#include "catalog.h"
+#include "copydb.h"
+#include "file_utils.h"
+#include "ld_stream.h"
+#include "lock_utils.h"
+#include "log.h"
+#include "signals.h"
+#include "string_utils.h"
+#include "summary.h"
+
+
+/*
+ * A COPY BINARY stream starts with a fixed-size header: an 11 bytes signature
+ * followed by an int32 flags field and an int32 header extension length. The
+ * stream ends with a trailer: an int16 field count of -1.
+ */
+#define COPY_BINARY_HEADER_SIZE 19
+
+static const char COPY_BINARY_TRAILER[2] = { (char) 0xff, (char) 0xff };
+
+
+typedef struct SpoolWriter
+{
+	CopySpool *spool;
+	bool binary;
+
+	gzFile file;
+	uint64_t segmentBytes;
+
+	char header[COPY_BINARY_HEADER_SIZE];
+	bool hasHeader;
+} SpoolWriter;
+
+
+/*
+ * The drain context registers the target transaction id of each segment
+ * before sending its data, see copydb_drain_table.
+ */
+typedef struct SpoolDrainContext
+{
+	DatabaseCatalog *catalog;
+	CopySpool *spool;
+} SpoolDrainContext;
+
+
+static bool spool_write_data(void *context, char *buffer, int length);
+static bool spool_write(SpoolWriter *writer, const char *buffer, int length);
+static bool spool_open_segment(SpoolWriter *writer);
+static bool spool_close_segment(SpoolWriter *writer, bool addTrailer);
+static void spool_segment_filename(CopySpool *spool, int segment,
+								   char *filename, size_t size);
+
+static bool copydb_drain_resume(PGSQL *dst, DatabaseCatalog *catalog,
+								CopySpool *spool);
+static bool copydb_drain_begin(void *context, uint64_t xid);
+static bool copydb_drain_segment(PGSQL *dst, CopySpool *spool, int segment,
+								 CopyArgs *args, char *buffer,
+								 CopyStats *stats,
+								 void *context,
+								 CopyStatsCallback *callback);
+
+static bool copydb_spool_holds_snapshot(CopyDataSpec *specs);
+
+static bool spool_fetch(SQLiteQuery *query);
+
+
+/*
+ * copydb_spool_data_by_oid finds the SourceTable entry by its OID and then
+ * COPY the table data from the source database into the spool. The table is
+ * then added to the drain queue, where the drain workers take over and COPY
+ * the data from the spool to the target database.
+ */
+bool
+copydb_spool_data_by_oid(CopyDataSpec *specs, PGSQL *src, PGSQL *dst,
+						 uint32_t oid, uint32_t part)
+{
+	DatabaseCatalog *sourceDB = &(specs->catalogs.source);
+	SourceTable *table = (SourceTable *) calloc(1, sizeof(SourceTable));
+
+	if (table == NULL)
+	{
+		log_error(ALLOCATION_FAILED_ERROR);
+		return false;
+	}
+
+	if (!catalog_lookup_s_table(sourceDB, oid, part, table) ||
+		table->oid == 0)
+	{
+		log_error("Failed to lookup table oid %u in internal catalogs, "
+				  "see above for details",
+				  oid);
+
+		return false;
+	}
+
+	CopyTableDataSpec *tableSpecs =
+		(CopyTableDataSpec *) calloc(1, sizeof(CopyTableDataSpec));
+
+	if (tableSpecs == NULL)
+	{
+		log_error(ALLOCATION_FAILED_ERROR);
+		return false;
+	}
+
+	if (!copydb_init_table_specs(tableSpecs, specs, table, part))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	bool tableStillExists = true;
+
+	if (!copydb_check_table_exists(src, table, &tableStillExists))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	if (!tableStillExists)
+	{
+		log_warn("Skipping table %s (oid %u) which does not exists anymore "
+				 "on the source database",
+				 table->qname, oid);
+		return true;
+	}
+
+	char psTitle[BUFSIZE] = { 0 };
+
+	if (table->partition.partCount > 0)
+	{
+		sformat(psTitle, sizeof(psTitle), "pgcopydb: spool %s [%d/%d]",
+				table->qname,
+				table->partition.partNumber,
+				table->partition.partCount);
+	}
+	else
+	{
+		sformat(psTitle, sizeof(psTitle), "pgcopydb: spool %s", table->qname);
+	}
+
+	(void) set_ps_title(psTitle);
+
+	/*
+	 * Skip tables that have been entirely done already on a previous run, and
+	 * tables that have been spooled already but not drained yet.
+	 */
+	bool isDone = specs->runState.tableCopyIsDone || table->excludeData;
+
+	if (!isDone)
+	{
+		if (!summary_lookup_table(sourceDB, tableSpecs))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+
+		isDone = tableSpecs->summary.doneTime > 0;
+	}
+
+	if (!isDone)
+	{
+		CopySpool spool = { 0 };
+
+		if (!spool_init_table(specs, tableSpecs, &spool) ||
+			!spool_lookup_table(sourceDB, &spool))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+
+		if (spool.spoolTime > 0 && directory_exists(spool.dir))
+		{
+			log_info("Skipping spool for table %s, already done on a "
+					 "previous run (%d/%d segments drained)",
+					 table->qname,
+					 spool.drained,
+					 spool.segments);
+		}
+		else
+		{
+			if (!copydb_prepare_copy_args(specs, tableSpecs, dst))
+			{
+				/* errors have already been logged */
+				return false;
+			}
+
+			if (!copydb_spool_table(specs, src, tableSpecs, &spool))
+			{
+				/* errors have already been logged */
+				return false;
+			}
+		}
+	}
+
+	/* the drain worker also takes care of indexes, constraints, vacuum */
+	if (!copydb_add_drain(specs, oid, part))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * copydb_spool_table runs COPY TO STDOUT on the source database and writes the
+ * data into a series of compressed segment files. Each segment file contains
+ * a complete COPY stream, so that the drain workers may COPY each segment in
+ * its own transaction.
+ */
+bool
+copydb_spool_table(CopyDataSpec *specs, PGSQL *src,
+				   CopyTableDataSpec *tableSpecs,
+				   CopySpool *spool)
+{
+	DatabaseCatalog *sourceDB = &(specs->catalogs.source);
+
+	/* a partial spool from a previous run is of no use, start again */
+	if (!spool_delete_table(sourceDB, spool))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	if (!copydb_rmdir_or_mkdir(spool->dir, true))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	spool->segments = 0;
+	spool->bytes = 0;
+	spool->drained = 0;
+	spool->drainTime = 0;
+
+	SpoolWriter writer = {
+		.spool = spool,
+		.binary = tableSpecs->copyArgs.useCopyBinary
+	};
+
+	CopyStats stats = { 0 };
+
+	bool success = pg_copy_out(src, &(tableSpecs->copyArgs), &stats,
+							   &writer, &spool_write_data);
+
+	/* an empty table still needs a segment, to TRUNCATE the target */
+	if (success && writer.file == NULL)
+	{
+		success = spool_open_segment(&writer);
+	}
+
+	success = spool_close_segment(&writer, false) && success;
+
+	if (!success)
+	{
+		log_error("Failed to spool table %s, see above for details",
+				  tableSpecs->sourceTable->qname);
+		return false;
+	}
+
+	spool->pid = getpid();
+	spool->spoolTime = time(NULL);
+
+	if (!spool_add_table(sourceDB, spool))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	char bytesPretty[BUFSIZE] = { 0 };
+
+	pretty_print_bytes(bytesPretty, sizeof(bytesPretty), spool->bytes);
+
+	log_notice("Spooled table %s: %d segments, %s",
+			   tableSpecs->sourceTable->qname,
+			   spool->segments,
+			   bytesPretty);
+
+	return true;
+}
+
+
+/*
+ * spool_write_data is a CopyDataCallback that writes a CopyData message to
+ * the current spool segment, opening a new segment when needed.
+ */
+static bool
+spool_write_data(void *context, char *buffer, int length)
+{
+	SpoolWriter *writer = (SpoolWriter *) context;
+
+	if (writer->file != NULL && writer->segmentBytes >= SPOOL_SEGMENT_SIZE)
+	{
+		/* a COPY BINARY segment must end with the trailer */
+		if (!spool_close_segment(writer, writer->binary))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+	}
+
+	if (writer->file == NULL && !spool_open_segment(writer))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/*
+	 * Postgres sends the COPY BINARY header in the first CopyData message, we
+	 * keep a copy to start each of the next segments with it.
+	 */
+	if (writer->binary && !writer->hasHeader)
+	{
+		if (length < COPY_BINARY_HEADER_SIZE)
+		{
+			log_error("Failed to spool COPY BINARY data: "
+					  "first message is only %d bytes",
+					  length);
+			return false;
+		}
+
+		memcpy(writer->header, buffer, COPY_BINARY_HEADER_SIZE);
+		writer->hasHeader = true;
+	}
+
+	writer->spool->bytes += length;
+
+	return spool_write(writer, buffer, length);
+}
+
+
+/*
+ * spool_write writes data to the current spool segment.
+ */
+static bool
+spool_write(SpoolWriter *writer, const char *buffer, int length)
+{
+	if (gzwrite(writer->file, buffer, length) != length)
+	{
+		int errnum = 0;
+
+		log_error("Failed to write to spool segment %d in \"%s\": %s",
+				  writer->spool->segments - 1,
+				  writer->spool->dir,
+				  gzerror(writer->file, &errnum));
+		return false;
+	}
+
+	writer->segmentBytes += length;
+
+	return true;
+}
+
+
+/*
+ * spool_open_segment opens the next segment file of the spool.
+ */
+static bool
+spool_open_segment(SpoolWriter *writer)
+{
+	CopySpool *spool = writer->spool;
+	char filename[MAXPGPATH] = { 0 };
+
+	spool_segment_filename(spool, spool->segments, filename, sizeof(filename));
+
+	/* favor speed over compression ratio, we need to keep-up with COPY */
+	writer->file = gzopen(filename, "wb1");
+
+	if (writer->file == NULL)
+	{
+		log_error("Failed to open spool segment \"%s\": %m", filename);
+		return false;
+	}
+
+	++spool->segments;
+	writer->segmentBytes = 0;
+
+	if (writer->binary && writer->hasHeader)
+	{
+		return spool_write(writer, writer->header, COPY_BINARY_HEADER_SIZE);
+	}
+
+	return true;
+}
+
+
+/*
+ * spool_close_segment closes the current segment file of the spool, if any.
+ */
+static bool
+spool_close_segment(SpoolWriter *writer, bool addTrailer)
+{
+	if (writer->file == NULL)
+	{
+		return true;
+	}
+
+	bool success = true;
+
+	if (addTrailer)
+	{
+		success = spool_write(writer,
+							  COPY_BINARY_TRAILER,
+							  sizeof(COPY_BINARY_TRAILER));
+	}
+
+	int rc = gzclose(writer->file);
+
+	writer->file = NULL;
+
+	if (rc != Z_OK)
+	{
+		log_error("Failed to close spool segment %d in \"%s\": %s",
+				  writer->spool->segments - 1,
+				  writer->spool->dir,
+				  zError(rc));
+		return false;
+	}
+
+	return success;
+}
+
+
+/*
+ * spool_segment_filename computes the file name of the given segment.
+ */
+static void
+spool_segment_filename(CopySpool *spool, int segment,
+					   char *filename, size_t size)
+{
+	sformat(filename, size, "%s/%08d.gz", spool->dir, segment);
+}
+
+
+/*
+ * copydb_drain_table COPY the table data from the spool segment files to the
+ * target database, one transaction per segment, starting at the first segment
+ * that has not been drained yet.
+ */
+bool
+copydb_drain_table(CopyDataSpec *specs, PGSQL *dst,
+				   CopyTableDataSpec *tableSpecs,
+				   CopyStats *stats,
+				   void *context,
+				   CopyStatsCallback *callback)
+{
+	DatabaseCatalog *sourceDB = &(specs->catalogs.source);
+	CopySpool spool = { 0 };
+
+	if (!spool_init_table(specs, tableSpecs, &spool) ||
+		!spool_lookup_table(sourceDB, &spool))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	if (spool.spoolTime == 0)
+	{
+		log_error("Failed to drain table %s: spool not found in \"%s\"",
+				  tableSpecs->sourceTable->qname,
+				  spool.dir);
+		return false;
+	}
+
+	if (!copydb_drain_resume(dst, sourceDB, &spool))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	if (spool.drained > 0)
+	{
+		log_info("Resuming drain of table %s at segment %d/%d",
+				 tableSpecs->sourceTable->qname,
+				 spool.drained + 1,
+				 spool.segments);
+	}
+
+	stats->startTime = time(NULL);
+	stats->bytesTransmitted = 0;
+
+	char *buffer = (char *) malloc(COPY_RELAY_BUFFER_SIZE);
+
+	if (buffer == NULL)
+	{
+		log_error(ALLOCATION_FAILED_ERROR);
+		return false;
+	}
+
+	SpoolDrainContext drainContext = {
+		.catalog = sourceDB,
+		.spool = &spool
+	};
+
+	for (int segment = spool.drained; segment < spool.segments; segment++)
+	{
+		/*
+		 * Only the first segment may TRUNCATE the target table, the next
+		 * segments add to the data that's already been committed.
+		 */
+		CopyArgs args = tableSpecs->copyArgs;
+
+		if (segment > 0)
+		{
+			args.truncate = false;
+			args.freeze = false;
+		}
+
+		args.beginCallback = &copydb_drain_begin;
+		args.beginContext = &drainContext;
+
+		if (!copydb_drain_segment(dst, &spool, segment, &args, buffer,
+								  stats, context, callback))
+		{
+			/* errors have already been logged */
+			free(buffer);
+			return false;
+		}
+
+		spool.drained = segment + 1;
+		spool.pendingXid = 0;
+
+		if (!spool_update_drained(sourceDB, &spool))
+		{
+			/* errors have already been logged */
+			free(buffer);
+			return false;
+		}
+
+		char filename[MAXPGPATH] = { 0 };
+
+		spool_segment_filename(&spool, segment, filename, sizeof(filename));
+
+		(void) unlink_file(filename);
+	}
+
+	free(buffer);
+
+	spool.drainTime = time(NULL);
+
+	if (!spool_update_drained(sourceDB, &spool))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	if (!rmtree(spool.dir, true))
+	{
+		log_warn("Failed to remove spool directory \"%s\"", spool.dir);
+	}
+
+	return true;
+}
+
+
+/*
+ * copydb_drain_resume checks the target transaction of the segment that was
+ * being drained when we were interrupted, if any. When that transaction has
+ * been committed the segment is registered as drained, otherwise it is sent
+ * again.
+ */
+static bool
+copydb_drain_resume(PGSQL *dst, DatabaseCatalog *catalog, CopySpool *spool)
+{
+	if (spool->pendingXid == 0)
+	{
+		return true;
+	}
+
+	bool committed = false;
+
+	if (!pgsql_txid_committed(dst, spool->pendingXid, &committed))
+	{
+		log_error("Failed to resume drain of segment %d in \"%s\"",
+				  spool->drained,
+				  spool->dir);
+		return false;
+	}
+
+	if (committed)
+	{
+		char filename[MAXPGPATH] = { 0 };
+
+		spool_segment_filename(spool, spool->drained,
+							   filename, sizeof(filename));
+
+		log_info("Segment %d in \"%s\" has already been committed "
+				 "in transaction %lld",
+				 spool->drained,
+				 spool->dir,
+				 (long long) spool->pendingXid);
+
+		(void) unlink_file(filename);
+
+		++spool->drained;
+	}
+
+	spool->pendingXid = 0;
+
+	return spool_update_drained(catalog, spool);
+}
+
+
+/*
+ * copydb_drain_begin is a CopyBeginCallback that registers the target
+ * transaction id of the segment being drained before sending its data.
+ */
+static bool
+copydb_drain_begin(void *context, uint64_t xid)
+{
+	SpoolDrainContext *drainContext = (SpoolDrainContext *) context;
+
+	drainContext->spool->pendingXid = xid;
+
+	return spool_update_drained(drainContext->catalog, drainContext->spool);
+}
+
+
+/*
+ * copydb_drain_segment COPY a single spool segment to the target database.
+ */
+static bool
+copydb_drain_segment(PGSQL *dst, CopySpool *spool, int segment,
+					 CopyArgs *args, char *buffer,
+					 CopyStats *stats,
+					 void *context,
+					 CopyStatsCallback *callback)
+{
+	char filename[MAXPGPATH] = { 0 };
+
+	spool_segment_filename(spool, segment, filename, sizeof(filename));
+
+	gzFile file = gzopen(filename, "rb");
+
+	if (file == NULL)
+	{
+		log_error("Failed to open spool segment \"%s\": %m", filename);
+		return false;
+	}
+
+	log_debug("Draining spool segment \"%s\"", filename);
+
+	if (!pg_copy_in_start(dst, args))
+	{
+		/* errors have already been logged */
+		(void) gzclose(file);
+		return false;
+	}
+
+	for (;;)
+	{
+		if (asked_to_quit || asked_to_stop || asked_to_stop_fast)
+		{
+			log_debug("COPY was asked to stop");
+
+			(void) gzclose(file);
+			(void) pg_copy_in_finish(dst, "pgcopydb was asked to stop");
+			return false;
+		}
+
+		int len = gzread(file, buffer, COPY_RELAY_BUFFER_SIZE);
+
+		if (len == 0)
+		{
+			break;
+		}
+
+		if (len < 0)
+		{
+			int errnum = 0;
+
+			log_error("Failed to read spool segment \"%s\": %s",
+					  filename,
+					  gzerror(file, &errnum));
+
+			(void) gzclose(file);
+			(void) pg_copy_in_finish(dst, "Failed to read spool segment");
+			return false;
+		}
+
+		if (!pg_copy_in_data(dst, buffer, len))
+		{
+			/* errors have already been logged */
+			(void) gzclose(file);
+			(void) pg_copy_in_finish(dst, "Failed to copy data to target");
+			return false;
+		}
+
+		stats->bytesTransmitted += len;
+
+		if (callback != NULL && !(*callback)(context, stats))
+		{
+			log_debug("Copy Stats Callback failed, see above for details");
+		}
+	}
+
+	(void) gzclose(file);
+
+	return pg_copy_in_finish(dst, NULL);
+}
+
+
+/*
+ * copydb_start_drain_workers create as many sub-process as needed, per
+ * --table-jobs, to COPY the data from the spool to the target database.
+ */
+bool
+copydb_start_drain_workers(CopyDataSpec *specs)
+{
+	log_info("STEP 4: starting %d table-data COPY spool drain processes",
+			 specs->tableJobs);
+
+	for (int i = 0; i < specs->tableJobs; i++)
+	{
+		/*
+		 * Flush stdio channels just before fork, to avoid
+		 * double-output problems.
+		 */
+		fflush(stdout);
+		fflush(stderr);
+
+		int fpid = fork();
+
+		switch (fpid)
+		{
+			case -1:
+			{
+				log_error("Failed to fork a COPY drain worker process: %m");
+				return false;
+			}
+
+			case 0:
+			{
+				/* child process runs the command */
+				(void) set_ps_title("pgcopydb: copy drain worker");
+
+				if (!copydb_drain_worker(specs))
+				{
+					/* errors have already been logged */
+					exit(EXIT_CODE_INTERNAL_ERROR);
+				}
+
+				exit(EXIT_CODE_QUIT);
+			}
+
+			default:
+			{
+				/* fork succeeded, in parent */
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+/*
+ * copydb_drain_worker is a worker process that loops over messages received
+ * from the drain queue, each message being the Oid and part number of a table
+ * that has been spooled already. The worker does not connect to the source
+ * database: the table data comes from the spool.
+ */
+bool
+copydb_drain_worker(CopyDataSpec *specs)
+{
+	uint64_t errors = 0;
+	pid_t pid = getpid();
+
+	log_notice("Started table-data COPY spool drain worker %d [%d]",
+			   pid,
+			   getppid());
+
+	PGSQL dst = { 0 };
+
+	/* initialize our connection to the target database */
+	if (!pgsql_init(&dst, specs->connStrings.target_pguri, PGSQL_CONN_TARGET))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* open connection to target and set GUC values */
+	if (!pgsql_set_gucs(&dst, dstSettings))
+	{
+		log_fatal("Failed to set our GUC settings on the target connection, "
+				  "see above for details");
+		return false;
+	}
+
+	if (!catalog_init_from_specs(specs))
+	{
+		log_error("Failed to open internal catalogs in COPY drain worker, "
+				  "see above for details");
+		return false;
+	}
+
+	bool stop = false;
+
+	while (!stop)
+	{
+		QMessage mesg = { 0 };
+		bool recv_ok = queue_receive(&(specs->drainQueue), &mesg);
+
+		if (asked_to_stop || asked_to_stop_fast || asked_to_quit)
+		{
+			log_error("COPY drain worker has been interrupted");
+			break;
+		}
+
+		if (!recv_ok)
+		{
+			log_error("COPY drain worker failed to receive a message from "
+					  "queue, see above for details");
+			break;
+		}
+
+		switch (mesg.type)
+		{
+			case QMSG_TYPE_STOP:
+			{
+				stop = true;
+				log_debug("Stop message received by COPY drain worker");
+				break;
+			}
+
+			case QMSG_TYPE_TABLEPOID:
+			{
+				if (!copydb_copy_data_by_oid(specs,
+											 NULL,
+											 &dst,
+											 mesg.data.tp.oid,
+											 mesg.data.tp.part))
+				{
+					log_error("Failed to drain data for table with oid %u "
+							  "and part number %u, see above for details",
+							  mesg.data.tp.oid,
+							  mesg.data.tp.part);
+
+					++errors;
+
+					if (specs->failFast)
+					{
+						pgsql_finish(&dst);
+						return false;
+					}
+				}
+				break;
+			}
+
+			default:
+			{
+				log_error("Received unknown message type %ld on drain queue %d",
+						  mesg.type,
+						  specs->drainQueue.qId);
+				break;
+			}
+		}
+	}
+
+	pgsql_finish(&dst);
+
+	if (!catalog_delete_process(&(specs->catalogs.source), pid))
+	{
+		log_warn("Failed to delete catalog process entry for pid %d", pid);
+	}
+
+	if (!catalog_close_from_specs(specs))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	return stop == true && errors == 0;
+}
+
+
+/*
+ * copydb_add_drain sends a message to the drain queue to process a given
+ * table, or a given table partition.
+ */
+bool
+copydb_add_drain(CopyDataSpec *specs, uint32_t oid, uint32_t part)
+{
+	QMessage mesg = {
+		.type = QMSG_TYPE_TABLEPOID,
+		.data.tp = { .oid = oid, .part = part }
+	};
+
+	if (!queue_send(&(specs->drainQueue), &mesg))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * copydb_drain_send_stop sends the STOP messages to the drain queue, one STOP
+ * message per worker.
+ */
+bool
+copydb_drain_send_stop(CopyDataSpec *specs)
+{
+	for (int i = 0; i < specs->tableJobs; i++)
+	{
+		QMessage stop = { .type = QMSG_TYPE_STOP };
+
+		if (!queue_send(&(specs->drainQueue), &stop))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/*
+ * copydb_spool_wait_for_workers waits until the given table-data workers are
+ * done spooling, leaving the other sub-processes (drain workers) alone.
+ */
+bool
+copydb_spool_wait_for_workers(CopyDataSpec *specs, pid_t *pids)
+{
+	bool success = true;
+	int running = specs->tableJobs;
+
+	while (running > 0)
+	{
+		running = 0;
+
+		for (int i = 0; i < specs->tableJobs; i++)
+		{
+			if (pids[i] <= 0)
+			{
+				continue;
+			}
+
+			bool exited = false;
+			int returnCode = -1;
+			int sig = 0;
+
+			if (!follow_wait_pid(pids[i], &exited, &returnCode, &sig))
+			{
+				/* errors have already been logged */
+				return false;
+			}
+
+			if (!exited)
+			{
+				++running;
+				continue;
+			}
+
+			if (returnCode != 0 || !signal_is_handled(sig))
+			{
+				log_error("COPY spool worker %d exited with code %d",
+						  pids[i],
+						  returnCode);
+
+				success = false;
+
+				if (specs->failFast)
+				{
+					log_error("Signaling other processes to terminate "
+							  "(see --fail-fast)");
+					(void) copydb_fatal_exit();
+				}
+			}
+
+			pids[i] = -1;
+		}
+
+		if (running > 0)
+		{
+			pg_usleep(150 * 1000); /* 150 ms */
+		}
+	}
+
+	log_info("All table data has been spooled, source reads are done");
+
+	return success;
+}
+
+
+/*
+ * copydb_spool_mark_done creates the given file to signal the process that
+ * holds the source snapshot that a part of the work is done.
+ */
+bool
+copydb_spool_mark_done(const char *filename)
+{
+	char pid[BUFSIZE] = { 0 };
+
+	sformat(pid, sizeof(pid), "%d\n", getpid());
+
+	if (!write_file(pid, strlen(pid), filename))
+	{
+		log_error("Failed to create file \"%s\"", filename);
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * copydb_spool_holds_snapshot returns true when the current process holds an
+ * open source snapshot that --spool may close early.
+ */
+static bool
+copydb_spool_holds_snapshot(CopyDataSpec *specs)
+{
+	TransactionSnapshot *snapshot = &(specs->sourceSnapshot);
+
+	return specs->useSpool &&
+		   snapshot->pid == getpid() &&
+		   (snapshot->state == SNAPSHOT_STATE_EXPORTED ||
+			snapshot->state == SNAPSHOT_STATE_SET);
+}
+
+
+/*
+ * copydb_spool_close_snapshot closes the source snapshot when all the table
+ * data, the large objects, and the extensions configuration tables have been
+ * read from the source database, which happens before the target database is
+ * done ingesting the data with --spool.
+ *
+ * Only the process that holds the snapshot closes it, this function is a
+ * no-op in other processes.
+ */
+bool
+copydb_spool_close_snapshot(CopyDataSpec *specs)
+{
+	if (!copydb_spool_holds_snapshot(specs))
+	{
+		return true;
+	}
+
+	SpoolPaths *spoolPaths = &(specs->cfPaths.spool);
+
+	if (!file_exists(spoolPaths->tablesDoneFile))
+	{
+		return true;
+	}
+
+	if (!specs->skipLargeObjects && !file_exists(spoolPaths->blobsDoneFile))
+	{
+		return true;
+	}
+
+	if (!specs->skipExtensions &&
+		!file_exists(spoolPaths->extensionsDoneFile))
+	{
+		return true;
+	}
+
+	log_info("Closing snapshot \"%s\" early, all the data has been spooled",
+			 specs->sourceSnapshot.snapshot);
+
+	return copydb_close_snapshot(specs);
+}
+
+
+/*
+ * copydb_spool_wait_for_snapshot waits until the source snapshot can be closed
+ * early, or until the given sub-process (the COPY supervisor) has exited.
+ * Returns false when the sub-process exited with an error, because it has now
+ * been waited for already.
+ */
+bool
+copydb_spool_wait_for_snapshot(CopyDataSpec *specs, pid_t pid)
+{
+	while (copydb_spool_holds_snapshot(specs))
+	{
+		if (asked_to_stop || asked_to_stop_fast || asked_to_quit)
+		{
+			return true;
+		}
+
+		if (!copydb_spool_close_snapshot(specs))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+
+		bool exited = false;
+		int returnCode = -1;
+		int sig = 0;
+
+		if (!follow_wait_pid(pid, &exited, &returnCode, &sig))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+
+		if (exited)
+		{
+			if (returnCode != 0 || !signal_is_handled(sig))
+			{
+				log_error("COPY supervisor %d exited with code %d",
+						  pid,
+						  returnCode);
+				return false;
+			}
+
+			return true;
+		}
+
+		pg_usleep(150 * 1000); /* 150 ms */
+	}
+
+	return true;
+}
+
+
+/*
+ * spool_init_table initializes a CopySpool for the given table (part).
+ */
+bool
+spool_init_table(CopyDataSpec *specs,
+				 CopyTableDataSpec *tableSpecs,
+				 CopySpool *spool)
+{
+	SourceTable *table = tableSpecs->sourceTable;
+
+	spool->oid = table->oid;
+	spool->partNumber = table->partition.partNumber;
+
+	sformat(spool->dir, sizeof(spool->dir), "%s/%u.%d",
+			specs->cfPaths.spool.dir,
+			spool->oid,
+			spool->partNumber);
+
+	return true;
+}
+
+
+/*
+ * spool_lookup_table fetches the spool entry for the given table (part) from
+ * our internal catalogs. When not found, spoolTime is zero.
+ */
+bool
+spool_lookup_table(DatabaseCatalog *catalog, CopySpool *spool)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: spool_lookup_table: db is NULL");
+		return false;
+	}
+
+	char *sql =
+		"  select pid, segments, bytes, spool_time_epoch, "
+		"         drained, drain_time_epoch, pending_xid "
+		"    from spool "
+		"   where tableoid = $1 and partnum = $2";
+
+	if (!semaphore_lock(&(catalog->sema)))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	SQLiteQuery query = {
+		.context = spool,
+		.fetchFunction = &spool_fetch
+	};
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", spool->oid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "partnum", spool->partNumber, NULL }
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* now execute the query, which return exactly one row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	(void) semaphore_unlock(&(catalog->sema));
+
+	return true;
+}
+
+
+/*
+ * spool_fetch fetches a CopySpool entry from a SQLite ppStmt result set.
+ */
+static bool
+spool_fetch(SQLiteQuery *query)
+{
+	CopySpool *spool = (CopySpool *) query->context;
+
+	spool->pid = sqlite3_column_int64(query->ppStmt, 0);
+	spool->segments = sqlite3_column_int(query->ppStmt, 1);
+	spool->bytes = sqlite3_column_int64(query->ppStmt, 2);
+	spool->spoolTime = sqlite3_column_int64(query->ppStmt, 3);
+	spool->drained = sqlite3_column_int(query->ppStmt, 4);
+	spool->drainTime = sqlite3_column_int64(query->ppStmt, 5);
+	spool->pendingXid = sqlite3_column_int64(query->ppStmt, 6);
+
+	return true;
+}
+
+
+/*
+ * spool_add_table registers a complete spool for the given table (part).
+ */
+bool
+spool_add_table(DatabaseCatalog *catalog, CopySpool *spool)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: spool_add_table: db is NULL");
+		return false;
+	}
+
+	char *sql =
+		"insert or replace into spool"
+		"(tableoid, partnum, pid, segments, bytes, spool_time_epoch, "
+		" drained, drain_time_epoch, pending_xid) "
+		"values($1, $2, $3, $4, $5, $6, 0, 0, 0)";
+
+	if (!semaphore_lock(&(catalog->sema)))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	SQLiteQuery query = { 0 };
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", spool->oid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "partnum", spool->partNumber, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "pid", spool->pid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "segments", spool->segments, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "bytes", spool->bytes, NULL },
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "spool_time_epoch",
+			spool->spoolTime, NULL
+		}
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* now execute the query, which does not return any row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	(void) semaphore_unlock(&(catalog->sema));
+
+	return true;
+}
+
+
+/*
+ * spool_update_drained registers how many segments of the spool have been
+ * drained to the target database already, and the target transaction id of
+ * the segment being drained, if any.
+ */
+bool
+spool_update_drained(DatabaseCatalog *catalog, CopySpool *spool)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: spool_update_drained: db is NULL");
+		return false;
+	}
+
+	char *sql =
+		"update spool set drained = $1, drain_time_epoch = $2, "
+		"                 pending_xid = $3 "
+		" where tableoid = $4 and partnum = $5";
+
+	if (!semaphore_lock(&(catalog->sema)))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	SQLiteQuery query = { 0 };
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "drained", spool->drained, NULL },
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "drain_time_epoch",
+			spool->drainTime, NULL
+		},
+
+		{ BIND_PARAMETER_TYPE_INT64, "pending_xid", spool->pendingXid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", spool->oid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "partnum", spool->partNumber, NULL }
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* now execute the query, which does not return any row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	(void) semaphore_unlock(&(catalog->sema));
+
+	return true;
+}
+
+
+/*
+ * spool_delete_table removes the spool entry for the given table (part).
+ */
+bool
+spool_delete_table(DatabaseCatalog *catalog, CopySpool *spool)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: spool_delete_table: db is NULL");
+		return false;
+	}
+
+	char *sql = "delete from spool where tableoid = $1 and partnum = $2";
+
+	if (!semaphore_lock(&(catalog->sema)))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	SQLiteQuery query = { 0 };
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", spool->oid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "partnum", spool->partNumber, NULL }
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* now execute the query, which does not return any row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	(void) semaphore_unlock(&(catalog->sema));
+
+	return true;
+}
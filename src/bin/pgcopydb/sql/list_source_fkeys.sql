@@ -0,0 +1,19 @@
+-- $1::oid[] : table OIDs from s_table (NULL means no filter)
+--
+-- Foreign key constraints of the plain tables, partitioned tables are left
+-- to pg_restore.
+SELECT c.oid,
+       c.conrelid,
+       c.confrelid,
+       format('%I.%I', n.nspname, r.relname) AS qname,
+       format('%I', c.conname) AS conname,
+       c.convalidated,
+       r.relpages * current_setting('block_size')::bigint AS bytes,
+       pg_catalog.pg_get_constraintdef(c.oid) AS condef
+  FROM pg_catalog.pg_constraint c
+       JOIN pg_catalog.pg_class r ON r.oid = c.conrelid
+       JOIN pg_catalog.pg_namespace n ON n.oid = r.relnamespace
+ WHERE c.contype = 'f'
+   AND r.relkind = 'r'
+   AND ($1::oid[] IS NULL OR c.conrelid = ANY($1::oid[]))
+ORDER BY c.conrelid, c.oid;
@@ -0,0 +1,93 @@
+-- $1::oid[] : table OIDs from s_table (NULL means no filter)
+--
+-- Planner statistics of the tables, as one SELECT statement per table that
+-- calls the Postgres 18 statistics import functions. Tables with extended
+-- statistics, with expression indexes (which have statistics of their own),
+-- or that have never been analyzed, are left to ANALYZE.
+--
+-- The range type statistics columns only exist in pg_stats from Postgres 17
+-- onward, so they are read from the row as jsonb, and are NULL before that.
+WITH tables AS (
+    SELECT c.oid, n.nspname, c.relname,
+           c.relpages, c.reltuples, c.relallvisible
+      FROM pg_catalog.pg_class c
+           JOIN pg_catalog.pg_namespace n ON n.oid = c.relnamespace
+     WHERE c.relkind IN ('r', 'm')
+       AND ($1::oid[] IS NULL OR c.oid = ANY($1::oid[]))
+       AND EXISTS (SELECT 1
+                     FROM pg_catalog.pg_stats s
+                    WHERE s.schemaname = n.nspname
+                      AND s.tablename = c.relname)
+       AND NOT EXISTS (SELECT 1
+                         FROM pg_catalog.pg_statistic_ext e
+                        WHERE e.stxrelid = c.oid)
+       AND NOT EXISTS (SELECT 1
+                         FROM pg_catalog.pg_index i
+                        WHERE i.indrelid = c.oid
+                          AND i.indexprs IS NOT NULL)
+)
+SELECT t.oid,
+       format('SELECT pg_catalog.pg_restore_relation_stats('
+              '''schemaname'', %L, ''relname'', %L, '
+              '''version'', %s::integer, '
+              '''relpages'', %s::integer, '
+              '''reltuples'', %s::real, '
+              '''relallvisible'', %s::integer)',
+              t.nspname, t.relname,
+              current_setting('server_version_num'),
+              t.relpages, t.reltuples, t.relallvisible)
+       || string_agg(
+           format(' UNION ALL SELECT pg_catalog.pg_restore_attribute_stats('
+                  '''schemaname'', %L, ''relname'', %L, '
+                  '''attname'', %L::name, ''inherited'', %L::boolean, '
+                  '''version'', %s::integer, ',
+                  s.schemaname, s.tablename, s.attname, s.inherited,
+                  current_setting('server_version_num'))
+           || concat_ws(', ',
+                format('''null_frac'', %L::real', s.null_frac),
+                format('''avg_width'', %L::integer', s.avg_width),
+                format('''n_distinct'', %L::real', s.n_distinct),
+                CASE WHEN s.most_common_vals IS NOT NULL
+                     THEN format('''most_common_vals'', %L::text',
+                                 s.most_common_vals::text) END,
+                CASE WHEN s.most_common_freqs IS NOT NULL
+                     THEN format('''most_common_freqs'', %L::real[]',
+                                 s.most_common_freqs) END,
+                CASE WHEN s.histogram_bounds IS NOT NULL
+                     THEN format('''histogram_bounds'', %L::text',
+                                 s.histogram_bounds::text) END,
+                CASE WHEN s.correlation IS NOT NULL
+                     THEN format('''correlation'', %L::real',
+                                 s.correlation) END,
+                CASE WHEN s.most_common_elems IS NOT NULL
+                     THEN format('''most_common_elems'', %L::text',
+                                 s.most_common_elems::text) END,
+                CASE WHEN s.most_common_elem_freqs IS NOT NULL
+                     THEN format('''most_common_elem_freqs'', %L::real[]',
+                                 s.most_common_elem_freqs) END,
+                CASE WHEN s.elem_count_histogram IS NOT NULL
+                     THEN format('''elem_count_histogram'', %L::real[]',
+                                 s.elem_count_histogram) END,
+                CASE WHEN r.j->'range_length_histogram' <> 'null'
+                     THEN format('''range_length_histogram'', %L::text',
+                                 ARRAY(SELECT jsonb_array_elements_text(
+                                         r.j->'range_length_histogram'))::text)
+                END,
+                CASE WHEN r.j->'range_empty_frac' <> 'null'
+                     THEN format('''range_empty_frac'', %L::real',
+                                 r.j->>'range_empty_frac') END,
+                CASE WHEN r.j->'range_bounds_histogram' <> 'null'
+                     THEN format('''range_bounds_histogram'', %L::text',
+                                 ARRAY(SELECT jsonb_array_elements_text(
+                                         r.j->'range_bounds_histogram'))::text)
+                END)
+           || ')',
+           '' ORDER BY s.attname, s.inherited) AS sql
+  FROM tables t
+       JOIN pg_catalog.pg_stats s
+         ON s.schemaname = t.nspname
+        AND s.tablename = t.relname
+       CROSS JOIN LATERAL (SELECT to_jsonb(s) AS j) AS r
+GROUP BY t.oid, t.nspname, t.relname,
+         t.relpages, t.reltuples, t.relallvisible
+ORDER BY t.oid;
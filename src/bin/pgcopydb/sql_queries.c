@@ -137,6 +137,14 @@ pgcopydb_sql_list_source_depend(const char **sql)
 }
 
 
+bool
+pgcopydb_sql_list_source_fkeys(const char **sql)
+{
+	*sql = sql_list_source_fkeys;
+	return true;
+}
+
+
 bool
 pgcopydb_sql_list_source_table_size(const char **sql)
 {
@@ -155,6 +163,14 @@ pgcopydb_sql_list_table_attributes(int pg_version, const char **sql)
 }
 
 
+bool
+pgcopydb_sql_list_source_table_stats(const char **sql)
+{
+	*sql = sql_list_source_table_stats;
+	return true;
+}
+
+
 bool
 pgcopydb_sql_filter_table_arrays(const char **sql)
 {
@@ -31,7 +31,9 @@ bool pgcopydb_sql_list_filtered_excl_tables(const char **sql);
 bool pgcopydb_sql_list_source_indexes(const char **sql);
 bool pgcopydb_sql_list_source_sequences(const char **sql);
 bool pgcopydb_sql_list_source_depend(const char **sql);
+bool pgcopydb_sql_list_source_fkeys(const char **sql);
 bool pgcopydb_sql_list_source_table_size(const char **sql);
+bool pgcopydb_sql_list_source_table_stats(const char **sql);
 
 bool pgcopydb_sql_list_table_attributes(int pg_version, const char **sql);
 
@@ -264,6 +264,47 @@ stringToUInt32(const char *str, uint32_t *number)
 }
 
 
+/*
+ * converts given string to a double precision floating point value.
+ * returns false upon failure
+ */
+bool
+stringToDouble(const char *str, double *number)
+{
+	char *endptr;
+
+	if (str == NULL)
+	{
+		return false;
+	}
+
+	if (number == NULL)
+	{
+		return false;
+	}
+
+	errno = 0;
+	double n = strtod(str, &endptr);
+
+	if (str == endptr)
+	{
+		return false;
+	}
+	else if (errno != 0)
+	{
+		return false;
+	}
+	else if (*endptr != '\0')
+	{
+		return false;
+	}
+
+	*number = n;
+
+	return true;
+}
+
+
 /*
  * converts given hexadecimal string to 32 bit unsigned int value.
  * returns 0 upon failure and sets error flag
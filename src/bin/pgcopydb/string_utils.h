@@ -35,6 +35,8 @@ bool stringToUInt64(const char *str, uint64_t *number);
 
 bool stringToUInt32(const char *str, uint32_t *number);
 
+bool stringToDouble(const char *str, double *number);
+
 bool hexStringToUInt32(const char *str, uint32_t *number);
 
 bool IntervalToString(uint64_t millisecs, char *buffer, size_t size);
@@ -64,6 +64,34 @@ TopLevelTiming topLevelTimingArray[] = {
 		.conn = "both",
 		.jobsMask = TIMING_TABLE_JOBS
 	},
+	{
+		.section = TIMING_SECTION_COPY_RETRY,
+		.label = "COPY retries (cumulative)",
+		.cumulative = true,
+		.conn = "both",
+		.jobsMask = TIMING_TABLE_JOBS
+	},
+	{
+		.section = TIMING_SECTION_COPY_SRC_WAIT,
+		.label = "COPY source wait (cumulative)",
+		.cumulative = true,
+		.conn = "source",
+		.jobsMask = TIMING_TABLE_JOBS
+	},
+	{
+		.section = TIMING_SECTION_COPY_DST_WAIT,
+		.label = "COPY target wait (cumulative)",
+		.cumulative = true,
+		.conn = "target",
+		.jobsMask = TIMING_TABLE_JOBS
+	},
+	{
+		.section = TIMING_SECTION_COPY_CLIENT,
+		.label = "COPY client time (cumulative)",
+		.cumulative = true,
+		.conn = "both",
+		.jobsMask = TIMING_TABLE_JOBS
+	},
 	{
 		.section = TIMING_SECTION_CREATE_INDEX,
 		.label = "CREATE INDEX (cumulative)",
@@ -85,6 +113,13 @@ TopLevelTiming topLevelTimingArray[] = {
 		.conn = "target",
 		.jobsMask = TIMING_VACUUM_JOBS
 	},
+	{
+		.section = TIMING_SECTION_SET_LOGGED,
+		.label = "SET LOGGED (cumulative)",
+		.cumulative = true,
+		.conn = "target",
+		.jobsMask = TIMING_INDEX_JOBS
+	},
 	{
 		.section = TIMING_SECTION_SET_SEQUENCES,
 		.label = "Reset Sequences",
@@ -98,6 +133,13 @@ TopLevelTiming topLevelTimingArray[] = {
 		.conn = "both",
 		.jobsMask = TIMING_LOBJECTS_JOBS
 	},
+	{
+		.section = TIMING_SECTION_CONN_REUSE,
+		.label = "Connection set-up saved (cumulative)",
+		.cumulative = true,
+		.conn = "both",
+		.jobsMask = TIMING_INDEX_JOBS | TIMING_VACUUM_JOBS | TIMING_LOBJECTS_JOBS
+	},
 	{
 		.section = TIMING_SECTION_FINALIZE_SCHEMA,
 		.label = "Finalize Schema",
@@ -147,6 +189,14 @@ static bool prepare_summary_table_hook(void *context, SourceTable *table);
 static bool prepare_summary_table_index_hook(void *ctx, SourceIndex *index);
 static bool summary_prepare_toplevel_durations_hook(void *ctx,
 													TopLevelTiming *timing);
+static bool summary_unlogged_fetch(SQLiteQuery *query);
+static bool summary_table_truncate_fetch(SQLiteQuery *query);
+
+typedef struct TruncateStateContext
+{
+	char *state;
+	size_t size;
+} TruncateStateContext;
 
 
 /*
@@ -345,34 +395,31 @@ summary_delete_table(DatabaseCatalog *catalog, CopyTableDataSpec *tableSpecs)
 
 
 /*
- * summary_delete_incomplete_table_copy removes every summary row for a table
- * COPY that started but never finished (done_time_epoch IS NULL).  These
- * rows carry a pid from the previous run.  On a resumed run the existing
- * code calls kill(old_pid, 0) to decide whether that pid is still alive;
- * inside a Docker container whose PID namespace was reset the same numeric
- * pid is often reused by an unrelated process, so kill() returns 0 and
- * pgcopydb incorrectly refuses to copy the table (issue #692).
- *
- * Deleting the incomplete rows here, before any worker is forked, turns the
- * affected tables back into "not yet started" so that workers copy them from
- * scratch.  Completed rows (done_time_epoch IS NOT NULL) are preserved so
- * that --resume still skips tables that finished in the previous run.
+ * summary_lookup_table_targets looks-up the per-target summary entries of a
+ * table (partition) in our catalogs. With --fanout-target, this allows
+ * skipping the targets that already received the table data in a previous
+ * attempt or a previous run.
  */
 bool
-summary_delete_incomplete_table_copy(DatabaseCatalog *catalog)
+summary_lookup_table_targets(DatabaseCatalog *catalog,
+							 CopyTableDataSpec *tableSpecs)
 {
 	sqlite3 *db = catalog->db;
 
 	if (db == NULL)
 	{
-		log_error("BUG: summary_delete_incomplete_table_copy: db is NULL");
+		log_error("BUG: summary_lookup_table_targets: db is NULL");
 		return false;
 	}
 
+	SourceTable *table = tableSpecs->sourceTable;
+	CopyTableSummary *tableSummary = &(tableSpecs->summary);
+
 	char *sql =
-		"delete from summary "
-		" where tableoid is not null "
-		"   and done_time_epoch is null";
+		"  select target, pid, done_time_epoch, bytes, stalls "
+		"    from summary_target "
+		"   where tableoid = $1 and partnum = $2 "
+		"order by target";
 
 	if (!semaphore_lock(&(catalog->sema)))
 	{
@@ -380,7 +427,10 @@ summary_delete_incomplete_table_copy(DatabaseCatalog *catalog)
 		return false;
 	}
 
-	SQLiteQuery query = { 0 };
+	SQLiteQuery query = {
+		.context = tableSummary,
+		.fetchFunction = &summary_table_target_fetch
+	};
 
 	if (!catalog_sql_prepare(db, sql, &query))
 	{
@@ -389,7 +439,49 @@ summary_delete_incomplete_table_copy(DatabaseCatalog *catalog)
 		return false;
 	}
 
-	if (!catalog_sql_execute_once(&query))
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL },
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "partnum",
+			table->partition.partNumber, NULL
+		},
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	int rc;
+
+	while ((rc = catalog_sql_step(&query)) == SQLITE_ROW)
+	{
+		if (!summary_table_target_fetch(&query))
+		{
+			/* errors have already been logged */
+			(void) catalog_sql_finalize(&query);
+			(void) semaphore_unlock(&(catalog->sema));
+			return false;
+		}
+	}
+
+	if (rc != SQLITE_DONE)
+	{
+		log_error("Failed to step through statement: %s", query.sql);
+		log_error("[SQLite] %s", sqlite3_errmsg(query.db));
+
+		(void) catalog_sql_finalize(&query);
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	if (!catalog_sql_finalize(&query))
 	{
 		/* errors have already been logged */
 		(void) semaphore_unlock(&(catalog->sema));
@@ -403,38 +495,62 @@ summary_delete_incomplete_table_copy(DatabaseCatalog *catalog)
 
 
 /*
- * summary_add_table INSERTs a SourceTable summary entry to our internal
- * catalogs database.
+ * summary_table_target_fetch fetches a CopyTargetSummary entry from a SQLite
+ * ppStmt result set.
  */
 bool
-summary_add_table(DatabaseCatalog *catalog, CopyTableDataSpec *tableSpecs)
+summary_table_target_fetch(SQLiteQuery *query)
 {
-	sqlite3 *db = catalog->db;
+	CopyTableSummary *tableSummary = (CopyTableSummary *) query->context;
 
-	if (db == NULL)
+	int target = sqlite3_column_int(query->ppStmt, 0);
+
+	if (target < 0 || target >= COPY_MAX_TARGETS)
 	{
-		log_error("BUG: summary_add_table: db is NULL");
+		log_error("Failed to fetch summary for target %d, "
+				  "pgcopydb supports up to %d targets",
+				  target,
+				  COPY_MAX_TARGETS);
 		return false;
 	}
 
-	SourceTable *table = tableSpecs->sourceTable;
-	CopyTableSummary *tableSummary = &(tableSpecs->summary);
+	CopyTargetSummary *targetSummary = &(tableSummary->targets[target]);
 
-	tableSummary->pid = getpid();
-	tableSummary->table = tableSpecs->sourceTable;
+	targetSummary->target = target;
+	targetSummary->pid = sqlite3_column_int64(query->ppStmt, 1);
+	targetSummary->doneTime = sqlite3_column_int64(query->ppStmt, 2);
+	targetSummary->bytesTransmitted = sqlite3_column_int64(query->ppStmt, 3);
+	targetSummary->stalls = sqlite3_column_int64(query->ppStmt, 4);
+	targetSummary->done = targetSummary->doneTime > 0;
 
-	if (!table_summary_init(tableSummary))
+	return true;
+}
+
+
+/*
+ * summary_finish_table_target INSERTs the summary entry for the given table
+ * (partition) and target, once the COPY is done on that target.
+ */
+bool
+summary_finish_table_target(DatabaseCatalog *catalog,
+							CopyTableDataSpec *tableSpecs,
+							int target)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
 	{
-		log_error("Failed to initialize table summary for pid %d and "
-				  "table %s",
-				  getpid(),
-				  table->qname);
+		log_error("BUG: summary_finish_table_target: db is NULL");
 		return false;
 	}
 
+	SourceTable *table = tableSpecs->sourceTable;
+	CopyTargetSummary *targetSummary = &(tableSpecs->summary.targets[target]);
+
 	char *sql =
-		"insert or replace into summary(pid, tableoid, partnum, start_time_epoch, command)"
-		"values($1, $2, $3, $4, $5)";
+		"insert or replace into summary_target"
+		"(tableoid, partnum, target, pid, done_time_epoch, bytes, stalls) "
+		"values($1, $2, $3, $4, $5, $6, $7)";
 
 	if (!semaphore_lock(&(catalog->sema)))
 	{
@@ -453,7 +569,6 @@ summary_add_table(DatabaseCatalog *catalog, CopyTableDataSpec *tableSpecs)
 
 	/* bind our parameters now */
 	BindParam params[] = {
-		{ BIND_PARAMETER_TYPE_INT64, "pid", tableSummary->pid, NULL },
 		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL },
 
 		{
@@ -461,15 +576,20 @@ summary_add_table(DatabaseCatalog *catalog, CopyTableDataSpec *tableSpecs)
 			table->partition.partNumber, NULL
 		},
 
+		{ BIND_PARAMETER_TYPE_INT64, "target", target, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "pid", targetSummary->pid, NULL },
+
 		{
-			BIND_PARAMETER_TYPE_INT64, "start_time_epoch",
-			tableSummary->startTime, NULL
+			BIND_PARAMETER_TYPE_INT64, "done_time_epoch",
+			targetSummary->doneTime, NULL
 		},
 
 		{
-			BIND_PARAMETER_TYPE_TEXT, "command",
-			0, (char *) tableSummary->command
-		}
+			BIND_PARAMETER_TYPE_INT64, "bytes",
+			targetSummary->bytesTransmitted, NULL
+		},
+
+		{ BIND_PARAMETER_TYPE_INT64, "stalls", targetSummary->stalls, NULL }
 	};
 
 	int count = sizeof(params) / sizeof(params[0]);
@@ -496,32 +616,29 @@ summary_add_table(DatabaseCatalog *catalog, CopyTableDataSpec *tableSpecs)
 
 
 /*
- * summary_finish_table UPDATEs a SourceTable summary entry to our internal
- * catalogs database.
+ * summary_lookup_table_targets_total computes the per-target totals of a
+ * table COPY, summing up all the table parts, for the summary report.
  */
 bool
-summary_finish_table(DatabaseCatalog *catalog, CopyTableDataSpec *tableSpecs)
+summary_lookup_table_targets_total(DatabaseCatalog *catalog,
+								   uint32_t tableoid,
+								   CopyTargetSummary *targets,
+								   int *count)
 {
 	sqlite3 *db = catalog->db;
 
 	if (db == NULL)
 	{
-		log_error("BUG: summary_finish_table: db is NULL");
-		return false;
-	}
-
-	SourceTable *table = tableSpecs->sourceTable;
-	CopyTableSummary *tableSummary = &(tableSpecs->summary);
-
-	if (!table_summary_finish(tableSummary))
-	{
-		log_error("Failed to finish summary for table %s", table->qname);
+		log_error("BUG: summary_lookup_table_targets_total: db is NULL");
 		return false;
 	}
 
 	char *sql =
-		"update summary set done_time_epoch = $1, duration = $2, bytes = $3 "
-		"where pid = $4 and tableoid = $5 and partnum = $6";
+		"  select target, count(*), sum(bytes), sum(stalls) "
+		"    from summary_target "
+		"   where tableoid = $1 "
+		"group by target "
+		"order by target";
 
 	if (!semaphore_lock(&(catalog->sema)))
 	{
@@ -540,40 +657,102 @@ summary_finish_table(DatabaseCatalog *catalog, CopyTableDataSpec *tableSpecs)
 
 	/* bind our parameters now */
 	BindParam params[] = {
-		{
-			BIND_PARAMETER_TYPE_INT64, "done_time_epoch",
-			tableSummary->doneTime, NULL
-		},
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", tableoid, NULL }
+	};
 
-		{
-			BIND_PARAMETER_TYPE_INT64, "duration",
-			tableSummary->durationMs, NULL
-		},
+	if (!catalog_sql_bind(&query, params, 1))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
 
-		{
-			BIND_PARAMETER_TYPE_INT64, "bytes",
-			tableSummary->bytesTransmitted, NULL
-		},
+	int rc;
 
-		{ BIND_PARAMETER_TYPE_INT64, "pid", getpid(), NULL },
-		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL },
+	*count = 0;
 
-		{
-			BIND_PARAMETER_TYPE_INT64, "partnum",
-			table->partition.partNumber, NULL
-		}
-	};
+	while ((rc = catalog_sql_step(&query)) == SQLITE_ROW &&
+		   *count < COPY_MAX_TARGETS)
+	{
+		CopyTargetSummary *target = &(targets[*count]);
 
-	int count = sizeof(params) / sizeof(params[0]);
+		target->target = sqlite3_column_int(query.ppStmt, 0);
+		target->parts = sqlite3_column_int64(query.ppStmt, 1);
+		target->bytesTransmitted = sqlite3_column_int64(query.ppStmt, 2);
+		target->stalls = sqlite3_column_int64(query.ppStmt, 3);
+		target->done = true;
 
-	if (!catalog_sql_bind(&query, params, count))
+		++(*count);
+	}
+
+	if (rc != SQLITE_DONE && rc != SQLITE_ROW)
+	{
+		log_error("Failed to step through statement: %s", query.sql);
+		log_error("[SQLite] %s", sqlite3_errmsg(query.db));
+
+		(void) catalog_sql_finalize(&query);
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	if (!catalog_sql_finalize(&query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	(void) semaphore_unlock(&(catalog->sema));
+
+	return true;
+}
+
+
+/*
+ * summary_delete_incomplete_table_copy removes every summary row for a table
+ * COPY that started but never finished (done_time_epoch IS NULL).  These
+ * rows carry a pid from the previous run.  On a resumed run the existing
+ * code calls kill(old_pid, 0) to decide whether that pid is still alive;
+ * inside a Docker container whose PID namespace was reset the same numeric
+ * pid is often reused by an unrelated process, so kill() returns 0 and
+ * pgcopydb incorrectly refuses to copy the table (issue #692).
+ *
+ * Deleting the incomplete rows here, before any worker is forked, turns the
+ * affected tables back into "not yet started" so that workers copy them from
+ * scratch.  Completed rows (done_time_epoch IS NOT NULL) are preserved so
+ * that --resume still skips tables that finished in the previous run.
+ */
+bool
+summary_delete_incomplete_table_copy(DatabaseCatalog *catalog)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: summary_delete_incomplete_table_copy: db is NULL");
+		return false;
+	}
+
+	char *sql =
+		"delete from summary "
+		" where tableoid is not null "
+		"   and done_time_epoch is null";
+
+	if (!semaphore_lock(&(catalog->sema)))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	SQLiteQuery query = { 0 };
+
+	if (!catalog_sql_prepare(db, sql, &query))
 	{
 		/* errors have already been logged */
 		(void) semaphore_unlock(&(catalog->sema));
 		return false;
 	}
 
-	/* now execute the query, which does not return any row */
 	if (!catalog_sql_execute_once(&query))
 	{
 		/* errors have already been logged */
@@ -588,28 +767,963 @@ summary_finish_table(DatabaseCatalog *catalog, CopyTableDataSpec *tableSpecs)
 
 
 /*
- * summary_update_table_copy_stats UPDATEs a summary entry to our internal
- * catalogs database with the current COPY statistics, typically while the COPY
- * command is running.
+ * summary_add_table INSERTs a SourceTable summary entry to our internal
+ * catalogs database.
  */
 bool
-summary_update_table_copy_stats(DatabaseCatalog *catalog,
-								CopyTableDataSpec *tableSpecs)
+summary_add_table(DatabaseCatalog *catalog, CopyTableDataSpec *tableSpecs)
 {
 	sqlite3 *db = catalog->db;
 
 	if (db == NULL)
 	{
-		log_error("BUG: summary_update_table_copy_stats: db is NULL");
+		log_error("BUG: summary_add_table: db is NULL");
+		return false;
+	}
+
+	SourceTable *table = tableSpecs->sourceTable;
+	CopyTableSummary *tableSummary = &(tableSpecs->summary);
+
+	tableSummary->pid = getpid();
+	tableSummary->table = tableSpecs->sourceTable;
+
+	if (!table_summary_init(tableSummary))
+	{
+		log_error("Failed to initialize table summary for pid %d and "
+				  "table %s",
+				  getpid(),
+				  table->qname);
+		return false;
+	}
+
+	char *sql =
+		"insert or replace into summary(pid, tableoid, partnum, start_time_epoch, command)"
+		"values($1, $2, $3, $4, $5)";
+
+	if (!semaphore_lock(&(catalog->sema)))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	SQLiteQuery query = { 0 };
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "pid", tableSummary->pid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL },
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "partnum",
+			table->partition.partNumber, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "start_time_epoch",
+			tableSummary->startTime, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_TEXT, "command",
+			0, (char *) tableSummary->command
+		}
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* now execute the query, which does not return any row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	(void) semaphore_unlock(&(catalog->sema));
+
+	return true;
+}
+
+
+/*
+ * summary_finish_table UPDATEs a SourceTable summary entry to our internal
+ * catalogs database.
+ */
+bool
+summary_finish_table(DatabaseCatalog *catalog, CopyTableDataSpec *tableSpecs)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: summary_finish_table: db is NULL");
+		return false;
+	}
+
+	SourceTable *table = tableSpecs->sourceTable;
+	CopyTableSummary *tableSummary = &(tableSpecs->summary);
+
+	if (!table_summary_finish(tableSummary))
+	{
+		log_error("Failed to finish summary for table %s", table->qname);
+		return false;
+	}
+
+	char *sql =
+		"update summary set done_time_epoch = $1, duration = $2, bytes = $3, "
+		"       ring_depth = $4, ring_samples = $5, ring_occupancy = $6, "
+		"       ring_full = $7, ring_empty = $8, wal_skipped = $9, "
+		"       frozen = $10, retries = $11, retry_duration = $12, "
+		"       copy_rows = $13, copy_messages = $14, "
+		"       src_wait = $15, dst_wait = $16, "
+		"       throttle_wait = $17, client_time = $18 "
+		"where pid = $19 and tableoid = $20 and partnum = $21";
+
+	if (!semaphore_lock(&(catalog->sema)))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	SQLiteQuery query = { 0 };
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{
+			BIND_PARAMETER_TYPE_INT64, "done_time_epoch",
+			tableSummary->doneTime, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "duration",
+			tableSummary->durationMs, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "bytes",
+			tableSummary->bytesTransmitted, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "ring_depth",
+			tableSummary->ringDepth, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "ring_samples",
+			tableSummary->ringSamples, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "ring_occupancy",
+			tableSummary->ringOccupancy, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "ring_full",
+			tableSummary->ringFull, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "ring_empty",
+			tableSummary->ringEmpty, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT, "wal_skipped",
+			tableSummary->walSkipped ? 1 : 0, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT, "frozen",
+			tableSummary->frozen ? 1 : 0, NULL
+		},
+
+		{ BIND_PARAMETER_TYPE_INT64, "retries", tableSummary->retries, NULL },
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "retry_duration",
+			tableSummary->retryMs, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "copy_rows",
+			tableSummary->copyRows, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "copy_messages",
+			tableSummary->copyMessages, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "src_wait",
+			tableSummary->srcWaitMs, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "dst_wait",
+			tableSummary->dstWaitMs, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "throttle_wait",
+			tableSummary->throttleMs, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "client_time",
+			tableSummary->clientMs, NULL
+		},
+
+		{ BIND_PARAMETER_TYPE_INT64, "pid", getpid(), NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL },
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "partnum",
+			table->partition.partNumber, NULL
+		}
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* now execute the query, which does not return any row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	(void) semaphore_unlock(&(catalog->sema));
+
+	return true;
+}
+
+
+/*
+ * summary_update_table_copy_stats UPDATEs a summary entry to our internal
+ * catalogs database with the current COPY statistics, typically while the COPY
+ * command is running.
+ */
+bool
+summary_update_table_copy_stats(DatabaseCatalog *catalog,
+								CopyTableDataSpec *tableSpecs)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: summary_update_table_copy_stats: db is NULL");
+		return false;
+	}
+
+	SourceTable *table = tableSpecs->sourceTable;
+	CopyTableSummary *tableSummary = &(tableSpecs->summary);
+
+	char *sql =
+		"update summary set duration = $1, bytes = $2, "
+		"       copy_rows = $3, copy_messages = $4, "
+		"       src_wait = $5, dst_wait = $6, "
+		"       throttle_wait = $7, client_time = $8 "
+		"where pid = $9 and tableoid = $10 and partnum = $11";
+
+	if (!semaphore_lock(&(catalog->sema)))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	SQLiteQuery query = { 0 };
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{
+			BIND_PARAMETER_TYPE_INT64, "duration",
+			tableSummary->durationMs, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "bytes",
+			tableSummary->bytesTransmitted, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "copy_rows",
+			tableSummary->copyRows, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "copy_messages",
+			tableSummary->copyMessages, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "src_wait",
+			tableSummary->srcWaitMs, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "dst_wait",
+			tableSummary->dstWaitMs, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "throttle_wait",
+			tableSummary->throttleMs, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "client_time",
+			tableSummary->clientMs, NULL
+		},
+
+		{ BIND_PARAMETER_TYPE_INT64, "pid", getpid(), NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL },
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "partnum",
+			table->partition.partNumber, NULL
+		}
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* now execute the query, which does not return any row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	(void) semaphore_unlock(&(catalog->sema));
+
+	return true;
+}
+
+
+/*
+ * summary_table_all_parts_done sets tableSpecs->allPartsAreDone to true when
+ * all the parts have already been done in the summary table of our internal
+ * catalogs.
+ */
+bool
+summary_table_count_parts_done(DatabaseCatalog *catalog,
+							   CopyTableDataSpec *tableSpecs)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: summary_table_count_parts_done: db is NULL");
+		return false;
+	}
+
+	SourceTable *table = tableSpecs->sourceTable;
+
+	char *sql =
+		"select count(s.oid), "
+		"       (select count(*) from s_table_part where oid = $1) "
+		" from s_table t "
+		"      join s_table_part p on t.oid = p.oid "
+		"      left join summary s "
+		"             on s.tableoid = p.oid "
+		"            and s.partnum = p.partnum "
+		"where tableoid = $1 "
+		"  and s.pid > 0 and s.done_time_epoch > 0";
+
+	if (!semaphore_lock(&(catalog->sema)))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	SQLiteQuery query = {
+		.context = tableSpecs,
+		.fetchFunction = &summary_table_fetch_count_parts_done
+	};
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL }
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* now execute the query, which does not return any row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	(void) semaphore_unlock(&(catalog->sema));
+
+	return true;
+}
+
+
+/*
+ * summary_table_fetch_count_parts_done fetches the count of parts already done
+ * in our summary from a SQLiteQuere ppStmt result.
+ */
+bool
+summary_table_fetch_count_parts_done(SQLiteQuery *query)
+{
+	CopyTableDataSpec *tableSpecs = (CopyTableDataSpec *) query->context;
+
+	tableSpecs->countPartsDone = sqlite3_column_int(query->ppStmt, 0);
+
+	/* idle workers may have split a running part since we started */
+	tableSpecs->countParts = sqlite3_column_int(query->ppStmt, 1);
+
+	return true;
+}
+
+
+/*
+ * summary_add_table_parts_done registers the first pid that sees all tables
+ * parts aredone, using SQLite insert-or-ignore returning facility to ensure
+ * concurrency control.
+ */
+bool
+summary_add_table_parts_done(DatabaseCatalog *catalog,
+							 CopyTableDataSpec *tableSpecs)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: summary_add_table_parts_done: db is NULL");
+		return false;
+	}
+
+	SourceTable *table = tableSpecs->sourceTable;
+
+	char *sql =
+		"insert or ignore into s_table_parts_done(tableoid, pid) "
+		"values($1, $2)";
+
+	if (!semaphore_lock(&(catalog->sema)))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	SQLiteQuery query = { 0 };
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "pid", getpid(), NULL }
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* now execute the query, which return exactly one row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	(void) semaphore_unlock(&(catalog->sema));
+
+	return true;
+}
+
+
+/*
+ * summary_lookup_table_parts_done selects the PID that went there first.
+ *
+ * We could use insert or ignore ... returning ... but that's supported by
+ * SQLite since version 3.35.0 (2021-03-12) and debian oldstable (bullseye) is
+ * still around with Package: libsqlite3-0 (3.34.1-3).
+ */
+bool
+summary_lookup_table_parts_done(DatabaseCatalog *catalog,
+								CopyTableDataSpec *tableSpecs)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: summary_lookup_table_parts_done: db is NULL");
+		return false;
+	}
+
+	SourceTable *table = tableSpecs->sourceTable;
+
+	char *sql = "select pid from s_table_parts_done where tableoid = $1 ";
+
+	if (!semaphore_lock(&(catalog->sema)))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	SQLiteQuery query = {
+		.context = tableSpecs,
+		.fetchFunction = &summary_table_parts_done_fetch
+	};
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL }
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* now execute the query, which does not return any row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	(void) semaphore_unlock(&(catalog->sema));
+
+	return true;
+}
+
+
+/*
+ * summary_table_parts_done_fetch fetches a row from s_table_parts_done.
+ */
+bool
+summary_table_parts_done_fetch(SQLiteQuery *query)
+{
+	CopyTableDataSpec *tableSpecs = (CopyTableDataSpec *) query->context;
+
+	tableSpecs->partsDonePid = sqlite3_column_int(query->ppStmt, 0);
+
+	return true;
+}
+
+
+/*
+ * summary_add_table_truncate registers that the TRUNCATE of a split table is
+ * left to its first part, so that the first part COPY skips writing WAL. The
+ * state is reset to "pending" unless a previous run has already completed.
+ */
+bool
+summary_add_table_truncate(DatabaseCatalog *catalog, SourceTable *table)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: summary_add_table_truncate: db is NULL");
+		return false;
+	}
+
+	char *sql =
+		"insert into s_table_truncate(tableoid, pid, state) "
+		"values($1, $2, 'pending') "
+		"on conflict(tableoid) do update set "
+		"  pid = excluded.pid, state = excluded.state "
+		"where s_table_truncate.state <> 'done'";
+
+	if (!semaphore_lock(&(catalog->sema)))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	SQLiteQuery query = { 0 };
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "pid", getpid(), NULL }
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* now execute the query, which does not return any row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	(void) semaphore_unlock(&(catalog->sema));
+
+	return true;
+}
+
+
+/*
+ * summary_set_table_truncate updates the state of the TRUNCATE of a split
+ * table: "done" once the first part has been copied, "failed" otherwise.
+ */
+bool
+summary_set_table_truncate(DatabaseCatalog *catalog,
+						   SourceTable *table,
+						   const char *state)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: summary_set_table_truncate: db is NULL");
+		return false;
+	}
+
+	char *sql =
+		"update s_table_truncate set pid = $1, state = $2 where tableoid = $3";
+
+	if (!semaphore_lock(&(catalog->sema)))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	SQLiteQuery query = { 0 };
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "pid", getpid(), NULL },
+		{ BIND_PARAMETER_TYPE_TEXT, "state", 0, (char *) state },
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL }
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* now execute the query, which does not return any row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	(void) semaphore_unlock(&(catalog->sema));
+
+	return true;
+}
+
+
+/*
+ * summary_lookup_table_truncate fetches the state of the TRUNCATE of a split
+ * table. The state is an empty string when the TRUNCATE is not left to the
+ * first part of the table.
+ */
+bool
+summary_lookup_table_truncate(DatabaseCatalog *catalog,
+							  SourceTable *table,
+							  char *state,
+							  size_t size)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: summary_lookup_table_truncate: db is NULL");
+		return false;
+	}
+
+	char *sql = "select state from s_table_truncate where tableoid = $1";
+
+	if (!semaphore_lock(&(catalog->sema)))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	TruncateStateContext context = { .state = state, .size = size };
+
+	state[0] = '\0';
+
+	SQLiteQuery query = {
+		.context = &context,
+		.fetchFunction = &summary_table_truncate_fetch
+	};
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL }
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* now execute the query, which return exactly one row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	(void) semaphore_unlock(&(catalog->sema));
+
+	return true;
+}
+
+
+/*
+ * summary_table_truncate_fetch fetches a row from s_table_truncate.
+ */
+static bool
+summary_table_truncate_fetch(SQLiteQuery *query)
+{
+	TruncateStateContext *context = (TruncateStateContext *) query->context;
+
+	if (sqlite3_column_type(query->ppStmt, 0) != SQLITE_NULL)
+	{
+		strlcpy(context->state,
+				(char *) sqlite3_column_text(query->ppStmt, 0),
+				context->size);
+	}
+
+	return true;
+}
+
+
+/*
+ * summary_add_vacuum INSERTs a SourceTable vacuum summary entry to our
+ * internal catalogs database.
+ */
+bool
+summary_add_vacuum(DatabaseCatalog *catalog, CopyTableDataSpec *tableSpecs)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: summary_add_vacuum: db is NULL");
+		return false;
+	}
+
+	SourceTable *table = tableSpecs->sourceTable;
+	CopyVacuumTableSummary *vacuumSummary = &(tableSpecs->vSummary);
+
+	vacuumSummary->pid = getpid();
+	vacuumSummary->table = tableSpecs->sourceTable;
+
+	if (!table_vacuum_summary_init(vacuumSummary))
+	{
+		log_error("Failed to initialize table vacuum summary for pid %d and "
+				  "table %s",
+				  getpid(),
+				  table->qname);
+		return false;
+	}
+
+	char *sql =
+		"insert into vacuum_summary(pid, tableoid, start_time_epoch)"
+		"values($1, $2, $3)";
+
+	if (!semaphore_lock(&(catalog->sema)))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	SQLiteQuery query = { 0 };
+
+	if (!catalog_sql_prepare(db, sql, &query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* bind our parameters now */
+	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "pid", vacuumSummary->pid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL },
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "start_time_epoch",
+			vacuumSummary->startTime, NULL
+		}
+	};
+
+	int count = sizeof(params) / sizeof(params[0]);
+
+	if (!catalog_sql_bind(&query, params, count))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	/* now execute the query, which does not return any row */
+	if (!catalog_sql_execute_once(&query))
+	{
+		/* errors have already been logged */
+		(void) semaphore_unlock(&(catalog->sema));
+		return false;
+	}
+
+	(void) semaphore_unlock(&(catalog->sema));
+
+	return true;
+}
+
+
+/*
+ * summary_finish_vacuum UPDATEs a SourceTable vacuum summary entry to our
+ * internal catalogs database.
+ */
+bool
+summary_finish_vacuum(DatabaseCatalog *catalog, CopyTableDataSpec *tableSpecs)
+{
+	sqlite3 *db = catalog->db;
+
+	if (db == NULL)
+	{
+		log_error("BUG: summary_finish_table: db is NULL");
+		return false;
+	}
+
+	SourceTable *table = tableSpecs->sourceTable;
+	CopyVacuumTableSummary *vacuumSummary = &(tableSpecs->vSummary);
+
+	if (!table_vacuum_summary_finish(vacuumSummary))
+	{
+		log_error("Failed to finish summary for table %s", table->qname);
 		return false;
 	}
 
-	SourceTable *table = tableSpecs->sourceTable;
-	CopyTableSummary *tableSummary = &(tableSpecs->summary);
-
 	char *sql =
-		"update summary set duration = $1, bytes = $2 "
-		"where pid = $3 and tableoid = $4 and partnum = $5";
+		"update vacuum_summary "
+		"set done_time_epoch = $1, duration = $2, "
+		"    frozen = $3, stats_imported = $4, parallel_workers = $5, "
+		"    command = $6 "
+		"where pid = $7 and tableoid = $8";
 
 	if (!semaphore_lock(&(catalog->sema)))
 	{
@@ -628,23 +1742,35 @@ summary_update_table_copy_stats(DatabaseCatalog *catalog,
 
 	/* bind our parameters now */
 	BindParam params[] = {
+		{
+			BIND_PARAMETER_TYPE_INT64, "done_time_epoch",
+			vacuumSummary->doneTime, NULL
+		},
+
 		{
 			BIND_PARAMETER_TYPE_INT64, "duration",
-			tableSummary->durationMs, NULL
+			vacuumSummary->durationMs, NULL
 		},
 
 		{
-			BIND_PARAMETER_TYPE_INT64, "bytes",
-			tableSummary->bytesTransmitted, NULL
+			BIND_PARAMETER_TYPE_INT, "frozen",
+			vacuumSummary->frozen ? 1 : 0, NULL
 		},
 
-		{ BIND_PARAMETER_TYPE_INT64, "pid", getpid(), NULL },
-		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL },
+		{
+			BIND_PARAMETER_TYPE_INT, "stats_imported",
+			vacuumSummary->statsImported ? 1 : 0, NULL
+		},
 
 		{
-			BIND_PARAMETER_TYPE_INT64, "partnum",
-			table->partition.partNumber, NULL
-		}
+			BIND_PARAMETER_TYPE_INT64, "parallel_workers",
+			vacuumSummary->parallelWorkers, NULL
+		},
+
+		{ BIND_PARAMETER_TYPE_TEXT, "command", 0, vacuumSummary->command },
+
+		{ BIND_PARAMETER_TYPE_INT64, "pid", getpid(), NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL }
 	};
 
 	int count = sizeof(params) / sizeof(params[0]);
@@ -671,33 +1797,31 @@ summary_update_table_copy_stats(DatabaseCatalog *catalog,
 
 
 /*
- * summary_table_all_parts_done sets tableSpecs->allPartsAreDone to true when
- * all the parts have already been done in the summary table of our internal
- * catalogs.
+ * summary_add_fkey INSERTs a foreign key summary entry to our internal
+ * catalogs database, registering the start of its VALIDATE CONSTRAINT.
  */
 bool
-summary_table_count_parts_done(DatabaseCatalog *catalog,
-							   CopyTableDataSpec *tableSpecs)
+summary_add_fkey(DatabaseCatalog *catalog, CopyFKeySummary *summary)
 {
 	sqlite3 *db = catalog->db;
 
 	if (db == NULL)
 	{
-		log_error("BUG: summary_table_count_parts_done: db is NULL");
+		log_error("BUG: summary_add_fkey: db is NULL");
 		return false;
 	}
 
-	SourceTable *table = tableSpecs->sourceTable;
+	summary->pid = getpid();
+	summary->startTime = time(NULL);
+	summary->doneTime = 0;
+	summary->durationMs = 0;
+
+	INSTR_TIME_SET_CURRENT(summary->startTimeInstr);
 
 	char *sql =
-		"select count(s.oid) "
-		" from s_table t "
-		"      join s_table_part p on t.oid = p.oid "
-		"      left join summary s "
-		"             on s.tableoid = p.oid "
-		"            and s.partnum = p.partnum "
-		"where tableoid = $1 "
-		"  and s.pid > 0 and s.done_time_epoch > 0";
+		"insert or replace into fkey_summary"
+		"(pid, conoid, start_time_epoch, command)"
+		"values($1, $2, $3, $4)";
 
 	if (!semaphore_lock(&(catalog->sema)))
 	{
@@ -705,10 +1829,7 @@ summary_table_count_parts_done(DatabaseCatalog *catalog,
 		return false;
 	}
 
-	SQLiteQuery query = {
-		.context = tableSpecs,
-		.fetchFunction = &summary_table_fetch_count_parts_done
-	};
+	SQLiteQuery query = { 0 };
 
 	if (!catalog_sql_prepare(db, sql, &query))
 	{
@@ -719,7 +1840,15 @@ summary_table_count_parts_done(DatabaseCatalog *catalog,
 
 	/* bind our parameters now */
 	BindParam params[] = {
-		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL }
+		{ BIND_PARAMETER_TYPE_INT64, "pid", summary->pid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "conoid", summary->fkey->oid, NULL },
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "start_time_epoch",
+			summary->startTime, NULL
+		},
+
+		{ BIND_PARAMETER_TYPE_TEXT, "command", 0, summary->command }
 	};
 
 	int count = sizeof(params) / sizeof(params[0]);
@@ -746,42 +1875,31 @@ summary_table_count_parts_done(DatabaseCatalog *catalog,
 
 
 /*
- * summary_table_fetch_count_parts_done fetches the count of parts already done
- * in our summary from a SQLiteQuere ppStmt result.
- */
-bool
-summary_table_fetch_count_parts_done(SQLiteQuery *query)
-{
-	CopyTableDataSpec *tableSpecs = (CopyTableDataSpec *) query->context;
-
-	tableSpecs->countPartsDone = sqlite3_column_int(query->ppStmt, 0);
-
-	return true;
-}
-
-
-/*
- * summary_add_table_parts_done registers the first pid that sees all tables
- * parts aredone, using SQLite insert-or-ignore returning facility to ensure
- * concurrency control.
+ * summary_finish_fkey UPDATEs a foreign key summary entry to our internal
+ * catalogs database, registering the duration of its VALIDATE CONSTRAINT.
  */
 bool
-summary_add_table_parts_done(DatabaseCatalog *catalog,
-							 CopyTableDataSpec *tableSpecs)
+summary_finish_fkey(DatabaseCatalog *catalog, CopyFKeySummary *summary)
 {
 	sqlite3 *db = catalog->db;
 
 	if (db == NULL)
 	{
-		log_error("BUG: summary_add_table_parts_done: db is NULL");
+		log_error("BUG: summary_finish_fkey: db is NULL");
 		return false;
 	}
 
-	SourceTable *table = tableSpecs->sourceTable;
+	summary->doneTime = time(NULL);
+
+	INSTR_TIME_SET_CURRENT(summary->durationInstr);
+	INSTR_TIME_SUBTRACT(summary->durationInstr, summary->startTimeInstr);
+
+	summary->durationMs = INSTR_TIME_GET_MILLISEC(summary->durationInstr);
 
 	char *sql =
-		"insert or ignore into s_table_parts_done(tableoid, pid) "
-		"values($1, $2)";
+		"update fkey_summary "
+		"set done_time_epoch = $1, duration = $2 "
+		"where pid = $3 and conoid = $4";
 
 	if (!semaphore_lock(&(catalog->sema)))
 	{
@@ -800,8 +1918,18 @@ summary_add_table_parts_done(DatabaseCatalog *catalog,
 
 	/* bind our parameters now */
 	BindParam params[] = {
-		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL },
-		{ BIND_PARAMETER_TYPE_INT64, "pid", getpid(), NULL }
+		{
+			BIND_PARAMETER_TYPE_INT64, "done_time_epoch",
+			summary->doneTime, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "duration",
+			summary->durationMs, NULL
+		},
+
+		{ BIND_PARAMETER_TYPE_INT64, "pid", summary->pid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "conoid", summary->fkey->oid, NULL }
 	};
 
 	int count = sizeof(params) / sizeof(params[0]);
@@ -813,7 +1941,7 @@ summary_add_table_parts_done(DatabaseCatalog *catalog,
 		return false;
 	}
 
-	/* now execute the query, which return exactly one row */
+	/* now execute the query, which does not return any row */
 	if (!catalog_sql_execute_once(&query))
 	{
 		/* errors have already been logged */
@@ -828,27 +1956,31 @@ summary_add_table_parts_done(DatabaseCatalog *catalog,
 
 
 /*
- * summary_lookup_table_parts_done selects the PID that went there first.
- *
- * We could use insert or ignore ... returning ... but that's supported by
- * SQLite since version 3.35.0 (2021-03-12) and debian oldstable (bullseye) is
- * still around with Package: libsqlite3-0 (3.34.1-3).
+ * summary_add_unlogged INSERTs a SourceTable unlogged summary entry to our
+ * internal catalogs database, registering that the table has been switched to
+ * UNLOGGED on the target database.
  */
 bool
-summary_lookup_table_parts_done(DatabaseCatalog *catalog,
-								CopyTableDataSpec *tableSpecs)
+summary_add_unlogged(DatabaseCatalog *catalog,
+					 CopyUnloggedTableSummary *summary)
 {
 	sqlite3 *db = catalog->db;
 
 	if (db == NULL)
 	{
-		log_error("BUG: summary_lookup_table_parts_done: db is NULL");
+		log_error("BUG: summary_add_unlogged: db is NULL");
 		return false;
 	}
 
-	SourceTable *table = tableSpecs->sourceTable;
+	SourceTable *table = summary->table;
 
-	char *sql = "select pid from s_table_parts_done where tableoid = $1 ";
+	summary->pid = getpid();
+	summary->unloggedTime = time(NULL);
+
+	char *sql =
+		"insert or replace into unlogged_summary"
+		"(pid, tableoid, unlogged_time_epoch)"
+		"values($1, $2, $3)";
 
 	if (!semaphore_lock(&(catalog->sema)))
 	{
@@ -856,10 +1988,7 @@ summary_lookup_table_parts_done(DatabaseCatalog *catalog,
 		return false;
 	}
 
-	SQLiteQuery query = {
-		.context = tableSpecs,
-		.fetchFunction = &summary_table_parts_done_fetch
-	};
+	SQLiteQuery query = { 0 };
 
 	if (!catalog_sql_prepare(db, sql, &query))
 	{
@@ -870,7 +1999,13 @@ summary_lookup_table_parts_done(DatabaseCatalog *catalog,
 
 	/* bind our parameters now */
 	BindParam params[] = {
-		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL }
+		{ BIND_PARAMETER_TYPE_INT64, "pid", summary->pid, NULL },
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL },
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "unlogged_time_epoch",
+			summary->unloggedTime, NULL
+		}
 	};
 
 	int count = sizeof(params) / sizeof(params[0]);
@@ -897,52 +2032,29 @@ summary_lookup_table_parts_done(DatabaseCatalog *catalog,
 
 
 /*
- * summary_table_parts_done_fetch fetches a row from s_table_parts_done.
- */
-bool
-summary_table_parts_done_fetch(SQLiteQuery *query)
-{
-	CopyTableDataSpec *tableSpecs = (CopyTableDataSpec *) query->context;
-
-	tableSpecs->partsDonePid = sqlite3_column_int(query->ppStmt, 0);
-
-	return true;
-}
-
-
-/*
- * summary_add_vacuum INSERTs a SourceTable vacuum summary entry to our
- * internal catalogs database.
+ * summary_lookup_unlogged fetches a SourceTable unlogged summary entry from
+ * our internal catalogs database. When the table has not been switched to
+ * UNLOGGED, the unloggedTime is zero.
  */
 bool
-summary_add_vacuum(DatabaseCatalog *catalog, CopyTableDataSpec *tableSpecs)
+summary_lookup_unlogged(DatabaseCatalog *catalog,
+						CopyUnloggedTableSummary *summary)
 {
 	sqlite3 *db = catalog->db;
 
 	if (db == NULL)
 	{
-		log_error("BUG: summary_add_vacuum: db is NULL");
+		log_error("BUG: summary_lookup_unlogged: db is NULL");
 		return false;
 	}
 
-	SourceTable *table = tableSpecs->sourceTable;
-	CopyVacuumTableSummary *vacuumSummary = &(tableSpecs->vSummary);
-
-	vacuumSummary->pid = getpid();
-	vacuumSummary->table = tableSpecs->sourceTable;
-
-	if (!table_vacuum_summary_init(vacuumSummary))
-	{
-		log_error("Failed to initialize table vacuum summary for pid %d and "
-				  "table %s",
-				  getpid(),
-				  table->qname);
-		return false;
-	}
+	SourceTable *table = summary->table;
 
 	char *sql =
-		"insert into vacuum_summary(pid, tableoid, start_time_epoch)"
-		"values($1, $2, $3)";
+		"  select pid, unlogged_time_epoch, start_time_epoch, "
+		"         done_time_epoch, duration "
+		"    from unlogged_summary "
+		"   where tableoid = $1";
 
 	if (!semaphore_lock(&(catalog->sema)))
 	{
@@ -950,7 +2062,10 @@ summary_add_vacuum(DatabaseCatalog *catalog, CopyTableDataSpec *tableSpecs)
 		return false;
 	}
 
-	SQLiteQuery query = { 0 };
+	SQLiteQuery query = {
+		.context = summary,
+		.fetchFunction = &summary_unlogged_fetch
+	};
 
 	if (!catalog_sql_prepare(db, sql, &query))
 	{
@@ -961,13 +2076,7 @@ summary_add_vacuum(DatabaseCatalog *catalog, CopyTableDataSpec *tableSpecs)
 
 	/* bind our parameters now */
 	BindParam params[] = {
-		{ BIND_PARAMETER_TYPE_INT64, "pid", vacuumSummary->pid, NULL },
-		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL },
-
-		{
-			BIND_PARAMETER_TYPE_INT64, "start_time_epoch",
-			vacuumSummary->startTime, NULL
-		}
+		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL }
 	};
 
 	int count = sizeof(params) / sizeof(params[0]);
@@ -979,7 +2088,7 @@ summary_add_vacuum(DatabaseCatalog *catalog, CopyTableDataSpec *tableSpecs)
 		return false;
 	}
 
-	/* now execute the query, which does not return any row */
+	/* now execute the query, which return exactly one row */
 	if (!catalog_sql_execute_once(&query))
 	{
 		/* errors have already been logged */
@@ -994,33 +2103,48 @@ summary_add_vacuum(DatabaseCatalog *catalog, CopyTableDataSpec *tableSpecs)
 
 
 /*
- * summary_finish_vacuum UPDATEs a SourceTable vacuum summary entry to our
- * internal catalogs database.
+ * summary_unlogged_fetch fetches a CopyUnloggedTableSummary entry from a
+ * SQLite ppStmt result set.
+ */
+static bool
+summary_unlogged_fetch(SQLiteQuery *query)
+{
+	CopyUnloggedTableSummary *summary =
+		(CopyUnloggedTableSummary *) query->context;
+
+	summary->pid = sqlite3_column_int64(query->ppStmt, 0);
+	summary->unloggedTime = sqlite3_column_int64(query->ppStmt, 1);
+	summary->startTime = sqlite3_column_int64(query->ppStmt, 2);
+	summary->doneTime = sqlite3_column_int64(query->ppStmt, 3);
+	summary->durationMs = sqlite3_column_int64(query->ppStmt, 4);
+
+	return true;
+}
+
+
+/*
+ * summary_finish_unlogged UPDATEs a SourceTable unlogged summary entry to our
+ * internal catalogs database, registering the SET LOGGED timing.
  */
 bool
-summary_finish_vacuum(DatabaseCatalog *catalog, CopyTableDataSpec *tableSpecs)
+summary_finish_unlogged(DatabaseCatalog *catalog,
+						CopyUnloggedTableSummary *summary)
 {
 	sqlite3 *db = catalog->db;
 
 	if (db == NULL)
 	{
-		log_error("BUG: summary_finish_table: db is NULL");
+		log_error("BUG: summary_finish_unlogged: db is NULL");
 		return false;
 	}
 
-	SourceTable *table = tableSpecs->sourceTable;
-	CopyVacuumTableSummary *vacuumSummary = &(tableSpecs->vSummary);
-
-	if (!table_vacuum_summary_finish(vacuumSummary))
-	{
-		log_error("Failed to finish summary for table %s", table->qname);
-		return false;
-	}
+	SourceTable *table = summary->table;
 
 	char *sql =
-		"update vacuum_summary "
-		"set done_time_epoch = $1, duration = $2 "
-		"where pid = $3 and tableoid = $4";
+		"update unlogged_summary "
+		"set pid = $1, start_time_epoch = $2, done_time_epoch = $3, "
+		"    duration = $4 "
+		"where tableoid = $5";
 
 	if (!semaphore_lock(&(catalog->sema)))
 	{
@@ -1039,17 +2163,23 @@ summary_finish_vacuum(DatabaseCatalog *catalog, CopyTableDataSpec *tableSpecs)
 
 	/* bind our parameters now */
 	BindParam params[] = {
+		{ BIND_PARAMETER_TYPE_INT64, "pid", getpid(), NULL },
+
+		{
+			BIND_PARAMETER_TYPE_INT64, "start_time_epoch",
+			summary->startTime, NULL
+		},
+
 		{
 			BIND_PARAMETER_TYPE_INT64, "done_time_epoch",
-			vacuumSummary->doneTime, NULL
+			summary->doneTime, NULL
 		},
 
 		{
 			BIND_PARAMETER_TYPE_INT64, "duration",
-			vacuumSummary->durationMs, NULL
+			summary->durationMs, NULL
 		},
 
-		{ BIND_PARAMETER_TYPE_INT64, "pid", getpid(), NULL },
 		{ BIND_PARAMETER_TYPE_INT64, "tableoid", table->oid, NULL }
 	};
 
@@ -1448,8 +2578,9 @@ summary_finish_index(DatabaseCatalog *catalog, CopyIndexSpec *indexSpecs)
 	}
 
 	char *sql =
-		"update summary set done_time_epoch = $1, duration = $2 "
-		"where pid = $3 and indexoid = $4";
+		"update summary set done_time_epoch = $1, duration = $2, "
+		"       mem_grant = $3, parallel_workers = $4 "
+		"where pid = $5 and indexoid = $6";
 
 	if (!semaphore_lock(&(catalog->sema)))
 	{
@@ -1478,6 +2609,16 @@ summary_finish_index(DatabaseCatalog *catalog, CopyIndexSpec *indexSpecs)
 			indexSummary->durationMs, NULL
 		},
 
+		{
+			BIND_PARAMETER_TYPE_INT64, "mem_grant",
+			indexSummary->memoryGrant, NULL
+		},
+
+		{
+			BIND_PARAMETER_TYPE_INT, "parallel_workers",
+			indexSummary->parallelWorkers, NULL
+		},
+
 		{ BIND_PARAMETER_TYPE_INT64, "pid", getpid(), NULL },
 		{ BIND_PARAMETER_TYPE_INT64, "indexoid", index->indexOid, NULL }
 	};
@@ -2958,6 +4099,40 @@ table_summary_finish(CopyTableSummary *summary)
 }
 
 
+/*
+ * summary_copy_bound returns which of the source, the target, the bandwidth
+ * limiter, or pgcopydb itself a COPY spent most of its time waiting for.
+ */
+const char *
+summary_copy_bound(uint64_t srcWaitMs,
+				   uint64_t dstWaitMs,
+				   uint64_t throttleMs,
+				   uint64_t clientMs)
+{
+	const char *bound = "source";
+	uint64_t max = srcWaitMs;
+
+	if (dstWaitMs > max)
+	{
+		bound = "target";
+		max = dstWaitMs;
+	}
+
+	if (throttleMs > max)
+	{
+		bound = "throttle";
+		max = throttleMs;
+	}
+
+	if (clientMs > max)
+	{
+		bound = "client";
+	}
+
+	return bound;
+}
+
+
 /*
  * table_vacuum_summary_init initializes the time elements of a table vacuum
  * summary.
@@ -3351,6 +4526,84 @@ print_summary_as_json(Summary *summary, const char *filename)
 		json_object_dotset_string(jsTableObj,
 								  "network.transmit-rate", entry->transmitRate);
 
+		if (entry->targetCount > 0)
+		{
+			JSON_Value *jsTargets = json_value_init_array();
+			JSON_Array *jsTargetArray = json_value_get_array(jsTargets);
+
+			for (int t = 0; t < entry->targetCount; t++)
+			{
+				CopyTargetSummary *target = &(entry->targets[t]);
+
+				JSON_Value *jsTarget = json_value_init_object();
+				JSON_Object *jsTargetObj = json_value_get_object(jsTarget);
+
+				json_object_set_number(jsTargetObj, "target", target->target);
+				json_object_set_number(jsTargetObj, "parts", target->parts);
+				json_object_set_number(jsTargetObj,
+									   "bytes", target->bytesTransmitted);
+				json_object_set_number(jsTargetObj, "stalls", target->stalls);
+
+				json_array_append_value(jsTargetArray, jsTarget);
+			}
+
+			json_object_set_value(jsTableObj, "targets", jsTargets);
+		}
+
+		if (entry->ringDepth > 0)
+		{
+			json_object_dotset_number(jsTableObj,
+									  "ring.depth", entry->ringDepth);
+			json_object_dotset_number(jsTableObj,
+									  "ring.occupancy", entry->ringOccupancy);
+			json_object_dotset_number(jsTableObj,
+									  "ring.reader-stalls", entry->ringFull);
+			json_object_dotset_number(jsTableObj,
+									  "ring.writer-stalls", entry->ringEmpty);
+		}
+
+		/* target wal_level=minimal: TRUNCATE and COPY in one transaction */
+		json_object_set_boolean(jsTableObj,
+								"wal-skipped", entry->walSkippedParts > 0);
+
+		if (entry->walSkippedParts > 0)
+		{
+			json_object_set_number(jsTableObj,
+								   "wal-skipped-parts", entry->walSkippedParts);
+		}
+
+		/* time lost to COPY retries */
+		if (entry->retries > 0)
+		{
+			json_object_dotset_number(jsTableObj,
+									  "retry.count", entry->retries);
+			json_object_dotset_number(jsTableObj,
+									  "retry.duration", entry->retryMs);
+		}
+
+		/* where the COPY spent its time */
+		if (entry->copyMessages > 0)
+		{
+			json_object_dotset_number(jsTableObj,
+									  "copy.rows", entry->copyRows);
+			json_object_dotset_number(jsTableObj,
+									  "copy.messages", entry->copyMessages);
+			json_object_dotset_number(jsTableObj,
+									  "copy.source-wait", entry->srcWaitMs);
+			json_object_dotset_number(jsTableObj,
+									  "copy.target-wait", entry->dstWaitMs);
+			json_object_dotset_number(jsTableObj,
+									  "copy.throttle-wait", entry->throttleMs);
+			json_object_dotset_number(jsTableObj,
+									  "copy.client", entry->clientMs);
+			json_object_dotset_string(jsTableObj,
+									  "copy.bound",
+									  summary_copy_bound(entry->srcWaitMs,
+														 entry->dstWaitMs,
+														 entry->throttleMs,
+														 entry->clientMs));
+		}
+
 		json_object_dotset_number(jsTableObj,
 								  "index.count", entry->indexArray.count);
 		json_object_dotset_number(jsTableObj,
@@ -3718,6 +4971,38 @@ prepare_summary_table_hook(void *ctx, SourceTable *table)
 								  entry->bytes,
 								  entry->durationTableMs);
 
+	entry->ringDepth = table->ringDepth;
+	entry->ringFull = table->ringFull;
+	entry->ringEmpty = table->ringEmpty;
+	entry->walSkippedParts = table->walSkippedParts;
+	entry->retries = table->retries;
+	entry->retryMs = table->retryMs;
+	entry->copyRows = table->copyRows;
+	entry->copyMessages = table->copyMessages;
+	entry->srcWaitMs = table->srcWaitMs;
+	entry->dstWaitMs = table->dstWaitMs;
+	entry->throttleMs = table->throttleMs;
+	entry->clientMs = table->clientMs;
+	entry->ringOccupancy =
+		table->ringSamples > 0
+		? (double) table->ringOccupancy / (double) table->ringSamples
+		: 0.0;
+
+	/* --fanout-target per-target summary */
+	entry->targetCount = 0;
+
+	if (specs->connStrings.fanoutCount > 0)
+	{
+		if (!summary_lookup_table_targets_total(sourceDB,
+												table->oid,
+												entry->targets,
+												&(entry->targetCount)))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+	}
+
 	/* read the index oid list from the table oid */
 	context->indexingDurationMs = 0;
 
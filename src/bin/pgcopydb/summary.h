@@ -22,6 +22,23 @@
 #include "string_utils.h"
 #include "schema.h"
 
+/*
+ * With --fanout-target, each target database gets its own COPY summary entry
+ * in the summary_target catalog table. Target 0 is the --target database, and
+ * target n is the n-th --fanout-target database.
+ */
+typedef struct CopyTargetSummary
+{
+	int target;
+	bool done;
+	pid_t pid;
+	uint64_t doneTime;          /* time(NULL) at done time */
+	uint64_t parts;             /* count of table parts done */
+	uint64_t bytesTransmitted;  /* total number of bytes copied */
+	uint64_t stalls;            /* times the COPY waited for this target */
+} CopyTargetSummary;
+
+
 typedef struct CopyTableSummary
 {
 	pid_t pid;                  /* pid */
@@ -32,7 +49,25 @@ typedef struct CopyTableSummary
 	instr_time startTimeInstr;  /* internal instr_time tracker */
 	instr_time durationInstr;   /* internal instr_time tracker */
 	uint64_t bytesTransmitted;  /* total number of bytes copied */
+	int ringDepth;              /* --use-copy-threads ring depth */
+	uint64_t ringSamples;       /* count of slots sent to the target */
+	uint64_t ringOccupancy;     /* sum of ring occupancy at each send */
+	uint64_t ringFull;          /* times the reader waited for the writer */
+	uint64_t ringEmpty;         /* times the writer waited for the reader */
+	bool walSkipped;            /* TRUNCATE and COPY in the same transaction */
+	bool frozen;                /* COPY FREEZE, see vacuum_prepare_command */
+	int retries;                /* failed COPY attempts */
+	uint64_t retryMs;           /* time lost to failed COPY attempts */
+	uint64_t copyRows;          /* rows sent by the source */
+	uint64_t copyMessages;      /* CopyData messages relayed */
+	uint64_t srcWaitMs;         /* time blocked waiting for the source */
+	uint64_t dstWaitMs;         /* time blocked waiting for the targets */
+	uint64_t throttleMs;        /* time waiting to respect --max-bandwidth */
+	uint64_t clientMs;          /* time running pgcopydb code */
 	char *command;              /* malloc'ed area */
+
+	/* --fanout-target per-target summary */
+	CopyTargetSummary targets[COPY_MAX_TARGETS];
 } CopyTableSummary;
 
 
@@ -45,8 +80,38 @@ typedef struct CopyVacuumTableSummary
 	uint64_t durationMs;        /* instr_time duration in milliseconds */
 	instr_time startTimeInstr;  /* internal instr_time tracker */
 	instr_time durationInstr;   /* internal instr_time tracker */
+	bool frozen;                /* all the table parts loaded with COPY FREEZE */
+	bool statsImported;         /* planner statistics imported from source */
+	int parallelWorkers;        /* VACUUM (PARALLEL n), zero when not used */
+	char command[BUFSIZE];      /* command run, empty when VACUUM is skipped */
 } CopyVacuumTableSummary;
 
+/* --fkey-jobs: foreign keys created NOT VALID, then validated */
+typedef struct CopyFKeySummary
+{
+	pid_t pid;                  /* pid */
+	SourceForeignKey *fkey;     /* oid, qname, conname */
+	uint64_t startTime;         /* time(NULL) at VALIDATE start time */
+	uint64_t doneTime;          /* time(NULL) at VALIDATE done time */
+	uint64_t durationMs;        /* VALIDATE duration in milliseconds */
+	instr_time startTimeInstr;  /* internal instr_time tracker */
+	instr_time durationInstr;   /* internal instr_time tracker */
+	char command[BUFSIZE];      /* ALTER TABLE ... VALIDATE CONSTRAINT */
+} CopyFKeySummary;
+
+/* --unlogged-load: tables switched to UNLOGGED, then back to LOGGED */
+typedef struct CopyUnloggedTableSummary
+{
+	pid_t pid;                  /* pid */
+	SourceTable *table;         /* oid, nspname, relname */
+	uint64_t unloggedTime;      /* time(NULL) at SET UNLOGGED time */
+	uint64_t startTime;         /* time(NULL) at SET LOGGED start time */
+	uint64_t doneTime;          /* time(NULL) at SET LOGGED done time */
+	uint64_t durationMs;        /* SET LOGGED duration in milliseconds */
+	instr_time startTimeInstr;  /* internal instr_time tracker */
+	instr_time durationInstr;   /* internal instr_time tracker */
+} CopyUnloggedTableSummary;
+
 typedef struct CopyIndexSummary
 {
 	pid_t pid;                  /* pid */
@@ -56,6 +121,8 @@ typedef struct CopyIndexSummary
 	uint64_t durationMs;        /* instr_time duration in milliseconds */
 	instr_time startTimeInstr;  /* internal instr_time tracker */
 	instr_time durationInstr;   /* internal instr_time tracker */
+	uint64_t memoryGrant;       /* --index-memory grant, zero when unused */
+	int parallelWorkers;        /* max_parallel_maintenance_workers */
 	char *command;              /* malloc'ed area */
 } CopyIndexSummary;
 
@@ -156,6 +223,21 @@ typedef struct SummaryTableEntry
 	char indexMs[INTERVAL_MAXLEN];
 	uint64_t durationTableMs;
 	uint64_t durationIndexMs;
+	int ringDepth;
+	double ringOccupancy;       /* average ring occupancy */
+	uint64_t ringFull;
+	uint64_t ringEmpty;
+	uint64_t walSkippedParts;
+	uint64_t retries;
+	uint64_t retryMs;
+	uint64_t copyRows;
+	uint64_t copyMessages;
+	uint64_t srcWaitMs;
+	uint64_t dstWaitMs;
+	uint64_t throttleMs;
+	uint64_t clientMs;
+	int targetCount;
+	CopyTargetSummary targets[COPY_MAX_TARGETS];
 	SummaryIndexArray indexArray;
 	SummaryIndexArray constraintArray;
 } SummaryTableEntry;
@@ -236,6 +318,11 @@ bool summary_iter_timing_finish(TimingIterator *iter);
 bool table_summary_init(CopyTableSummary *summary);
 bool table_summary_finish(CopyTableSummary *summary);
 
+const char * summary_copy_bound(uint64_t srcWaitMs,
+								uint64_t dstWaitMs,
+								uint64_t throttleMs,
+								uint64_t clientMs);
+
 bool table_vacuum_summary_init(CopyVacuumTableSummary *summary);
 bool table_vacuum_summary_finish(CopyVacuumTableSummary *summary);
 
@@ -15,11 +15,13 @@
 
 #include "catalog.h"
 #include "cli_root.h"
+#include "concurrency.h"
 #include "copydb.h"
 #include "env_utils.h"
 #include "lock_utils.h"
 #include "log.h"
 #include "pidfile.h"
+#include "schedule.h"
 #include "schema.h"
 #include "signals.h"
 #include "string_utils.h"
@@ -28,6 +30,11 @@
 
 static bool copydb_copy_supervisor_add_table_hook(void *ctx, SourceTable *table);
 static bool copydb_update_copy_stats_hook(void *ctx, CopyStats *stats);
+static void copydb_copy_stats_to_summary(CopyStats *stats,
+										 CopyTableSummary *summary);
+static bool copydb_targets_have_connection_error(PGSQL **dsts, int count);
+static bool copydb_wait_for_table_truncate(CopyDataSpec *specs,
+										   CopyTableDataSpec *tableSpecs);
 
 /*
  * copydb_table_data fetches the list of tables from the source database and
@@ -109,6 +116,7 @@ bool
 copydb_process_table_data(CopyDataSpec *specs)
 {
 	int errors = 0;
+	pid_t copyPid = -1;
 
 	/*
 	 * Take care of extensions configuration table in an auxilliary process.
@@ -134,7 +142,7 @@ copydb_process_table_data(CopyDataSpec *specs)
 		 * First start the COPY data workers with their supervisor and IPC
 		 * infrastructure (queues).
 		 */
-		if (!copydb_start_copy_supervisor(specs))
+		if (!copydb_start_copy_supervisor(specs, &copyPid))
 		{
 			/* errors have already been logged */
 			++errors;
@@ -202,6 +210,19 @@ copydb_process_table_data(CopyDataSpec *specs)
 		}
 	}
 
+	/*
+	 * With --spool, close the source snapshot as soon as all the table data
+	 * has been spooled, while the target database is still ingesting it.
+	 */
+	if (errors == 0 && specs->useSpool && copyPid > 0)
+	{
+		if (!copydb_spool_wait_for_snapshot(specs, copyPid))
+		{
+			/* errors have already been logged */
+			++errors;
+		}
+	}
+
 	if (!copydb_wait_for_subprocesses(specs->failFast))
 	{
 		log_error("Some sub-processes have exited with error status, "
@@ -209,6 +230,13 @@ copydb_process_table_data(CopyDataSpec *specs)
 		++errors;
 	}
 
+	/* with --unlogged-load, make sure no table is left UNLOGGED */
+	if (errors == 0 && !copydb_set_tables_logged(specs))
+	{
+		/* errors have already been logged */
+		++errors;
+	}
+
 	if (errors > 0)
 	{
 		log_error("Errors detected, see above for details");
@@ -226,7 +254,7 @@ copydb_process_table_data(CopyDataSpec *specs)
  * when all the partitions are done.
  */
 bool
-copydb_start_copy_supervisor(CopyDataSpec *specs)
+copydb_start_copy_supervisor(CopyDataSpec *specs, pid_t *pidOut)
 {
 	/*
 	 * Flush stdio channels just before fork, to avoid double-output problems.
@@ -261,6 +289,10 @@ copydb_start_copy_supervisor(CopyDataSpec *specs)
 		default:
 		{
 			/* fork succeeded, in parent */
+			if (pidOut != NULL)
+			{
+				*pidOut = fpid;
+			}
 			break;
 		}
 	}
@@ -274,6 +306,7 @@ typedef struct CopySupervisorContext
 {
 	CopyDataSpec *specs;
 	PGSQL *dst;
+	Schedule *schedule;
 } CopySupervisorContext;
 
 
@@ -295,6 +328,13 @@ copydb_copy_supervisor(CopyDataSpec *specs)
 		return false;
 	}
 
+	if (specs->useSpool &&
+		!queue_create(&(specs->drainQueue), "copy spool drain"))
+	{
+		log_error("Failed to create the COPY spool drain process queue");
+		return false;
+	}
+
 	DatabaseCatalog *sourceDB = &(specs->catalogs.source);
 
 	/*
@@ -333,6 +373,20 @@ copydb_copy_supervisor(CopyDataSpec *specs)
 		return false;
 	}
 
+	/* with --unlogged-load, switch target tables to UNLOGGED before COPY */
+	if (specs->unloggedLoad && !copydb_set_tables_unlogged(specs))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* check if the target database allows skipping WAL on COPY */
+	if (!copydb_check_wal_skip(specs))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
 	if (!catalog_close(sourceDB))
 	{
 		/* errors have already been logged */
@@ -340,9 +394,19 @@ copydb_copy_supervisor(CopyDataSpec *specs)
 	}
 
 	/*
-	 * Start COPY table-data workers, as many as --table-jobs.
+	 * Start COPY table-data workers, as many as --table-jobs. With --spool
+	 * the table-data workers fill-in the spool, and as many drain workers
+	 * then COPY the data from the spool to the target database.
 	 */
-	if (!copydb_start_table_data_workers(specs))
+	pid_t *pids = (pid_t *) calloc(specs->tableJobs, sizeof(pid_t));
+
+	if (pids == NULL)
+	{
+		log_error(ALLOCATION_FAILED_ERROR);
+		return false;
+	}
+
+	if (!copydb_start_table_data_workers(specs, pids))
 	{
 		log_fatal("Failed to start table data COPY workers, "
 				  "see above for details");
@@ -352,6 +416,16 @@ copydb_copy_supervisor(CopyDataSpec *specs)
 		return false;
 	}
 
+	if (specs->useSpool && !copydb_start_drain_workers(specs))
+	{
+		log_fatal("Failed to start table data COPY spool drain workers, "
+				  "see above for details");
+
+		(void) copydb_fatal_exit();
+
+		return false;
+	}
+
 	/* reopen catalog in the supervisor process after the fork */
 	if (!catalog_open(sourceDB))
 	{
@@ -365,6 +439,18 @@ copydb_copy_supervisor(CopyDataSpec *specs)
 		return false;
 	}
 
+	/* with --adaptive-jobs, tune the count of active workers as we wait */
+	ConcurrencyController controller = { 0 };
+
+	if (!concurrency_controller_init(&controller,
+									 CONCURRENCY_POOL_COPY,
+									 sourceDB,
+									 specs->connStrings.target_pguri))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
 	/*
 	 * Now start the worker that adds tables to the queue.
 	 */
@@ -378,10 +464,44 @@ copydb_copy_supervisor(CopyDataSpec *specs)
 		return false;
 	}
 
+	/*
+	 * With --spool, once the table-data workers are done reading from the
+	 * source, signal the drain workers that no more tables are coming, and
+	 * signal the snapshot holder that the snapshot may be closed.
+	 */
+	bool spoolSuccess = true;
+
+	if (specs->useSpool)
+	{
+		spoolSuccess = copydb_spool_wait_for_workers(specs, pids);
+
+		if (!copydb_drain_send_stop(specs) ||
+			!copydb_spool_mark_done(specs->cfPaths.spool.tablesDoneFile))
+		{
+			/* errors have already been logged */
+			(void) copydb_fatal_exit();
+			return false;
+		}
+
+		/* pgcopydb copy table-data holds the snapshot in this process */
+		if (!copydb_spool_close_snapshot(specs))
+		{
+			log_warn("Failed to close snapshot early, "
+					 "see above for details");
+		}
+	}
+
 	/*
 	 * Now just wait for the table-data COPY processes to be done.
 	 */
-	if (!copydb_wait_for_subprocesses(specs->failFast))
+	bool success =
+		copydb_wait_for_subprocesses_hook(specs->failFast,
+										  &concurrency_tick,
+										  &controller);
+
+	concurrency_controller_finish(&controller);
+
+	if (!success || !spoolSuccess)
 	{
 		log_error("Some COPY worker process(es) have exited with error, "
 				  "see above for details");
@@ -488,7 +608,7 @@ copydb_copy_start_worker_queue_tables(CopyDataSpec *specs)
 
 /*
  * copydb_copy_worker_queue_tables iterates over the list of tables and sends
- * the to the table-data copy queue.
+ * the to the table-data copy queue, longest jobs first, see schedule.c.
  */
 bool
 copydb_copy_worker_queue_tables(CopyDataSpec *specs)
@@ -497,9 +617,12 @@ copydb_copy_worker_queue_tables(CopyDataSpec *specs)
 
 	log_notice("Started queue tables COPY worker %d [%d]", pid, getppid());
 
+	Schedule schedule = { 0 };
+
 	CopySupervisorContext context = {
 		.specs = specs,
-		.dst = NULL
+		.dst = NULL,
+		.schedule = &schedule
 	};
 
 	if (!catalog_init_from_specs(specs))
@@ -560,6 +683,17 @@ copydb_copy_worker_queue_tables(CopyDataSpec *specs)
 		(void) pgsql_finish(&dst);
 	}
 
+	/*
+	 * Now that we have the cost of each COPY job, include the cost of the
+	 * CREATE INDEX jobs that follow them, and queue the longest jobs first.
+	 */
+	if (!schedule_add_indexes(sourceDB, &schedule))
+	{
+		log_fatal("Failed to add tables to the COPY worker queue, terminating");
+		(void) copydb_fatal_exit();
+		return false;
+	}
+
 	if (!catalog_close_from_specs(specs))
 	{
 		log_error("Failed to close internal catalogs in COPY supervisor, "
@@ -567,6 +701,28 @@ copydb_copy_worker_queue_tables(CopyDataSpec *specs)
 		return false;
 	}
 
+	(void) schedule_sort(&schedule);
+
+	for (int i = 0; i < schedule.count; i++)
+	{
+		ScheduleItem *item = &(schedule.array[i]);
+
+		log_debug("Queueing COPY of table %s part %d, estimated at %.3fs",
+				  item->table->qname,
+				  item->partNumber,
+				  item->cost);
+
+		if (!copydb_add_copy(specs, item->oid, item->partNumber))
+		{
+			log_fatal("Failed to add tables to the COPY worker queue, "
+					  "terminating");
+			(void) copydb_fatal_exit();
+			return false;
+		}
+	}
+
+	(void) schedule_free(&schedule);
+
 	/*
 	 * Add the STOP messages to the queue now, one STOP message per worker.
 	 */
@@ -595,22 +751,19 @@ copydb_copy_supervisor_add_table_hook(void *ctx, SourceTable *table)
 	CopyDataSpec *specs = context->specs;
 	PGSQL *dst = context->dst;
 
-	if (table->partition.partCount == 0)
-	{
-		if (!copydb_add_copy(specs, table->oid, 0))
-		{
-			/* errors have already been logged */
-			return false;
-		}
-	}
-	else
+	if (table->partition.partCount > 0)
 	{
 		/*
-		 * Add as many times the table OID as we have partitions, each with
-		 * their own partition number that starts at 1 (not zero).
+		 * The table OID is queued as many times as we have partitions, each
+		 * with their own partition number that starts at 1 (not zero).
 		 *
 		 * Before adding the table to be processed by workers, truncate it on
 		 * the target database now, avoiding concurrency issues.
+		 *
+		 * When the target database runs with wal_level minimal, the TRUNCATE
+		 * is done in the same transaction as the COPY of the first part
+		 * instead, so that this COPY skips writing WAL. The other parts then
+		 * wait until the first part is done.
 		 */
 		bool granted = false;
 
@@ -620,7 +773,41 @@ copydb_copy_supervisor_add_table_hook(void *ctx, SourceTable *table)
 			return false;
 		}
 
-		if (granted)
+		/*
+		 * With --copy-chunk-size, chunks that have been committed already in
+		 * a previous run are kept on the target: parts resume from there.
+		 */
+		if (granted && specs->copyChunkSize > 0)
+		{
+			DatabaseCatalog *sourceDB = &(specs->catalogs.source);
+			bool hasProgress = false;
+
+			if (!chunk_table_has_progress(sourceDB, table->oid, &hasProgress))
+			{
+				/* errors have already been logged */
+				return false;
+			}
+
+			if (hasProgress)
+			{
+				log_info("Skipping TRUNCATE of table %s, "
+						 "resuming COPY from the last committed chunks",
+						 table->qname);
+				granted = false;
+			}
+		}
+
+		if (granted && copydb_table_truncate_is_deferred(specs, table))
+		{
+			DatabaseCatalog *sourceDB = &(specs->catalogs.source);
+
+			if (!summary_add_table_truncate(sourceDB, table))
+			{
+				/* errors have already been logged */
+				return false;
+			}
+		}
+		else if (granted)
 		{
 			char relkind = '\0';
 
@@ -637,17 +824,14 @@ copydb_copy_supervisor_add_table_hook(void *ctx, SourceTable *table)
 				return false;
 			}
 		}
+	}
 
-		for (int i = 0; i < table->partition.partCount; i++)
-		{
-			int partNumber = i + 1;
+	DatabaseCatalog *sourceDB = &(specs->catalogs.source);
 
-			if (!copydb_add_copy(specs, table->oid, partNumber))
-			{
-				/* errors have already been logged */
-				return false;
-			}
-		}
+	if (!schedule_add_table(sourceDB, context->schedule, table))
+	{
+		/* errors have already been logged */
+		return false;
 	}
 
 	return true;
@@ -700,13 +884,16 @@ copydb_add_copy(CopyDataSpec *specs, uint32_t oid, uint32_t part)
 
 /*
  * copydb_start_table_data_workers create as many sub-process as needed, per
- * --table-jobs.
+ * --table-jobs. When pids is not NULL, it is filled with the pids of the
+ * sub-processes.
  */
 bool
-copydb_start_table_data_workers(CopyDataSpec *specs)
+copydb_start_table_data_workers(CopyDataSpec *specs, pid_t *pids)
 {
 	log_info("STEP 4: starting %d table-data COPY processes", specs->tableJobs);
 
+	concurrency_reset(CONCURRENCY_POOL_COPY);
+
 	for (int i = 0; i < specs->tableJobs; i++)
 	{
 		/*
@@ -743,6 +930,10 @@ copydb_start_table_data_workers(CopyDataSpec *specs)
 			default:
 			{
 				/* fork succeeded, in parent */
+				if (pids != NULL)
+				{
+					pids[i] = fpid;
+				}
 				break;
 			}
 		}
@@ -790,6 +981,20 @@ copydb_table_data_worker(CopyDataSpec *specs)
 		return false;
 	}
 
+	/* also initialize our connections to the --fanout-target databases */
+	for (int i = 0; i < specs->connStrings.fanoutCount; i++)
+	{
+		PGSQL *fanout = &(specs->fanoutDst[i]);
+
+		if (!pgsql_init(fanout,
+						specs->connStrings.fanout_pguri[i],
+						PGSQL_CONN_TARGET))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+	}
+
 	if (!catalog_init_from_specs(specs))
 	{
 		log_error("Failed to open internal catalogs in COPY worker process, "
@@ -801,12 +1006,20 @@ copydb_table_data_worker(CopyDataSpec *specs)
 
 	while (!stop)
 	{
+		/* with --adaptive-jobs, we might have to wait for our turn */
+		if (!concurrency_acquire(CONCURRENCY_POOL_COPY))
+		{
+			log_error("COPY worker has been interrupted");
+			break;
+		}
+
 		QMessage mesg = { 0 };
 		bool recv_ok = queue_receive(&(specs->copyQueue), &mesg);
 
 		if (asked_to_stop || asked_to_stop_fast || asked_to_quit)
 		{
 			log_error("COPY worker has been interrupted");
+			concurrency_release(CONCURRENCY_POOL_COPY);
 			break;
 		}
 
@@ -814,6 +1027,15 @@ copydb_table_data_worker(CopyDataSpec *specs)
 		{
 			log_error("COPY worker failed to receive a message from queue, "
 					  "see above for details");
+			concurrency_release(CONCURRENCY_POOL_COPY);
+			break;
+		}
+
+		/* with --total-jobs, wait until the jobs budget allows for it */
+		if (!concurrency_budget_acquire(CONCURRENCY_POOL_COPY))
+		{
+			log_error("COPY worker has been interrupted");
+			concurrency_release(CONCURRENCY_POOL_COPY);
 			break;
 		}
 
@@ -821,18 +1043,40 @@ copydb_table_data_worker(CopyDataSpec *specs)
 		{
 			case QMSG_TYPE_STOP:
 			{
-				stop = true;
 				log_debug("Stop message received by COPY worker");
+
+				/* parked workers now need to get their STOP message too */
+				concurrency_stopping(CONCURRENCY_POOL_COPY);
+
+				/* before leaving, help with the parts still in progress */
+				if (!copydb_copy_steal_table_parts(specs, src, &dst, &errors))
+				{
+					log_error("COPY worker failed to split table parts "
+							  "still in progress, see above for details");
+					++errors;
+				}
+
+				stop = true;
 				break;
 			}
 
 			case QMSG_TYPE_TABLEPOID:
 			{
-				if (!copydb_copy_data_by_oid(specs,
-											 src,
-											 &dst,
-											 mesg.data.tp.oid,
-											 mesg.data.tp.part))
+				/* with --spool, COPY the data into the spool files */
+				bool success =
+					specs->useSpool
+					? copydb_spool_data_by_oid(specs,
+											   src,
+											   &dst,
+											   mesg.data.tp.oid,
+											   mesg.data.tp.part)
+					: copydb_copy_data_by_oid(specs,
+											  src,
+											  &dst,
+											  mesg.data.tp.oid,
+											  mesg.data.tp.part);
+
+				if (!success)
 				{
 					log_error("Failed to copy data for table with oid %u "
 							  "and part number %u, see above for details",
@@ -843,6 +1087,8 @@ copydb_table_data_worker(CopyDataSpec *specs)
 
 					if (specs->failFast)
 					{
+						concurrency_budget_release(CONCURRENCY_POOL_COPY);
+						concurrency_release(CONCURRENCY_POOL_COPY);
 						pgsql_finish(&dst);
 						return false;
 					}
@@ -853,6 +1099,8 @@ copydb_table_data_worker(CopyDataSpec *specs)
 					if (!copydb_set_snapshot(specs))
 					{
 						/* errors have already been logged */
+						concurrency_budget_release(CONCURRENCY_POOL_COPY);
+						concurrency_release(CONCURRENCY_POOL_COPY);
 						return false;
 					}
 				}
@@ -867,6 +1115,9 @@ copydb_table_data_worker(CopyDataSpec *specs)
 				break;
 			}
 		}
+
+		concurrency_budget_release(CONCURRENCY_POOL_COPY);
+		concurrency_release(CONCURRENCY_POOL_COPY);
 	}
 
 	/* terminate our connection to the source database now */
@@ -874,6 +1125,11 @@ copydb_table_data_worker(CopyDataSpec *specs)
 
 	pgsql_finish(&dst);
 
+	for (int i = 0; i < specs->connStrings.fanoutCount; i++)
+	{
+		pgsql_finish(&(specs->fanoutDst[i]));
+	}
+
 	if (!catalog_delete_process(&(specs->catalogs.source), pid))
 	{
 		log_warn("Failed to delete catalog process entry for pid %d", pid);
@@ -937,11 +1193,14 @@ copydb_copy_data_by_oid(CopyDataSpec *specs, PGSQL *src, PGSQL *dst,
 			  part);
 
 	/*
-	 * Now check that the table still exists on the source server.
+	 * Now check that the table still exists on the source server. When
+	 * draining the --spool there is no source connection, and the spool
+	 * worker did that check already.
 	 */
 	bool tableStillExists = true;
 
-	if (!copydb_check_table_exists(src, table, &tableStillExists))
+	if (src != NULL &&
+		!copydb_check_table_exists(src, table, &tableStillExists))
 	{
 		/* errors have already been logged */
 		return false;
@@ -987,6 +1246,10 @@ copydb_copy_data_by_oid(CopyDataSpec *specs, PGSQL *src, PGSQL *dst,
 	 * run. We still need to process the indexes, constraints, and vacuum.
 	 * So, signal the index and vacuum workers as usual.
 	 */
+	bool truncatingPart =
+		copydb_table_truncate_is_deferred(specs, table) &&
+		table->partition.partNumber == 1;
+
 	if (isDone)
 	{
 		log_info("Skipping table-data %s (%u), already done on a previous run",
@@ -995,6 +1258,17 @@ copydb_copy_data_by_oid(CopyDataSpec *specs, PGSQL *src, PGSQL *dst,
 	}
 	else
 	{
+		/*
+		 * When the first part of the table is responsible for the TRUNCATE,
+		 * the other parts must wait until it's done.
+		 */
+		if (!truncatingPart &&
+			!copydb_wait_for_table_truncate(specs, tableSpecs))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+
 		/*
 		 * 1. Now COPY the TABLE DATA from the source to the destination.
 		 */
@@ -1002,6 +1276,11 @@ copydb_copy_data_by_oid(CopyDataSpec *specs, PGSQL *src, PGSQL *dst,
 		{
 			if (!copydb_copy_table(specs, src, dst, tableSpecs))
 			{
+				if (truncatingPart)
+				{
+					(void) summary_set_table_truncate(sourceDB, table, "failed");
+				}
+
 				/* errors have already been logged */
 				return false;
 			}
@@ -1014,6 +1293,13 @@ copydb_copy_data_by_oid(CopyDataSpec *specs, PGSQL *src, PGSQL *dst,
 		}
 	}
 
+	/* unblock the other parts of the table, also on a resumed run */
+	if (truncatingPart && !summary_set_table_truncate(sourceDB, table, "done"))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
 	if (specs->section == DATA_SECTION_TABLE_DATA)
 	{
 		log_debug("Skip indexes, constraints, vacuum (section: table-data)");
@@ -1068,6 +1354,13 @@ copydb_copy_data_by_oid(CopyDataSpec *specs, PGSQL *src, PGSQL *dst,
 
 			if (tableSpecs->sourceTable->indexCount == 0)
 			{
+				if (!copydb_set_table_logged(specs, dst,
+											 tableSpecs->sourceTable))
+				{
+					/* errors have already been logged */
+					return false;
+				}
+
 				if (!specs->skipVacuum)
 				{
 					SourceTable *sourceTable = tableSpecs->sourceTable;
@@ -1163,6 +1456,50 @@ copydb_table_create_lockfile(CopyDataSpec *specs,
 		}
 	}
 
+	if (!copydb_prepare_copy_args(specs, tableSpecs, dst))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	if (!summary_add_table(sourceDB, tableSpecs))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* also track the process information in our catalogs */
+	ProcessInfo ps = {
+		.pid = getpid(),
+		.psType = "COPY",
+		.psTitle = ps_buffer,
+		.tableOid = tableSpecs->sourceTable->oid,
+		.partNumber = tableSpecs->part.partNumber
+	};
+
+	if (!catalog_upsert_process_info(sourceDB, &ps))
+	{
+		log_error("Failed to track progress in our catalogs, "
+				  "see above for details");
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * copydb_prepare_copy_args prepares the COPY arguments and query for the given
+ * table, including the choice of COPY format and whether we can TRUNCATE the
+ * target table.
+ */
+bool
+copydb_prepare_copy_args(CopyDataSpec *specs,
+						 CopyTableDataSpec *tableSpecs,
+						 PGSQL *dst)
+{
+	DatabaseCatalog *sourceDB = &(specs->catalogs.source);
+
 	/* build the table attributes' list */
 	if (!catalog_s_table_attrlist(sourceDB, tableSpecs->sourceTable))
 	{
@@ -1184,6 +1521,33 @@ copydb_table_create_lockfile(CopyDataSpec *specs,
 	args->truncate = false;     /* default value, see below */
 	args->freeze = tableSpecs->sourceTable->partition.partCount <= 1;
 	args->useCopyBinary = specs->useCopyBinary;
+	args->useCopyThreads = specs->useCopyThreads;
+
+	/*
+	 * With --copy-format auto, use the COPY format that has been computed
+	 * from the table attribute types when fetching the source catalogs.
+	 */
+	if (specs->copyFormat == COPY_FORMAT_AUTO)
+	{
+		SourceTableCopyFormat copyFormat = { 0 };
+
+		if (!catalog_lookup_s_table_copy_format(sourceDB,
+												tableSpecs->sourceTable->oid,
+												&copyFormat))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+
+		args->useCopyBinary = streq(copyFormat.format, "binary");
+
+		log_notice("Table %s uses COPY %s (%s)",
+				   tableSpecs->sourceTable->qname,
+				   args->useCopyBinary ? "BINARY" : "text",
+				   IS_EMPTY_STRING_BUFFER(copyFormat.reason)
+				   ? "unknown attribute types"
+				   : copyFormat.reason);
+	}
 
 	if (args->useCopyBinary)
 	{
@@ -1214,10 +1578,23 @@ copydb_table_create_lockfile(CopyDataSpec *specs,
 	 * top-level rather than for each partition, disabling the COPY FREEZE
 	 * optimisation.
 	 *
+	 * When the target database runs with wal_level minimal, the first part
+	 * of a partitionned COPY is responsible for the TRUNCATE instead, so that
+	 * its COPY skips writing WAL, see copydb_table_truncate_is_deferred.
+	 *
 	 * Second, we need the permission to run the TRUNCATE command on the target
 	 * table on the target database.
 	 */
-	if (tableSpecs->sourceTable->partition.partCount <= 1)
+	bool truncatingPart =
+		copydb_table_truncate_is_deferred(specs, tableSpecs->sourceTable) &&
+		tableSpecs->sourceTable->partition.partNumber == 1;
+
+	if (truncatingPart)
+	{
+		args->freeze = true;
+	}
+
+	if (tableSpecs->sourceTable->partition.partCount <= 1 || truncatingPart)
 	{
 		bool granted = false;
 
@@ -1245,57 +1622,73 @@ copydb_table_create_lockfile(CopyDataSpec *specs,
 		return false;
 	}
 
-	if (!summary_add_table(sourceDB, tableSpecs))
+	return true;
+}
+
+
+/*
+ * copydb_mark_table_as_done creates the table doneFile with the expected
+ * summary content. To create a doneFile we must acquire the synchronisation
+ * semaphore first. The lockFile is also removed here.
+ */
+bool
+copydb_mark_table_as_done(CopyDataSpec *specs,
+						  CopyTableDataSpec *tableSpecs)
+{
+	DatabaseCatalog *sourceDB = &(specs->catalogs.source);
+
+	if (!summary_finish_table(sourceDB, tableSpecs))
 	{
 		/* errors have already been logged */
 		return false;
 	}
 
-	/* also track the process information in our catalogs */
-	ProcessInfo ps = {
-		.pid = getpid(),
-		.psType = "COPY",
-		.psTitle = ps_buffer,
-		.tableOid = tableSpecs->sourceTable->oid,
-		.partNumber = tableSpecs->part.partNumber
-	};
-
-	if (!catalog_upsert_process_info(sourceDB, &ps))
+	if (!summary_increment_timing(sourceDB,
+								  TIMING_SECTION_COPY_DATA,
+								  1, /* count */
+								  tableSpecs->summary.bytesTransmitted,
+								  tableSpecs->summary.durationMs))
 	{
-		log_error("Failed to track progress in our catalogs, "
-				  "see above for details");
+		/* errors have already been logged */
 		return false;
 	}
 
-	return true;
-}
-
-
-/*
- * copydb_mark_table_as_done creates the table doneFile with the expected
- * summary content. To create a doneFile we must acquire the synchronisation
- * semaphore first. The lockFile is also removed here.
- */
-bool
-copydb_mark_table_as_done(CopyDataSpec *specs,
-						  CopyTableDataSpec *tableSpecs)
-{
-	DatabaseCatalog *sourceDB = &(specs->catalogs.source);
-
-	if (!summary_finish_table(sourceDB, tableSpecs))
+	if (tableSpecs->summary.retries > 0 &&
+		!summary_increment_timing(sourceDB,
+								  TIMING_SECTION_COPY_RETRY,
+								  tableSpecs->summary.retries,
+								  0, /* bytes */
+								  tableSpecs->summary.retryMs))
 	{
 		/* errors have already been logged */
 		return false;
 	}
 
-	if (!summary_increment_timing(sourceDB,
-								  TIMING_SECTION_COPY_DATA,
-								  1, /* count */
-								  tableSpecs->summary.bytesTransmitted,
-								  tableSpecs->summary.durationMs))
+	/* wait-time attribution: source wait, target wait, and client time */
+	struct
 	{
-		/* errors have already been logged */
-		return false;
+		TimingSection section;
+		uint64_t durationMs;
+	}
+	waits[] = {
+		{ TIMING_SECTION_COPY_SRC_WAIT, tableSpecs->summary.srcWaitMs },
+		{ TIMING_SECTION_COPY_DST_WAIT, tableSpecs->summary.dstWaitMs },
+		{ TIMING_SECTION_COPY_CLIENT, tableSpecs->summary.clientMs }
+	};
+
+	int count = sizeof(waits) / sizeof(waits[0]);
+
+	for (int i = 0; i < count; i++)
+	{
+		if (!summary_increment_timing(sourceDB,
+									  waits[i].section,
+									  1, /* count */
+									  0, /* bytes */
+									  waits[i].durationMs))
+		{
+			/* errors have already been logged */
+			return false;
+		}
 	}
 
 	return true;
@@ -1334,10 +1727,12 @@ copydb_table_parts_are_all_done(CopyDataSpec *specs,
 	 * If all partitions are done, try and register this worker's PID as the
 	 * first worker that saw the situation. Only that one is allowed to queue
 	 * the CREATE INDEX (or VACUUM) commands.
+	 *
+	 * The count of parts is read again from our catalogs at the same time as
+	 * the count of parts done, because idle workers may add parts to a table
+	 * while it's being copied, see chunk_steal.
 	 */
-	int partCount = tableSpecs->sourceTable->partition.partCount;
-
-	if (tableSpecs->countPartsDone == partCount)
+	if (tableSpecs->countPartsDone == tableSpecs->countParts)
 	{
 		*allPartsDone = true;
 
@@ -1396,11 +1791,26 @@ copydb_copy_table(CopyDataSpec *specs, PGSQL *src, PGSQL *dst,
 
 	bool retry = true;
 	bool success = false;
+	bool frozen = false;
+
+	/* time lost in failed attempts, including the sleep before retrying */
+	instr_time attemptStart;
+	instr_time attemptDuration;
+	uint64_t retryMs = 0;
 
 	while (!success && retry)
 	{
 		++attempts;
 
+		if (attempts > 1)
+		{
+			INSTR_TIME_SET_CURRENT(attemptDuration);
+			INSTR_TIME_SUBTRACT(attemptDuration, attemptStart);
+			retryMs += INSTR_TIME_GET_MILLISEC(attemptDuration);
+		}
+
+		INSTR_TIME_SET_CURRENT(attemptStart);
+
 		/* re-init stats between attempts */
 		CopyStats empty = { 0 };
 		stats = empty;
@@ -1410,10 +1820,60 @@ copydb_copy_table(CopyDataSpec *specs, PGSQL *src, PGSQL *dst,
 			.tableSpecs = tableSpecs
 		};
 
+		/*
+		 * With --fanout-target, skip the targets that already have the table
+		 * data from a previous attempt or a previous run.
+		 */
+		PGSQL *dsts[COPY_MAX_TARGETS] = { 0 };
+		int targets[COPY_MAX_TARGETS] = { 0 };
+		int dstCount = 0;
+
+		if (!copydb_prepare_copy_targets(specs, tableSpecs, dst,
+										 dsts, targets, &dstCount))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+
+		if (dstCount == 0)
+		{
+			log_notice("Table %s COPY is already done on all targets",
+					   tableSpecs->sourceTable->qname);
+			success = true;
+			break;
+		}
+
 		/* ignore previous attempts, we need only one success here */
-		success = pg_copy(src, dst,
-						  &(tableSpecs->copyArgs), &stats,
-						  &context, &copydb_update_copy_stats_hook);
+		if (specs->useSpool)
+		{
+			success = copydb_drain_table(specs, dst, tableSpecs, &stats,
+										 &context,
+										 &copydb_update_copy_stats_hook);
+		}
+		else if (copydb_copy_table_use_chunks(specs, tableSpecs))
+		{
+			/* chunks resume from the last one committed on the target */
+			success = copydb_copy_table_chunks(specs, src, dsts[0], tableSpecs,
+											   &stats, &context,
+											   &copydb_update_copy_stats_hook);
+		}
+		else
+		{
+			success = pg_copy_fanout(src, dsts, dstCount,
+									 &(tableSpecs->copyArgs), &stats,
+									 &context, &copydb_update_copy_stats_hook);
+
+			/* pg_copy_fanout disables COPY FREEZE when it can not be used */
+			frozen = success && tableSpecs->copyArgs.freeze;
+		}
+
+		/* some targets may have succeeded even when others have failed */
+		if (!copydb_mark_copy_targets_done(specs, tableSpecs,
+										   &stats, dsts, targets))
+		{
+			/* errors have already been logged */
+			return false;
+		}
 
 		if (success)
 		{
@@ -1432,8 +1892,8 @@ copydb_copy_table(CopyDataSpec *specs, PGSQL *src, PGSQL *dst,
 			attempts < maxAttempts &&
 
 			/* retry only on Connection Exception errors */
-			(pgsql_state_is_connection_error(src) ||
-			 pgsql_state_is_connection_error(dst));
+			((src != NULL && pgsql_state_is_connection_error(src)) ||
+			 copydb_targets_have_connection_error(dsts, dstCount));
 
 		if (maxAttempts <= attempts)
 		{
@@ -1466,10 +1926,236 @@ copydb_copy_table(CopyDataSpec *specs, PGSQL *src, PGSQL *dst,
 	/* publish bytesTransmitted accumulated value to the summary */
 	summary->bytesTransmitted = stats.bytesTransmitted;
 
+	/* publish where the COPY spent its time to the summary */
+	copydb_copy_stats_to_summary(&stats, summary);
+
+	if (success)
+	{
+		log_notice("Table %s COPY: %lld rows, %lld messages, "
+				   "source wait %lldms, target wait %lldms, "
+				   "throttle %lldms, client %lldms",
+				   tableSpecs->sourceTable->qname,
+				   (long long) summary->copyRows,
+				   (long long) summary->copyMessages,
+				   (long long) summary->srcWaitMs,
+				   (long long) summary->dstWaitMs,
+				   (long long) summary->throttleMs,
+				   (long long) summary->clientMs);
+	}
+
+	/* publish retries and the time they cost to the summary */
+	summary->retries = attempts - 1;
+	summary->retryMs = retryMs;
+
+	/*
+	 * With wal_level minimal, a COPY in the same transaction as the TRUNCATE
+	 * skips writing WAL. Drained spool segments after the first one use their
+	 * own transaction, and so do chunks, so we only report the single COPY
+	 * case here.
+	 */
+	summary->walSkipped =
+		success &&
+		specs->walSkip &&
+		!specs->useSpool &&
+		!copydb_copy_table_use_chunks(specs, tableSpecs) &&
+		tableSpecs->copyArgs.truncate;
+
+	if (summary->walSkipped)
+	{
+		log_notice("Table %s COPY skipped writing WAL (wal_level is minimal)",
+				   tableSpecs->sourceTable->qname);
+	}
+
+	/*
+	 * Spool segments and chunks are copied without FREEZE, and so the VACUUM
+	 * step only skips tables where all the parts have been loaded frozen by
+	 * a single COPY, see vacuum_prepare_command. With --unlogged-load the
+	 * table is rewritten by ALTER TABLE ... SET LOGGED, which loses the frozen
+	 * pages, so it needs its VACUUM.
+	 */
+	summary->frozen = frozen && !specs->unloggedLoad;
+
+	/* publish --use-copy-threads ring statistics to the summary */
+	summary->ringDepth = stats.ringDepth;
+	summary->ringSamples = stats.ringSamples;
+	summary->ringOccupancy = stats.ringOccupancy;
+	summary->ringFull = stats.ringFull;
+	summary->ringEmpty = stats.ringEmpty;
+
+	if (stats.ringDepth > 0)
+	{
+		log_notice("Table %s COPY ring: depth %d, average occupancy %.2f, "
+				   "reader stalls %lld, writer stalls %lld",
+				   tableSpecs->sourceTable->qname,
+				   stats.ringDepth,
+				   stats.ringSamples > 0
+				   ? (double) stats.ringOccupancy / (double) stats.ringSamples
+				   : 0.0,
+				   (long long) stats.ringFull,
+				   (long long) stats.ringEmpty);
+	}
+
 	return success;
 }
 
 
+/*
+ * copydb_prepare_copy_targets prepares the list of target connections for a
+ * table COPY: the --target database and the --fanout-target databases, if
+ * any, skipping the targets where the table data has already been copied. The
+ * targets array is filled with the target number of each connection, 0 being
+ * the --target database.
+ */
+bool
+copydb_prepare_copy_targets(CopyDataSpec *specs,
+							CopyTableDataSpec *tableSpecs,
+							PGSQL *dst,
+							PGSQL **dsts,
+							int *targets,
+							int *dstCount)
+{
+	DatabaseCatalog *sourceDB = &(specs->catalogs.source);
+	CopyTableSummary *summary = &(tableSpecs->summary);
+
+	*dstCount = 0;
+
+	/* without --fanout-target, COPY to the main target only */
+	if (specs->connStrings.fanoutCount == 0)
+	{
+		dsts[0] = dst;
+		targets[0] = 0;
+		*dstCount = 1;
+
+		return true;
+	}
+
+	if (!summary_lookup_table_targets(sourceDB, tableSpecs))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	for (int t = 0; t <= specs->connStrings.fanoutCount; t++)
+	{
+		if (summary->targets[t].done)
+		{
+			log_notice("Skipping table %s on target %d, already done",
+					   tableSpecs->sourceTable->qname,
+					   t);
+			continue;
+		}
+
+		PGSQL *pgsql = t == 0 ? dst : &(specs->fanoutDst[t - 1]);
+
+		/* (re-)open the fan-out target connection and set GUC values */
+		if (t > 0 && pgsql->connection == NULL)
+		{
+			if (!pgsql_set_gucs(pgsql, dstSettings))
+			{
+				log_error("Failed to set our GUC settings on the fan-out "
+						  "target %d connection, see above for details",
+						  t);
+				return false;
+			}
+		}
+
+		dsts[*dstCount] = pgsql;
+		targets[*dstCount] = t;
+		++(*dstCount);
+	}
+
+	return true;
+}
+
+
+/*
+ * copydb_mark_copy_targets_done registers the per-target COPY summary in our
+ * catalogs when using --fanout-target, so that a retry or a --resume run only
+ * copies the table data to the targets that don't have it yet. Connections to
+ * the fan-out targets that failed are closed, to be opened again at the next
+ * attempt.
+ */
+bool
+copydb_mark_copy_targets_done(CopyDataSpec *specs,
+							  CopyTableDataSpec *tableSpecs,
+							  CopyStats *stats,
+							  PGSQL **dsts,
+							  int *targets)
+{
+	DatabaseCatalog *sourceDB = &(specs->catalogs.source);
+	CopyTableSummary *summary = &(tableSpecs->summary);
+
+	if (specs->connStrings.fanoutCount == 0)
+	{
+		return true;
+	}
+
+	for (int i = 0; i < stats->targetCount; i++)
+	{
+		CopyTargetStats *targetStats = &(stats->targets[i]);
+		int t = targets[i];
+
+		if (!targetStats->done)
+		{
+			if (t > 0)
+			{
+				pgsql_finish(dsts[i]);
+			}
+
+			continue;
+		}
+
+		CopyTargetSummary *targetSummary = &(summary->targets[t]);
+
+		targetSummary->target = t;
+		targetSummary->done = true;
+		targetSummary->pid = getpid();
+		targetSummary->doneTime = time(NULL);
+		targetSummary->bytesTransmitted = targetStats->bytesTransmitted;
+		targetSummary->stalls = targetStats->stalls;
+
+		if (!summary_finish_table_target(sourceDB, tableSpecs, t))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+
+		char bytesPretty[BUFSIZE] = { 0 };
+
+		(void) pretty_print_bytes(bytesPretty,
+								  sizeof(bytesPretty),
+								  targetStats->bytesTransmitted);
+
+		log_notice("Table %s COPY done on target %d: %s, %lld stalls",
+				   tableSpecs->sourceTable->qname,
+				   t,
+				   bytesPretty,
+				   (long long) targetStats->stalls);
+	}
+
+	return true;
+}
+
+
+/*
+ * copydb_targets_have_connection_error returns true when any of the given
+ * target connections had a Connection Exception error.
+ */
+static bool
+copydb_targets_have_connection_error(PGSQL **dsts, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (pgsql_state_is_connection_error(dsts[i]))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
 /*
  * copydb_update_copy_stats_hook updates the bytesTransmitted data in our
  * SQLite summary.
@@ -1507,6 +2193,8 @@ copydb_update_copy_stats_hook(void *ctx, CopyStats *stats)
 	/* update tablespecs summary durationMs and bytesTransmitted */
 	summary->bytesTransmitted = stats->bytesTransmitted;
 
+	copydb_copy_stats_to_summary(stats, summary);
+
 	instr_time duration;
 
 	INSTR_TIME_SET_CURRENT(duration);
@@ -1527,6 +2215,40 @@ copydb_update_copy_stats_hook(void *ctx, CopyStats *stats)
 }
 
 
+/*
+ * copydb_copy_stats_to_summary publishes the COPY wait-time attribution from
+ * the given stats to the table summary, in milliseconds.
+ *
+ * While the COPY is running the client time is not known yet, so we report
+ * the time that is not accounted for by known waits: that's the client time,
+ * plus the current wait, if any.
+ */
+static void
+copydb_copy_stats_to_summary(CopyStats *stats, CopyTableSummary *summary)
+{
+	summary->copyRows = stats->rows;
+	summary->copyMessages = stats->messages;
+	summary->srcWaitMs = stats->srcWaitUs / 1000;
+	summary->dstWaitMs = stats->dstWaitUs / 1000;
+	summary->throttleMs = stats->throttleUs / 1000;
+	summary->clientMs = stats->clientUs / 1000;
+
+	if (stats->clientUs == 0)
+	{
+		instr_time duration;
+
+		INSTR_TIME_SET_CURRENT(duration);
+		INSTR_TIME_SUBTRACT(duration, summary->startTimeInstr);
+
+		uint64_t totalMs = INSTR_TIME_GET_MILLISEC(duration);
+		uint64_t waitMs =
+			summary->srcWaitMs + summary->dstWaitMs + summary->throttleMs;
+
+		summary->clientMs = totalMs > waitMs ? totalMs - waitMs : 0;
+	}
+}
+
+
 /*
  * copydb_prepare_copy_query prepares a COPY query using the list of attribute
  * names from the SourceTable instance.
@@ -1564,6 +2286,38 @@ copydb_prepare_copy_query(CopyTableDataSpec *tableSpecs, CopyArgs *args)
 								  (long long) tableSpecs->part.max + 1);
 			}
 		}
+		else if (tableSpecs->part.typed)
+		{
+			/*
+			 * Row-wise comparisons of the key columns with typed literals
+			 * allow range scans on the unique key index.
+			 */
+			if (IS_EMPTY_STRING_BUFFER(tableSpecs->part.minKey))
+			{
+				appendPQExpBuffer(srcWhereClause,
+								  "WHERE (%s) < (%s)",
+								  tableSpecs->part.partKey,
+								  tableSpecs->part.maxKey);
+			}
+
+			/* the last partition has no upper bound */
+			else if (IS_EMPTY_STRING_BUFFER(tableSpecs->part.maxKey))
+			{
+				appendPQExpBuffer(srcWhereClause,
+								  "WHERE (%s) >= (%s)",
+								  tableSpecs->part.partKey,
+								  tableSpecs->part.minKey);
+			}
+			else
+			{
+				appendPQExpBuffer(srcWhereClause,
+								  "WHERE (%s) >= (%s) AND (%s) < (%s)",
+								  tableSpecs->part.partKey,
+								  tableSpecs->part.minKey,
+								  tableSpecs->part.partKey,
+								  tableSpecs->part.maxKey);
+			}
+		}
 		else
 		{
 			/* partition to take care of NULL values */
@@ -2111,3 +2865,152 @@ copydb_table_data_worker_multidb(CopyDataSpec *parentSpecs)
 
 	return stop == true && errors == 0;
 }
+
+
+/*
+ * copydb_check_wal_skip checks the target database wal_level. When it is
+ * minimal, Postgres skips writing WAL for a COPY that runs in the same
+ * transaction as the TRUNCATE (or CREATE TABLE) of the target table, and
+ * fsyncs the table files at COMMIT time instead.
+ */
+bool
+copydb_check_wal_skip(CopyDataSpec *specs)
+{
+	PGSQL dst = { 0 };
+
+	if (!pgsql_init(&dst, specs->connStrings.target_pguri, PGSQL_CONN_TARGET))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	char walLevel[BUFSIZE] = { 0 };
+
+	if (!pgsql_get_wal_level(&dst, walLevel, sizeof(walLevel)))
+	{
+		/* errors have already been logged */
+		(void) pgsql_finish(&dst);
+		return false;
+	}
+
+	(void) pgsql_finish(&dst);
+
+	specs->walSkip = streq(walLevel, "minimal");
+
+	if (specs->walSkip)
+	{
+		log_info("Target database wal_level is minimal: "
+				 "COPY skips writing WAL after TRUNCATE");
+	}
+	else
+	{
+		log_debug("Target database wal_level is %s", walLevel);
+	}
+
+	return true;
+}
+
+
+/*
+ * copydb_table_truncate_is_deferred returns true when the TRUNCATE of a
+ * partitionned COPY is done by its first part, in the same transaction as
+ * the COPY, rather than by the supervisor before queueing the parts.
+ *
+ * That's only interesting when the target database runs with wal_level
+ * minimal. With --spool the drain workers process segments in queue order,
+ * and waiting for the first part could then block all of them, so we keep
+ * the up-front TRUNCATE in that case. With --copy-chunk-size only the first
+ * chunk would skip WAL, which is not worth waiting for either.
+ */
+bool
+copydb_table_truncate_is_deferred(CopyDataSpec *specs, SourceTable *table)
+{
+	return specs->walSkip &&
+		   !specs->useSpool &&
+		   specs->copyChunkSize == 0 &&
+		   table->partition.partCount > 1;
+}
+
+
+/*
+ * copydb_wait_for_table_truncate waits until the first part of a partitionned
+ * COPY is done, when that part is responsible for the TRUNCATE of the target
+ * table.
+ *
+ * The --total-jobs budget token is given back while waiting, otherwise the
+ * waiting parts could take all the tokens and the first part would never get
+ * one.
+ */
+static bool
+copydb_wait_for_table_truncate(CopyDataSpec *specs,
+							   CopyTableDataSpec *tableSpecs)
+{
+	DatabaseCatalog *sourceDB = &(specs->catalogs.source);
+	SourceTable *table = tableSpecs->sourceTable;
+
+	if (!copydb_table_truncate_is_deferred(specs, table))
+	{
+		return true;
+	}
+
+	bool logged = false;
+	bool released = false;
+	bool success = false;
+
+	while (true)
+	{
+		char state[NAMEDATALEN] = { 0 };
+
+		if (!summary_lookup_table_truncate(sourceDB, table,
+										   state, sizeof(state)))
+		{
+			/* errors have already been logged */
+			break;
+		}
+
+		/* no registered TRUNCATE: the supervisor did it up-front */
+		if (IS_EMPTY_STRING_BUFFER(state) || streq(state, "done"))
+		{
+			success = true;
+			break;
+		}
+
+		if (streq(state, "failed"))
+		{
+			log_error("Failed to copy table %s part %d: "
+					  "the first part failed to TRUNCATE and COPY",
+					  table->qname,
+					  table->partition.partNumber);
+			break;
+		}
+
+		if (asked_to_stop || asked_to_stop_fast || asked_to_quit)
+		{
+			break;
+		}
+
+		if (!logged)
+		{
+			log_notice("Table %s part %d waits for the first part to be done",
+					   table->qname,
+					   table->partition.partNumber);
+			logged = true;
+
+			if (concurrency_budget_held(CONCURRENCY_POOL_COPY))
+			{
+				concurrency_budget_release(CONCURRENCY_POOL_COPY);
+				released = true;
+			}
+		}
+
+		pg_usleep(100 * 1000);  /* 100ms */
+	}
+
+	/* take a --total-jobs budget token again before we COPY */
+	if (success && released)
+	{
+		success = concurrency_budget_acquire(CONCURRENCY_POOL_COPY);
+	}
+
+	return success;
+}
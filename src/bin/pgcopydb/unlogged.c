@@ -0,0 +1,283 @@
+/*
+ * src/bin/pgcopydb/unlogged.c
+ *     Implementation of the --unlogged-load option: target tables are switched
+ *     to UNLOGGED before COPY, and back to LOGGED once their indexes and
+ *     constraints have been built.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+#include "catalog.h"
+#include "copydb.h"
+#include "log.h"
+#include "signals.h"
+#include "summary.h"
+
+
+typedef struct UnloggedContext
+{
+	CopyDataSpec *specs;
+	PGSQL *dst;
+	int count;
+} UnloggedContext;
+
+
+static bool copydb_set_table_unlogged_hook(void *ctx, SourceTable *table);
+static bool copydb_set_table_logged_hook(void *ctx, SourceTable *table);
+
+
+/*
+ * copydb_set_tables_unlogged switches the target tables to UNLOGGED before
+ * the COPY workers are started, so that the table data is not written to the
+ * target WAL. Only tables that are permanent on the target are switched, and
+ * registered in our catalogs to be switched back to LOGGED later.
+ */
+bool
+copydb_set_tables_unlogged(CopyDataSpec *specs)
+{
+	DatabaseCatalog *sourceDB = &(specs->catalogs.source);
+
+	if (specs->runState.tableCopyIsDone)
+	{
+		log_info("Skipping SET UNLOGGED, table data is already done");
+		return true;
+	}
+
+	PGSQL dst = { 0 };
+
+	if (!pgsql_init(&dst, specs->connStrings.target_pguri, PGSQL_CONN_TARGET))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	UnloggedContext context = { .specs = specs, .dst = &dst };
+
+	if (!catalog_iter_s_table(sourceDB, &context,
+							  &copydb_set_table_unlogged_hook))
+	{
+		log_error("Failed to switch target tables to UNLOGGED, "
+				  "see above for details");
+		(void) pgsql_finish(&dst);
+		return false;
+	}
+
+	(void) pgsql_finish(&dst);
+
+	log_info("Switched %d tables to UNLOGGED on the target database",
+			 context.count);
+
+	return true;
+}
+
+
+/*
+ * copydb_set_table_unlogged_hook is an iterator callback function.
+ */
+static bool
+copydb_set_table_unlogged_hook(void *ctx, SourceTable *table)
+{
+	UnloggedContext *context = (UnloggedContext *) ctx;
+	DatabaseCatalog *sourceDB = &(context->specs->catalogs.source);
+
+	/* only ordinary tables with data to COPY are considered */
+	if (table->relkind != 'r' || table->excludeData)
+	{
+		return true;
+	}
+
+	/* skip tables that we already switched in a previous run */
+	CopyUnloggedTableSummary summary = { .table = table };
+
+	if (!summary_lookup_unlogged(sourceDB, &summary))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	if (summary.unloggedTime > 0)
+	{
+		return true;
+	}
+
+	/* skip tables that are UNLOGGED (or TEMP) in the schema already */
+	char relpersistence = 0;
+
+	if (!pgsql_get_table_relpersistence(context->dst,
+										table->qname,
+										&relpersistence))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	if (relpersistence != 'p')
+	{
+		return true;
+	}
+
+	char sql[BUFSIZE] = { 0 };
+
+	sformat(sql, sizeof(sql), "ALTER TABLE %s SET UNLOGGED", table->qname);
+
+	log_debug("%s;", sql);
+
+	/*
+	 * Some tables can not be switched to UNLOGGED, for instance when they are
+	 * part of a publication on the target. Those are copied as usual.
+	 */
+	if (!pgsql_execute(context->dst, sql))
+	{
+		log_warn("Failed to switch table %s to UNLOGGED, "
+				 "copying it as a LOGGED table",
+				 table->qname);
+		return true;
+	}
+
+	if (!summary_add_unlogged(sourceDB, &summary))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	++context->count;
+
+	return true;
+}
+
+
+/*
+ * copydb_set_table_logged switches the given table back to LOGGED on the
+ * target database, when --unlogged-load switched it to UNLOGGED before. This
+ * happens once all the table parts have been copied and all the indexes and
+ * constraints have been built, just before the table is sent to VACUUM.
+ */
+bool
+copydb_set_table_logged(CopyDataSpec *specs, PGSQL *dst, SourceTable *table)
+{
+	DatabaseCatalog *sourceDB = &(specs->catalogs.source);
+	CopyUnloggedTableSummary summary = { .table = table };
+
+	if (!specs->unloggedLoad)
+	{
+		return true;
+	}
+
+	if (!summary_lookup_unlogged(sourceDB, &summary))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	/* skip tables that are not UNLOGGED, or already LOGGED again */
+	if (summary.unloggedTime == 0 || summary.doneTime > 0)
+	{
+		return true;
+	}
+
+	char sql[BUFSIZE] = { 0 };
+
+	sformat(sql, sizeof(sql), "ALTER TABLE %s SET LOGGED", table->qname);
+
+	/* also set the process title for this specific table */
+	char psTitle[BUFSIZE] = { 0 };
+	sformat(psTitle, sizeof(psTitle), "pgcopydb: %s", sql);
+	(void) set_ps_title(psTitle);
+
+	log_notice("%s;", sql);
+
+	summary.startTime = time(NULL);
+	INSTR_TIME_SET_CURRENT(summary.startTimeInstr);
+
+	if (!pgsql_execute(dst, sql))
+	{
+		log_error("Failed to run command, see above for details: %s", sql);
+		return false;
+	}
+
+	summary.doneTime = time(NULL);
+
+	INSTR_TIME_SET_CURRENT(summary.durationInstr);
+	INSTR_TIME_SUBTRACT(summary.durationInstr, summary.startTimeInstr);
+
+	summary.durationMs = INSTR_TIME_GET_MILLISEC(summary.durationInstr);
+
+	if (!summary_finish_unlogged(sourceDB, &summary))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	if (!summary_increment_timing(sourceDB,
+								  TIMING_SECTION_SET_LOGGED,
+								  1, /* count */
+								  0, /* bytes */
+								  summary.durationMs))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * copydb_set_tables_logged switches back to LOGGED any table that is still
+ * UNLOGGED at the end of the table data step. Tables are normally switched in
+ * the index and vacuum chain already, this is a safety net for resumed runs
+ * where that chain has been skipped.
+ */
+bool
+copydb_set_tables_logged(CopyDataSpec *specs)
+{
+	DatabaseCatalog *sourceDB = &(specs->catalogs.source);
+
+	if (!specs->unloggedLoad)
+	{
+		return true;
+	}
+
+	if (!catalog_open(sourceDB))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	PGSQL dst = { 0 };
+
+	if (!pgsql_init(&dst, specs->connStrings.target_pguri, PGSQL_CONN_TARGET))
+	{
+		/* errors have already been logged */
+		return false;
+	}
+
+	UnloggedContext context = { .specs = specs, .dst = &dst };
+
+	if (!catalog_iter_s_table(sourceDB, &context,
+							  &copydb_set_table_logged_hook))
+	{
+		log_error("Failed to switch target tables to LOGGED, "
+				  "see above for details");
+		(void) pgsql_finish(&dst);
+		return false;
+	}
+
+	(void) pgsql_finish(&dst);
+
+	return true;
+}
+
+
+/*
+ * copydb_set_table_logged_hook is an iterator callback function.
+ */
+static bool
+copydb_set_table_logged_hook(void *ctx, SourceTable *table)
+{
+	UnloggedContext *context = (UnloggedContext *) ctx;
+
+	return copydb_set_table_logged(context->specs, context->dst, table);
+}
@@ -10,6 +10,7 @@
 
 #include "catalog.h"
 #include "cli_root.h"
+#include "concurrency.h"
 #include "copydb.h"
 #include "env_utils.h"
 #include "lock_utils.h"
@@ -17,6 +18,17 @@
 #include "signals.h"
 #include "summary.h"
 
+static bool vacuum_lookup_table_stats(CopyDataSpec *specs,
+									  PGSQL *dst,
+									  SourceTable *table,
+									  SourceTablePgStats *stats);
+static bool vacuum_prepare_command(CopyDataSpec *specs,
+								   PGSQL *dst,
+								   CopyTableDataSpec *tableSpecs);
+static bool vacuum_set_parallel(CopyDataSpec *specs,
+								PGSQL *dst,
+								CopyTableDataSpec *tableSpecs);
+
 /*
  * vacuum_start_supervisor starts a VACUUM supervisor process.
  */
@@ -236,6 +248,13 @@ vacuum_worker(CopyDataSpec *specs)
 	 */
 	MultiDbContext vacCtx = { 0 };
 
+	/*
+	 * Singledb path: the target connection is opened at the first table and
+	 * then re-used for all the tables, see copydb_prepare_target_connection.
+	 */
+	PGSQL dst = { 0 };
+	ConnectionReuse reuse = { 0 };
+
 	if (specs->allDatabases)
 	{
 		if (!multidb_context_init(&vacCtx, specs))
@@ -244,6 +263,16 @@ vacuum_worker(CopyDataSpec *specs)
 			return false;
 		}
 	}
+	else
+	{
+		char *pguri = specs->connStrings.target_pguri;
+
+		if (!pgsql_init(&dst, pguri, PGSQL_CONN_TARGET))
+		{
+			/* errors have already been logged */
+			return false;
+		}
+	}
 
 	int errors = 0;
 	bool stop = false;
@@ -256,6 +285,7 @@ vacuum_worker(CopyDataSpec *specs)
 		if (asked_to_stop || asked_to_stop_fast || asked_to_quit)
 		{
 			log_error("VACUUM worker has been interrupted");
+			(void) pgsql_finish(&dst);
 			(void) multidb_index_context_close_all(&vacCtx);
 			return false;
 		}
@@ -263,6 +293,16 @@ vacuum_worker(CopyDataSpec *specs)
 		if (!recv_ok)
 		{
 			/* errors have already been logged */
+			(void) pgsql_finish(&dst);
+			(void) multidb_index_context_close_all(&vacCtx);
+			return false;
+		}
+
+		/* with --total-jobs, wait until the jobs budget allows for it */
+		if (!concurrency_budget_acquire(CONCURRENCY_POOL_VACUUM))
+		{
+			log_error("VACUUM worker has been interrupted");
+			(void) pgsql_finish(&dst);
 			(void) multidb_index_context_close_all(&vacCtx);
 			return false;
 		}
@@ -280,6 +320,7 @@ vacuum_worker(CopyDataSpec *specs)
 			{
 				uint32_t oid = mesg.data.tp.oid;
 				CopyDataSpec *useSpecs = specs;
+				PGSQL *useDst = &dst;
 
 				if (specs->allDatabases)
 				{
@@ -296,6 +337,8 @@ vacuum_worker(CopyDataSpec *specs)
 
 						if (specs->failFast)
 						{
+							concurrency_budget_release(CONCURRENCY_POOL_VACUUM);
+							(void) pgsql_finish(&dst);
 							(void) multidb_index_context_close_all(&vacCtx);
 							return false;
 						}
@@ -303,9 +346,11 @@ vacuum_worker(CopyDataSpec *specs)
 					}
 
 					useSpecs = entry->dbSpecs;
+					useDst = &entry->dst;
 				}
 
-				if (!vacuum_analyze_table_by_oid(useSpecs, oid))
+				if (!copydb_prepare_target_connection(useDst, &reuse) ||
+					!vacuum_analyze_table_by_oid(useSpecs, useDst, oid))
 				{
 					++errors;
 
@@ -315,6 +360,8 @@ vacuum_worker(CopyDataSpec *specs)
 
 					if (specs->failFast)
 					{
+						concurrency_budget_release(CONCURRENCY_POOL_VACUUM);
+						(void) pgsql_finish(&dst);
 						(void) multidb_index_context_close_all(&vacCtx);
 						return false;
 					}
@@ -330,10 +377,19 @@ vacuum_worker(CopyDataSpec *specs)
 				break;
 			}
 		}
+
+		concurrency_budget_release(CONCURRENCY_POOL_VACUUM);
 	}
 
+	(void) pgsql_finish(&dst);
 	(void) multidb_index_context_close_all(&vacCtx);
 
+	if (!copydb_report_connection_reuse(&(specs->catalogs.source), &reuse))
+	{
+		log_warn("Failed to register connection re-use timings, "
+				 "see above for details");
+	}
+
 	if (!catalog_delete_process(&(specs->catalogs.source), pid))
 	{
 		log_warn("Failed to delete catalog process entry for pid %d", pid);
@@ -361,11 +417,18 @@ vacuum_worker(CopyDataSpec *specs)
 
 /*
  * vacuum_analyze_table_by_oid reads the done file for the given table OID,
- * fetches the schemaname and relname from there, and then connects to the
- * target database to issue a VACUUM ANALYZE command.
+ * fetches the schemaname and relname from there, and then uses the given
+ * target database connection to issue a VACUUM ANALYZE command.
+ *
+ * On Postgres 18 targets, when we have exported the planner statistics of the
+ * table from the source database, we import them instead and only run VACUUM
+ * on the target, which still sets the visibility map and hint bits.
+ *
+ * Tables loaded with COPY FREEZE are already all-visible and frozen, and are
+ * only analyzed when needed. See vacuum_prepare_command for details.
  */
 bool
-vacuum_analyze_table_by_oid(CopyDataSpec *specs, uint32_t oid)
+vacuum_analyze_table_by_oid(CopyDataSpec *specs, PGSQL *dst, uint32_t oid)
 {
 	DatabaseCatalog *sourceDB = &(specs->catalogs.source);
 	SourceTable table = { 0 };
@@ -381,6 +444,7 @@ vacuum_analyze_table_by_oid(CopyDataSpec *specs, uint32_t oid)
 	log_trace("vacuum_analyze_table_by_oid: %u %s", table.oid, table.qname);
 
 	CopyTableDataSpec tableSpecs = { 0 };
+	CopyVacuumTableSummary *vacuumSummary = &(tableSpecs.vSummary);
 
 	/* vacuum is done per table, irrespective of the COPY partitioning */
 	if (!copydb_init_table_specs(&tableSpecs, specs, &table, 0))
@@ -389,82 +453,298 @@ vacuum_analyze_table_by_oid(CopyDataSpec *specs, uint32_t oid)
 		return false;
 	}
 
-	PGSQL dst = { 0 };
+	SourceTablePgStats stats = { 0 };
 
-	/* initialize our connection to the target database */
-	if (!pgsql_init(&dst, specs->connStrings.target_pguri, PGSQL_CONN_TARGET))
+	if (!vacuum_lookup_table_stats(specs, dst, &table, &stats))
 	{
 		/* errors have already been logged */
 		return false;
 	}
 
-	/* finally, vacuum analyze the table and its indexes */
-	char vacuum[BUFSIZE] = { 0 };
+	if (!summary_add_vacuum(sourceDB, &tableSpecs))
+	{
+		/* errors have already been logged */
+		free(stats.sql);
+		return false;
+	}
+
+	if (stats.sql != NULL)
+	{
+		log_notice("Importing planner statistics for table %s", table.qname);
+
+		vacuumSummary->statsImported = pgsql_execute(dst, stats.sql);
+
+		if (!vacuumSummary->statsImported)
+		{
+			log_warn("Failed to import planner statistics for table %s, "
+					 "running ANALYZE instead",
+					 table.qname);
+		}
+
+		free(stats.sql);
+	}
 
-	sformat(vacuum, sizeof(vacuum),
-			"VACUUM ANALYZE %s.%s",
-			table.nspname,
-			table.relname);
+	if (!vacuum_prepare_command(specs, dst, &tableSpecs))
+	{
+		/* errors have already been logged */
+		return false;
+	}
 
-	/* also set the process title for this specific table */
-	char psTitle[BUFSIZE] = { 0 };
-	sformat(psTitle, sizeof(psTitle), "pgcopydb: %s", vacuum);
-	(void) set_ps_title(psTitle);
+	char *command = vacuumSummary->command;
 
-	if (specs->datname[0] != '\0')
+	if (IS_EMPTY_STRING_BUFFER(command))
 	{
-		log_notice("%s: %s;", specs->datname, vacuum);
+		log_notice("Skipping VACUUM of table %s: loaded with COPY FREEZE "
+				   "and planner statistics imported",
+				   table.qname);
 	}
 	else
 	{
-		log_notice("%s;", vacuum);
+		/* also set the process title for this specific table */
+		char psTitle[BUFSIZE] = { 0 };
+		sformat(psTitle, sizeof(psTitle), "pgcopydb: %s", command);
+		(void) set_ps_title(psTitle);
+
+		if (specs->datname[0] != '\0')
+		{
+			log_notice("%s: %s;", specs->datname, command);
+		}
+		else
+		{
+			log_notice("%s;", command);
+		}
+
+		/* also track the process information in our catalogs */
+		ProcessInfo ps = {
+			.pid = getpid(),
+			.psType = "VACUUM",
+			.psTitle = ps_buffer,
+			.tableOid = table.oid
+		};
+
+		if (!catalog_upsert_process_info(sourceDB, &ps))
+		{
+			log_error("Failed to track progress in our catalogs, "
+					  "see above for details");
+			return false;
+		}
+
+		if (!pgsql_execute(dst, command))
+		{
+			log_error("Failed to run command, see above for details: %s",
+					  command);
+			return false;
+		}
 	}
 
-	/* also track the process information in our catalogs */
-	ProcessInfo ps = {
-		.pid = getpid(),
-		.psType = "VACUUM",
-		.psTitle = ps_buffer,
-		.tableOid = table.oid
-	};
+	if (!summary_finish_vacuum(sourceDB, &tableSpecs))
+	{
+		/* errors have already been logged */
+		return false;
+	}
 
-	if (!catalog_upsert_process_info(sourceDB, &ps))
+	if (!summary_increment_timing(sourceDB,
+								  TIMING_SECTION_VACUUM,
+								  1, /* count */
+								  0, /* bytes */
+								  vacuumSummary->durationMs))
 	{
-		log_error("Failed to track progress in our catalogs, "
-				  "see above for details");
+		/* errors have already been logged */
 		return false;
 	}
 
-	if (!summary_add_vacuum(sourceDB, &tableSpecs))
+	return true;
+}
+
+
+/*
+ * vacuum_prepare_command prepares the command to run on the target database
+ * for the given table, and registers the decisions made in the vacuum
+ * summary:
+ *
+ * - tables where all the parts have been loaded with COPY FREEZE on a
+ *   Postgres 14 or later target already have their visibility map set, they
+ *   are not vacuumed, and only analyzed when their planner statistics have
+ *   not been imported,
+ *
+ * - otherwise, with --parallel-vacuum-larger-than, large tables that have
+ *   at least two indexes use VACUUM (PARALLEL n), see vacuum_set_parallel,
+ *
+ * - and tables are analyzed unless their planner statistics have been
+ *   imported.
+ *
+ * The command is empty when there is nothing left to do for the table.
+ */
+static bool
+vacuum_prepare_command(CopyDataSpec *specs,
+					   PGSQL *dst,
+					   CopyTableDataSpec *tableSpecs)
+{
+	SourceTable *table = tableSpecs->sourceTable;
+	CopyVacuumTableSummary *vacuumSummary = &(tableSpecs->vSummary);
+
+	bool analyze = !vacuumSummary->statsImported;
+
+	if (!pgsql_server_version(dst))
 	{
 		/* errors have already been logged */
 		return false;
 	}
 
-	if (!pgsql_execute(&dst, vacuum))
+	/* COPY FREEZE sets the visibility map bits from Postgres 14 onward */
+	if (dst->pgversion_num >= 140000)
+	{
+		if (!catalog_s_table_loaded_frozen(&(specs->catalogs.source),
+										   table,
+										   &(vacuumSummary->frozen)))
+		{
+			log_error("Failed to lookup COPY FREEZE status of table %s "
+					  "in our internal catalogs, see above for details",
+					  table->qname);
+			return false;
+		}
+	}
+
+	if (vacuumSummary->frozen)
+	{
+		if (analyze)
+		{
+			sformat(vacuumSummary->command, sizeof(vacuumSummary->command),
+					"ANALYZE %s.%s",
+					table->nspname,
+					table->relname);
+		}
+
+		return true;
+	}
+
+	if (!vacuum_set_parallel(specs, dst, tableSpecs))
 	{
-		log_error("Failed to run command, see above for details: %s", vacuum);
+		/* errors have already been logged */
 		return false;
 	}
 
-	(void) pgsql_finish(&dst);
+	if (vacuumSummary->parallelWorkers > 0)
+	{
+		sformat(vacuumSummary->command, sizeof(vacuumSummary->command),
+				"VACUUM (%sPARALLEL %d) %s.%s",
+				analyze ? "ANALYZE, " : "",
+				vacuumSummary->parallelWorkers,
+				table->nspname,
+				table->relname);
+	}
+	else
+	{
+		sformat(vacuumSummary->command, sizeof(vacuumSummary->command),
+				"VACUUM %s%s.%s",
+				analyze ? "ANALYZE " : "",
+				table->nspname,
+				table->relname);
+	}
 
-	if (!summary_finish_vacuum(sourceDB, &tableSpecs))
+	return true;
+}
+
+
+/*
+ * vacuum_set_parallel computes the PARALLEL degree of the VACUUM of the given
+ * table when using --parallel-vacuum-larger-than. Parallel VACUUM processes
+ * the indexes of a table with one worker per index, the leader taking one of
+ * them, so the degree is the index count minus one.
+ *
+ * The degree is capped by max_parallel_maintenance_workers, which we set in
+ * the session: the target connection settings are reset for each table.
+ */
+static bool
+vacuum_set_parallel(CopyDataSpec *specs,
+					PGSQL *dst,
+					CopyTableDataSpec *tableSpecs)
+{
+	SourceTable *table = tableSpecs->sourceTable;
+	CopyVacuumTableSummary *vacuumSummary = &(tableSpecs->vSummary);
+
+	if (specs->parallelVacuumLargerThan == 0)
+	{
+		return true;
+	}
+
+	/* the VACUUM PARALLEL option is available from Postgres 13 onward */
+	if (dst->pgversion_num < 130000)
+	{
+		return true;
+	}
+
+	if (table->bytes <= 0 ||
+		(uint64_t) table->bytes < specs->parallelVacuumLargerThan)
+	{
+		return true;
+	}
+
+	if (!catalog_s_table_count_indexes(&(specs->catalogs.source), table))
 	{
 		/* errors have already been logged */
 		return false;
 	}
 
-	if (!summary_increment_timing(sourceDB,
-								  TIMING_SECTION_VACUUM,
-								  1, /* count */
-								  0, /* bytes */
-								  tableSpecs.vSummary.durationMs))
+	if (table->indexCount < 2)
+	{
+		return true;
+	}
+
+	vacuumSummary->parallelWorkers = table->indexCount - 1;
+
+	char sql[BUFSIZE] = { 0 };
+
+	sformat(sql, sizeof(sql),
+			"SET max_parallel_maintenance_workers TO %d",
+			vacuumSummary->parallelWorkers);
+
+	if (!pgsql_execute(dst, sql))
+	{
+		log_error("Failed to set max_parallel_maintenance_workers "
+				  "for table %s",
+				  table->qname);
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * vacuum_lookup_table_stats fetches the planner statistics of the given table
+ * that we exported from the source database, when the target database is
+ * running Postgres 18 or later. Otherwise stats->sql is NULL and the table is
+ * to be analyzed on the target.
+ */
+static bool
+vacuum_lookup_table_stats(CopyDataSpec *specs,
+						  PGSQL *dst,
+						  SourceTable *table,
+						  SourceTablePgStats *stats)
+{
+	/* the statistics import functions are new in Postgres 18 */
+	if (!pgsql_server_version(dst))
 	{
 		/* errors have already been logged */
 		return false;
 	}
 
+	if (dst->pgversion_num < 180000)
+	{
+		return true;
+	}
+
+	if (!catalog_lookup_s_table_pg_stats(&(specs->catalogs.source),
+										 table->oid,
+										 stats))
+	{
+		log_error("Failed to lookup planner statistics for table %s "
+				  "in our internal catalogs, see above for details",
+				  table->qname);
+		return false;
+	}
+
 	return true;
 }
 
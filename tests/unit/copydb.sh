@@ -123,3 +123,1011 @@ if ! grep -q "not safe for COPY BINARY" /tmp/pgcopydb-binary-test.log; then
 fi
 
 echo "issue-894 binary tsvector regression test: PASSED"
+
+
+# ============================================================
+# Feature tests
+#
+# clone_test <name> <filters> [options...] clones the tables listed in
+# the <filters> file into a fresh target database <name>, using the
+# work directory /tmp/pgcopydb-<name> and logging the output into
+# /tmp/pgcopydb-<name>.log, and returns the pgcopydb exit status.
+#
+# compare_test <name> <sql> checks that the query returns the same
+# result on the source database and on the target database <name>.
+# ============================================================
+
+clone_test()
+{
+    local name="$1"
+    local filters="$2"
+
+    shift 2
+
+    psql -a -d "${PGCOPYDB_TARGET_PGURI}" -c "CREATE DATABASE ${name}"
+
+    pgcopydb clone \
+        --source "${PGCOPYDB_SOURCE_PGURI}" \
+        --target "${PGCOPYDB_TARGET_PGURI%/*}/${name}" \
+        --filters "${filters}" \
+        --skip-collations \
+        --skip-extensions \
+        --skip-large-objects \
+        --skip-db-properties \
+        --dir "/tmp/pgcopydb-${name}" \
+        --fail-fast \
+        --notice \
+        "$@" 2>&1 | tee "/tmp/pgcopydb-${name}.log"
+
+    return "${PIPESTATUS[0]}"
+}
+
+compare_test()
+{
+    local name="$1"
+    local sql="$2"
+    local src
+    local dst
+
+    src=$(psql -t -A -d "${PGCOPYDB_SOURCE_PGURI}" -c "${sql}")
+    dst=$(psql -t -A -d "${PGCOPYDB_TARGET_PGURI%/*}/${name}" -c "${sql}")
+
+    if [ "${src}" != "${dst}" ]; then
+        echo "ERROR: ${name}: expected ${src}, got ${dst}"
+        exit 1
+    fi
+}
+
+
+# ============================================================
+# COPY with a separate reader thread (--use-copy-threads)
+#
+# Clone a table into a fresh database using the threaded COPY
+# relay, check that the data arrives intact, and that the ring
+# statistics are reported in the JSON summary.
+# ============================================================
+
+cat > /tmp/copy_threads_test.ini <<'FILTEREOF'
+[include-only-table]
+"Sp1eCial .Char"."source1testing"
+FILTEREOF
+
+clone_test copy_threads_test /tmp/copy_threads_test.ini \
+    --use-copy-threads \
+    --table-jobs 1 \
+    --index-jobs 1
+
+compare_test copy_threads_test \
+    'select count(*), sum(s1) from "Sp1eCial .Char"."source1testing"'
+
+if ! grep -q '"ring"' /tmp/pgcopydb-copy_threads_test/summary.json; then
+    echo "ERROR: --use-copy-threads test: ring statistics not found in summary"
+    cat /tmp/pgcopydb-copy_threads_test/summary.json
+    exit 1
+fi
+
+echo "--use-copy-threads test: PASSED"
+
+
+# ============================================================
+# COPY time attribution
+#
+# The time spent in COPY is split between source waits, target
+# waits and client time, and the dominant one is reported in the
+# JSON summary.
+# ============================================================
+
+cat > /tmp/copy_time_test.ini <<'FILTEREOF'
+[include-only-table]
+"Sp1eCial .Char"."source1testing"
+FILTEREOF
+
+clone_test copy_time_test /tmp/copy_time_test.ini \
+    --table-jobs 1 \
+    --index-jobs 1
+
+if ! grep -q '"bound"' /tmp/pgcopydb-copy_time_test/summary.json; then
+    echo "ERROR: COPY time attribution test: COPY wait times not found in summary"
+    cat /tmp/pgcopydb-copy_time_test/summary.json
+    exit 1
+fi
+
+echo "COPY time attribution test: PASSED"
+
+
+# ============================================================
+# Fan-out COPY (--fanout-target)
+#
+# Copy the table data into two target databases at once, reading
+# the source data only once, and check that both targets get the
+# data intact.
+# ============================================================
+
+cat > /tmp/fanout_test.ini <<'FILTEREOF'
+[include-only-table]
+"Sp1eCial .Char"."source1testing"
+FILTEREOF
+
+for db in fanout_a fanout_b
+do
+    psql -a -d "${PGCOPYDB_TARGET_PGURI}" -c "CREATE DATABASE ${db}"
+
+    pgcopydb copy schema \
+        --source "${PGCOPYDB_SOURCE_PGURI}" \
+        --target "${PGCOPYDB_TARGET_PGURI%/*}/${db}" \
+        --filters /tmp/fanout_test.ini \
+        --dir /tmp/pgcopydb-schema-${db}
+done
+
+pgcopydb copy table-data \
+    --source "${PGCOPYDB_SOURCE_PGURI}" \
+    --target "${PGCOPYDB_TARGET_PGURI%/*}/fanout_a" \
+    --fanout-target "${PGCOPYDB_TARGET_PGURI%/*}/fanout_b" \
+    --filters /tmp/fanout_test.ini \
+    --dir /tmp/pgcopydb-fanout-test \
+    --notice 2>&1 | tee /tmp/pgcopydb-fanout-test.log
+
+for db in fanout_a fanout_b
+do
+    compare_test "${db}" \
+        'select count(*), sum(s1) from "Sp1eCial .Char"."source1testing"'
+done
+
+if ! grep -q "COPY done on target 1" /tmp/pgcopydb-fanout-test.log; then
+    echo "ERROR: --fanout-target test: per-target summary not found in output"
+    exit 1
+fi
+
+echo "--fanout-target test: PASSED"
+
+
+# ============================================================
+# Spool table data to disk (--spool)
+#
+# Clone a table into a fresh database through the on-disk spool
+# using COPY BINARY, check that the data arrives intact, and that
+# the source snapshot has been closed early.
+# ============================================================
+
+cat > /tmp/spool_test.ini <<'FILTEREOF'
+[include-only-table]
+"Sp1eCial .Char"."source1testing"
+FILTEREOF
+
+clone_test spool_test /tmp/spool_test.ini \
+    --spool \
+    --use-copy-binary \
+    --table-jobs 2 \
+    --index-jobs 1
+
+compare_test spool_test \
+    'select count(*), sum(s1) from "Sp1eCial .Char"."source1testing"'
+
+if ! grep -q "early, all the data has been spooled" /tmp/pgcopydb-spool_test.log; then
+    echo "ERROR: --spool test: snapshot was not closed early"
+    exit 1
+fi
+
+echo "--spool test: PASSED"
+
+
+# ============================================================
+# UNLOGGED load (--unlogged-load)
+#
+# Clone a table into a fresh database through an UNLOGGED table,
+# check that the data arrives intact, that the table has been
+# switched back to LOGGED, and that the timing is reported.
+# ============================================================
+
+cat > /tmp/unlogged_test.ini <<'FILTEREOF'
+[include-only-table]
+"Sp1eCial .Char"."source1testing"
+FILTEREOF
+
+clone_test unlogged_test /tmp/unlogged_test.ini \
+    --unlogged-load \
+    --table-jobs 2 \
+    --index-jobs 1
+
+compare_test unlogged_test \
+    'select count(*), sum(s1) from "Sp1eCial .Char"."source1testing"'
+
+persistence=$(psql -t -A -d "${PGCOPYDB_TARGET_PGURI%/*}/unlogged_test" \
+    -c "select relpersistence from pg_class where oid = '\"Sp1eCial .Char\".\"source1testing\"'::regclass")
+
+if [ "${persistence}" != "p" ]; then
+    echo "ERROR: --unlogged-load test: expected a LOGGED table, got ${persistence}"
+    exit 1
+fi
+
+if ! grep -q "SET LOGGED" /tmp/pgcopydb-unlogged_test/summary.json; then
+    echo "ERROR: --unlogged-load test: SET LOGGED timing not found in summary"
+    cat /tmp/pgcopydb-unlogged_test/summary.json
+    exit 1
+fi
+
+if ! grep -q '"wal-skipped"' /tmp/pgcopydb-unlogged_test/summary.json; then
+    echo "ERROR: wal-skipped property not found in summary"
+    exit 1
+fi
+
+echo "--unlogged-load test: PASSED"
+
+
+# ============================================================
+# Automatic COPY format (--copy-format auto)
+#
+# The uuid table only has built-in types, one of them faster in
+# binary, and is copied with COPY BINARY. The tsv table has a
+# tsvector column, which is unsafe for COPY BINARY.
+# ============================================================
+
+pgcopydb list tables \
+    --source "${PGCOPYDB_SOURCE_PGURI}" \
+    --dir /tmp/pgcopydb-copy-format-test \
+    > /tmp/copy-format-tables.out
+
+cat /tmp/copy-format-tables.out
+
+if ! grep -E '\| +uuid \|.*\| +binary$' /tmp/copy-format-tables.out; then
+    echo "ERROR: --copy-format test: expected binary for table uuid"
+    exit 1
+fi
+
+if ! grep -E '\| +tsv \|.*\| +text$' /tmp/copy-format-tables.out; then
+    echo "ERROR: --copy-format test: expected text for table tsv"
+    exit 1
+fi
+
+echo "--copy-format test: PASSED"
+
+
+# ============================================================
+# Chunked COPY (--copy-chunk-size)
+#
+# Clone a table into a fresh database with a tiny chunk size so
+# that the table data is committed in several chunks, and check
+# that the data arrives intact.
+# ============================================================
+
+cat > /tmp/chunk_test.ini <<'FILTEREOF'
+[include-only-table]
+"Sp1eCial .Char"."source1testing"
+FILTEREOF
+
+clone_test chunk_test /tmp/chunk_test.ini \
+    --copy-chunk-size 64kB \
+    --table-jobs 2 \
+    --index-jobs 1
+
+compare_test chunk_test \
+    'select count(*), sum(s1) from "Sp1eCial .Char"."source1testing"'
+
+if ! grep -q "COPY done in [0-9]* chunks" /tmp/pgcopydb-chunk_test.log; then
+    echo "ERROR: --copy-chunk-size test: chunked COPY not found in output"
+    exit 1
+fi
+
+echo "--copy-chunk-size test: PASSED"
+
+
+# ============================================================
+# Bandwidth limits (--max-bandwidth)
+#
+# Clone a table into a fresh database with global and per-worker
+# bandwidth limits, and check that the data arrives intact.
+# ============================================================
+
+cat > /tmp/ratelimit_test.ini <<'FILTEREOF'
+[include-only-table]
+"Sp1eCial .Char"."source1testing"
+FILTEREOF
+
+clone_test ratelimit_test /tmp/ratelimit_test.ini \
+    --max-bandwidth 20MB \
+    --max-worker-bandwidth 10MB \
+    --table-jobs 2 \
+    --index-jobs 1
+
+compare_test ratelimit_test \
+    'select count(*), sum(s1) from "Sp1eCial .Char"."source1testing"'
+
+if ! grep -q "Limiting source bandwidth to" /tmp/pgcopydb-ratelimit_test.log; then
+    echo "ERROR: --max-bandwidth test: bandwidth limit not found in output"
+    exit 1
+fi
+
+echo "--max-bandwidth test: PASSED"
+
+
+# ============================================================
+# Split boundaries on a sparse integer key
+#
+# Most of the key values of this table are in a small range, and a few
+# rows have very large key values: equal-width ranges would put most of
+# the rows in the first part. Check that the parts are balanced.
+# ============================================================
+
+psql -a -d "${PGCOPYDB_SOURCE_PGURI}" <<'EOF_SQL'
+create table public.sparse_keys (id bigint primary key, f1 char(100));
+
+insert into public.sparse_keys
+     select x, md5(x::text) from generate_series(1, 19000) as t(x);
+
+insert into public.sparse_keys
+     select x, md5(x::text) from generate_series(10000000, 10000999) as t(x);
+
+analyze public.sparse_keys;
+EOF_SQL
+
+pgcopydb list schema --dir /tmp/pgcopydb-sparse-test \
+    --not-consistent --split-tables-larger-than 256kB >/dev/null
+
+pgcopydb list table-parts --dir /tmp/pgcopydb-sparse-test \
+    --schema-name public --table-name sparse_keys \
+    --split-tables-larger-than 256kB 2>&1 | tee /tmp/pgcopydb-sparse-test.log
+
+# skip the header and the first part, which is for NULL values
+if ! awk -F'|' '$1 ~ /^ *[0-9]+\/[0-9]+ *$/ && $2 + 0 != -1 {
+         n++; sum += $5; if ($5 > max) max = $5 }
+       END { exit !(n > 1 && max * n <= 2 * sum) }' \
+       /tmp/pgcopydb-sparse-test.log
+then
+    echo "ERROR: sparse split test: parts are not balanced"
+    exit 1
+fi
+
+echo "sparse split test: PASSED"
+
+
+# ============================================================
+# Split on a composite non-integer unique key
+#
+# This table primary key is (tenant_id, id) where id is an uuid. Check
+# that the table is split using typed key boundaries rather than CTID.
+# ============================================================
+
+psql -a -d "${PGCOPYDB_SOURCE_PGURI}" <<'EOF_SQL'
+create table public.tenant_keys
+ (
+   tenant_id integer,
+   id uuid,
+   f1 char(100),
+   primary key(tenant_id, id)
+ );
+
+insert into public.tenant_keys
+     select x % 10, md5(x::text)::uuid, md5(x::text)
+       from generate_series(1, 20000) as t(x);
+
+analyze public.tenant_keys;
+EOF_SQL
+
+pgcopydb list schema --dir /tmp/pgcopydb-typed-split-test \
+    --not-consistent --split-tables-larger-than 512kB >/dev/null
+
+pgcopydb list table-parts --dir /tmp/pgcopydb-typed-split-test \
+    --schema-name public --table-name tenant_keys \
+    --split-tables-larger-than 512kB 2>&1 | tee /tmp/pgcopydb-typed-split-test.log
+
+if ! grep -q "'::integer, '.*'::uuid" /tmp/pgcopydb-typed-split-test.log; then
+    echo "ERROR: typed split test: no typed key boundaries found"
+    exit 1
+fi
+
+echo "typed split test: PASSED"
+
+
+# ============================================================
+# Idle COPY workers split the parts still in progress
+#
+# This table is split in two parts and copied in small chunks with more
+# table jobs than parts: idle workers may split off the end of the parts
+# that are still in progress. Check that the data arrives intact, once.
+# ============================================================
+
+psql -a -d "${PGCOPYDB_SOURCE_PGURI}" <<'EOF_SQL'
+create table public.steal_rows (id bigint primary key, f1 char(100));
+
+insert into public.steal_rows
+     select x, md5(x::text) from generate_series(1, 40000) as t(x);
+
+analyze public.steal_rows;
+EOF_SQL
+
+cat > /tmp/steal_test.ini <<'FILTEREOF'
+[include-only-table]
+public.steal_rows
+FILTEREOF
+
+clone_test steal_test /tmp/steal_test.ini \
+    --split-tables-larger-than 2MB \
+    --split-max-parts 2 \
+    --copy-chunk-size 64kB \
+    --table-jobs 4 \
+    --index-jobs 1
+
+compare_test steal_test \
+    'select count(*), count(distinct id), sum(id) from public.steal_rows'
+
+echo "part splitting test: PASSED"
+
+
+# ============================================================
+# Split boundaries on a table with holes
+#
+# This table has no unique key and most of its rows have been deleted
+# from the first blocks: equal-width block ranges would put most of the
+# live tuples in the last part. Check that the CTID parts are balanced.
+# ============================================================
+
+psql -a -d "${PGCOPYDB_SOURCE_PGURI}" <<'EOF_SQL'
+create table public.ctid_holes (id bigint, f1 char(100));
+
+insert into public.ctid_holes
+     select x, md5(x::text) from generate_series(1, 40000) as t(x);
+
+delete from public.ctid_holes where id <= 30000;
+EOF_SQL
+
+pgcopydb list schema --dir /tmp/pgcopydb-ctid-holes-test \
+    --not-consistent --split-tables-larger-than 1MB >/dev/null
+
+pgcopydb list table-parts --dir /tmp/pgcopydb-ctid-holes-test \
+    --schema-name public --table-name ctid_holes \
+    --split-tables-larger-than 1MB 2>&1 | tee /tmp/pgcopydb-ctid-holes-test.log
+
+if ! awk -F'|' '$1 ~ /^ *[0-9]+\/[0-9]+ *$/ {
+         n++; sum += $5; if ($5 > max) max = $5 }
+       END { exit !(n > 1 && max * n <= 2 * sum) }' \
+       /tmp/pgcopydb-ctid-holes-test.log
+then
+    echo "ERROR: ctid density split test: parts are not balanced"
+    exit 1
+fi
+
+echo "ctid density split test: PASSED"
+
+
+# ============================================================
+# Longest job first, index builds included
+#
+# The sched_big table is larger than the sched_gin table, but the GIN
+# index on sched_gin makes it the longest job: check that the predicted
+# timeline starts with it.
+# ============================================================
+
+psql -a -d "${PGCOPYDB_SOURCE_PGURI}" <<'EOF_SQL'
+create table public.sched_big (id bigint, f1 char(100));
+create table public.sched_gin (id bigint, tags int[]);
+
+insert into public.sched_big
+     select x, md5(x::text) from generate_series(1, 300000) as t(x);
+
+insert into public.sched_gin
+     select x, array[x % 97, x % 89, x % 83, x % 79, x % 73]
+       from generate_series(1, 200000) as t(x);
+
+create index sched_gin_tags on public.sched_gin using gin(tags);
+
+analyze public.sched_big, public.sched_gin;
+EOF_SQL
+
+cat > /tmp/schedule.ini <<'FILTEREOF'
+[include-only-table]
+public.sched_big
+public.sched_gin
+FILTEREOF
+
+pgcopydb list schedule --dir /tmp/pgcopydb-schedule-test \
+    --not-consistent --filter /tmp/schedule.ini \
+    --table-jobs 1 --index-jobs 1 2>&1 | tee /tmp/pgcopydb-schedule-test.log
+
+first=$(awk -F'|' '$4 ~ /COPY/ { gsub(/ /, "", $5); print $5; exit }' \
+            /tmp/pgcopydb-schedule-test.log)
+
+if [ "${first}" != "public.sched_gin" ]; then
+    echo "ERROR: schedule test: expected sched_gin first, got ${first}"
+    exit 1
+fi
+
+if ! grep -q "Predicted duration" /tmp/pgcopydb-schedule-test.log; then
+    echo "ERROR: schedule test: missing predicted duration"
+    exit 1
+fi
+
+echo "schedule test: PASSED"
+
+
+# ============================================================
+# Automatic split size
+#
+# With --split-tables-larger-than auto the size threshold is computed from
+# the total size of the tables and --table-jobs, with a 16 MB minimum: the
+# sched_big table from the previous test is then split in several parts.
+# ============================================================
+
+pgcopydb list schema --dir /tmp/pgcopydb-split-auto-test \
+    --not-consistent --split-tables-larger-than auto --table-jobs 4 >/dev/null
+
+pgcopydb list table-parts --dir /tmp/pgcopydb-split-auto-test \
+    --schema-name public --table-name sched_big \
+    --split-tables-larger-than auto --table-jobs 4 2>&1 \
+    | tee /tmp/pgcopydb-split-auto-test.log
+
+if ! grep -q "Automatic split" /tmp/pgcopydb-split-auto-test.log; then
+    echo "ERROR: split auto test: missing the automatic split explanation"
+    exit 1
+fi
+
+if ! awk -F'|' '$1 ~ /^ *[0-9]+\/[0-9]+ *$/ { n++ } END { exit !(n > 1) }' \
+       /tmp/pgcopydb-split-auto-test.log
+then
+    echo "ERROR: split auto test: table sched_big has not been split"
+    exit 1
+fi
+
+echo "split auto test: PASSED"
+
+
+# ============================================================
+# Adaptive concurrency (--adaptive-jobs)
+#
+# Clone the schedule test tables with the adaptive controller in the COPY
+# and CREATE INDEX supervisors, and check that the data arrives intact
+# and that the controller bounds are reported.
+# ============================================================
+
+cat > /tmp/adaptive_test.ini <<'FILTEREOF'
+[include-only-table]
+public.sched_big
+public.sched_gin
+FILTEREOF
+
+clone_test adaptive_test /tmp/adaptive_test.ini \
+    --adaptive-jobs \
+    --min-table-jobs 2 \
+    --table-jobs 4 \
+    --index-jobs 2
+
+compare_test adaptive_test 'select count(*), sum(id) from public.sched_big'
+
+if ! grep -q "Adaptive COPY concurrency: between 2 and 4 active workers" \
+       /tmp/pgcopydb-adaptive_test.log
+then
+    echo "ERROR: --adaptive-jobs test: COPY controller has not been started"
+    exit 1
+fi
+
+if ! grep -q "Adaptive CREATE INDEX concurrency: between 1 and 2 active workers" \
+       /tmp/pgcopydb-adaptive_test.log
+then
+    echo "ERROR: --adaptive-jobs test: CREATE INDEX controller has not been started"
+    exit 1
+fi
+
+echo "--adaptive-jobs test: PASSED"
+
+
+# ============================================================
+# Shared jobs budget (--total-jobs)
+#
+# Clone the schedule test tables with a budget of 2 jobs shared by all the
+# workers, and check that the data and the indexes arrive intact.
+# ============================================================
+
+cat > /tmp/total_jobs_test.ini <<'FILTEREOF'
+[include-only-table]
+public.sched_big
+public.sched_gin
+FILTEREOF
+
+clone_test total_jobs_test /tmp/total_jobs_test.ini \
+    --total-jobs 2
+
+compare_test total_jobs_test 'select count(*), sum(id) from public.sched_gin'
+
+idx=$(psql -t -A -d "${PGCOPYDB_TARGET_PGURI%/*}/total_jobs_test" \
+    -c "select count(*) from pg_indexes where indexname = 'sched_gin_tags'")
+
+if [ "${idx}" != "1" ]; then
+    echo "ERROR: --total-jobs test: index sched_gin_tags is missing"
+    exit 1
+fi
+
+if ! grep -q "STEP 4: starting 2 table-data COPY processes" \
+       /tmp/pgcopydb-total_jobs_test.log
+then
+    echo "ERROR: --total-jobs test: --table-jobs does not default to 2"
+    exit 1
+fi
+
+echo "--total-jobs test: PASSED"
+
+
+# ============================================================
+# Connection re-use in the CREATE INDEX and VACUUM workers
+#
+# With a single index job and a single table job, the same worker process
+# builds both sched_gin and sched_big indexes and vacuums both tables, and
+# the summary reports the connection set-up time saved.
+# ============================================================
+
+psql -d "${PGCOPYDB_SOURCE_PGURI}" \
+     -c "create index if not exists sched_big_id on public.sched_big(id)"
+
+cat > /tmp/conn_reuse_test.ini <<'FILTEREOF'
+[include-only-table]
+public.sched_big
+public.sched_gin
+FILTEREOF
+
+clone_test conn_reuse_test /tmp/conn_reuse_test.ini \
+    --table-jobs 1 \
+    --index-jobs 1
+
+idx=$(psql -t -A -d "${PGCOPYDB_TARGET_PGURI%/*}/conn_reuse_test" \
+    -c "select count(*) from pg_indexes where indexname in ('sched_gin_tags', 'sched_big_id')")
+
+if [ "${idx}" != "2" ]; then
+    echo "ERROR: connection re-use test: expected 2 indexes, got ${idx}"
+    exit 1
+fi
+
+sql="select count(*) from timings where label like 'Connection set-up saved%' and count > 0"
+saved=$(sqlite3 /tmp/pgcopydb-conn_reuse_test/schema/source.db "${sql}")
+
+if [ "${saved}" != "1" ]; then
+    echo "ERROR: connection re-use test: no connection set-up time saved"
+    exit 1
+fi
+
+echo "connection re-use test: PASSED"
+
+
+# ============================================================
+# maintenance_work_mem budget (--index-memory)
+#
+# Each CREATE INDEX gets a grant from the budget, registered in the
+# summary table of the source catalog.
+# ============================================================
+
+cat > /tmp/index_memory_test.ini <<'FILTEREOF'
+[include-only-table]
+public.sched_big
+public.sched_gin
+FILTEREOF
+
+clone_test index_memory_test /tmp/index_memory_test.ini \
+    --index-jobs 2 \
+    --index-memory 256MB
+
+if ! grep -q "of maintenance_work_mem to index public.sched_gin_tags" \
+       /tmp/pgcopydb-index_memory_test.log
+then
+    echo "ERROR: --index-memory test: no grant for index sched_gin_tags"
+    exit 1
+fi
+
+sql="select count(*) from summary where indexoid is not null and mem_grant >= 64 * 1024 * 1024"
+grants=$(sqlite3 /tmp/pgcopydb-index_memory_test/schema/source.db "${sql}")
+
+if [ "${grants}" != "2" ]; then
+    echo "ERROR: --index-memory test: expected 2 grants, got ${grants}"
+    exit 1
+fi
+
+echo "--index-memory test: PASSED"
+
+# ============================================================
+# Parallel CREATE INDEX (--parallel-index-larger-than)
+#
+# The btree index sched_big_id is larger than the threshold and is built
+# with parallel workers, the GIN index sched_gin_tags is not.
+# ============================================================
+
+cat > /tmp/parallel_index_test.ini <<'FILTEREOF'
+[include-only-table]
+public.sched_big
+public.sched_gin
+FILTEREOF
+
+clone_test parallel_index_test /tmp/parallel_index_test.ini \
+    --index-jobs 4 \
+    --parallel-index-larger-than 1MB
+
+db=/tmp/pgcopydb-parallel_index_test/schema/source.db
+
+sql="select s.parallel_workers from summary s join s_index i on i.oid = s.indexoid where i.relname = 'sched_big_id'"
+big=$(sqlite3 "${db}" "${sql}")
+
+if [ -z "${big}" ] || [ "${big}" -lt 1 ]; then
+    echo "ERROR: --parallel-index-larger-than test: sched_big_id built with '${big}' workers"
+    exit 1
+fi
+
+sql="select s.parallel_workers from summary s join s_index i on i.oid = s.indexoid where i.relname = 'sched_gin_tags'"
+gin=$(sqlite3 "${db}" "${sql}")
+
+if [ "${gin}" != "0" ]; then
+    echo "ERROR: --parallel-index-larger-than test: sched_gin_tags built with '${gin}' workers"
+    exit 1
+fi
+
+echo "--parallel-index-larger-than test: PASSED"
+
+# ============================================================
+# Foreign keys created NOT VALID and validated concurrently (--fkey-jobs)
+#
+# The valid foreign key is validated by a worker and registered in the
+# fkey_summary table, the NOT VALID one stays NOT VALID on the target.
+# ============================================================
+
+psql -a -d "${PGCOPYDB_SOURCE_PGURI}" <<'EOF_SQL'
+create table public.fk_parent (id bigint primary key);
+create table public.fk_child (id bigint, parent_id bigint, other_id bigint);
+
+insert into public.fk_parent select x from generate_series(1, 1000) as t(x);
+
+insert into public.fk_child
+     select x, x % 1000 + 1, x % 1000 + 1
+       from generate_series(1, 50000) as t(x);
+
+alter table public.fk_child
+  add constraint fk_child_parent_id_fkey
+      foreign key (parent_id) references public.fk_parent(id);
+
+alter table public.fk_child
+  add constraint fk_child_other_id_fkey
+      foreign key (other_id) references public.fk_parent(id) not valid;
+EOF_SQL
+
+cat > /tmp/fkey_jobs_test.ini <<'FILTEREOF'
+[include-only-table]
+public.fk_parent
+public.fk_child
+FILTEREOF
+
+clone_test fkey_jobs_test /tmp/fkey_jobs_test.ini \
+    --fkey-jobs 2
+
+sql="select string_agg(conname || '=' || convalidated, ',' order by conname) from pg_constraint where conrelid = 'public.fk_child'::regclass and contype = 'f'"
+fkeys=$(psql -At -d "${PGCOPYDB_TARGET_PGURI%/*}/fkey_jobs_test" -c "${sql}")
+
+if [ "${fkeys}" != "fk_child_other_id_fkey=false,fk_child_parent_id_fkey=true" ]; then
+    echo "ERROR: --fkey-jobs test: unexpected foreign keys on target: ${fkeys}"
+    exit 1
+fi
+
+sql="select count(*) from fkey_summary s join s_fkey f on f.oid = s.conoid where f.conname = 'fk_child_parent_id_fkey' and s.done_time_epoch is not null"
+validated=$(sqlite3 /tmp/pgcopydb-fkey_jobs_test/schema/source.db "${sql}")
+
+if [ "${validated}" != "1" ]; then
+    echo "ERROR: --fkey-jobs test: expected 1 validation in fkey_summary, got ${validated}"
+    exit 1
+fi
+
+echo "--fkey-jobs test: PASSED"
+
+
+# ============================================================
+# Foreign keys with --fkey-jobs and --resume
+#
+# The source table has rows that break its foreign key, so that the
+# validation fails on the target. Once these rows are deleted on the
+# target, --resume must skip the foreign key that already exists there
+# and validate it.
+# ============================================================
+
+psql -a -d "${PGCOPYDB_SOURCE_PGURI}" <<'EOF_SQL'
+create table public.fk_resume_parent (id bigint primary key);
+create table public.fk_resume_child (id bigint, parent_id bigint);
+
+insert into public.fk_resume_parent select x from generate_series(1, 100) as t(x);
+
+insert into public.fk_resume_child
+     select x, x % 100 + 1 from generate_series(1, 1000) as t(x);
+
+alter table public.fk_resume_child
+  add constraint fk_resume_child_parent_id_fkey
+      foreign key (parent_id) references public.fk_resume_parent(id);
+
+-- skip the foreign key triggers to insert orphan rows
+set session_replication_role to replica;
+
+insert into public.fk_resume_child values (1001, 1000), (1002, 1000);
+EOF_SQL
+
+cat > /tmp/fkey_resume_test.ini <<'FILTEREOF'
+[include-only-table]
+public.fk_resume_parent
+public.fk_resume_child
+FILTEREOF
+
+if clone_test fkey_resume_test /tmp/fkey_resume_test.ini --fkey-jobs 2
+then
+    echo "ERROR: --fkey-jobs resume test: validation did not fail"
+    exit 1
+fi
+
+PGCOPYDB_TARGET_FK_RESUME="${PGCOPYDB_TARGET_PGURI%/*}/fkey_resume_test"
+
+psql -a -d "${PGCOPYDB_TARGET_FK_RESUME}" \
+     -c "delete from public.fk_resume_child where parent_id = 1000"
+
+pgcopydb clone \
+    --source "${PGCOPYDB_SOURCE_PGURI}" \
+    --target "${PGCOPYDB_TARGET_FK_RESUME}" \
+    --filters /tmp/fkey_resume_test.ini \
+    --skip-collations \
+    --skip-extensions \
+    --skip-large-objects \
+    --skip-db-properties \
+    --fkey-jobs 2 \
+    --dir /tmp/pgcopydb-fkey_resume_test \
+    --resume \
+    --not-consistent \
+    --fail-fast \
+    --notice 2>&1 | tee /tmp/pgcopydb-fkey_resume_test-resume.log
+
+if ! grep -q "Foreign key fk_resume_child_parent_id_fkey already exists" \
+       /tmp/pgcopydb-fkey_resume_test-resume.log
+then
+    echo "ERROR: --fkey-jobs resume test: foreign key was not skipped"
+    exit 1
+fi
+
+sql="select convalidated from pg_constraint where conname = 'fk_resume_child_parent_id_fkey'"
+validated=$(psql -At -d "${PGCOPYDB_TARGET_FK_RESUME}" -c "${sql}")
+
+if [ "${validated}" != "t" ]; then
+    echo "ERROR: --fkey-jobs resume test: foreign key has not been validated"
+    exit 1
+fi
+
+echo "--fkey-jobs resume test: PASSED"
+
+
+# ============================================================
+# planner_stats_test: planner statistics exported from the source are stored
+# in our catalogs, and imported rather than running ANALYZE on Postgres 18
+# targets
+# ============================================================
+
+psql -a -d "${PGCOPYDB_SOURCE_PGURI}" <<'EOF_SQL'
+create table public.stats_import (id bigint primary key, kind text);
+
+insert into public.stats_import
+     select x, 'kind ' || x % 10
+       from generate_series(1, 10000) as t(x);
+
+analyze public.stats_import;
+
+create table public.stats_expr (id bigint primary key, kind text);
+create index on public.stats_expr (lower(kind));
+
+insert into public.stats_expr
+     select x, 'Kind ' || x % 10
+       from generate_series(1, 10000) as t(x);
+
+analyze public.stats_expr;
+EOF_SQL
+
+cat > /tmp/planner_stats_test.ini <<'FILTEREOF'
+[include-only-table]
+public.stats_import
+public.stats_expr
+FILTEREOF
+
+clone_test planner_stats_test /tmp/planner_stats_test.ini
+
+PGCOPYDB_TARGET_STATS="${PGCOPYDB_TARGET_PGURI%/*}/planner_stats_test"
+catalog=/tmp/pgcopydb-planner_stats_test/schema/source.db
+
+target_version=$(psql -At -d "${PGCOPYDB_TARGET_STATS}" -c "show server_version_num")
+
+# statistics are only exported when the target can import them
+expected=0
+
+if [ "${target_version}" -ge 180000 ]; then
+    expected=1
+fi
+
+sql="select count(*) from s_table_pg_stats s join s_table t on t.oid = s.oid where t.relname = 'stats_import' and s.sql like '%pg_restore_attribute_stats%'"
+exported=$(sqlite3 "${catalog}" "${sql}")
+
+if [ "${exported}" != "${expected}" ]; then
+    echo "ERROR: planner statistics test: expected ${expected} table in s_table_pg_stats, got ${exported}"
+    exit 1
+fi
+
+# expression indexes have statistics of their own, the table is analyzed
+sql="select count(*) from s_table_pg_stats s join s_table t on t.oid = s.oid where t.relname = 'stats_expr'"
+exported=$(sqlite3 "${catalog}" "${sql}")
+
+if [ "${exported}" != "0" ]; then
+    echo "ERROR: planner statistics test: table with an expression index was exported"
+    exit 1
+fi
+
+if [ "${target_version}" -ge 180000 ]; then
+    if ! grep -q "Importing planner statistics for table" /tmp/pgcopydb-planner_stats_test.log; then
+        echo "ERROR: planner statistics test: statistics were not imported"
+        exit 1
+    fi
+
+    if grep -q "VACUUM ANALYZE public.stats_import" /tmp/pgcopydb-planner_stats_test.log; then
+        echo "ERROR: planner statistics test: table was analyzed on the target"
+        exit 1
+    fi
+fi
+
+sql="select count(*) from pg_stats where schemaname = 'public' and tablename = 'stats_import'"
+columns=$(psql -At -d "${PGCOPYDB_TARGET_STATS}" -c "${sql}")
+
+if [ "${columns}" != "2" ]; then
+    echo "ERROR: planner statistics test: expected 2 columns in pg_stats, got ${columns}"
+    exit 1
+fi
+
+echo "planner statistics test: PASSED"
+
+
+# ============================================================
+# vacuum_strategy_test: tables loaded with COPY FREEZE are not vacuumed,
+# and with --parallel-vacuum-larger-than large tables with several indexes
+# use VACUUM (PARALLEL n). The decisions are registered in vacuum_summary.
+# ============================================================
+
+psql -a -d "${PGCOPYDB_SOURCE_PGURI}" <<'EOF_SQL'
+create table public.vac_big (id bigint primary key, tag text);
+create index vac_big_tag on public.vac_big(tag);
+
+insert into public.vac_big
+     select x, 'tag number ' || x % 100
+       from generate_series(1, 100000) as t(x);
+
+create table public.vac_small (id bigint primary key);
+insert into public.vac_small select x from generate_series(1, 100) as t(x);
+
+analyze public.vac_big, public.vac_small;
+EOF_SQL
+
+cat > /tmp/vacuum_strategy_test.ini <<'FILTEREOF'
+[include-only-table]
+public.vac_big
+public.vac_small
+FILTEREOF
+
+# split vac_big so that its parts are not loaded with COPY FREEZE
+clone_test vacuum_strategy_test /tmp/vacuum_strategy_test.ini \
+    --split-tables-larger-than 1MB \
+    --parallel-vacuum-larger-than 1MB
+
+catalog=/tmp/pgcopydb-vacuum_strategy_test/schema/source.db
+
+sql="select v.frozen || ':' || coalesce(v.command, '') from vacuum_summary v join s_table t on t.oid = v.tableoid where t.relname = 'vac_small'"
+small=$(sqlite3 "${catalog}" "${sql}")
+
+case "${small}" in
+    "1:ANALYZE public.vac_small"|"1:")
+        ;;
+    *)
+        echo "ERROR: vacuum strategy test: vac_small was vacuumed: ${small}"
+        exit 1
+        ;;
+esac
+
+sql="select v.frozen || ':' || v.parallel_workers || ':' || v.command from vacuum_summary v join s_table t on t.oid = v.tableoid where t.relname = 'vac_big'"
+big=$(sqlite3 "${catalog}" "${sql}")
+
+case "${big}" in
+    "0:1:VACUUM (ANALYZE, PARALLEL 1) public.vac_big"|"0:1:VACUUM (PARALLEL 1) public.vac_big")
+        ;;
+    *)
+        echo "ERROR: vacuum strategy test: unexpected vac_big VACUUM: ${big}"
+        exit 1
+        ;;
+esac
+
+echo "vacuum strategy test: PASSED"